@@ -0,0 +1,55 @@
+#include "CanvasPipeline.h"
+#include "SkCanvas.h"
+
+CanvasPipeline::CanvasPipeline(int width, int height)
+	: m_canvas(NULL)
+{
+	// Both threads are in the same process, so the writer shares its bitmap heap with the reader
+	// instead of copying bitmaps into the blocks.
+	m_canvas = m_writer.startRecording(&m_ring, 0, width, height);
+}
+
+CanvasPipeline::~CanvasPipeline()
+{
+	// Nothing plays back anymore, so close() must not wait for room in the ring.
+	m_ring.abort();
+	close();
+}
+
+void CanvasPipeline::endFrame()
+{
+	if (!m_canvas)
+		return;
+
+	m_writer.flushRecording(true);
+	m_ring.flush();
+}
+
+void CanvasPipeline::close()
+{
+	if (!m_canvas)
+		return;
+
+	// Writes the op that tells the reader we are done.
+	m_writer.endRecording();
+	m_canvas = NULL;
+	m_ring.flush();
+}
+
+bool CanvasPipeline::playFrame(SkCanvas* target)
+{
+	m_reader.setCanvas(target);
+	for (;;) {
+		bool endOfFrame = false;
+		SkGPipeReader::Status status = m_ring.playbackBlock(&m_reader, &endOfFrame);
+		if (status == SkGPipeReader::kError_Status) {
+			// Nothing after this can be played back: don't let the script thread wait for us.
+			m_ring.abort();
+			return false;
+		}
+		if (status == SkGPipeReader::kDone_Status)
+			return false;
+		if (endOfFrame)
+			return true;
+	}
+}
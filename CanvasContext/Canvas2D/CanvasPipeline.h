@@ -0,0 +1,48 @@
+#ifndef __CANVAS_PIPELINE__
+#define __CANVAS_PIPELINE__
+
+#include "SkGPipe.h"
+#include "SkGPipeRingController.h"
+
+class SkCanvas;
+
+// Lets the script thread draw a frame through CanvasContext2D while another thread rasterizes the
+// frame before it.
+//
+// Drawing into canvas() is recorded by an SkGPipeWriter into the blocks of an
+// SkGPipeRingController. Each block is handed to the render thread as soon as it is full, or when
+// the script thread calls endFrame(), and playFrame() plays it back with an SkGPipeReader. When
+// all the blocks of the ring wait to be played back, the script thread waits for the render
+// thread.
+//
+// canvas() only records: readPixels() and writePixels() on it fail, so getImageData() and
+// putImageData() don't work on a CanvasContext2D that draws into it.
+class CanvasPipeline
+{
+public:
+	CanvasPipeline(int width, int height);
+	~CanvasPipeline();
+
+	// The canvas to record into. Script thread only.
+	SkCanvas* canvas() const { return m_canvas; }
+
+	// Ends the frame recorded since the last call and hands it to the render thread.
+	// Script thread only.
+	void endFrame();
+
+	// Stops recording. Once the render thread has played back everything recorded before, the
+	// next playFrame() returns false. Script thread only.
+	void close();
+
+	// Plays back the next frame into target, waiting for the script thread to record it.
+	// Returns false if the pipeline was closed. Render thread only.
+	bool playFrame(SkCanvas* target);
+
+private:
+	SkGPipeRingController m_ring;
+	SkGPipeWriter m_writer;
+	SkGPipeReader m_reader;
+	SkCanvas* m_canvas;
+};
+
+#endif
@@ -8,6 +8,7 @@ LOCAL_ARM_MODE := arm
 LOCAL_MODULE := canvascontext2d
 
 LOCAL_CFLAGS += -DUSE_MMAP\
+				-DSK_USE_POSIX_THREADS\
 				-fexceptions
 				
 LOCAL_C_INCLUDES := $../../CanvasContext/Canvas2D \
@@ -18,6 +19,8 @@ LOCAL_C_INCLUDES := $../../CanvasContext/Canvas2D \
 					$../../skia/include/config \
 					$../../skia/include/effects \
 					$../../skia/include/gpu \
+					$../../skia/include/pipe \
+					$../../skia/src/pipe/utils \
 					$../thirdparty/v8 \
 				
 
@@ -41,6 +44,7 @@ LOCAL_SRC_FILES	+=  \
 					../../../CanvasContext/Canvas2D/CanvasContext2D.cpp \
 					../../../CanvasContext/Canvas2D/CanvasGradient.cpp \
 					../../../CanvasContext/Canvas2D/CanvasPattern.cpp \
+					../../../CanvasContext/Canvas2D/CanvasPipeline.cpp \
 					../../../CanvasContext/Canvas2D/CanvasStyle.cpp \
 					../../../CanvasContext/Canvas2D/Color.cpp \
 					../../../CanvasContext/Canvas2D/ColorData.cpp \
@@ -11,6 +11,7 @@ LOCAL_CFLAGS += \
 				-DSK_SUPPORT_GPU \
 				-DSK_FONTHOST_DOES_NOT_USE_FONTMGR \
 				-DSK_IGNORE_ETC1_SUPPORT \
+				-DSK_USE_POSIX_THREADS \
 				-DGL_GLEXT_PROTOTYPES \
 				-fexceptions
 #				-fshort-wchar	
@@ -127,6 +128,7 @@ LOCAL_SRC_FILES	+=  \
 	../../../skia/src/core/SkLocalMatrixShader.cpp \
 	../../../skia/src/core/SkLineClipper.cpp \
 	../../../skia/src/core/SkMallocPixelRef.cpp \
+	../../../skia/src/core/SkMappedRecord.cpp \
 	../../../skia/src/core/SkMask.cpp \
 	../../../skia/src/core/SkMaskFilter.cpp \
 	../../../skia/src/core/SkMaskGamma.cpp \
@@ -160,6 +162,7 @@ LOCAL_SRC_FILES	+=  \
 	../../../skia/src/core/SkRasterClip.cpp \
 	../../../skia/src/core/SkRasterizer.cpp \
 	../../../skia/src/core/SkReadBuffer.cpp \
+	../../../skia/src/core/SkRecordDiff.cpp \
 	../../../skia/src/core/SkRecordDraw.cpp \
 	../../../skia/src/core/SkRecordOpts.cpp \
 	../../../skia/src/core/SkRecorder.cpp \
@@ -208,6 +211,7 @@ LOCAL_SRC_FILES	+=  \
 	../../../skia/src/image/SkSurface_Raster.cpp \
 	../../../skia/src/pipe/SkGPipeRead.cpp \
 	../../../skia/src/pipe/SkGPipeWrite.cpp \
+	../../../skia/src/pipe/utils/SkGPipeRingController.cpp \
 	../../../skia/src/lazy/SkCachingPixelRef.cpp \
 	../../../skia/src/pathops/SkAddIntersections.cpp \
 	../../../skia/src/pathops/SkDCubicIntersection.cpp \
@@ -375,6 +379,7 @@ LOCAL_SRC_FILES	+=  \
 	../../../skia/src/gpu/GrAddPathRenderers_default.cpp \
 	../../../skia/src/gpu/GrAllocPool.cpp \
 	../../../skia/src/gpu/GrAtlas.cpp \
+	../../../skia/src/gpu/GrBitmapAtlas.cpp \
 	../../../skia/src/gpu/GrBitmapTextContext.cpp \
 	../../../skia/src/gpu/GrBlend.cpp \
 	../../../skia/src/gpu/GrBufferAllocPool.cpp \
@@ -386,6 +391,7 @@ LOCAL_SRC_FILES	+=  \
 	../../../skia/src/gpu/GrDistanceFieldTextContext.cpp \
 	../../../skia/src/gpu/GrDrawState.cpp \
 	../../../skia/src/gpu/GrDrawTarget.cpp \
+	../../../skia/src/gpu/GrFilePersistentCache.cpp \
 	../../../skia/src/gpu/GrEffect.cpp \
 	../../../skia/src/gpu/GrClipMaskCache.cpp \
 	../../../skia/src/gpu/GrClipMaskManager.cpp \
@@ -446,6 +452,7 @@ LOCAL_SRC_FILES	+=  \
 	../../../skia/src/gpu/gl/GrGLProgram.cpp \
 	../../../skia/src/gpu/gl/GrGLProgramDesc.cpp \
 	../../../skia/src/gpu/gl/GrGLProgramEffects.cpp \
+	../../../skia/src/gpu/gl/GrGLPersistentProgramCache.cpp \
 	../../../skia/src/gpu/gl/GrGLRenderTarget.cpp \
 	../../../skia/src/gpu/gl/GrGLShaderBuilder.cpp \
 	../../../skia/src/gpu/gl/GrGLSL.cpp \
@@ -494,6 +501,7 @@ LOCAL_SRC_FILES += \
 	../../../skia/src/opts/SkBlitMask_opts_none.cpp \
 	../../../skia/src/opts/SkBlitRow_opts_none.cpp \
 	../../../skia/src/opts/SkBlurImage_opts_none.cpp \
+	../../../skia/src/opts/SkMipMap_opts_none.cpp \
 	../../../skia/src/opts/SkMorphology_opts_none.cpp \
 	../../../skia/src/opts/SkUtils_opts_none.cpp \
 	../../../skia/src/opts/SkXfermode_opts_none.cpp
@@ -6,6 +6,7 @@
 
 
 #include "CanvasContext2D.h"
+#include "CanvasPipeline.h"
 #include "PassOwnPtr.h"
 #include "SkiaUtils.h"
 #include "CanvasGradient.h"
@@ -30,6 +31,10 @@ SkCanvas *gCanvas;
 
 
 EgretGame::EgretGame()
+	: mPipeline(NULL)
+	, mFramesRequested(0)
+	, mFrameTime(0)
+	, mStopScript(false)
 {
 	SkForceLinking(false);
 }
@@ -62,13 +67,32 @@ void EgretGame::initialize()
 	gCanvas = fCanvas;
     setMultiTouch(true); 
 
-	mJSEngine.init();
-
+	Properties* config = getConfig()->getNamespace("canvas", true);
+	if (config && config->getBool("pipelined"))
+	{
+		// The script records into the pipeline on its own thread, and render() rasterizes on
+		// this one, which owns the GL context. Ask for the first frame now, so that the script
+		// always records one frame ahead of the one being rasterized.
+		mPipeline = new CanvasPipeline(iw, ih);
+		gCanvas = mPipeline->canvas();
+		mScriptThread.reset(new std::thread(&EgretGame::runScript, this));
+		requestFrame(0);
+	}
+	else
+	{
+		mJSEngine.init();
+	}
 }
 
 void EgretGame::update(float elapsedTime)
 {
 	clear(CLEAR_COLOR_DEPTH, Vector4(1, 1, 1, 1), 1.0f, 0);
+	if (mPipeline)
+	{
+		// Let the script record the next frame while render() rasterizes this one.
+		requestFrame(elapsedTime);
+		return;
+	}
 	mJSEngine.update(elapsedTime);
 
 	//SkPaint paint;
@@ -92,18 +116,74 @@ void EgretGame::update(float elapsedTime)
 
 void EgretGame::render(float elapsedTime)
 {
-	mJSEngine.render( elapsedTime );
+	if (mPipeline)
+		mPipeline->playFrame(fCanvas);
+	else
+		mJSEngine.render( elapsedTime );
 	fCurContext->flush();
 }
 
 void EgretGame::finalize()
 {
-	mJSEngine.uninit();
+	if (mPipeline)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mFrameMutex);
+			mStopScript = true;
+		}
+		mFrameRequested.notify_one();
+		// The script thread may be waiting for room in the pipeline: play back what is left
+		// until it closes the pipeline.
+		while (mPipeline->playFrame(fCanvas))
+			;
+		mScriptThread->join();
+		mScriptThread.reset(NULL);
+		delete mPipeline;
+		mPipeline = NULL;
+	}
+	else
+	{
+		mJSEngine.uninit();
+	}
 	delete fCurContext;
 	delete fCurRenderTarget;
 	delete fCanvas;
 }
 
+void EgretGame::runScript()
+{
+	mJSEngine.init();
+	for (;;)
+	{
+		float elapsedTime;
+		{
+			std::unique_lock<std::mutex> lock(mFrameMutex);
+			while (!mFramesRequested && !mStopScript)
+				mFrameRequested.wait(lock);
+			if (mStopScript)
+				break;
+			--mFramesRequested;
+			elapsedTime = mFrameTime;
+			mFrameTime = 0;
+		}
+		mJSEngine.update(elapsedTime);
+		mJSEngine.render(elapsedTime);
+		mPipeline->endFrame();
+	}
+	mJSEngine.uninit();
+	mPipeline->close();
+}
+
+void EgretGame::requestFrame(float elapsedTime)
+{
+	{
+		std::lock_guard<std::mutex> lock(mFrameMutex);
+		++mFramesRequested;
+		mFrameTime += elapsedTime;
+	}
+	mFrameRequested.notify_one();
+}
+
 void EgretGame::drawSplash(void* param)
 {
 	//SkPaint paint;
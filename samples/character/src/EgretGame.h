@@ -6,6 +6,9 @@
 using namespace gameplay;
 
 #include "JSEngine.h"
+#include <condition_variable>
+
+class CanvasPipeline;
 
 /**
  * This is a mesh demo game for rendering Mesh.
@@ -79,12 +82,28 @@ private:
     void drawSplash(void* param);
 	bool visitDrawNode(Node* node, void *cookie);
 
+	/**
+	 * In pipelined mode, runs the script on its own thread: each frame asked for by
+	 * requestFrame() is recorded into mPipeline, and played back by render() on this thread.
+	 */
+	void runScript();
+	void requestFrame(float elapsedTime);
+
 	GrContext *fCurContext;
 	GrRenderTarget *fCurRenderTarget;
 	SkCanvas * fCanvas;
 
 	JSEngine mJSEngine;
 
+	// Pipelined mode, set by "pipelined = true" in the canvas section of game.config.
+	CanvasPipeline* mPipeline;
+	std::unique_ptr<std::thread> mScriptThread;
+	std::mutex mFrameMutex;
+	std::condition_variable mFrameRequested;
+	int mFramesRequested;
+	float mFrameTime;
+	bool mStopScript;
+
 };
 
 #endif
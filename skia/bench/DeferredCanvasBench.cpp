@@ -5,9 +5,16 @@
  * found in the LICENSE file.
  */
 #include "Benchmark.h"
+#include "BenchTimer.h"
+#include "SkCommandLineFlags.h"
 #include "SkDeferredCanvas.h"
 #include "SkDevice.h"
 #include "SkString.h"
+#include "SkSurface.h"
+#include "SkTSort.h"
+
+DEFINE_bool(deferredLatency, false,
+            "Log recording latency percentiles when DeferredRecordBench is done.");
 
 class DeferredCanvasBench : public Benchmark {
 public:
@@ -24,19 +31,21 @@ protected:
         return fName.c_str();
     }
 
-    virtual void onDraw(const int loops, SkCanvas* canvas) {
-#if 0   // what specifically are we interested in timing here?
-        SkBaseDevice *device = canvas->getDevice()->createCompatibleDevice(
-            SkBitmap::kARGB_8888_Config, CANVAS_WIDTH, CANVAS_HEIGHT, false);
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fSurface.reset(SkSurface::NewRasterPMColor(CANVAS_WIDTH, CANVAS_HEIGHT));
+    }
 
-        SkAutoTUnref<SkDeferredCanvas> deferredCanvas(SkDeferredCanvas::Create(device));
-        device->unref();
+    virtual void onDraw(const int loops, SkCanvas* canvas) {
+        SkAutoTUnref<SkDeferredCanvas> deferredCanvas(SkDeferredCanvas::Create(fSurface));
 
         initDeferredCanvas(deferredCanvas);
         drawInDeferredCanvas(loops, deferredCanvas);
         finalizeDeferredCanvas(deferredCanvas);
         deferredCanvas->flush();
-#endif
     }
 
     virtual void initDeferredCanvas(SkDeferredCanvas* canvas) = 0;
@@ -46,6 +55,8 @@ protected:
     SkString fName;
 
 private:
+    SkAutoTUnref<SkSurface> fSurface;
+
     typedef Benchmark INHERITED;
 };
 
@@ -65,17 +76,44 @@ private:
 
 // Test that records very simple draw operations.
 // This benchmark aims to capture performance fluctuations in the recording
-// overhead of SkDeferredCanvas
+// overhead of SkDeferredCanvas. With a command limit, the flushes it triggers
+// happen in the middle of recording, either on the recording thread or in the
+// background. With --deferredLatency, the time each draw takes to record is
+// logged as percentiles when the bench is done, since the flushes show up in
+// the tail rather than in the mean.
 class DeferredRecordBench : public DeferredCanvasBench {
 public:
-    DeferredRecordBench()
-        : INHERITED("record") {
+    enum FlushMode {
+        kNone_FlushMode,
+        kSync_FlushMode,
+        kAsync_FlushMode,
+    };
+
+    DeferredRecordBench(FlushMode flushMode)
+        : INHERITED(kNone_FlushMode == flushMode ? "record" :
+                    kSync_FlushMode == flushMode ? "record_flush_sync" : "record_flush_async")
+        , fFlushMode(flushMode)
+        , fNextSample(0)
+        , fSampleCount(0) {
+    }
+
+    virtual ~DeferredRecordBench() {
+        this->reportLatencies();
     }
 
 protected:
+    enum {
+        // Four commands per draw.
+        kMaxRecordingCommands = 4096,
+        kMaxSamples = 1 << 16,
+    };
 
     virtual void initDeferredCanvas(SkDeferredCanvas* canvas) SK_OVERRIDE {
         canvas->setNotificationClient(&fNotificationClient);
+        if (kNone_FlushMode != fFlushMode) {
+            canvas->setMaxRecordingCommands(kMaxRecordingCommands);
+            canvas->setAsyncFlush(kAsync_FlushMode == fFlushMode);
+        }
     }
 
     virtual void drawInDeferredCanvas(const int loops, SkDeferredCanvas* canvas) SK_OVERRIDE {
@@ -83,10 +121,17 @@ protected:
         rect.setXYWH(0, 0, 10, 10);
         SkPaint paint;
         for (int i = 0; i < loops; i++) {
-            canvas->save();
-            canvas->translate(SkIntToScalar(i * 27 % CANVAS_WIDTH), SkIntToScalar(i * 13 % CANVAS_HEIGHT));
-            canvas->drawRect(rect, paint);
-            canvas->restore();
+            if (!FLAGS_deferredLatency) {
+                this->drawOne(i, rect, paint, canvas);
+                continue;
+            }
+            fTimer.start();
+            this->drawOne(i, rect, paint, canvas);
+            fTimer.end();
+            // Keeps the latest samples.
+            fLatencies[fNextSample] = SkDoubleToScalar(fTimer.fWall);
+            fNextSample = (fNextSample + 1) % kMaxSamples;
+            fSampleCount = SkMin32(fSampleCount + 1, kMaxSamples);
         }
     }
 
@@ -96,11 +141,40 @@ protected:
     }
 
 private:
+    void drawOne(int i, const SkRect& rect, const SkPaint& paint, SkDeferredCanvas* canvas) {
+        canvas->save();
+        canvas->translate(SkIntToScalar(i * 27 % CANVAS_WIDTH), SkIntToScalar(i * 13 % CANVAS_HEIGHT));
+        canvas->drawRect(rect, paint);
+        canvas->restore();
+    }
+
+    void reportLatencies() {
+        int count = fSampleCount;
+        if (0 == count) {
+            return;
+        }
+        SkTQSort(fLatencies, fLatencies + count - 1);
+        // Milliseconds to microseconds.
+        const SkScalar scale = 1000;
+        SkDebugf("%s: recording latency of %d draws in us: p50 %.2f p90 %.2f p99 %.2f "
+                 "p99.9 %.2f max %.2f\n", fName.c_str(), count,
+                 fLatencies[count * 50 / 100] * scale, fLatencies[count * 90 / 100] * scale,
+                 fLatencies[count * 99 / 100] * scale, fLatencies[count * 999 / 1000] * scale,
+                 fLatencies[count - 1] * scale);
+    }
+
     typedef DeferredCanvasBench INHERITED;
     SimpleNotificationClient fNotificationClient;
+    const FlushMode fFlushMode;
+    WallTimer fTimer;
+    SkScalar fLatencies[kMaxSamples];
+    int fNextSample;
+    int fSampleCount;
 };
 
 
 ///////////////////////////////////////////////////////////////////////////////
 
-DEF_BENCH( return new DeferredRecordBench(); )
+DEF_BENCH( return new DeferredRecordBench(DeferredRecordBench::kNone_FlushMode); )
+DEF_BENCH( return new DeferredRecordBench(DeferredRecordBench::kSync_FlushMode); )
+DEF_BENCH( return new DeferredRecordBench(DeferredRecordBench::kAsync_FlushMode); )
@@ -10,7 +10,9 @@
 #include "SkFontHost.h"
 #include "SkPaint.h"
 #include "SkString.h"
+#include "SkTDArray.h"
 #include "SkTemplates.h"
+#include "SkTypeface.h"
 
 #include "gUniqueGlyphIDs.h"
 #define gUniqueGlyphIDs_Sentinel    0xFFFF
@@ -53,6 +55,75 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Draws a working set of glyphs comparable to a page of CJK text: a few thousand distinct glyphs,
+// most of them large, every frame. On the GPU this is more than fits in a single page of the
+// glyph atlas, so it measures the cost of plot eviction, atlas uploads and any flushes they cause.
+// Run it with the NULLGPU config to exclude driver time.
+class FontCacheAtlasBench : public Benchmark {
+public:
+    FontCacheAtlasBench() : fSizeCount(0) {}
+
+protected:
+    enum {
+        kWorkingSetGlyphs = 3000,
+        kMaxGlyphsPerSize = 2048,
+        kGlyphsPerRow = 32,
+        kFirstTextSize = 28,
+    };
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return kGPU_Backend == backend;
+    }
+
+    virtual const char* onGetName() SK_OVERRIDE {
+        return "fontcache_atlas_cjk";
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        // The default typeface rarely has thousands of glyphs, so we make up the working set by
+        // drawing the glyphs it has at several sizes. Each size is a separate strike.
+        SkAutoTUnref<SkTypeface> typeface(SkTypeface::RefDefault());
+        int glyphCount = SkTMin(typeface->countGlyphs(), (int)kMaxGlyphsPerSize);
+        fGlyphs.setCount(SkTMax(glyphCount - 1, 0));
+        for (int i = 0; i < fGlyphs.count(); ++i) {
+            fGlyphs[i] = SkToU16(i + 1);   // skip the missing glyph
+        }
+        fSizeCount = fGlyphs.isEmpty() ? 0 :
+                     (kWorkingSetGlyphs + fGlyphs.count() - 1) / fGlyphs.count();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+
+        SkScalar height = SkIntToScalar(canvas->getDeviceSize().height());
+        for (int i = 0; i < loops; ++i) {
+            SkScalar y = 0;
+            for (int size = 0; size < fSizeCount; ++size) {
+                SkScalar textSize = SkIntToScalar(kFirstTextSize + 4 * size);
+                paint.setTextSize(textSize);
+                for (int start = 0; start < fGlyphs.count(); start += kGlyphsPerRow) {
+                    int count = SkTMin((int)kGlyphsPerRow, fGlyphs.count() - start);
+                    y += textSize;
+                    if (y > height) {
+                        y = textSize;
+                    }
+                    canvas->drawText(&fGlyphs[start], count * sizeof(uint16_t), 0, y, paint);
+                }
+            }
+        }
+    }
+
+private:
+    SkTDArray<uint16_t> fGlyphs;
+    int                 fSizeCount;
+
+    typedef Benchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 static uint32_t rotr(uint32_t value, unsigned bits) {
     return (value >> bits) | (value << (32 - bits));
 }
@@ -153,6 +224,7 @@ private:
 ///////////////////////////////////////////////////////////////////////////////
 
 DEF_BENCH( return new FontCacheBench(); )
+DEF_BENCH( return new FontCacheAtlasBench(); )
 
 // undefine this to run the efficiency test
 //DEF_BENCH( return new FontCacheEfficiency(); )
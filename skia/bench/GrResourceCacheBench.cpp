@@ -233,7 +233,121 @@ private:
     typedef Benchmark INHERITED;
 };
 
+class SizedResource : public GrCacheable {
+public:
+    SK_DECLARE_INST_COUNT(SizedResource);
+    SizedResource(size_t size)
+        : fSize(size) {
+    }
+
+    virtual size_t gpuMemorySize() const SK_OVERRIDE {
+        return fSize;
+    }
+
+    virtual bool isValidOnGpu() const SK_OVERRIDE {
+        return true;
+    }
+
+private:
+    size_t fSize;
+
+    typedef GrCacheable INHERITED;
+};
+
+// Simulates frames that mix small sprite textures, looked up by content, with large scratch
+// layers and stencil buffers. Each frame uses a window of the sprites that moves slowly, so most
+// lookups hit, and a few layers of varying sizes. The scratch category has a limit of its own
+// and resources unused for a few frames are purged by age, so this measures the cost of the
+// per-category bookkeeping and of the purges on top of find and add.
+class GrResourceCacheBenchMixed : public Benchmark {
+    enum {
+        SPRITE_COUNT = 1024,
+        SPRITES_PER_FRAME = 256,
+        SPRITE_STEP = 16,
+        SPRITE_BYTES = 32 * 32 * 4,
+        LAYERS_PER_FRAME = 4,
+        LAYER_SIZES = 7,
+        LAYER_BYTES = 128 * 128 * 4,
+        FRAMES = 32,
+        MAX_UNUSED_FLUSHES = 8,
+    };
+
+public:
+    GrResourceCacheBenchMixed() {
+        fDomain = GrCacheID::GenerateDomain();
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kGPU_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return "grresourcecache_mixed";
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
+        GrGpu* gpu = canvas->getGrContext()->getGpu();
+
+        for (int i = 0; i < loops; ++i) {
+            GrResourceCache cache(CACHE_SIZE_COUNT, CACHE_SIZE_BYTES);
+            cache.setCategoryLimit(kScratch_GrResourceCategory, CACHE_SIZE_BYTES / 4);
+            cache.setMaxUnusedFlushes(MAX_UNUSED_FLUSHES);
+
+            for (int frame = 0; frame < FRAMES; ++frame) {
+                int firstSprite = frame * SPRITE_STEP;
+                for (int k = 0; k < SPRITES_PER_FRAME; ++k) {
+                    this->findOrAdd(&cache, this->spriteKey(gpu, (firstSprite + k) % SPRITE_COUNT),
+                                    SPRITE_BYTES);
+                }
+                for (int k = 0; k < LAYERS_PER_FRAME; ++k) {
+                    int size = (frame + k) % LAYER_SIZES;
+                    GrTextureDesc desc;
+                    desc.fFlags = kRenderTarget_GrTextureFlagBit;
+                    desc.fWidth = 128 << (size % 3);
+                    desc.fHeight = 128 + 64 * size;
+                    desc.fConfig = kSkia8888_GrPixelConfig;
+                    this->findOrAdd(&cache, TextureResource::ComputeKey(desc),
+                                    LAYER_BYTES << (size % 3));
+                    this->findOrAdd(&cache,
+                                    StencilResource::ComputeKey(desc.fWidth, desc.fHeight, 0),
+                                    desc.fWidth * desc.fHeight);
+                }
+                cache.didFlush();
+            }
+            cache.purgeAllUnlocked();
+        }
+    }
+
+private:
+    GrResourceKey spriteKey(GrGpu* gpu, int index) const {
+        GrCacheID::Key key;
+        memset(&key, 0, sizeof(key));
+        key.fData32[0] = index;
+        GrTextureDesc desc;
+        desc.fWidth = 32;
+        desc.fHeight = 32;
+        desc.fConfig = kSkia8888_GrPixelConfig;
+        return GrTextureImpl::ComputeKey(gpu, NULL, desc, GrCacheID(fDomain, key));
+    }
+
+    void findOrAdd(GrResourceCache* cache, const GrResourceKey& key, size_t bytes) {
+        if (NULL != cache->find(key)) {
+            return;
+        }
+        GrCacheable* resource = SkNEW_ARGS(SizedResource, (bytes));
+        cache->purgeAsNeeded(1, bytes);
+        cache->addResource(key, resource);
+        resource->unref();
+    }
+
+    GrCacheID::Domain fDomain;
+
+    typedef Benchmark INHERITED;
+};
+
 DEF_BENCH( return new GrResourceCacheBenchAdd(); )
 DEF_BENCH( return new GrResourceCacheBenchFind(); )
+DEF_BENCH( return new GrResourceCacheBenchMixed(); )
 
 #endif
@@ -623,6 +623,62 @@ private:
 };
 
 
+// Fills thousands of tiny, non-convex paths per frame (e.g. glyph-like shapes
+// or map symbols). The per-path cost is dominated by setting up edges rather
+// than by blitting, so this measures the overhead of the edge builder.
+class ManySmallPathsBench : public Benchmark {
+    enum {
+        kPathCount = 1000,
+    };
+
+    SkString            fName;
+    bool                fAA;
+    SkTArray<SkPath>    fPaths;
+
+public:
+    ManySmallPathsBench(bool aa) : fAA(aa) {
+        fName.printf("path_many_small_%s", aa ? "aa" : "bw");
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkRandom rand;
+        fPaths.reset();
+        for (int i = 0; i < kPathCount; ++i) {
+            SkScalar x = rand.nextUScalar1() * 600;
+            SkScalar y = rand.nextUScalar1() * 600;
+            SkScalar size = 4 + rand.nextUScalar1() * 12;
+
+            SkPath* path = &fPaths.push_back();
+            path->moveTo(x, y);
+            path->lineTo(x + size, y + size * SK_ScalarHalf);
+            path->lineTo(x, y + size);
+            path->lineTo(x + size * SK_ScalarHalf, y + size * SK_ScalarHalf);
+            if (i & 1) {
+                path->quadTo(x + size, y, x + size * SK_ScalarHalf, y);
+            }
+            path->close();
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
+        SkPaint paint;
+        paint.setColor(SK_ColorBLACK);
+        paint.setAntiAlias(fAA);
+
+        for (int i = 0; i < loops; ++i) {
+            canvas->drawPath(fPaths[i % kPathCount], paint);
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
 // Chrome creates its own round rects with each corner possibly being different.
 // In its "zero radius" incarnation it creates degenerate round rects.
 // Note: PathTest::test_arb_round_rect_is_convex and
@@ -1006,6 +1062,8 @@ DEF_BENCH( return new SkBench_AddPathTest(SkBench_AddPathTest::kReversePathTo_Ad
 
 DEF_BENCH( return new CirclesBench(FLAGS00); )
 DEF_BENCH( return new CirclesBench(FLAGS01); )
+DEF_BENCH( return new ManySmallPathsBench(false); )
+DEF_BENCH( return new ManySmallPathsBench(true); )
 DEF_BENCH( return new ArbRoundRectBench(false); )
 DEF_BENCH( return new ArbRoundRectBench(true); )
 DEF_BENCH( return new ConservativelyContainsBench(ConservativelyContainsBench::kRect_Type); )
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SkPath.h"
+#include "SkPathOps.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkTArray.h"
+
+// Builds a closed, wavy and slightly jagged outline around (cx, cy) with the
+// given number of segments, similar to a coastline or a border in map data.
+static void make_outline(SkPath* path, SkRandom& rand, SkScalar cx, SkScalar cy,
+                         SkScalar radius, int segments) {
+    for (int i = 0; i < segments; ++i) {
+        SkScalar angle = SK_ScalarPI * 2 * i / segments;
+        SkScalar r = radius * (1 + SkScalarSin(angle * 7) / 10) + rand.nextUScalar1();
+        SkPoint pt = SkPoint::Make(cx + r * SkScalarCos(angle), cy + r * SkScalarSin(angle));
+        if (0 == i) {
+            path->moveTo(pt);
+        } else {
+            path->lineTo(pt);
+        }
+    }
+    path->close();
+}
+
+/**
+ *  Unions two large outlines, each made of many segments. Without a broad
+ *  phase, finding their intersections tests every pair of segments, so the
+ *  cost grows with the square of the segment count.
+ */
+class PathOpsOutlineUnionBench : public Benchmark {
+    SkString    fName;
+    SkPath      fOne;
+    SkPath      fTwo;
+
+public:
+    PathOpsOutlineUnionBench(int segments) {
+        fName.printf("pathops_union_outline_%d", segments);
+
+        SkRandom rand;
+        make_outline(&fOne, rand, 300, 300, 200, segments);
+        make_outline(&fTwo, rand, 400, 350, 200, segments);
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; ++i) {
+            SkPath result;
+            Op(fOne, fTwo, kUnion_PathOp, &result);
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+/**
+ *  Simplifies one path made of many small overlapping polygons scattered over
+ *  a tile, as produced when merging the building footprints of a map tile.
+ */
+class PathOpsSimplifyTileBench : public Benchmark {
+    SkString    fName;
+    SkPath      fPath;
+
+public:
+    PathOpsSimplifyTileBench(int count) {
+        fName.printf("pathops_simplify_tile_%d", count);
+
+        SkRandom rand;
+        for (int i = 0; i < count; ++i) {
+            make_outline(&fPath, rand, rand.nextUScalar1() * 512, rand.nextUScalar1() * 512,
+                         8 + rand.nextUScalar1() * 16, 4 + rand.nextU() % 12);
+        }
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; ++i) {
+            SkPath result;
+            Simplify(fPath, &result);
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+/**
+ *  Unions many small polygons into one path, either with a single call to the
+ *  N path Op or with one two path Op per polygon.
+ */
+class PathOpsUnionManyBench : public Benchmark {
+    SkString        fName;
+    SkTArray<SkPath> fPaths;
+    bool            fBatch;
+
+public:
+    PathOpsUnionManyBench(int count, bool batch) : fBatch(batch) {
+        fName.printf("pathops_union_many_%d_%s", count, batch ? "batch" : "pairwise");
+
+        SkRandom rand;
+        for (int i = 0; i < count; ++i) {
+            make_outline(&fPaths.push_back(), rand, rand.nextUScalar1() * 512,
+                         rand.nextUScalar1() * 512, 8 + rand.nextUScalar1() * 16,
+                         4 + rand.nextU() % 12);
+        }
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; ++i) {
+            SkPath result;
+            if (fBatch) {
+                Op(fPaths.begin(), fPaths.count(), kUnion_PathOp, &result);
+            } else {
+                for (int j = 0; j < fPaths.count(); ++j) {
+                    Op(result, fPaths[j], kUnion_PathOp, &result);
+                }
+            }
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+DEF_BENCH( return SkNEW_ARGS(PathOpsOutlineUnionBench, (100)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsOutlineUnionBench, (1000)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsOutlineUnionBench, (4000)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsOutlineUnionBench, (16000)); )
+
+DEF_BENCH( return SkNEW_ARGS(PathOpsSimplifyTileBench, (100)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsSimplifyTileBench, (1000)); )
+
+DEF_BENCH( return SkNEW_ARGS(PathOpsUnionManyBench, (100, true)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsUnionManyBench, (100, false)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsUnionManyBench, (1000, true)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsUnionManyBench, (1000, false)); )
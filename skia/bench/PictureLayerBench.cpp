@@ -0,0 +1,103 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SkCanvas.h"
+#include "SkPaint.h"
+#include "SkPicture.h"
+#include "SkPictureRecorder.h"
+#include "SkRect.h"
+#include "SkString.h"
+
+// Draws a picture made of many small translucent saveLayers, like the shadowed or
+// faded cards of a web page. On the GPU the layers are pre-rendered into the layer
+// cache by EXPERIMENTAL_drawPicture, so after the first draw only the cached layers
+// are composited.
+class PictureLayerBench : public Benchmark {
+public:
+    PictureLayerBench(int layerSize, bool optimize)
+        : fLayerSize(layerSize)
+        , fOptimize(optimize) {
+        fName.printf("picture_layers_%d%s", layerSize, optimize ? "_optimized" : "");
+    }
+
+    enum {
+        kPictureWidth = 1024,
+        kPictureHeight = 1024,
+        kShapesPerLayer = 8,
+    };
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return kGPU_Backend == backend;
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(kPictureWidth, kPictureHeight, NULL, 0);
+
+        SkPaint layerPaint;
+        layerPaint.setAlpha(0x80);
+
+        SkPaint paint;
+        paint.setAntiAlias(true);
+
+        const SkScalar size = SkIntToScalar(fLayerSize);
+        int color = 0;
+        for (int y = 0; y + fLayerSize <= kPictureHeight; y += fLayerSize + fLayerSize / 4) {
+            for (int x = 0; x + fLayerSize <= kPictureWidth; x += fLayerSize + fLayerSize / 4) {
+                SkRect bounds = SkRect::MakeXYWH(SkIntToScalar(x), SkIntToScalar(y),
+                                                 size, size);
+                canvas->saveLayer(&bounds, &layerPaint);
+                for (int i = 0; i < kShapesPerLayer; ++i) {
+                    paint.setColor(0xFF000000 | (0x3F1F0F * ++color));
+                    SkScalar inset = size * i / (2 * kShapesPerLayer);
+                    SkRect r = bounds;
+                    r.inset(inset, inset);
+                    if (i & 1) {
+                        canvas->drawOval(r, paint);
+                    } else {
+                        canvas->drawRect(r, paint);
+                    }
+                }
+                canvas->restore();
+            }
+        }
+
+        fPicture.reset(recorder.endRecording());
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
+        if (fOptimize) {
+            canvas->EXPERIMENTAL_optimize(fPicture);
+        }
+
+        for (int i = 0; i < loops; ++i) {
+            canvas->drawPicture(fPicture);
+        }
+
+        if (fOptimize) {
+            canvas->EXPERIMENTAL_purge(fPicture);
+        }
+    }
+
+private:
+    int                     fLayerSize;
+    bool                    fOptimize;
+    SkString                fName;
+    SkAutoTUnref<SkPicture> fPicture;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(PictureLayerBench, (32, false)); )
+DEF_BENCH( return SkNEW_ARGS(PictureLayerBench, (32, true)); )
+DEF_BENCH( return SkNEW_ARGS(PictureLayerBench, (128, false)); )
+DEF_BENCH( return SkNEW_ARGS(PictureLayerBench, (128, true)); )
@@ -7,7 +7,9 @@
 #include "Benchmark.h"
 #include "SkCanvas.h"
 #include "SkColor.h"
+#include "SkGradientShader.h"
 #include "SkPaint.h"
+#include "SkPath.h"
 #include "SkPicture.h"
 #include "SkPictureRecorder.h"
 #include "SkPoint.h"
@@ -171,8 +173,72 @@ private:
     typedef PictureRecordBench INHERITED;
 };
 
+/*
+ *  Records draws that set their paint up again before each draw, but only ever switch it between
+ *  a few settings, as views that share one paint object do. Also draws the same path and bitmap
+ *  again and again.
+ */
+class ChurningPaintRecordBench : public PictureRecordBench {
+public:
+    ChurningPaintRecordBench() : INHERITED("churning_paint") {
+        static const SkColor kColors[] = { SK_ColorRED, SK_ColorBLUE };
+        static const SkPoint kPoints[] = { { 0, 0 }, { SkIntToScalar(16), SkIntToScalar(16) } };
+        fShader.reset(SkGradientShader::CreateLinear(kPoints, kColors, NULL,
+                                                     SK_ARRAY_COUNT(kColors),
+                                                     SkShader::kClamp_TileMode));
+        fPath.addCircle(SkIntToScalar(8), SkIntToScalar(8), SkIntToScalar(8));
+        fBitmap.allocN32Pixels(16, 16);
+        fBitmap.eraseColor(SK_ColorBLUE);
+    }
+
+    enum {
+        ColorCount = 4,
+    };
+protected:
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        static const SkColor kColors[ColorCount] = {
+            SK_ColorRED, SK_ColorGREEN, SK_ColorBLACK, SK_ColorYELLOW
+        };
+
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = NULL;
+        SkPaint paint;
+        for (int i = 0; i < loops; i++) {
+            if (0 == i % kMaxLoopsPerCanvas) {
+                SkAutoTUnref<SkPicture> picture(recorder.endRecording());
+                canvas = recorder.beginRecording(PICTURE_WIDTH, PICTURE_HEIGHT, NULL, 0);
+            }
+            const SkRect rect = SkRect::MakeXYWH(SkIntToScalar(i % PICTURE_WIDTH),
+                                                 SkIntToScalar(i % PICTURE_HEIGHT),
+                                                 SkIntToScalar(16), SkIntToScalar(16));
+
+            paint.setColor(kColors[i % ColorCount]);
+            paint.setStyle(SkPaint::kFill_Style);
+            canvas->drawRect(rect, paint);
+
+            paint.setStyle(SkPaint::kStroke_Style);
+            paint.setStrokeWidth(SkIntToScalar(2));
+            canvas->drawPath(fPath, paint);
+
+            paint.setStyle(SkPaint::kFill_Style);
+            paint.setShader(fShader);
+            canvas->drawOval(rect, paint);
+            paint.setShader(NULL);
+
+            canvas->drawBitmap(fBitmap, rect.fLeft, rect.fTop);
+        }
+    }
+
+private:
+    SkAutoTUnref<SkShader> fShader;
+    SkPath                 fPath;
+    SkBitmap               fBitmap;
+    typedef PictureRecordBench INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 DEF_BENCH( return new DictionaryRecordBench(); )
 DEF_BENCH( return new UniquePaintDictionaryRecordBench(); )
 DEF_BENCH( return new RecurringPaintDictionaryRecordBench(); )
+DEF_BENCH( return new ChurningPaintRecordBench(); )
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SamplePipeControllers.h"
+#include "SkCanvas.h"
+#include "SkGPipe.h"
+#include "SkGPipeRingController.h"
+#include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkString.h"
+
+// Measures how fast draws go through an SkGPipe into a raster canvas: either played back by the
+// recording thread as they are written (PipeController), or played back on a reader thread while
+// the next ones are written (SkGPipeRingController). Each loop is kOpsPerLoop draws, so the
+// throughput in ops/sec is kOpsPerLoop divided by the time per loop.
+class PipeControllerBench : public Benchmark {
+public:
+    explicit PipeControllerBench(bool ring) : fRing(ring) {
+        fName.printf("pipe_controller_%s_%d", ring ? "ring" : "sync", kOpsPerLoop);
+    }
+
+    enum {
+        kOpsPerLoop = 1000,
+        kSize = 256,
+    };
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fBitmap.allocN32Pixels(kSize, kSize);
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkCanvas target(fBitmap);
+        SkGPipeWriter writer;
+        if (fRing) {
+            SkGPipeRingController controller;
+            SkGPipeRingReaderThread reader(&controller, &target);
+            reader.start();
+            this->record(writer.startRecording(&controller, 0, kSize, kSize), loops);
+            writer.endRecording();
+            controller.flush();
+            reader.join();
+        } else {
+            PipeController controller(&target);
+            this->record(writer.startRecording(&controller, 0, kSize, kSize), loops);
+            writer.endRecording();
+        }
+    }
+
+private:
+    void record(SkCanvas* canvas, int loops) {
+        SkRandom rand;
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        for (int i = 0; i < loops; i++) {
+            for (int j = 0; j < kOpsPerLoop; j++) {
+                paint.setColor(rand.nextU() | 0xFF000000);
+                SkRect rect = SkRect::MakeXYWH(rand.nextRangeScalar(0, kSize),
+                                               rand.nextRangeScalar(0, kSize),
+                                               16, 16);
+                if (j & 1) {
+                    canvas->drawOval(rect, paint);
+                } else {
+                    canvas->drawRect(rect, paint);
+                }
+            }
+        }
+    }
+
+    bool     fRing;
+    SkString fName;
+    SkBitmap fBitmap;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(PipeControllerBench, (false)); )
+DEF_BENCH( return SkNEW_ARGS(PipeControllerBench, (true)); )
@@ -88,6 +88,9 @@ public:
         if (fBulkLoad) {
             fName.append("_bulk");
         }
+        if (kSmall_QueryType == q) {
+            fName.append("_small");
+        }
     }
 
     virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
@@ -155,6 +158,9 @@ private:
     typedef Benchmark INHERITED;
 };
 
+static const SkRTree::BulkLoadOrder kUnsorted = SkRTree::kUnsorted_BulkLoadOrder;
+static const SkRTree::BulkLoadOrder kHilbert = SkRTree::kHilbert_BulkLoadOrder;
+
 static inline SkIRect make_concentric_rects_increasing(SkRandom&, int index, int numRects) {
     SkIRect out = {0, 0, index + 1, index + 1};
     return out;
@@ -198,7 +204,7 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeBuildBench, ("(unsorted)XYordered", &make_XYordered_rects, true,
-                      SkRTree::Create(5, 16, 1, false)));
+                      SkRTree::Create(5, 16, 1, kUnsorted)));
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("XYordered", &make_XYordered_rects, true,
@@ -206,7 +212,7 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("(unsorted)XYordered", &make_XYordered_rects, true,
-                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, false)));
+                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, kUnsorted)));
 )
 
 DEF_BENCH(
@@ -219,7 +225,7 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeBuildBench, ("(unsorted)YXordered", &make_YXordered_rects, true,
-                      SkRTree::Create(5, 16, 1, false)));
+                      SkRTree::Create(5, 16, 1, kUnsorted)));
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("YXordered", &make_YXordered_rects, true,
@@ -227,7 +233,7 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("(unsorted)YXordered", &make_YXordered_rects, true,
-                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, false)));
+                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, kUnsorted)));
 )
 
 DEF_BENCH(
@@ -240,7 +246,7 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeBuildBench, ("(unsorted)random", &make_random_rects, true,
-                      SkRTree::Create(5, 16, 1, false)));
+                      SkRTree::Create(5, 16, 1, kUnsorted)));
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("random", &make_random_rects, true,
@@ -248,7 +254,7 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("(unsorted)random", &make_random_rects, true,
-                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, false)));
+                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, kUnsorted)));
 )
 
 DEF_BENCH(
@@ -257,7 +263,8 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeBuildBench, ("(unsorted)concentric",
-                      &make_concentric_rects_increasing, true, SkRTree::Create(5, 16, 1, false)));
+                      &make_concentric_rects_increasing, true,
+                      SkRTree::Create(5, 16, 1, kUnsorted)));
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("concentric", &make_concentric_rects_increasing, true,
@@ -265,5 +272,45 @@ DEF_BENCH(
 )
 DEF_BENCH(
     return SkNEW_ARGS(RTreeQueryBench, ("(unsorted)concentric", &make_concentric_rects_increasing, true,
-                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, false)));
+                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, kUnsorted)));
+)
+
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeBuildBench, ("(hilbert)XYordered", &make_XYordered_rects, true,
+                      SkRTree::Create(5, 16, 1, kHilbert)));
+)
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeQueryBench, ("(hilbert)XYordered", &make_XYordered_rects, true,
+                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, kHilbert)));
+)
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeBuildBench, ("(hilbert)random", &make_random_rects, true,
+                      SkRTree::Create(5, 16, 1, kHilbert)));
+)
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeQueryBench, ("(hilbert)random", &make_random_rects, true,
+                      RTreeQueryBench::kRandom_QueryType, SkRTree::Create(5, 16, 1, kHilbert)));
+)
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeBuildBench, ("(hilbert)concentric",
+                      &make_concentric_rects_increasing, true,
+                      SkRTree::Create(5, 16, 1, kHilbert)));
+)
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeQueryBench, ("(hilbert)concentric", &make_concentric_rects_increasing,
+                      true, RTreeQueryBench::kRandom_QueryType,
+                      SkRTree::Create(5, 16, 1, kHilbert)));
+)
+
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeQueryBench, ("random", &make_random_rects, true,
+                      RTreeQueryBench::kSmall_QueryType, SkRTree::Create(5, 16)));
+)
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeQueryBench, ("(hilbert)random", &make_random_rects, true,
+                      RTreeQueryBench::kSmall_QueryType, SkRTree::Create(5, 16, 1, kHilbert)));
+)
+DEF_BENCH(
+    return SkNEW_ARGS(RTreeQueryBench, ("random", &make_random_rects, false,
+                      RTreeQueryBench::kSmall_QueryType, SkRTree::Create(5, 16)));
 )
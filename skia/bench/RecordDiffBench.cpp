@@ -0,0 +1,161 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SkBBHFactory.h"
+#include "SkCanvas.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkRandom.h"
+#include "SkRecord.h"
+#include "SkRecordDiff.h"
+#include "SkRecorder.h"
+#include "SkRegion.h"
+
+#include "../include/record/SkRecording.h"
+
+static const int kWidth = 1024;
+static const int kHeight = 4096;
+
+// Draws a page of boxes with an icon in each, two commands per box.  In the next frame, one box
+// in fifty changes color, so 1% of the commands change.
+static void draw_frame(SkCanvas* canvas, bool next) {
+    SkRandom rand;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+
+    SkPath icon;
+    icon.moveTo(0, 10);
+    icon.lineTo(5, 0);
+    icon.lineTo(10, 10);
+    icon.close();
+
+    int box = 0;
+    for (int y = 0; y < kHeight; y += 16) {
+        for (int x = 0; x < kWidth; x += 128, box++) {
+            SkColor color = rand.nextU() | 0xFF000000;
+            if (next && 0 == box % 50) {
+                color ^= 0x00FFFFFF;
+            }
+            paint.setColor(color);
+            canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(x), SkIntToScalar(y), 120, 14), paint);
+            paint.setColor(SK_ColorBLACK);
+            icon.offset(SkIntToScalar(x + 2) - icon.getBounds().fLeft,
+                        SkIntToScalar(y + 2) - icon.getBounds().fTop);
+            canvas->drawPath(icon, paint);
+        }
+    }
+}
+
+// Measures how long it takes to find what changed in the next frame: summarizing its commands and
+// comparing them with the summary of the last frame.
+class RecordDiffBench : public Benchmark {
+public:
+    RecordDiffBench() : fCullBounds(SkIRect::MakeWH(kWidth, kHeight)) {}
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return "record_diff_1pct";
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkRecord last;
+        SkRecorder lastRecorder(&last, kWidth, kHeight);
+        draw_frame(&lastRecorder, false);
+        fLast.reset(SkNEW_ARGS(SkRecordSummary, (last, fCullBounds)));
+
+        SkRecorder nextRecorder(&fNext, kWidth, kHeight);
+        draw_frame(&nextRecorder, true);
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkRegion damage;
+        for (int i = 0; i < loops; i++) {
+            SkRecordSummary next(fNext, fCullBounds);
+            SkRecordDiff(*fLast, next, &damage);
+        }
+    }
+
+private:
+    const SkIRect                  fCullBounds;
+    SkAutoTDelete<SkRecordSummary> fLast;
+    SkRecord                       fNext;
+
+    typedef Benchmark INHERITED;
+};
+
+// Measures how long it takes to bring a raster of the last frame up to date with the next one,
+// either by drawing all of it again or by drawing it once for each rect of what
+// SkPlayback::computeDamage() finds changed, so that the tile grid only plays back the commands in
+// that rect.
+class RecordRedrawBench : public Benchmark {
+public:
+    explicit RecordRedrawBench(bool damagedOnly) : fDamagedOnly(damagedOnly) {}
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fDamagedOnly ? "record_redraw_damaged_1pct" : "record_redraw_full_1pct";
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkTileGridFactory::TileGridInfo info;
+        info.fTileInterval.set(256, 256);
+        info.fMargin.setEmpty();
+        info.fOffset.setZero();
+        SkTileGridFactory factory(info);
+
+        EXPERIMENTAL::SkRecording last(kWidth, kHeight, &factory);
+        draw_frame(last.canvas(), false);
+        SkAutoTDelete<EXPERIMENTAL::SkPlayback> lastPlayback(last.releasePlayback());
+
+        EXPERIMENTAL::SkRecording next(kWidth, kHeight, &factory);
+        draw_frame(next.canvas(), true);
+        fNext.reset(next.releasePlayback());
+
+        if (!fNext->computeDamage(*lastPlayback, &fDamage)) {
+            fDamage.setRect(SkIRect::MakeWH(kWidth, kHeight));
+        }
+        fBitmap.allocN32Pixels(kWidth, kHeight);
+        SkCanvas canvas(fBitmap);
+        lastPlayback->draw(&canvas);
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkCanvas canvas(fBitmap);
+        for (int i = 0; i < loops; i++) {
+            if (!fDamagedOnly) {
+                fNext->draw(&canvas);
+                continue;
+            }
+            for (SkRegion::Iterator iter(fDamage); !iter.done(); iter.next()) {
+                canvas.save();
+                canvas.clipRect(SkRect::Make(iter.rect()));
+                fNext->draw(&canvas);
+                canvas.restore();
+            }
+        }
+    }
+
+private:
+    bool                                    fDamagedOnly;
+    SkAutoTDelete<EXPERIMENTAL::SkPlayback> fNext;
+    SkRegion                                fDamage;
+    SkBitmap                                fBitmap;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW(RecordDiffBench); )
+DEF_BENCH( return SkNEW_ARGS(RecordRedrawBench, (false)); )
+DEF_BENCH( return SkNEW_ARGS(RecordRedrawBench, (true)); )
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SkCanvas.h"
+#include "SkData.h"
+#include "SkPaint.h"
+#include "SkPicture.h"
+#include "SkPictureRecorder.h"
+#include "SkRandom.h"
+#include "SkStream.h"
+#include "SkString.h"
+
+#include "../include/record/SkRecording.h"
+
+// Draws a page of rects, paths, text and a few bitmaps, like a cached web page.
+static void draw_page(SkCanvas* canvas, int width, int height) {
+    SkRandom rand;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setTextSize(12);
+
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(64, 64);
+    bitmap.eraseColor(SK_ColorBLUE);
+
+    SkPath path;
+    path.moveTo(0, 0);
+    path.cubicTo(20, -10, 40, 30, 60, 10);
+
+    static const char kText[] = "The quick brown fox jumps over the lazy dog.";
+    for (int y = 0; y < height; y += 20) {
+        paint.setColor(rand.nextU() | 0xFF000000);
+        const SkScalar x = rand.nextRangeScalar(0, SkIntToScalar(width / 2));
+        canvas->drawRect(SkRect::MakeXYWH(x, SkIntToScalar(y), 100, 18), paint);
+
+        canvas->save();
+        canvas->translate(x, SkIntToScalar(y));
+        canvas->drawPath(path, paint);
+        canvas->restore();
+
+        canvas->drawText(kText, sizeof(kText) - 1, x, SkIntToScalar(y + 15), paint);
+        if (0 == y % 400) {
+            canvas->drawBitmap(bitmap, x, SkIntToScalar(y));
+        }
+    }
+}
+
+// Measures how long it takes to load a serialized page, as an SkPicture or as an SkRecord in the
+// format SkPlayback::CreateFromData() plays back in place.
+class RecordLoadBench : public Benchmark {
+public:
+    explicit RecordLoadBench(bool mapped) : fMapped(mapped) {}
+
+    enum {
+        kWidth = 1000,
+        kHeight = 4000,
+    };
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fMapped ? "record_load_mapped" : "record_load_picture";
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkDynamicMemoryWStream stream;
+        if (fMapped) {
+            EXPERIMENTAL::SkRecording recording(kWidth, kHeight);
+            draw_page(recording.canvas(), kWidth, kHeight);
+            SkAutoTDelete<EXPERIMENTAL::SkPlayback> playback(recording.releasePlayback());
+            playback->serialize(&stream);
+        } else {
+            SkPictureRecorder recorder;
+            draw_page(recorder.beginRecording(kWidth, kHeight, NULL, 0), kWidth, kHeight);
+            SkAutoTUnref<SkPicture> picture(recorder.endRecording());
+            picture->serialize(&stream);
+        }
+        fData.reset(stream.copyToData());
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; i++) {
+            if (fMapped) {
+                SkAutoTDelete<EXPERIMENTAL::SkPlayback> playback(
+                        EXPERIMENTAL::SkPlayback::CreateFromData(fData));
+                SkASSERT(NULL != playback.get());
+            } else {
+                SkMemoryStream stream(fData);
+                SkAutoTUnref<SkPicture> picture(SkPicture::CreateFromStream(&stream));
+                SkASSERT(NULL != picture.get());
+            }
+        }
+    }
+
+private:
+    bool                 fMapped;
+    SkAutoTUnref<SkData> fData;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(RecordLoadBench, (false)); )
+DEF_BENCH( return SkNEW_ARGS(RecordLoadBench, (true)); )
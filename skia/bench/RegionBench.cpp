@@ -9,6 +9,7 @@
 #include "SkRandom.h"
 #include "SkRegion.h"
 #include "SkString.h"
+#include "SkTDArray.h"
 
 static bool union_proc(SkRegion& a, SkRegion& b) {
     SkRegion result;
@@ -117,6 +118,81 @@ private:
     typedef Benchmark INHERITED;
 };
 
+/**
+ *  Builds a region from many rects, as a damage tracker or a clip-heavy
+ *  canvas would, either with one union per rect or with the bulk APIs.
+ */
+class RegionRectsBench : public Benchmark {
+public:
+    enum Mode {
+        kUnionLoop_Mode,    // region.op(rect, kUnion_Op) for each rect
+        kSetRects_Mode,     // region.setRects(rects, count)
+        kOpRects_Mode,      // region.op(rects, count, kUnion_Op) into a complex region
+        kInPlace_Mode,      // region.op(a, b, kUnion_Op) into the same region each time
+    };
+
+private:
+    SkTDArray<SkIRect>  fRects;
+    SkRegion            fA, fB;
+    SkRegion            fDst;
+    Mode                fMode;
+    SkString            fName;
+
+public:
+    RegionRectsBench(int count, Mode mode) : fMode(mode) {
+        static const char* gNames[] = { "unionloop", "setrects", "oprects", "inplace" };
+        fName.printf("region_rects_%s_%d", gNames[mode], count);
+
+        SkRandom rand;
+        for (int i = 0; i < count; i++) {
+            int x = rand.nextU() % 1024;
+            int y = rand.nextU() % 768;
+            *fRects.append() = SkIRect::MakeXYWH(x, y, 8 + rand.nextU() % 64,
+                                                 8 + rand.nextU() % 64);
+        }
+        fA.setRects(fRects.begin(), count / 2);
+        fB.setRects(fRects.begin() + count / 2, count - count / 2);
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) {
+        for (int i = 0; i < loops; ++i) {
+            switch (fMode) {
+                case kUnionLoop_Mode: {
+                    SkRegion rgn;
+                    for (int j = 0; j < fRects.count(); ++j) {
+                        rgn.op(fRects[j], SkRegion::kUnion_Op);
+                    }
+                    break;
+                }
+                case kSetRects_Mode: {
+                    SkRegion rgn;
+                    rgn.setRects(fRects.begin(), fRects.count());
+                    break;
+                }
+                case kOpRects_Mode: {
+                    SkRegion rgn(fA);
+                    rgn.op(fRects.begin() + fRects.count() / 2,
+                           fRects.count() - fRects.count() / 2, SkRegion::kUnion_Op);
+                    break;
+                }
+                case kInPlace_Mode:
+                    fDst.op(fA, fB, SkRegion::kUnion_Op);
+                    break;
+            }
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
 class RectSectBench : public Benchmark {
     enum {
         N = 1000
@@ -184,5 +260,10 @@ DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, sectsrgn_proc, "intersectsrgn"
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, sectsrect_proc, "intersectsrect")); )
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, containsxy_proc, "containsxy")); )
 
+DEF_BENCH( return SkNEW_ARGS(RegionRectsBench, (1000, RegionRectsBench::kUnionLoop_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(RegionRectsBench, (1000, RegionRectsBench::kSetRects_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(RegionRectsBench, (1000, RegionRectsBench::kOpRects_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(RegionRectsBench, (1000, RegionRectsBench::kInPlace_Mode)); )
+
 DEF_BENCH( return SkNEW_ARGS(RectSectBench, (false)); )
 DEF_BENCH( return SkNEW_ARGS(RectSectBench, (true)); )
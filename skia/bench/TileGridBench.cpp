@@ -0,0 +1,130 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkCanvas.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkTileGrid.h"
+
+// A long page of mostly small draws, some boxes, and a few backgrounds that span many tiles.
+static const int PAGE_WIDTH = 1024;
+static const int PAGE_HEIGHT = 8192;
+static const int TILE_SIZE = 256;
+static const int NUM_RECTS = 10000;
+
+static SkIRect make_page_rect(SkRandom& rand) {
+    SkIRect rect;
+    rect.fLeft = rand.nextU() % PAGE_WIDTH;
+    rect.fTop = rand.nextU() % PAGE_HEIGHT;
+    const uint32_t kind = rand.nextU() % 100;
+    if (kind == 0) {
+        rect.fLeft = 0;
+        rect.fRight = PAGE_WIDTH;
+        rect.fTop = rand.nextU() % (PAGE_HEIGHT / 2);
+        rect.fBottom = rect.fTop + PAGE_HEIGHT / 4 + rand.nextU() % (PAGE_HEIGHT / 2);
+    } else if (kind < 10) {
+        rect.fRight = rect.fLeft + 1 + rand.nextU() % 512;
+        rect.fBottom = rect.fTop + 1 + rand.nextU() % 512;
+    } else {
+        rect.fRight = rect.fLeft + 1 + rand.nextU() % 100;
+        rect.fBottom = rect.fTop + 1 + rand.nextU() % 40;
+    }
+    return rect;
+}
+
+static SkTileGrid* make_tile_grid(SkTileGridFactory::Layout layout) {
+    SkTileGridFactory::TileGridInfo info;
+    info.fTileInterval.set(TILE_SIZE, TILE_SIZE);
+    info.fMargin.setEmpty();
+    info.fOffset.setZero();
+    return SkNEW_ARGS(SkTileGrid, (PAGE_WIDTH / TILE_SIZE, PAGE_HEIGHT / TILE_SIZE, info,
+                                   layout));
+}
+
+static const char* layout_name(SkTileGridFactory::Layout layout) {
+    return SkTileGridFactory::kFlat_Layout == layout ? "flat" : "adaptive";
+}
+
+// Time how long it takes to fill a tile grid with deferred insertions.
+class TileGridBuildBench : public Benchmark {
+public:
+    TileGridBuildBench(SkTileGridFactory::Layout layout) : fGrid(make_tile_grid(layout)) {
+        fName.printf("tilegrid_%s_build", layout_name(layout));
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkRandom rand;
+        for (int i = 0; i < loops; ++i) {
+            for (int j = 0; j < NUM_RECTS; ++j) {
+                fGrid->insert(reinterpret_cast<void*>(j), make_page_rect(rand), true);
+            }
+            fGrid->flushDeferredInserts();
+            fGrid->clear();
+        }
+    }
+
+private:
+    SkAutoTUnref<SkTileGrid> fGrid;
+    SkString fName;
+    typedef Benchmark INHERITED;
+};
+
+// Time how long it takes to search every tile of a tile grid once.
+class TileGridQueryBench : public Benchmark {
+public:
+    TileGridQueryBench(SkTileGridFactory::Layout layout) : fGrid(make_tile_grid(layout)) {
+        fName.printf("tilegrid_%s_query", layout_name(layout));
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkRandom rand;
+        for (int j = 0; j < NUM_RECTS; ++j) {
+            fGrid->insert(reinterpret_cast<void*>(j), make_page_rect(rand), true);
+        }
+        fGrid->flushDeferredInserts();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkTDArray<void*> hits;
+        for (int i = 0; i < loops; ++i) {
+            for (int y = 0; y < PAGE_HEIGHT; y += TILE_SIZE) {
+                for (int x = 0; x < PAGE_WIDTH; x += TILE_SIZE) {
+                    fGrid->search(SkIRect::MakeXYWH(x, y, TILE_SIZE, TILE_SIZE), &hits);
+                }
+            }
+        }
+    }
+
+private:
+    SkAutoTUnref<SkTileGrid> fGrid;
+    SkString fName;
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(TileGridBuildBench, (SkTileGridFactory::kFlat_Layout)); )
+DEF_BENCH( return SkNEW_ARGS(TileGridBuildBench, (SkTileGridFactory::kAdaptive_Layout)); )
+DEF_BENCH( return SkNEW_ARGS(TileGridQueryBench, (SkTileGridFactory::kFlat_Layout)); )
+DEF_BENCH( return SkNEW_ARGS(TileGridQueryBench, (SkTileGridFactory::kAdaptive_Layout)); )
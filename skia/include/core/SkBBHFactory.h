@@ -56,12 +56,25 @@ public:
         SkIPoint fOffset;
     };
 
-    SkTileGridFactory(const TileGridInfo& info) : fInfo(info) { }
+    /** How the tile grid stores the data whose bounds span many tiles. */
+    enum Layout {
+        /** Each datum goes in every tile it overlaps. */
+        kFlat_Layout,
+        /** Data that overlap many tiles go in coarser grids stacked over the grid of tiles, so
+          * that large draws aren't copied into hundreds of tiles. Searches return the same data
+          * as with kFlat_Layout.
+          */
+        kAdaptive_Layout,
+    };
+
+    SkTileGridFactory(const TileGridInfo& info, Layout layout = kFlat_Layout)
+        : fInfo(info), fLayout(layout) { }
 
     virtual SkBBoxHierarchy* operator()(int width, int height) const SK_OVERRIDE;
 
 private:
     TileGridInfo fInfo;
+    Layout fLayout;
 
     typedef SkBBHFactory INHERITED;
 };
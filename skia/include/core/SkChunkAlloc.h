@@ -23,6 +23,14 @@ public:
      */
     void reset();
 
+    /**
+     *  Like reset(), this invalidates all returned pointers, but the memory is
+     *  kept for reuse: if more than one block was allocated, they are replaced
+     *  by a single block of the combined capacity, so that a subsequent
+     *  sequence of allocations of the same total size needs no new blocks.
+     */
+    void rewind();
+
     enum AllocFailType {
         kReturnNil_AllocFailType,
         kThrow_AllocFailType
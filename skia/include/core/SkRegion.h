@@ -121,9 +121,10 @@ public:
     bool setRect(int32_t left, int32_t top, int32_t right, int32_t bottom);
 
     /**
-     *  Set this region to the union of an array of rects. This is generally
-     *  faster than calling region.op(rect, kUnion_Op) in a loop. If count is
-     *  0, then this region is set to the empty region.
+     *  Set this region to the union of an array of rects. The rects do not
+     *  need to be sorted, and may overlap. This builds the region in a single
+     *  sweep, so it is much faster than calling region.op(rect, kUnion_Op) in
+     *  a loop. If count is 0, then this region is set to the empty region.
      *  @return true if the resulting region is non-empty
      */
     bool setRects(const SkIRect rects[], int count);
@@ -272,10 +273,22 @@ public:
     /**
      *  Set this region to the result of applying the Op to this region and the
      *  specified region: this = (this op rgn).
+     *  If this region's storage is not shared with another region and is large
+     *  enough to hold the result, it is reused, so accumulating many ops into
+     *  one region does not allocate for each op.
      *  Return true if the resulting region is non-empty.
      */
     bool op(const SkRegion& rgn, Op op) { return this->op(*this, rgn, op); }
 
+    /**
+     *  Set this region to the result of applying the Op to this region and the
+     *  union of the specified rectangles: this = (this op (rects[0] + ...)).
+     *  The union of the rectangles is built as in setRects(), so this is much
+     *  faster than applying the Op with each rectangle in turn.
+     *  Return true if the resulting region is non-empty.
+     */
+    bool op(const SkIRect rects[], int count, Op op);
+
     /**
      *  Set this region to the result of applying the Op to the specified
      *  rectangle and region: this = (rect op rgn).
@@ -20,6 +20,7 @@
 
 class GrAARectRenderer;
 class GrAutoScratchTexture;
+class GrBitmapAtlas;
 class GrCacheable;
 class GrDrawState;
 class GrDrawTarget;
@@ -34,6 +35,7 @@ class GrLayerCache;
 class GrOvalRenderer;
 class GrPath;
 class GrPathRenderer;
+class GrPersistentCache;
 class GrResourceEntry;
 class GrResourceCache;
 class GrStencilBuffer;
@@ -160,6 +162,81 @@ public:
         this->setResourceCacheLimits(maxTextures, maxTextureBytes);
     }
 
+    /**
+     *  Returns the maximum number of bytes of video memory that resources of the category can
+     *  hold in the cache.
+     */
+    size_t getResourceCategoryLimit(GrResourceCategory) const;
+
+    /**
+     *  Specify the maximum number of bytes of video memory that resources of the category can
+     *  hold in the cache. If the category exceeds it, its least recently used resources are
+     *  purged even if the cache is within its overall limits, and a category over its limit is
+     *  purged before the others when the cache is over its overall limits. By default the
+     *  categories have no limit of their own.
+     */
+    void setResourceCategoryLimit(GrResourceCategory, size_t maxResourceBytes);
+
+    /**
+     *  Gets the number of resources of the category held in the cache and the bytes of video
+     *  memory they use. Either pointer may be NULL.
+     */
+    void getResourceCategoryUsage(GrResourceCategory, int* resourceCount,
+                                  size_t* resourceBytes) const;
+
+    /**
+     *  Specify the number of flushes after which a cached resource that hasn't been used is
+     *  purged, even if the cache is within its limits. 0, the default, disables purging by age.
+     */
+    void setResourceCacheMaxUnusedFlushes(int flushes);
+
+    enum MemoryPressureLevel {
+        /** Purge scratch resources and resources that weren't used since the last flush. */
+        kModerate_MemoryPressureLevel,
+        /** Purge all unlocked resources, like freeGpuResources(). */
+        kCritical_MemoryPressureLevel
+    };
+
+    /**
+     *  Called by the host application when the system is running low on memory, to release as
+     *  much of the cached video memory as the level asks for. Resources in use are not freed.
+     */
+    void handleMemoryPressure(MemoryPressureLevel);
+
+    /**
+     *  Returns the maximum number of compiled shader programs the context keeps alive.
+     */
+    int getProgramCacheLimit() const;
+
+    /**
+     *  Specify the maximum number of compiled shader programs the context keeps alive. When the
+     *  limit is reached the least recently used program is deleted. Scenes that use more distinct
+     *  effect combinations than the limit will recompile programs every frame.
+     */
+    void setProgramCacheLimit(int maxPrograms);
+
+    /**
+     *  Compiles the shader programs needed to draw rects with each of the paints to the current
+     *  render target, so that the first frame that uses them doesn't stall on shader compiles.
+     *  Typically called at startup with the paints an app knows it will use.
+     *
+     *  Each paint is warmed up for filled rects drawn by drawRect() without antialiasing, for
+     *  rects drawn by drawRectToRect() (how bitmaps are drawn) if the paint has effects, and for
+     *  antialiased rects drawn by drawRect() if the paint is antialiased and the render target
+     *  isn't multisampled. Other draws, such as paths, ovals, stroked rects without antialiasing
+     *  and draws whose clip needs a coverage effect, may still compile programs when first used.
+     *
+     *  @return the number of programs that were compiled or were already cached.
+     */
+    int precompilePrograms(const GrPaint paints[], int count);
+
+    /**
+     *  Specify storage that outlives the process in which compiled shader programs are saved, so
+     *  that later runs can load them instead of compiling them again. Pass NULL to stop using
+     *  it. The context takes a ref on the cache. See GrPersistentCache::CreateFileCache().
+     */
+    void setPersistentCache(GrPersistentCache*);
+
     /**
      * Frees GPU created by the context. Can be called to reduce GPU memory
      * pressure.
@@ -718,6 +795,47 @@ public:
     void dumpFontCache() const;
 #endif
 
+    /**
+     * Counts of the work the context has issued to the underlying 3D API since the last call to
+     * resetGpuStats(). Counting costs an increment per event so it is always enabled. A client
+     * typically resets the stats at the start of a frame and reads them after flushing it.
+     */
+    struct GpuStats {
+        int     fDraws;                 //!< draw calls, including path draws
+        int     fProgramSwitches;       //!< changes of the bound shader program
+        int     fTextureBinds;          //!< textures bound to a texture unit for drawing
+        int     fBufferUploads;         //!< updates of vertex or index buffer contents
+        size_t  fBufferUploadBytes;
+        int     fTextureUploads;        //!< uploads of texel data to textures
+        size_t  fTextureUploadBytes;
+        int     fRenderTargetChanges;   //!< changes of the bound render target
+        int     fScissorChanges;        //!< changes of the scissor rect or scissor enable
+        int     fDrawBufferFlushes;     //!< non-empty flushes of the deferred draw buffer
+        int     fConcatenatedDraws;     //!< draws appended to the previous recorded draw
+        int     fMergedDraws;           //!< recorded draws merged into another draw at flush
+        int     fBitmapAtlasHits;       //!< bitmap draws that found the bitmap in the atlas
+        int     fBitmapAtlasMisses;     //!< bitmaps copied into the atlas
+        int     fProgramCacheHits;      //!< shader program lookups found in the program cache
+        int     fProgramCacheMisses;    //!< shader program lookups that compiled a new program
+        int     fProgramCacheEvictions; //!< programs deleted to stay within the cache limit
+        SkMSec  fProgramCompileMSecs;   //!< time spent compiling and linking programs
+
+        void reset() { sk_bzero(this, sizeof(*this)); }
+    };
+
+    /**
+     * Returns the stats accumulated since the last call to resetGpuStats(). Draws that are still
+     * deferred are not counted until the context is flushed. The stats are also reported as
+     * trace counters in the disabled-by-default "skia.gpu" category each time the context is
+     * flushed.
+     */
+    const GpuStats& getGpuStats() const;
+
+    /**
+     * Zeroes the stats returned by getGpuStats().
+     */
+    void resetGpuStats();
+
     ///////////////////////////////////////////////////////////////////////////
     // Helpers
 
@@ -914,6 +1032,7 @@ public:
     const GrGpu* getGpu() const { return fGpu; }
     GrFontCache* getFontCache() { return fFontCache; }
     GrLayerCache* getLayerCache() { return fLayerCache.get(); }
+    GrBitmapAtlas* getBitmapAtlas() { return fBitmapAtlas.get(); }
     GrDrawTarget* getTextTarget();
     const GrIndexBuffer* getQuadIndexBuffer() const;
     GrAARectRenderer* getAARectRenderer() { return fAARectRenderer; }
@@ -965,6 +1084,7 @@ private:
     GrResourceCache*                fResourceCache;
     GrFontCache*                    fFontCache;
     SkAutoTDelete<GrLayerCache>     fLayerCache;
+    SkAutoTDelete<GrBitmapAtlas>    fBitmapAtlas;
 
     GrPathRendererChain*            fPathRendererChain;
     GrSoftwarePathRenderer*         fSoftwarePathRenderer;
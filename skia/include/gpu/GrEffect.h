@@ -300,6 +300,9 @@ protected:
 
 private:
     bool isEqual(const GrEffect& other) const {
+        if (this == &other) {
+            return true;
+        }
         if (&this->getFactory() != &other.getFactory()) {
             return false;
         }
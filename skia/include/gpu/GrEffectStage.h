@@ -188,6 +188,31 @@ public:
             return fCoordChangeMatrix == stage.fCoordChangeMatrix;
         }
 
+        bool isEqual(const DeferredStage& stage, bool ignoreCoordChange) const {
+            if (fVertexAttribIndices[0] != stage.fVertexAttribIndices[0] ||
+                fVertexAttribIndices[1] != stage.fVertexAttribIndices[1]) {
+                return false;
+            }
+
+            if (fEffect != stage.fEffect && !fEffect->isEqual(*stage.fEffect)) {
+                return false;
+            }
+
+            if (ignoreCoordChange) {
+                return true;
+            }
+
+            if (fCoordChangeMatrixSet != stage.fCoordChangeMatrixSet) {
+                return false;
+            }
+
+            if (!fCoordChangeMatrixSet) {
+                return true;
+            }
+
+            return fCoordChangeMatrix == stage.fCoordChangeMatrix;
+        }
+
     private:
         const GrEffect*               fEffect;
         bool                          fCoordChangeMatrixSet;
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrPersistentCache_DEFINED
+#define GrPersistentCache_DEFINED
+
+#include "SkRefCnt.h"
+
+class SkData;
+
+/**
+ *  Storage for data that the GPU backend wants to keep across runs, such as compiled shader
+ *  programs. Keys and values are opaque blobs. The backend builds the keys so that data written
+ *  by a different driver or a different version of Skia is never loaded, and it validates the
+ *  values it gets back, so an implementation is free to drop, evict or lose entries at any time.
+ *
+ *  Clients can subclass this to put the data wherever suits their platform, or use
+ *  CreateFileCache() to keep one file per entry in a directory.
+ */
+class SK_API GrPersistentCache : public SkRefCnt {
+public:
+    SK_DECLARE_INST_COUNT(GrPersistentCache)
+
+    /**
+     *  Returns the data last stored with the key, or NULL if there is none. The caller must
+     *  unref the returned data.
+     */
+    virtual SkData* load(const SkData& key) = 0;
+
+    /**
+     *  Stores data under the key, replacing any data already stored with it.
+     */
+    virtual void store(const SkData& key, const SkData& data) = 0;
+
+    /**
+     *  Returns a cache that stores each entry as a file in directory, which is created if it
+     *  doesn't exist. Returns NULL if the directory can't be created.
+     */
+    static GrPersistentCache* CreateFileCache(const char directory[]);
+
+private:
+    typedef SkRefCnt INHERITED;
+};
+
+#endif
@@ -158,6 +158,7 @@ public:
                                     const GrTextureDesc& desc,
                                     const GrCacheID& cacheID);
     static GrResourceKey ComputeScratchKey(const GrTextureDesc& desc);
+    static bool IsTextureKey(const GrResourceKey& key);
     static bool NeedsResizing(const GrResourceKey& key);
     static bool NeedsBilerp(const GrResourceKey& key);
 
@@ -503,6 +503,20 @@ private:
     static const Domain kInvalid_Domain = 0;
 };
 
+/**
+ * The kinds of resources in GrContext's resource cache. Each category can be given a limit of its
+ * own so that resources of one kind, e.g. large scratch render targets for layers, don't evict all
+ * resources of another kind.
+ */
+enum GrResourceCategory {
+    kScratch_GrResourceCategory,    //!< textures and render targets reused for their dimensions
+    kTexture_GrResourceCategory,    //!< textures of specific content, e.g. uploaded bitmaps
+    kOther_GrResourceCategory,      //!< stencil buffers, paths, ...
+
+    kLast_GrResourceCategory = kOther_GrResourceCategory
+};
+static const int kGrResourceCategoryCnt = kLast_GrResourceCategory + 1;
+
 /**
  * Clips are composed from these objects.
  */
@@ -161,6 +161,12 @@ private:
     GrRenderTarget*     fRenderTarget;
     bool                fNeedClear;
 
+    // The texture effect of the last bitmap drawn without a texture domain. It is reused while
+    // bitmaps come from the same texture with the same params (e.g. sprites from an atlas) so
+    // that runs of such draws don't allocate effects and are cheap to batch.
+    SkAutoTUnref<GrEffectRef>   fCachedBitmapEffect;
+    GrTextureParams             fCachedBitmapEffectParams;
+
     // called from rt and tex cons
     void initFromRenderTarget(GrContext*, GrRenderTarget*, unsigned flags);
 
@@ -40,6 +40,26 @@ enum SkPathOp {
   */
 bool SK_API Op(const SkPath& one, const SkPath& two, SkPathOp op, SkPath* result);
 
+/** Set result to the result of applying the Op across all of the paths:
+    result = paths[0] op paths[1] op ... op paths[count - 1].
+    This is much faster than calling the two path Op repeatedly for many
+    paths. The union or xor of polygons (paths without curves or inverse
+    fills) is resolved in a single pass over the contours of every path.
+    Otherwise, union, intersect and xor combine the paths as a balanced tree
+    of two path Ops, and the difference ops are applied in order.
+
+    Returns true if operation was able to produce a result;
+    otherwise, result is unmodified.
+
+    @param paths The operands.
+    @param count The number of operands.
+    @param op The operation to apply between each successive operand.
+    @param result The product of the operands. The result may be one of the
+                  inputs.
+    @return True if operation succeeded.
+  */
+bool SK_API Op(const SkPath* paths, int count, SkPathOp op, SkPath* result);
+
 /** Set this path to a set of non-overlapping contours that describe the
     same area as the original path.
     The curve order is reduced where possible so that cubics may
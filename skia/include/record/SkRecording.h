@@ -14,8 +14,15 @@
 #include "SkTypes.h"      // SkNoncopyable
 
 // These are intentionally left opaque.
+class SkBBHFactory;
+class SkBBoxHierarchy;
+class SkData;
+class SkMappedRecord;
 class SkRecord;
+class SkRecordSummary;
 class SkRecorder;
+class SkRegion;
+class SkWStream;
 
 namespace EXPERIMENTAL {
 
@@ -41,20 +48,55 @@ public:
     // Remember, if you've got an SkPlayback*, you probably own it.  Don't forget to delete it!
     ~SkPlayback();
 
-    // Draw recorded commands into a canvas.
+    // Draw recorded commands into a canvas.  If the recording has a bounding box hierarchy,
+    // only the commands that may draw into the canvas' clip are played back.
     void draw(SkCanvas*) const;
 
+    // Write the recorded commands to a stream in a form that CreateFromData() can play back
+    // in place, e.g. from a memory mapped file.  The bounding box hierarchy is not written.
+    void serialize(SkWStream*) const;
+
+    // Set damage to the device area that may look different when this is drawn instead of
+    // previous, so that a raster backend that kept what previous drew, e.g. in tiles, only has to
+    // draw this again where it intersects damage.  The commands of both playbacks are compared
+    // one by one, by type and arguments, and only the bounds of those that differ are damaged.
+    // Note that clear() ignores the clip: draw each damaged tile into a canvas of its own rather
+    // than clipping a canvas that holds all of them.
+    //
+    // Returns false, leaving damage alone, if either playback was made by CreateFromData();
+    // then everything must be drawn again.  A playback summarizes its commands the first time it
+    // is compared and keeps the summary, so comparing it with the next frame's playback only
+    // summarizes the new one.
+    bool computeDamage(const SkPlayback& previous, SkRegion* damage) const;
+
+    // Returns NULL if data was not written by serialize().  The SkPlayback refs data and plays
+    // back from it directly, so it must not change while the SkPlayback is alive.
+    static SkPlayback* CreateFromData(SkData* data);
+
 private:
-    explicit SkPlayback(const SkRecord*);
+    SkPlayback(const SkRecord*, SkBBoxHierarchy*, int width, int height);
+    explicit SkPlayback(const SkMappedRecord*);
+
+    // Returns NULL for a playback made by CreateFromData().
+    const SkRecordSummary* summary() const;
 
+    // Exactly one of fRecord and fMapped is set.
     SkAutoTDelete<const SkRecord> fRecord;
+    SkAutoTUnref<SkBBoxHierarchy> fBBH;
+    SkAutoTDelete<const SkMappedRecord> fMapped;
+    int fWidth;
+    int fHeight;
+    // Made by the first call to summary(), which may come from any thread.
+    mutable SkRecordSummary* fSummary;
 
     friend class SkRecording;
 };
 
 class SK_API SkRecording : SkNoncopyable {
 public:
-    SkRecording(int width, int height);
+    // If bbhFactory is not NULL, releasePlayback() fills one of its bounding box hierarchies with
+    // the bounds of each command so that playback can skip the ones outside of the clip.
+    SkRecording(int width, int height, SkBBHFactory* bbhFactory = NULL);
     ~SkRecording();
 
     // Draws issued to this canvas will be replayed by SkPlayback::draw().
@@ -66,6 +108,9 @@ public:
     SkPlayback* releasePlayback();
 
 private:
+    int fWidth;
+    int fHeight;
+    SkBBHFactory* fBBHFactory;
     SkAutoTDelete<SkRecord> fRecord;
     SkAutoTUnref<SkRecorder> fRecorder;
 };
@@ -111,9 +111,37 @@ public:
      */
     void setMaxRecordingStorage(size_t maxStorage);
 
+    /**
+     *  Specify the number of draw commands after which recorded commands are
+     *  flushed automatically, so that playing them back costs less at a time.
+     *  Save, restore, matrix and clip calls count as commands. By default
+     *  there is no limit.
+     *  @param maxCommands The number of commands to record between flushes.
+     */
+    void setMaxRecordingCommands(int maxCommands);
+
+    /**
+     *  Enable or disable flushing in the background. When enabled, the
+     *  commands recorded when a limit set by setMaxRecordingStorage or
+     *  setMaxRecordingCommands is reached are handed to a thread that plays
+     *  them back into the surface, while recording goes on into a second
+     *  buffer. Only one flush is played back at a time: reaching the storage
+     *  limit again before it is done waits for it, while reaching the command
+     *  limit again keeps recording. Explicit flushes, pixel access and
+     *  immediate draws wait for the background flush to be done.
+     *  The notification client is still called on the recording thread;
+     *  flushedDrawCommands is called once the commands are handed off.
+     *  Surfaces backed by a GrContext are always flushed on the recording
+     *  thread, since their GL context belongs to it: for them, and for any
+     *  such surface set later with setSurface, this call is ignored.
+     *  @param async true/false
+     */
+    void setAsyncFlush(bool async);
+
     /**
      *  Returns the number of bytes currently allocated for the purpose of
-     *  recording draw commands.
+     *  recording draw commands. Commands being flushed in the background are
+     *  not counted.
      */
     size_t storageAllocatedForRecording() const;
 
@@ -6,7 +6,6 @@
  */
 
 #include "SkBBHFactory.h"
-#include "SkPictureStateTree.h"
 #include "SkQuadTree.h"
 #include "SkRTree.h"
 #include "SkTileGrid.h"
@@ -24,10 +23,9 @@ SkBBoxHierarchy* SkRTreeFactory::operator()(int width, int height) const {
 
     SkScalar aspectRatio = SkScalarDiv(SkIntToScalar(width),
                                        SkIntToScalar(height));
-    bool sortDraws = false;  // Do not sort draw calls when bulk loading.
-
+    // Do not sort draw calls when bulk loading.
     return SkRTree::Create(kRTreeMinChildren, kRTreeMaxChildren,
-                           aspectRatio, sortDraws);
+                           aspectRatio, SkRTree::kUnsorted_BulkLoadOrder);
 }
 
 SkBBoxHierarchy* SkTileGridFactory::operator()(int width, int height) const {
@@ -39,6 +37,5 @@ SkBBoxHierarchy* SkTileGridFactory::operator()(int width, int height) const {
     // "-1"s below.
     int xTileCount = (width + fInfo.fTileInterval.width() - 1) / fInfo.fTileInterval.width();
     int yTileCount = (height + fInfo.fTileInterval.height() - 1) / fInfo.fTileInterval.height();
-    return SkNEW_ARGS(SkTileGrid, (xTileCount, yTileCount, fInfo,
-                                    SkTileGridNextDatum<SkPictureStateTree::Draw>));
+    return SkNEW_ARGS(SkTileGrid, (xTileCount, yTileCount, fInfo, fLayout));
 }
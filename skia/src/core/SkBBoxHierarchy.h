@@ -61,6 +61,12 @@ public:
      */
     virtual void search(const SkIRect& query, SkTDArray<void*>* results) = 0;
 
+    /**
+     * Returns true if search() returns the data in the order in which they were inserted, so that
+     * callers don't need to sort them.
+     */
+    virtual bool searchIsOrdered() const { return false; }
+
     virtual void clear() = 0;
 
     /**
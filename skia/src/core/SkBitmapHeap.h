@@ -169,10 +169,12 @@ public:
      * @return  a SkBitmapHeapEntry that wraps the bitmap or NULL if external storage is used.
      */
     SkBitmapHeapEntry* getEntry(int32_t slot) const {
-        SkASSERT(slot <= fStorage.count());
         if (fExternalStorage != NULL) {
             return NULL;
         }
+        // A reader on another thread may ask for an entry while insert() grows fStorage.
+        SkAutoMutexAcquire lock(fStorageMutex);
+        SkASSERT(slot <= fStorage.count());
         return fStorage[slot];
     }
 
@@ -286,6 +288,8 @@ private:
 
     // heap storage
     SkTDArray<SkBitmapHeapEntry*> fStorage;
+    // Guards changes to the size of fStorage against getEntry() on another thread.
+    mutable SkMutex fStorageMutex;
     // Used to mark slots in fStorage as deleted without actually deleting
     // the slot so as not to mess up the numbering.
     SkTDArray<int> fUnusedSlots;
@@ -270,35 +270,19 @@ bool SkBitmapProcState::possiblyScaleImage() {
      *  a scale > 1 to indicate down scaling by the CTM.
      */
     if (scaleSqd > SK_Scalar1) {
-        const SkMipMap* mip = NULL;
-
-        SkASSERT(NULL == fScaledCacheID);
-        fScaledCacheID = SkScaledImageCache::FindAndLockMip(fOrigBitmap, &mip);
-        if (!fScaledCacheID) {
-            SkASSERT(NULL == mip);
-            mip = SkMipMap::Build(fOrigBitmap);
-            if (mip) {
-                fScaledCacheID = SkScaledImageCache::AddAndLockMip(fOrigBitmap,
-                                                                   mip);
-                SkASSERT(mip->getRefCnt() > 1);
-                mip->unref();   // the cache took a ref
-                SkASSERT(fScaledCacheID);
-            }
-        } else {
-            SkASSERT(mip);
-        }
-
-        if (mip) {
-            SkScalar levelScale = SkScalarInvert(SkScalarSqrt(scaleSqd));
-            SkMipMap::Level level;
-            if (mip->extractLevel(levelScale, &level)) {
-                SkScalar invScaleFixup = level.fScale;
+        SkScalar levelScale = SkScalarInvert(SkScalarSqrt(scaleSqd));
+        int level = SkMipMap::ComputeLevel(levelScale);
+        if (level > 0) {
+            // Only the level we sample from is built (or found) in the cache.
+            SkASSERT(NULL == fScaledCacheID);
+            fScaledCacheID = SkMipMap::FindAndLockLevel(fOrigBitmap, level,
+                                                        &fScaledBitmap);
+            if (fScaledCacheID) {
+                SkASSERT(NULL != fScaledBitmap.getPixels());
+                SkScalar invScaleFixup = SkIntToScalar(fScaledBitmap.width()) /
+                                         fOrigBitmap.width();
                 fInvMatrix.postScale(invScaleFixup, invScaleFixup);
 
-                SkImageInfo info = fOrigBitmap.info();
-                info.fWidth = level.fWidth;
-                info.fHeight = level.fHeight;
-                fScaledBitmap.installPixels(info, level.fPixels, level.fRowBytes);
                 fBitmap = &fScaledBitmap;
                 fFilterLevel = SkPaint::kLow_FilterLevel;
                 unlocker.release();
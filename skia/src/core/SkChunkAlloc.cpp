@@ -19,6 +19,7 @@ static size_t increase_next_size(size_t size) {
 
 struct SkChunkAlloc::Block {
     Block*  fNext;
+    size_t  fSize;
     size_t  fFreeSize;
     char*   fFreePtr;
     // data[] follows
@@ -69,6 +70,28 @@ void SkChunkAlloc::reset() {
     fBlockCount = 0;
 }
 
+void SkChunkAlloc::rewind() {
+    if (NULL == fBlock) {
+        return;
+    }
+
+    if (fBlock->fNext) {
+        // Coalesce into one block that can hold everything we held before.
+        size_t capacity = fTotalCapacity;
+        this->reset();
+        fBlock = this->newBlock(capacity, kReturnNil_AllocFailType);
+        if (fBlock) {
+            fBlock->fNext = NULL;
+        }
+        return;
+    }
+
+    fBlock->fFreeSize = fBlock->fSize;
+    fBlock->fFreePtr = fBlock->startOfData();
+    fChunkSize = fMinSize;
+    fTotalUsed = 0;
+}
+
 SkChunkAlloc::Block* SkChunkAlloc::newBlock(size_t bytes, AllocFailType ftype) {
     size_t size = bytes;
     if (size < fChunkSize) {
@@ -80,6 +103,7 @@ SkChunkAlloc::Block* SkChunkAlloc::newBlock(size_t bytes, AllocFailType ftype) {
 
     if (block) {
         //    block->fNext = fBlock;
+        block->fSize = size;
         block->fFreeSize = size;
         block->fFreePtr = block->startOfData();
 
@@ -11,6 +11,13 @@
 #include "SkEdgeClipper.h"
 #include "SkLineClipper.h"
 #include "SkGeometry.h"
+#include "SkTLS.h"
+
+// Per-thread edge storage larger than this is freed after each draw, rather
+// than kept around for the next one.
+#ifndef SK_EDGEBUILDER_MAX_RETAINED_BYTES
+    #define SK_EDGEBUILDER_MAX_RETAINED_BYTES   (256 * 1024)
+#endif
 
 template <typename T> static T* typedAllocThrow(SkChunkAlloc& alloc) {
     return static_cast<T*>(alloc.allocThrow(sizeof(T)));
@@ -20,6 +27,15 @@ template <typename T> static T* typedAllocThrow(SkChunkAlloc& alloc) {
 
 SkEdgeBuilder::SkEdgeBuilder() : fAlloc(16*1024) {
     fEdgeList = NULL;
+    fInUse = false;
+}
+
+void SkEdgeBuilder::trimStorage(size_t maxBytes) {
+    if (fAlloc.totalCapacity() + fList.reserved() * sizeof(SkEdge*) > maxBytes) {
+        fAlloc.reset();
+        fList.reset();
+        fEdgeList = NULL;
+    }
 }
 
 void SkEdgeBuilder::addLine(const SkPoint pts[]) {
@@ -163,8 +179,9 @@ static void handle_quad(SkEdgeBuilder* builder, const SkPoint pts[3]) {
 
 int SkEdgeBuilder::build(const SkPath& path, const SkIRect* iclip,
                          int shiftUp) {
-    fAlloc.reset();
-    fList.reset();
+    // keep our storage from the previous build (if any) for reuse
+    fAlloc.rewind();
+    fList.rewind();
     fShiftUp = shiftUp;
 
     SkScalar conicTol = SK_ScalarHalf * (1 << shiftUp);
@@ -278,3 +295,33 @@ int SkEdgeBuilder::build(const SkPath& path, const SkIRect* iclip,
     fEdgeList = fList.begin();
     return fList.count();
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void* create_thread_builder() {
+    return SkNEW(SkEdgeBuilder);
+}
+
+static void delete_thread_builder(void* builder) {
+    SkDELETE(static_cast<SkEdgeBuilder*>(builder));
+}
+
+SkEdgeBuilder* SkEdgeBuilder::AcquireThreadBuilder() {
+    SkEdgeBuilder* builder = static_cast<SkEdgeBuilder*>(
+            SkTLS::Get(create_thread_builder, delete_thread_builder));
+    if (builder->fInUse) {
+        builder = SkNEW(SkEdgeBuilder);
+    }
+    builder->fInUse = true;
+    return builder;
+}
+
+void SkEdgeBuilder::ReleaseThreadBuilder(SkEdgeBuilder* builder) {
+    SkASSERT(builder && builder->fInUse);
+    if (builder != SkTLS::Find(create_thread_builder)) {
+        SkDELETE(builder);
+        return;
+    }
+    builder->trimStorage(SK_EDGEBUILDER_MAX_RETAINED_BYTES);
+    builder->fInUse = false;
+}
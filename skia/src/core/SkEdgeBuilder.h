@@ -26,6 +26,12 @@ public:
 
     SkEdge** edgeList() { return fEdgeList; }
 
+    /**
+     *  Frees the edge storage if it has grown beyond maxBytes. Otherwise the
+     *  storage is kept, and reused by the next call to build().
+     */
+    void trimStorage(size_t maxBytes);
+
 private:
     SkChunkAlloc        fAlloc;
     SkTDArray<SkEdge*>  fList;
@@ -47,6 +53,35 @@ public:
     void addClipper(SkEdgeClipper*);
 
     int buildPoly(const SkPath& path, const SkIRect* clip, int shiftUp);
+
+    /**
+     *  Returns the calling thread's builder, or a new one if that is already
+     *  in use. Must be balanced by a call to ReleaseThreadBuilder().
+     */
+    static SkEdgeBuilder* AcquireThreadBuilder();
+    static void ReleaseThreadBuilder(SkEdgeBuilder*);
+
+private:
+    bool                fInUse;
+};
+
+/**
+ *  Provides an SkEdgeBuilder owned by the calling thread, so that drawing many
+ *  paths reuses the same edge storage (at its high-water capacity) instead of
+ *  allocating and freeing it for every path. If the thread's builder is
+ *  already in use (re-entrant scan conversion), a temporary one is used.
+ */
+class SkAutoEdgeBuilder : SkNoncopyable {
+public:
+    SkAutoEdgeBuilder() : fBuilder(SkEdgeBuilder::AcquireThreadBuilder()) {}
+    ~SkAutoEdgeBuilder() { SkEdgeBuilder::ReleaseThreadBuilder(fBuilder); }
+
+    SkEdgeBuilder* get() const { return fBuilder; }
+    SkEdgeBuilder* operator->() const { return fBuilder; }
+
+private:
+    SkEdgeBuilder*  fBuilder;
 };
+#define SkAutoEdgeBuilder(...) SK_REQUIRE_LOCAL_VAR(SkAutoEdgeBuilder)
 
 #endif
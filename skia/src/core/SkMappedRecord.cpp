@@ -0,0 +1,995 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMappedRecord.h"
+
+#include "SkCanvas.h"
+#include "SkChecksum.h"
+#include "SkChunkAlloc.h"
+#include "SkMallocPixelRef.h"
+#include "SkPictureFlat.h"
+#include "SkPtrRecorder.h"
+#include "SkReadBuffer.h"
+#include "SkRecord.h"
+#include "SkStream.h"
+#include "SkTDynamicHash.h"
+#include "SkTypeface.h"
+#include "SkWriteBuffer.h"
+#include "SkWriter32.h"
+
+using namespace SkRecords;
+
+// The serialized data is laid out as
+//     Header
+//     uint32_t offsets[fCount]       of each command, from the start of the commands
+//     commands                       fOpsSize bytes
+//     tables                         fTablesSize bytes
+//     pixels                         fPixelsSize bytes
+// Each command is its SkRecords::Type followed by its arguments.  Scalars, rects and arrays of
+// points and text are written as is, so that they can be played back in place.  Paints, paths and
+// bitmaps are written as indices into the tables, which hold them flattened.  Bitmaps whose pixels
+// can be used in place point into the pixels instead.
+//
+// Every section is a multiple of 4 bytes, so if the data is 4-byte aligned, so is every command.
+
+namespace {
+
+static const uint32_t kMagic   = SkSetFourByteTag('s', 'k', 'r', 'm');
+// Bump this whenever SK_RECORD_TYPES or the way any command is written changes.
+static const uint32_t kVersion = 1;
+
+// Stands in for the paint index of commands that don't have a paint.
+static const uint32_t kNoPaint = 0xFFFFFFFF;
+
+struct Header {
+    uint32_t fMagic;
+    uint32_t fVersion;
+    uint32_t fCount;       // The number of commands.
+    uint32_t fOpsSize;     // Sizes in bytes of each section.
+    uint32_t fTablesSize;
+    uint32_t fPixelsSize;
+};
+
+static size_t bytes_per_pixel_in_place(SkColorType colorType) {
+    switch (colorType) {
+        case kN32_SkColorType:       return 4;
+        case kRGB_565_SkColorType:   return 2;
+        case kARGB_4444_SkColorType: return 2;
+        case kAlpha_8_SkColorType:   return 1;
+        default:                     return 0;  // Not supported in place, e.g. needs a color table.
+    }
+}
+
+// Maps keys, compared by their bytes, to the index they were first added with.
+class KeyIndex : SkNoncopyable {
+public:
+    KeyIndex() : fAlloc(4096) {}
+
+    // If an identical key was added before, returns its index.  Otherwise adds key with index.
+    // size must be a multiple of 4.
+    uint32_t findOrAdd(const void* key, size_t size, uint32_t index) {
+        Key lookup;
+        lookup.fBytes = key;
+        lookup.fSize = size;
+        lookup.fHash = SkChecksum::Murmur3((const uint32_t*)key, size);
+        if (const Entry* entry = fEntries.find(lookup)) {
+            return entry->fIndex;
+        }
+
+        Entry* entry = (Entry*)fAlloc.allocThrow(sizeof(Entry) + size);
+        memcpy(entry + 1, key, size);
+        entry->fKey = lookup;
+        entry->fKey.fBytes = entry + 1;
+        entry->fIndex = index;
+        fEntries.add(entry);
+        return index;
+    }
+
+private:
+    struct Key {
+        const void* fBytes;
+        size_t      fSize;
+        uint32_t    fHash;
+
+        bool operator==(const Key& other) const {
+            return fHash == other.fHash &&
+                   fSize == other.fSize &&
+                   0 == memcmp(fBytes, other.fBytes, fSize);
+        }
+    };
+
+    struct Entry {
+        Key      fKey;
+        uint32_t fIndex;
+
+        static const Key& GetKey(const Entry& entry) { return entry.fKey; }
+        static uint32_t Hash(const Key& key) { return key.fHash; }
+    };
+
+    SkTDynamicHash<Entry, Key> fEntries;
+    SkChunkAlloc fAlloc;  // Owns the Entries and a copy of their keys.
+};
+
+// Tells whether a command is a NoOp.  NoOps aren't written.
+struct IsNoOp {
+    template <typename T> bool operator()(const T&) { return false; }
+    bool operator()(const NoOp&) { return true; }
+};
+
+// An SkRecord visitor that writes each command and the tables it refers to.
+class Serializer : SkNoncopyable {
+public:
+    explicit Serializer(const SkRecord&);
+
+    void write(SkWStream*);
+
+    template <typename T> void operator()(const T& r) {
+        fOffsets.push(SkToU32(fOps.bytesWritten()));
+        fOps.write32(T::kType);
+        this->writeArgs(r);
+    }
+    void operator()(const NoOp&) {}
+
+private:
+    // No base case, so we'll be compile-time checked that we implement all possibilities.
+    template <typename T> void writeArgs(const T&);
+
+    void writePaint(const SkPaint*);
+    void writePath(const SkPath&);
+    void writeBitmap(const SkBitmap&);
+    void writeMatrix(const SkMatrix&);
+
+    // Returns the index of the command at index i of the SkRecord, once NoOps are left out.
+    unsigned indexWithoutNoOps(unsigned i) const { return fKeptBefore[i]; }
+
+    SkAutoTMalloc<unsigned> fKeptBefore;  // The number of commands kept before each command.
+    unsigned fCurrentOp;
+
+    SkTDArray<uint32_t> fOffsets;
+    SkWriter32 fOps;
+
+    SkRefCntSet  fTypefaces;
+    SkFactorySet fFactories;
+
+    // Paints and paths are appended to their tables already flattened, so they can be compared.
+    SkWriter32 fPaints;
+    SkWriter32 fPaths;
+    SkWriteBuffer fBitmaps;
+    uint32_t fPaintCount, fPathCount, fBitmapCount;
+    KeyIndex fPaintIndex, fPathIndex, fBitmapIndex;
+
+    SkDynamicMemoryWStream fPixels;
+};
+
+Serializer::Serializer(const SkRecord& record)
+    : fKeptBefore(record.count() + 1)
+    , fBitmaps(SkWriteBuffer::kCrossProcess_Flag)
+    , fPaintCount(0)
+    , fPathCount(0)
+    , fBitmapCount(0) {
+    fBitmaps.setTypefaceRecorder(&fTypefaces);
+    fBitmaps.setFactoryRecorder(&fFactories);
+
+    IsNoOp isNoOp;
+    fKeptBefore[0] = 0;
+    for (unsigned i = 0; i < record.count(); i++) {
+        fKeptBefore[i+1] = fKeptBefore[i] + (record.visit<bool>(i, isNoOp) ? 0 : 1);
+    }
+
+    for (fCurrentOp = 0; fCurrentOp < record.count(); fCurrentOp++) {
+        record.visit<void>(fCurrentOp, *this);
+    }
+    fBitmaps.setTypefaceRecorder(NULL);
+    fBitmaps.setFactoryRecorder(NULL);
+}
+
+void Serializer::writePaint(const SkPaint* paint) {
+    if (NULL == paint) {
+        fOps.write32(kNoPaint);
+        return;
+    }
+    SkWriteBuffer buffer(SkWriteBuffer::kCrossProcess_Flag);
+    buffer.setTypefaceRecorder(&fTypefaces);
+    buffer.setFactoryRecorder(&fFactories);
+    buffer.writePaint(*paint);
+
+    SkAutoMalloc flat(buffer.bytesWritten());
+    buffer.writeToMemory(flat.get());
+    const uint32_t index = fPaintIndex.findOrAdd(flat.get(), buffer.bytesWritten(), fPaintCount);
+    if (index == fPaintCount) {
+        fPaints.write(flat.get(), buffer.bytesWritten());
+        fPaintCount++;
+    }
+    fOps.write32(index);
+
+    buffer.setTypefaceRecorder(NULL);
+    buffer.setFactoryRecorder(NULL);
+}
+
+void Serializer::writePath(const SkPath& path) {
+    SkWriter32 flat;
+    flat.writePath(path);
+
+    SkAutoMalloc bytes(flat.bytesWritten());
+    flat.flatten(bytes.get());
+    const uint32_t index = fPathIndex.findOrAdd(bytes.get(), flat.bytesWritten(), fPathCount);
+    if (index == fPathCount) {
+        fPaths.write(bytes.get(), flat.bytesWritten());
+        fPathCount++;
+    }
+    fOps.write32(index);
+}
+
+void Serializer::writeBitmap(const SkBitmap& bitmap) {
+    // Recorded bitmaps are immutable, so bitmaps sharing pixels draw the same.
+    const SkIPoint origin = bitmap.pixelRefOrigin();
+    const uint32_t key[] = {
+        bitmap.getGenerationID(),
+        SkToU32(origin.fX), SkToU32(origin.fY),
+        SkToU32(bitmap.width()), SkToU32(bitmap.height()),
+        SkToU32(bitmap.colorType()),
+    };
+    const uint32_t index = fBitmapIndex.findOrAdd(key, sizeof(key), fBitmapCount);
+    fOps.write32(index);
+    if (index != fBitmapCount) {
+        return;
+    }
+    fBitmapCount++;
+
+    const size_t bytesPerPixel = bytes_per_pixel_in_place(bitmap.colorType());
+    SkAutoLockPixels lock(bitmap);
+    if (0 == bytesPerPixel || NULL == bitmap.getPixels() || bitmap.width() <= 0) {
+        fBitmaps.writeBool(false);
+        fBitmaps.writeBitmap(bitmap);
+        return;
+    }
+
+    const size_t rowBytes = SkAlign4(bitmap.width() * bytesPerPixel);
+    fBitmaps.writeBool(true);
+    fBitmaps.writeInt(bitmap.width());
+    fBitmaps.writeInt(bitmap.height());
+    fBitmaps.writeInt(bitmap.colorType());
+    fBitmaps.writeInt(bitmap.alphaType());
+    fBitmaps.writeUInt(SkToU32(rowBytes));
+    fBitmaps.writeUInt(SkToU32(fPixels.bytesWritten()));
+
+    const uint32_t zero = 0;
+    const size_t pad = rowBytes - bitmap.width() * bytesPerPixel;
+    for (int y = 0; y < bitmap.height(); y++) {
+        fPixels.write(bitmap.getAddr(0, y), bitmap.width() * bytesPerPixel);
+        fPixels.write(&zero, pad);
+    }
+}
+
+void Serializer::writeMatrix(const SkMatrix& matrix) {
+    for (int i = 0; i < 9; i++) {
+        fOps.writeScalar(matrix[i]);
+    }
+}
+
+template <> void Serializer::writeArgs(const Restore&) {}
+template <> void Serializer::writeArgs(const Save& r) { fOps.write32(r.flags); }
+template <> void Serializer::writeArgs(const SaveLayer& r) {
+    fOps.writeBool(NULL != r.bounds);
+    if (NULL != r.bounds) {
+        fOps.writeRect(*r.bounds);
+    }
+    this->writePaint(r.paint);
+    fOps.write32(r.flags);
+}
+
+template <> void Serializer::writeArgs(const PushCull& r) { fOps.writeRect(r.rect); }
+template <> void Serializer::writeArgs(const PopCull&) {}
+template <> void Serializer::writeArgs(const PairedPushCull& r) {
+    fOps.writeRect(r.base->rect);
+    // PairedPushCull skips the commands after it up to and including skip, some of which may be
+    // NoOps we leave out.
+    fOps.write32(this->indexWithoutNoOps(fCurrentOp + r.skip + 1) -
+                 this->indexWithoutNoOps(fCurrentOp + 1));
+}
+
+template <> void Serializer::writeArgs(const Concat& r) { this->writeMatrix(r.matrix); }
+template <> void Serializer::writeArgs(const SetMatrix& r) { this->writeMatrix(r.matrix); }
+
+template <> void Serializer::writeArgs(const ClipPath& r) {
+    this->writePath(r.path);
+    fOps.write32(r.op);
+    fOps.writeBool(r.doAA);
+}
+template <> void Serializer::writeArgs(const ClipRRect& r) {
+    fOps.writeRRect(r.rrect);
+    fOps.write32(r.op);
+    fOps.writeBool(r.doAA);
+}
+template <> void Serializer::writeArgs(const ClipRect& r) {
+    fOps.writeRect(r.rect);
+    fOps.write32(r.op);
+    fOps.writeBool(r.doAA);
+}
+template <> void Serializer::writeArgs(const ClipRegion& r) {
+    fOps.write32(SkToU32(r.region.writeToMemory(NULL)));
+    fOps.writeRegion(r.region);
+    fOps.write32(r.op);
+}
+
+template <> void Serializer::writeArgs(const Clear& r) { fOps.write32(r.color); }
+
+template <> void Serializer::writeArgs(const DrawBitmap& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fOps.writeScalar(r.left);
+    fOps.writeScalar(r.top);
+}
+template <> void Serializer::writeArgs(const DrawBitmapMatrix& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    this->writeMatrix(r.matrix);
+}
+template <> void Serializer::writeArgs(const DrawBitmapNine& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fOps.writeIRect(r.center);
+    fOps.writeRect(r.dst);
+}
+template <> void Serializer::writeArgs(const DrawBitmapRectToRect& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fOps.writeBool(NULL != r.src);
+    if (NULL != r.src) {
+        fOps.writeRect(*r.src);
+    }
+    fOps.writeRect(r.dst);
+    fOps.write32(r.flags);
+}
+template <> void Serializer::writeArgs(const DrawDRRect& r) {
+    this->writePaint(&r.paint);
+    fOps.writeRRect(r.outer);
+    fOps.writeRRect(r.inner);
+}
+template <> void Serializer::writeArgs(const DrawOval& r) {
+    this->writePaint(&r.paint);
+    fOps.writeRect(r.oval);
+}
+template <> void Serializer::writeArgs(const DrawPaint& r) { this->writePaint(&r.paint); }
+template <> void Serializer::writeArgs(const DrawPath& r) {
+    this->writePaint(&r.paint);
+    this->writePath(r.path);
+}
+template <> void Serializer::writeArgs(const DrawPoints& r) {
+    this->writePaint(&r.paint);
+    fOps.write32(r.mode);
+    fOps.write32(SkToU32(r.count));
+    fOps.write(r.pts, r.count * sizeof(SkPoint));
+}
+template <> void Serializer::writeArgs(const DrawPosText& r) {
+    this->writePaint(&r.paint);
+    const int points = r.paint.countText(r.text, r.byteLength);
+    fOps.write32(SkToU32(r.byteLength));
+    fOps.write32(points);
+    fOps.writePad(r.text, r.byteLength);
+    fOps.write(r.pos, points * sizeof(SkPoint));
+}
+template <> void Serializer::writeArgs(const DrawPosTextH& r) {
+    this->writePaint(&r.paint);
+    const int points = r.paint.countText(r.text, r.byteLength);
+    fOps.write32(SkToU32(r.byteLength));
+    fOps.write32(points);
+    fOps.writeScalar(r.y);
+    fOps.writePad(r.text, r.byteLength);
+    fOps.write(r.xpos, points * sizeof(SkScalar));
+}
+template <> void Serializer::writeArgs(const BoundedDrawPosTextH& r) {
+    fOps.writeScalar(r.minY);
+    fOps.writeScalar(r.maxY);
+    this->writeArgs(*r.base);
+}
+template <> void Serializer::writeArgs(const DrawRRect& r) {
+    this->writePaint(&r.paint);
+    fOps.writeRRect(r.rrect);
+}
+template <> void Serializer::writeArgs(const DrawRect& r) {
+    this->writePaint(&r.paint);
+    fOps.writeRect(r.rect);
+}
+template <> void Serializer::writeArgs(const DrawSprite& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fOps.writeInt(r.left);
+    fOps.writeInt(r.top);
+}
+template <> void Serializer::writeArgs(const DrawText& r) {
+    this->writePaint(&r.paint);
+    fOps.write32(SkToU32(r.byteLength));
+    fOps.writeScalar(r.x);
+    fOps.writeScalar(r.y);
+    fOps.writePad(r.text, r.byteLength);
+}
+template <> void Serializer::writeArgs(const DrawTextOnPath& r) {
+    this->writePaint(&r.paint);
+    fOps.write32(SkToU32(r.byteLength));
+    this->writePath(r.path);
+    fOps.writeBool(NULL != r.matrix);
+    if (NULL != r.matrix) {
+        this->writeMatrix(*r.matrix);
+    }
+    fOps.writePad(r.text, r.byteLength);
+}
+template <> void Serializer::writeArgs(const DrawVertices& r) {
+    this->writePaint(&r.paint);
+    fOps.write32(r.vmode);
+    fOps.write32(r.vertexCount);
+    fOps.write32(r.indexCount);
+    fOps.writeBool(NULL != r.texs);
+    fOps.writeBool(NULL != r.colors);
+    // The xfermode is written as the only effect of a paint, to share the paints' table.
+    if (NULL != r.xmode.get()) {
+        SkPaint xmodePaint;
+        xmodePaint.setXfermode(r.xmode.get());
+        this->writePaint(&xmodePaint);
+    } else {
+        this->writePaint(NULL);
+    }
+    fOps.write(r.vertices, r.vertexCount * sizeof(SkPoint));
+    if (NULL != r.texs) {
+        fOps.write(r.texs, r.vertexCount * sizeof(SkPoint));
+    }
+    if (NULL != r.colors) {
+        fOps.write(r.colors, r.vertexCount * sizeof(SkColor));
+    }
+    fOps.writePad(r.indices, r.indexCount * sizeof(uint16_t));
+}
+
+void Serializer::write(SkWStream* stream) {
+    // The factories and typefaces the tables refer to come first, as in an SkPicture.
+    SkDynamicMemoryWStream tables;
+    tables.write32(fFactories.count());
+    SkAutoTMalloc<SkFlattenable::Factory> factories(fFactories.count());
+    fFactories.copyToArray(factories.get());
+    for (int i = 0; i < fFactories.count(); i++) {
+        const char* name = SkFlattenable::FactoryToName(factories[i]);
+        const size_t length = NULL == name ? 0 : strlen(name);
+        tables.writePackedUInt(length);
+        tables.write(name, length);
+    }
+    tables.write32(fTypefaces.count());
+    SkAutoTMalloc<SkRefCnt*> typefaces(fTypefaces.count());
+    fTypefaces.copyToArray(typefaces.get());
+    for (int i = 0; i < fTypefaces.count(); i++) {
+        ((SkTypeface*)typefaces[i])->serialize(&tables);
+    }
+    const uint32_t zero = 0;
+    tables.write(&zero, SkAlign4(tables.bytesWritten()) - tables.bytesWritten());
+
+    tables.write32(fPaintCount);
+    fPaints.writeToStream(&tables);
+    tables.write32(fPathCount);
+    fPaths.writeToStream(&tables);
+    tables.write32(fBitmapCount);
+    SkAutoMalloc bitmaps(fBitmaps.bytesWritten());
+    fBitmaps.writeToMemory(bitmaps.get());
+    tables.write(bitmaps.get(), fBitmaps.bytesWritten());
+
+    Header header;
+    header.fMagic      = kMagic;
+    header.fVersion    = kVersion;
+    header.fCount      = fOffsets.count();
+    header.fOpsSize    = SkToU32(fOps.bytesWritten());
+    header.fTablesSize = SkToU32(tables.bytesWritten());
+    header.fPixelsSize = SkToU32(fPixels.bytesWritten());
+    stream->write(&header, sizeof(header));
+    stream->write(fOffsets.begin(), fOffsets.count() * sizeof(uint32_t));
+    fOps.writeToStream(stream);
+    SkAutoTDelete<SkStreamAsset> tablesStream(tables.detachAsStream());
+    stream->writeStream(tablesStream.get(), tablesStream->getLength());
+    SkAutoTDelete<SkStreamAsset> pixelsStream(fPixels.detachAsStream());
+    stream->writeStream(pixelsStream.get(), pixelsStream->getLength());
+}
+
+// Reads the arguments of a command in place.  Reading past the end of the command fails, after
+// which every read returns NULL or 0.
+class OpReader : SkNoncopyable {
+public:
+    OpReader(const char* start, const char* stop) : fCurr(start), fStop(stop), fValid(true) {}
+
+    bool isValid() const { return fValid; }
+
+    template <typename T> const T* skip(size_t count = 1) {
+        const size_t available = fStop - fCurr;
+        if (!fValid || count > available / sizeof(T) || SkAlign4(count * sizeof(T)) > available) {
+            fValid = false;
+            return NULL;
+        }
+        const T* ptr = (const T*)fCurr;
+        fCurr += SkAlign4(count * sizeof(T));
+        return ptr;
+    }
+
+    uint32_t readU32() {
+        const uint32_t* value = this->skip<uint32_t>();
+        return value ? *value : 0;
+    }
+    int32_t readInt() { return (int32_t)this->readU32(); }
+    bool readBool() { return 0 != this->readU32(); }
+    SkScalar readScalar() {
+        const SkScalar* value = this->skip<SkScalar>();
+        return value ? *value : 0;
+    }
+
+    void readMatrix(SkMatrix* matrix) {
+        const SkScalar* m = this->skip<SkScalar>(9);
+        if (NULL != m) {
+            matrix->setAll(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8]);
+        }
+    }
+    void readRRect(SkRRect* rrect) {
+        const char* bytes = this->skip<char>(SkRRect::kSizeInMemory);
+        if (NULL != bytes) {
+            rrect->readFromMemory(bytes, SkRRect::kSizeInMemory);
+        }
+    }
+
+private:
+    const char* fCurr;
+    const char* fStop;
+    bool fValid;
+};
+
+static bool valid_op(uint32_t op) { return op <= SkRegion::kLastOp; }
+
+}  // namespace
+
+void SkRecordSerialize(const SkRecord& record, SkWStream* stream) {
+    Serializer serializer(record);
+    serializer.write(stream);
+}
+
+SkMappedRecord::SkMappedRecord(SkData* data)
+    : fData(SkRef(data))
+    , fCount(0)
+    , fOffsets(NULL)
+    , fOps(NULL)
+    , fOpsSize(0) {}
+
+SkMappedRecord* SkMappedRecord::Create(SkData* data) {
+    SkASSERT(NULL != data);
+    if (data->size() < sizeof(Header)) {
+        return NULL;
+    }
+
+    // Commands are read in place, so they must be aligned.  Mapped files always are.
+    SkAutoTUnref<SkData> aligned(SkIsAlign4((intptr_t)data->data())
+                                     ? SkRef(data)
+                                     : SkData::NewWithCopy(data->data(), data->size()));
+
+    const Header* header = (const Header*)aligned->data();
+    if (header->fMagic != kMagic || header->fVersion != kVersion) {
+        return NULL;
+    }
+    const uint64_t size = (uint64_t)sizeof(Header) + (uint64_t)header->fCount * sizeof(uint32_t)
+                        + header->fOpsSize + header->fTablesSize + header->fPixelsSize;
+    if (size != aligned->size() || !SkIsAlign4(header->fOpsSize) ||
+        !SkIsAlign4(header->fTablesSize)) {
+        return NULL;
+    }
+
+    SkAutoTDelete<SkMappedRecord> record(SkNEW_ARGS(SkMappedRecord, (aligned)));
+    record->fCount   = header->fCount;
+    record->fOffsets = (const uint32_t*)(header + 1);
+    record->fOps     = (const char*)(record->fOffsets + record->fCount);
+    record->fOpsSize = header->fOpsSize;
+
+    const char* tables = record->fOps + record->fOpsSize;
+    if (!record->parseTables(tables, header->fTablesSize,
+                             tables + header->fTablesSize, header->fPixelsSize)) {
+        return NULL;
+    }
+
+    const SkMatrix& identity = SkMatrix::I();
+    for (unsigned i = 0; i < record->fCount; i++) {
+        const uint32_t offset = record->fOffsets[i];
+        const uint32_t next = i + 1 < record->fCount ? record->fOffsets[i+1] : record->fOpsSize;
+        if (!SkIsAlign4(offset) || offset >= next || next > record->fOpsSize) {
+            return NULL;
+        }
+        const int skip = record->play(i, NULL, identity);
+        if (skip < 0 || i + skip >= record->fCount) {
+            return NULL;
+        }
+    }
+    return record.detach();
+}
+
+bool SkMappedRecord::parseTables(const void* tables, size_t size,
+                                 const void* pixels, size_t pixelsSize) {
+    SkMemoryStream stream(tables, size);
+
+    const uint32_t factoryCount = stream.readU32();
+    if (factoryCount > size) {
+        return false;
+    }
+    SkFactoryPlayback factories(factoryCount);
+    for (uint32_t i = 0; i < factoryCount; i++) {
+        SkString name;
+        const size_t length = stream.readPackedUInt();
+        if (length > size) {
+            return false;
+        }
+        name.resize(length);
+        if (stream.read(name.writable_str(), length) != length) {
+            return false;
+        }
+        factories.base()[i] = SkFlattenable::NameToFactory(name.c_str());
+    }
+
+    const uint32_t typefaceCount = stream.readU32();
+    if (typefaceCount > size) {
+        return false;
+    }
+    SkTypefacePlayback typefaces;
+    typefaces.setCount(typefaceCount);
+    for (uint32_t i = 0; i < typefaceCount; i++) {
+        SkAutoTUnref<SkTypeface> typeface(SkTypeface::Deserialize(&stream));
+        if (NULL == typeface.get()) {
+            typeface.reset(SkTypeface::RefDefault());
+        }
+        typefaces.set(i, typeface);
+    }
+
+    const size_t flattened = SkAlign4(stream.getPosition());
+    if (flattened > size) {
+        return false;
+    }
+    SkReadBuffer buffer((const char*)tables + flattened, size - flattened);
+    buffer.setFlags(SkReadBuffer::kCrossProcess_Flag | SkReadBuffer::kScalarIsFloat_Flag);
+    factories.setupBuffer(buffer);
+    typefaces.setupBuffer(buffer);
+
+    const uint32_t paintCount = buffer.readUInt();
+    if (paintCount > size) {
+        return false;
+    }
+    fPaints.push_back_n(paintCount);
+    for (uint32_t i = 0; i < paintCount; i++) {
+        buffer.readPaint(&fPaints[i]);
+    }
+
+    const uint32_t pathCount = buffer.readUInt();
+    if (pathCount > size) {
+        return false;
+    }
+    fPaths.push_back_n(pathCount);
+    for (uint32_t i = 0; i < pathCount; i++) {
+        buffer.readPath(&fPaths[i]);
+    }
+
+    const uint32_t bitmapCount = buffer.readUInt();
+    if (bitmapCount > size) {
+        return false;
+    }
+    fBitmaps.push_back_n(bitmapCount);
+    for (uint32_t i = 0; i < bitmapCount; i++) {
+        SkBitmap* bitmap = &fBitmaps[i].fBitmap;
+        if (!buffer.readBool()) {
+            buffer.readBitmap(bitmap);
+            continue;
+        }
+
+        const int width  = buffer.readInt();
+        const int height = buffer.readInt();
+        const SkColorType colorType = (SkColorType)buffer.readInt();
+        const SkAlphaType alphaType = (SkAlphaType)buffer.readInt();
+        const size_t rowBytes = buffer.readUInt();
+        const size_t offset = buffer.readUInt();
+
+        const size_t bytesPerPixel = bytes_per_pixel_in_place(colorType);
+        if (0 == bytesPerPixel || width <= 0 || height <= 0 ||
+            (uint64_t)width * bytesPerPixel > rowBytes || !SkIsAlign4(offset) ||
+            offset > pixelsSize || (uint64_t)height * rowBytes > pixelsSize - offset ||
+            alphaType < 0 || alphaType > kLastEnum_SkAlphaType) {
+            return false;
+        }
+
+        // The pixel ref refs fData, which outlives the in-place pixels.
+        const SkImageInfo info = SkImageInfo::Make(width, height, colorType, alphaType);
+        const size_t start = (const char*)pixels - (const char*)fData->data() + offset;
+        SkAutoTUnref<SkData> subset(SkData::NewSubset(fData, start, height * rowBytes));
+        SkAutoTUnref<SkPixelRef> pixelRef(
+                SkMallocPixelRef::NewWithData(info, rowBytes, NULL, subset));
+        if (NULL == pixelRef.get()) {
+            return false;
+        }
+        bitmap->setInfo(info, rowBytes);
+        bitmap->setPixelRef(pixelRef);
+        bitmap->setImmutable();
+    }
+    return buffer.isValid();
+}
+
+void SkMappedRecord::draw(SkCanvas* canvas) const {
+    const SkMatrix initialCTM = canvas->getTotalMatrix();
+    for (unsigned i = 0; i < fCount; i++) {
+        const int skip = this->play(i, canvas, initialCTM);
+        SkASSERT(skip >= 0);  // Create() checked every command.
+        i += skip;
+    }
+}
+
+// Each case reads the arguments of its command, then checks them and returns -1 if they're not
+// valid, and otherwise plays the command back if there's a canvas.  Any pointer read may be NULL
+// until reader.isValid() has been checked.
+int SkMappedRecord::play(unsigned i, SkCanvas* canvas, const SkMatrix& initialCTM) const {
+    const uint32_t stop = i + 1 < fCount ? fOffsets[i+1] : fOpsSize;
+    OpReader reader(fOps + fOffsets[i], fOps + stop);
+
+    #define PAINT(index) (kNoPaint == (index) ? NULL : &fPaints[index])
+    #define VALID_PAINT(index) ((index) < (uint32_t)fPaints.count())
+    #define VALID_OPTIONAL_PAINT(index) (kNoPaint == (index) || VALID_PAINT(index))
+    #define VALID_PATH(index) ((index) < (uint32_t)fPaths.count())
+    #define VALID_BITMAP(index) ((index) < (uint32_t)fBitmaps.count())
+    #define CHECK(valid) if (!reader.isValid() || !(valid)) { return -1; } \
+                         if (NULL == canvas) { return 0; }
+
+    const uint32_t type = reader.readU32();
+    switch (type) {
+        case NoOp_Type: {
+            CHECK(true);
+        } return 0;
+        case Restore_Type: {
+            CHECK(true);
+            canvas->restore();
+        } return 0;
+        case Save_Type: {
+            const SkCanvas::SaveFlags flags = (SkCanvas::SaveFlags)reader.readU32();
+            CHECK(true);
+            canvas->save(flags);
+        } return 0;
+        case SaveLayer_Type: {
+            const SkRect* bounds = reader.readBool() ? reader.skip<SkRect>() : NULL;
+            const uint32_t paint = reader.readU32();
+            const SkCanvas::SaveFlags flags = (SkCanvas::SaveFlags)reader.readU32();
+            CHECK(VALID_OPTIONAL_PAINT(paint));
+            canvas->saveLayer(bounds, PAINT(paint), flags);
+        } return 0;
+        case PushCull_Type: {
+            const SkRect* rect = reader.skip<SkRect>();
+            CHECK(true);
+            canvas->pushCull(*rect);
+        } return 0;
+        case PopCull_Type: {
+            CHECK(true);
+            canvas->popCull();
+        } return 0;
+        case PairedPushCull_Type: {
+            const SkRect* rect = reader.skip<SkRect>();
+            const int skip = reader.readInt();
+            if (!reader.isValid() || skip < 0) {
+                return -1;
+            }
+            if (NULL == canvas) {
+                return skip;  // So that Create() checks it stays inside the record.
+            }
+            if (canvas->quickReject(*rect)) {
+                return skip;
+            }
+            canvas->pushCull(*rect);
+        } return 0;
+        case Concat_Type: {
+            SkMatrix matrix;
+            reader.readMatrix(&matrix);
+            CHECK(true);
+            canvas->concat(matrix);
+        } return 0;
+        case SetMatrix_Type: {
+            SkMatrix matrix;
+            reader.readMatrix(&matrix);
+            CHECK(true);
+            canvas->setMatrix(SkMatrix::Concat(initialCTM, matrix));
+        } return 0;
+        case ClipPath_Type: {
+            const uint32_t path = reader.readU32();
+            const uint32_t op = reader.readU32();
+            const bool doAA = reader.readBool();
+            CHECK(VALID_PATH(path) && valid_op(op));
+            canvas->clipPath(fPaths[path], (SkRegion::Op)op, doAA);
+        } return 0;
+        case ClipRRect_Type: {
+            SkRRect rrect;
+            reader.readRRect(&rrect);
+            const uint32_t op = reader.readU32();
+            const bool doAA = reader.readBool();
+            CHECK(valid_op(op));
+            canvas->clipRRect(rrect, (SkRegion::Op)op, doAA);
+        } return 0;
+        case ClipRect_Type: {
+            const SkRect* rect = reader.skip<SkRect>();
+            const uint32_t op = reader.readU32();
+            const bool doAA = reader.readBool();
+            CHECK(valid_op(op));
+            canvas->clipRect(*rect, (SkRegion::Op)op, doAA);
+        } return 0;
+        case ClipRegion_Type: {
+            const uint32_t size = reader.readU32();
+            const char* bytes = reader.skip<char>(size);
+            const uint32_t op = reader.readU32();
+            SkRegion region;
+            CHECK(valid_op(op) && region.readFromMemory(bytes, size) == size);
+            canvas->clipRegion(region, (SkRegion::Op)op);
+        } return 0;
+        case Clear_Type: {
+            const SkColor color = reader.readU32();
+            CHECK(true);
+            canvas->clear(color);
+        } return 0;
+        case DrawBitmap_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t bitmap = reader.readU32();
+            const SkScalar left = reader.readScalar();
+            const SkScalar top = reader.readScalar();
+            CHECK(VALID_OPTIONAL_PAINT(paint) && VALID_BITMAP(bitmap));
+            canvas->drawBitmap(fBitmaps[bitmap].fBitmap, left, top, PAINT(paint));
+        } return 0;
+        case DrawBitmapMatrix_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t bitmap = reader.readU32();
+            SkMatrix matrix;
+            reader.readMatrix(&matrix);
+            CHECK(VALID_OPTIONAL_PAINT(paint) && VALID_BITMAP(bitmap));
+            canvas->drawBitmapMatrix(fBitmaps[bitmap].fBitmap, matrix, PAINT(paint));
+        } return 0;
+        case DrawBitmapNine_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t bitmap = reader.readU32();
+            const SkIRect* center = reader.skip<SkIRect>();
+            const SkRect* dst = reader.skip<SkRect>();
+            CHECK(VALID_OPTIONAL_PAINT(paint) && VALID_BITMAP(bitmap));
+            canvas->drawBitmapNine(fBitmaps[bitmap].fBitmap, *center, *dst, PAINT(paint));
+        } return 0;
+        case DrawBitmapRectToRect_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t bitmap = reader.readU32();
+            const SkRect* src = reader.readBool() ? reader.skip<SkRect>() : NULL;
+            const SkRect* dst = reader.skip<SkRect>();
+            const SkCanvas::DrawBitmapRectFlags flags =
+                    (SkCanvas::DrawBitmapRectFlags)reader.readU32();
+            CHECK(VALID_OPTIONAL_PAINT(paint) && VALID_BITMAP(bitmap));
+            canvas->drawBitmapRectToRect(fBitmaps[bitmap].fBitmap, src, *dst, PAINT(paint), flags);
+        } return 0;
+        case DrawDRRect_Type: {
+            const uint32_t paint = reader.readU32();
+            SkRRect outer, inner;
+            reader.readRRect(&outer);
+            reader.readRRect(&inner);
+            CHECK(VALID_PAINT(paint));
+            canvas->drawDRRect(outer, inner, fPaints[paint]);
+        } return 0;
+        case DrawOval_Type: {
+            const uint32_t paint = reader.readU32();
+            const SkRect* oval = reader.skip<SkRect>();
+            CHECK(VALID_PAINT(paint));
+            canvas->drawOval(*oval, fPaints[paint]);
+        } return 0;
+        case DrawPaint_Type: {
+            const uint32_t paint = reader.readU32();
+            CHECK(VALID_PAINT(paint));
+            canvas->drawPaint(fPaints[paint]);
+        } return 0;
+        case DrawPath_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t path = reader.readU32();
+            CHECK(VALID_PAINT(paint) && VALID_PATH(path));
+            canvas->drawPath(fPaths[path], fPaints[paint]);
+        } return 0;
+        case DrawPoints_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t mode = reader.readU32();
+            const uint32_t count = reader.readU32();
+            const SkPoint* pts = reader.skip<SkPoint>(count);
+            CHECK(VALID_PAINT(paint) && mode <= SkCanvas::kPolygon_PointMode);
+            canvas->drawPoints((SkCanvas::PointMode)mode, count, pts, fPaints[paint]);
+        } return 0;
+        case DrawPosText_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t byteLength = reader.readU32();
+            const uint32_t points = reader.readU32();
+            const char* text = reader.skip<char>(byteLength);
+            const SkPoint* pos = reader.skip<SkPoint>(points);
+            CHECK(VALID_PAINT(paint) &&
+                  (NULL != canvas || fPaints[paint].countText(text, byteLength) == (int)points));
+            canvas->drawPosText(text, byteLength, pos, fPaints[paint]);
+        } return 0;
+        case BoundedDrawPosTextH_Type:
+        case DrawPosTextH_Type: {
+            const bool bounded = BoundedDrawPosTextH_Type == type;
+            const SkScalar minY = bounded ? reader.readScalar() : 0;
+            const SkScalar maxY = bounded ? reader.readScalar() : 0;
+            const uint32_t paint = reader.readU32();
+            const uint32_t byteLength = reader.readU32();
+            const uint32_t points = reader.readU32();
+            const SkScalar y = reader.readScalar();
+            const char* text = reader.skip<char>(byteLength);
+            const SkScalar* xpos = reader.skip<SkScalar>(points);
+            CHECK(VALID_PAINT(paint) &&
+                  (NULL != canvas || fPaints[paint].countText(text, byteLength) == (int)points));
+            if (bounded && canvas->quickRejectY(minY, maxY)) {
+                return 0;
+            }
+            canvas->drawPosTextH(text, byteLength, xpos, y, fPaints[paint]);
+        } return 0;
+        case DrawRRect_Type: {
+            const uint32_t paint = reader.readU32();
+            SkRRect rrect;
+            reader.readRRect(&rrect);
+            CHECK(VALID_PAINT(paint));
+            canvas->drawRRect(rrect, fPaints[paint]);
+        } return 0;
+        case DrawRect_Type: {
+            const uint32_t paint = reader.readU32();
+            const SkRect* rect = reader.skip<SkRect>();
+            CHECK(VALID_PAINT(paint));
+            canvas->drawRect(*rect, fPaints[paint]);
+        } return 0;
+        case DrawSprite_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t bitmap = reader.readU32();
+            const int left = reader.readInt();
+            const int top = reader.readInt();
+            CHECK(VALID_OPTIONAL_PAINT(paint) && VALID_BITMAP(bitmap));
+            canvas->drawSprite(fBitmaps[bitmap].fBitmap, left, top, PAINT(paint));
+        } return 0;
+        case DrawText_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t byteLength = reader.readU32();
+            const SkScalar x = reader.readScalar();
+            const SkScalar y = reader.readScalar();
+            const char* text = reader.skip<char>(byteLength);
+            CHECK(VALID_PAINT(paint));
+            canvas->drawText(text, byteLength, x, y, fPaints[paint]);
+        } return 0;
+        case DrawTextOnPath_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t byteLength = reader.readU32();
+            const uint32_t path = reader.readU32();
+            SkMatrix storage;
+            const bool hasMatrix = reader.readBool();
+            if (hasMatrix) {
+                reader.readMatrix(&storage);
+            }
+            const char* text = reader.skip<char>(byteLength);
+            CHECK(VALID_PAINT(paint) && VALID_PATH(path));
+            canvas->drawTextOnPath(text, byteLength, fPaths[path],
+                                   hasMatrix ? &storage : NULL, fPaints[paint]);
+        } return 0;
+        case DrawVertices_Type: {
+            const uint32_t paint = reader.readU32();
+            const uint32_t vmode = reader.readU32();
+            const uint32_t vertexCount = reader.readU32();
+            const uint32_t indexCount = reader.readU32();
+            const bool hasTexs = reader.readBool();
+            const bool hasColors = reader.readBool();
+            const uint32_t xmode = reader.readU32();
+            const SkPoint* vertices = reader.skip<SkPoint>(vertexCount);
+            const SkPoint* texs = hasTexs ? reader.skip<SkPoint>(vertexCount) : NULL;
+            const SkColor* colors = hasColors ? reader.skip<SkColor>(vertexCount) : NULL;
+            const uint16_t* indices = reader.skip<uint16_t>(indexCount);
+            CHECK(VALID_PAINT(paint) && VALID_OPTIONAL_PAINT(xmode) &&
+                  vmode <= SkCanvas::kTriangleFan_VertexMode &&
+                  (int)vertexCount >= 0 && (int)indexCount >= 0);
+            canvas->drawVertices((SkCanvas::VertexMode)vmode, vertexCount, vertices, texs, colors,
+                                 NULL == PAINT(xmode) ? NULL : PAINT(xmode)->getXfermode(),
+                                 indexCount > 0 ? indices : NULL, indexCount, fPaints[paint]);
+        } return 0;
+        default:
+            return -1;
+    }
+
+    #undef CHECK
+    #undef VALID_BITMAP
+    #undef VALID_PATH
+    #undef VALID_OPTIONAL_PAINT
+    #undef VALID_PAINT
+    #undef PAINT
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMappedRecord_DEFINED
+#define SkMappedRecord_DEFINED
+
+#include "SkBitmap.h"
+#include "SkData.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkTArray.h"
+
+class SkCanvas;
+class SkRecord;
+class SkWStream;
+
+// Write the commands of an SkRecord to stream in the format played back by SkMappedRecord.
+// NoOps are left out.
+void SkRecordSerialize(const SkRecord&, SkWStream*);
+
+// SkMappedRecord plays back commands written by SkRecordSerialize() straight out of the serialized
+// data: the commands, their point arrays and text, and the pixels of most bitmaps are used in
+// place, so the data can be an mmapped file shared by many processes.  Only the paints, paths and
+// bitmaps that can't be used in place, which the commands refer to by index into shared tables,
+// are unflattened when the data is loaded.
+//
+// The format is versioned, but it depends on the layout of SkRecords, so the version must be bumped
+// whenever SK_RECORD_TYPES changes.  It is only readable on machines of the same endianness.  Like
+// a serialized SkPicture, the data is expected to come from a trusted source: the commands are
+// checked when the data is loaded, but the flattened paints, paths and bitmaps are not.
+class SkMappedRecord : SkNoncopyable {
+public:
+    // Returns NULL if data doesn't hold commands written by SkRecordSerialize().  Refs data.
+    static SkMappedRecord* Create(SkData* data);
+
+    // Returns the number of commands.
+    unsigned count() const { return fCount; }
+
+    // Returns the serialized data the commands are played back from.
+    SkData* data() const { return fData.get(); }
+
+    // Draw the commands into a canvas.
+    void draw(SkCanvas*) const;
+
+private:
+    // SkBitmap is an SkRefCnt, but its constructors zero the whole object, vtable pointer
+    // included, so SkTArray<SkBitmap> would crash calling the virtual destructor. Destroying a
+    // Bitmap calls ~SkBitmap() directly.
+    struct Bitmap {
+        SkBitmap fBitmap;
+    };
+
+    explicit SkMappedRecord(SkData*);
+
+    bool parseTables(const void* tables, size_t size, const void* pixels, size_t pixelsSize);
+
+    // Plays back the i-th command into canvas.  If canvas is NULL, only checks that the command
+    // can be played back.  Returns the number of commands to skip after this one, or -1 if the
+    // command is not valid.
+    int play(unsigned i, SkCanvas* canvas, const SkMatrix& initialCTM) const;
+
+    SkAutoTUnref<SkData> fData;
+    unsigned             fCount;
+    const uint32_t*      fOffsets;   // of each command in fOps
+    const char*          fOps;
+    size_t               fOpsSize;
+
+    SkTArray<SkPaint>    fPaints;
+    SkTArray<SkPath>     fPaths;
+    SkTArray<Bitmap>     fBitmaps;
+};
+
+#endif//SkMappedRecord_DEFINED
@@ -8,33 +8,33 @@
 #include "SkMipMap.h"
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
+#include "SkMipMap_opts.h"
 
-static void downsampleby2_proc32(SkBitmap* dst, int x, int y,
-                                 const SkBitmap& src) {
-    x <<= 1;
-    y <<= 1;
-    const SkPMColor* p = src.getAddr32(x, y);
-    const SkPMColor* baseP = p;
-    SkPMColor c, ag, rb;
+/*
+ *  Each row proc averages 2x2 blocks from two adjacent source rows into one
+ *  destination row of dstWidth pixels. Since the destination dimensions are
+ *  always the source dimensions >> 1, every block is fully inside the source,
+ *  so no edge clamping is needed.
+ */
 
-    c = *p; ag = (c >> 8) & 0xFF00FF; rb = c & 0xFF00FF;
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+static void downsample_row_32(void* dst, const void* srcRow0, const void* srcRow1,
+                              int dstWidth) {
+    const SkPMColor* p0 = static_cast<const SkPMColor*>(srcRow0);
+    const SkPMColor* p1 = static_cast<const SkPMColor*>(srcRow1);
+    SkPMColor* d = static_cast<SkPMColor*>(dst);
 
-    p = baseP;
-    if (y < src.height() - 1) {
-        p += src.rowBytes() >> 2;
-    }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+    for (int i = 0; i < dstWidth; ++i) {
+        SkPMColor c, ag, rb;
 
-    *dst->getAddr32(x >> 1, y >> 1) =
-    ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        c = p0[0]; ag  = (c >> 8) & 0xFF00FF; rb  = c & 0xFF00FF;
+        c = p0[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[0]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+
+        d[i] = ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        p0 += 2;
+        p1 += 2;
+    }
 }
 
 static inline uint32_t expand16(U16CPU c) {
@@ -47,31 +47,19 @@ static inline U16CPU pack16(uint32_t c) {
     return (c & ~SK_G16_MASK_IN_PLACE) | ((c >> 16) & SK_G16_MASK_IN_PLACE);
 }
 
-static void downsampleby2_proc16(SkBitmap* dst, int x, int y,
-                                 const SkBitmap& src) {
-    x <<= 1;
-    y <<= 1;
-    const uint16_t* p = src.getAddr16(x, y);
-    const uint16_t* baseP = p;
-    SkPMColor       c;
+static void downsample_row_16(void* dst, const void* srcRow0, const void* srcRow1,
+                              int dstWidth) {
+    const uint16_t* p0 = static_cast<const uint16_t*>(srcRow0);
+    const uint16_t* p1 = static_cast<const uint16_t*>(srcRow1);
+    uint16_t* d = static_cast<uint16_t*>(dst);
 
-    c = expand16(*p);
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c += expand16(*p);
-
-    p = baseP;
-    if (y < src.height() - 1) {
-        p += src.rowBytes() >> 1;
-    }
-    c += expand16(*p);
-    if (x < src.width() - 1) {
-        p += 1;
+    for (int i = 0; i < dstWidth; ++i) {
+        uint32_t c = expand16(p0[0]) + expand16(p0[1]) +
+                     expand16(p1[0]) + expand16(p1[1]);
+        d[i] = (uint16_t)pack16(c >> 2);
+        p0 += 2;
+        p1 += 2;
     }
-    c += expand16(*p);
-
-    *dst->getAddr16(x >> 1, y >> 1) = (uint16_t)pack16(c >> 2);
 }
 
 static uint32_t expand4444(U16CPU c) {
@@ -82,174 +70,178 @@ static U16CPU collaps4444(uint32_t c) {
     return (c & 0xF0F) | ((c >> 12) & ~0xF0F);
 }
 
-static void downsampleby2_proc4444(SkBitmap* dst, int x, int y,
-                                   const SkBitmap& src) {
-    x <<= 1;
-    y <<= 1;
-    const uint16_t* p = src.getAddr16(x, y);
-    const uint16_t* baseP = p;
-    uint32_t        c;
-
-    c = expand4444(*p);
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c += expand4444(*p);
+static void downsample_row_4444(void* dst, const void* srcRow0, const void* srcRow1,
+                                int dstWidth) {
+    const uint16_t* p0 = static_cast<const uint16_t*>(srcRow0);
+    const uint16_t* p1 = static_cast<const uint16_t*>(srcRow1);
+    uint16_t* d = static_cast<uint16_t*>(dst);
 
-    p = baseP;
-    if (y < src.height() - 1) {
-        p += src.rowBytes() >> 1;
+    for (int i = 0; i < dstWidth; ++i) {
+        uint32_t c = expand4444(p0[0]) + expand4444(p0[1]) +
+                     expand4444(p1[0]) + expand4444(p1[1]);
+        d[i] = (uint16_t)collaps4444(c >> 2);
+        p0 += 2;
+        p1 += 2;
     }
-    c += expand4444(*p);
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c += expand4444(*p);
-
-    *dst->getAddr16(x >> 1, y >> 1) = (uint16_t)collaps4444(c >> 2);
 }
 
-SkMipMap::Level* SkMipMap::AllocLevels(int levelCount, size_t pixelSize) {
-    if (levelCount < 0) {
-        return NULL;
-    }
-    int64_t size = sk_64_mul(levelCount + 1, sizeof(Level)) + pixelSize;
-    if (!sk_64_isS32(size)) {
-        return NULL;
+static SkMipMapDownsampleRowProc choose_row_proc(SkColorType ct) {
+    SkMipMapDownsampleRowProc proc = SkMipMapGetPlatformRowProc(ct);
+    if (proc) {
+        return proc;
     }
-    return (Level*)sk_malloc_throw(sk_64_asS32(size));
-}
-
-SkMipMap* SkMipMap::Build(const SkBitmap& src) {
-    void (*proc)(SkBitmap* dst, int x, int y, const SkBitmap& src);
-
-    const SkColorType ct = src.colorType();
-    const SkAlphaType at = src.alphaType();
     switch (ct) {
         case kRGBA_8888_SkColorType:
         case kBGRA_8888_SkColorType:
-            proc = downsampleby2_proc32;
-            break;
+            return downsample_row_32;
         case kRGB_565_SkColorType:
-            proc = downsampleby2_proc16;
-            break;
+            return downsample_row_16;
         case kARGB_4444_SkColorType:
-            proc = downsampleby2_proc4444;
-            break;
+            return downsample_row_4444;
         default:
             return NULL; // don't build mipmaps for any other colortypes (yet)
     }
+}
 
-    SkAutoLockPixels alp(src);
-    if (!src.readyToDraw()) {
-        return NULL;
-    }
+static void downsample(const SkBitmap& src, SkBitmap* dst, SkMipMapDownsampleRowProc proc) {
+    SkASSERT(dst->width() == (src.width() >> 1));
+    SkASSERT(dst->height() == (src.height() >> 1));
 
-    // whip through our loop to compute the exact size needed
-    size_t  size = 0;
-    int     countLevels = 0;
-    {
-        int width = src.width();
-        int height = src.height();
-        for (;;) {
-            width >>= 1;
-            height >>= 1;
-            if (0 == width || 0 == height) {
-                break;
-            }
-            size += SkColorTypeMinRowBytes(ct, width) * height;
-            countLevels += 1;
-        }
-    }
-    if (0 == countLevels) {
-        return NULL;
-    }
+    const char* srcRow = static_cast<const char*>(src.getPixels());
+    const size_t srcRB = src.rowBytes();
+    char* dstRow = static_cast<char*>(dst->getPixels());
+    const size_t dstRB = dst->rowBytes();
+    const int width = dst->width();
 
-    Level* levels = SkMipMap::AllocLevels(countLevels, size);
-    if (NULL == levels) {
-        return NULL;
+    for (int y = 0; y < dst->height(); ++y) {
+        proc(dstRow, srcRow, srcRow + srcRB, width);
+        srcRow += srcRB << 1;
+        dstRow += dstRB;
     }
+}
 
-    uint8_t*    baseAddr = (uint8_t*)&levels[countLevels];
-    uint8_t*    addr = baseAddr;
-    int         width = src.width();
-    int         height = src.height();
-    uint32_t    rowBytes;
-    SkBitmap    srcBM(src);
-
-    for (int i = 0; i < countLevels; ++i) {
-        width >>= 1;
-        height >>= 1;
-        rowBytes = SkToU32(SkColorTypeMinRowBytes(ct, width));
-
-        levels[i].fPixels   = addr;
-        levels[i].fWidth    = width;
-        levels[i].fHeight   = height;
-        levels[i].fRowBytes = rowBytes;
-        levels[i].fScale    = (float)width / src.width();
-
-        SkBitmap dstBM;
-        dstBM.installPixels(SkImageInfo::Make(width, height, ct, at), addr, rowBytes);
-
-        srcBM.lockPixels();
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                proc(&dstBM, x, y, srcBM);
-            }
+static SkScaledImageCache::ID* find_and_lock_level(const SkBitmap& src, int level,
+                                                   SkBitmap* result) {
+    SkScaledImageCache::ID* id = SkScaledImageCache::FindAndLockMip(src, level, result);
+    if (id) {
+        result->lockPixels();
+        if (NULL == result->getPixels()) {
+            // found a purged entry (discardablememory?), release it
+            result->reset();
+            SkScaledImageCache::Unlock(id);
+            return NULL;
         }
-        srcBM.unlockPixels();
-
-        srcBM = dstBM;
-        addr += height * rowBytes;
     }
-    SkASSERT(addr == baseAddr + size);
-
-    return SkNEW_ARGS(SkMipMap, (levels, countLevels, size));
+    return id;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-//static int gCounter;
-
-SkMipMap::SkMipMap(Level* levels, int count, size_t size)
-    : fSize(size), fLevels(levels), fCount(count) {
-    SkASSERT(levels);
-    SkASSERT(count > 0);
-//    SkDebugf("mips %d\n", ++gCounter);
-}
-
-SkMipMap::~SkMipMap() {
-    sk_free(fLevels);
-//    SkDebugf("mips %d\n", --gCounter);
-}
+int SkMipMap::ComputeLevel(SkScalar scale) {
+    if (scale >= SK_Scalar1) {
+        return 0;
+    }
 
-static SkFixed compute_level(SkScalar scale) {
     SkFixed s = SkAbs32(SkScalarToFixed(SkScalarInvert(scale)));
-
     if (s < SK_Fixed1) {
         return 0;
     }
     int clz = SkCLZ(s);
     SkASSERT(clz >= 1 && clz <= 15);
-    return SkIntToFixed(15 - clz) + ((unsigned)(s << (clz + 1)) >> 16);
+    SkFixed level = SkIntToFixed(15 - clz) + ((unsigned)(s << (clz + 1)) >> 16);
+    return level >> 16;
 }
 
-bool SkMipMap::extractLevel(SkScalar scale, Level* levelPtr) const {
-    if (scale >= SK_Scalar1) {
-        return false;
+int SkMipMap::CountLevels(const SkBitmap& src) {
+    int width = src.width();
+    int height = src.height();
+    int count = 0;
+    for (;;) {
+        width >>= 1;
+        height >>= 1;
+        if (0 == width || 0 == height) {
+            break;
+        }
+        count += 1;
     }
+    return count;
+}
+
+SkScaledImageCache::ID* SkMipMap::FindAndLockLevel(const SkBitmap& src, int level,
+                                                   SkBitmap* result) {
+    SkASSERT(result);
 
-    int level = compute_level(scale) >> 16;
-    SkASSERT(level >= 0);
+    const SkColorType ct = src.colorType();
+    SkMipMapDownsampleRowProc proc = choose_row_proc(ct);
+    if (NULL == proc) {
+        return NULL;
+    }
+
+    level = SkMin32(level, CountLevels(src));
     if (level <= 0) {
-        return false;
+        return NULL;
+    }
+
+    // Look for the requested level, or failing that the deepest resident
+    // level above it, so we only compute what is missing.
+    SkBitmap parent;
+    SkScaledImageCache::ID* parentID = NULL;
+    int parentLevel = level;
+    for (; parentLevel > 0; --parentLevel) {
+        parentID = find_and_lock_level(src, parentLevel, &parent);
+        if (parentID) {
+            break;
+        }
+    }
+    if (parentLevel == level) {
+        SkASSERT(parentID);
+        *result = parent;
+        result->lockPixels();
+        return parentID;
+    }
+
+    if (0 == parentLevel) {
+        parent = src;
+        parent.lockPixels();
+        if (!parent.readyToDraw()) {
+            return NULL;
+        }
     }
 
-    if (level > fCount) {
-        level = fCount;
+    for (int i = parentLevel + 1; i <= level; ++i) {
+        const SkImageInfo info = SkImageInfo::Make(parent.width() >> 1,
+                                                   parent.height() >> 1,
+                                                   ct, src.alphaType());
+        SkBitmap child;
+        bool success;
+        if (i == level) {
+            // Only the level we were asked for is stored in the cache.
+            child.setInfo(info);
+            success = child.allocPixels(SkScaledImageCache::GetAllocator(), NULL);
+        } else {
+            success = child.allocPixels(info);
+        }
+        if (success) {
+            downsample(parent, &child, proc);
+        }
+
+        if (parentID) {
+            parent.reset();
+            SkScaledImageCache::Unlock(parentID);
+            parentID = NULL;
+        }
+        if (!success) {
+            return NULL;
+        }
+        parent = child;
+        parent.lockPixels();
     }
-    if (levelPtr) {
-        *levelPtr = fLevels[level - 1];
+
+    SkScaledImageCache::ID* id = SkScaledImageCache::AddAndLockMip(src, level, parent);
+    if (NULL == id) {
+        return NULL;
     }
-    return true;
+    *result = parent;
+    result->lockPixels();
+    return id;
 }
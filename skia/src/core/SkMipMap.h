@@ -8,36 +8,47 @@
 #ifndef SkMipMap_DEFINED
 #define SkMipMap_DEFINED
 
-#include "SkRefCnt.h"
 #include "SkScalar.h"
+#include "SkScaledImageCache.h"
 
 class SkBitmap;
 
-class SkMipMap : public SkRefCnt {
+/**
+ *  Mipmap levels are built lazily, one level at a time. Each level is stored
+ *  as its own entry in SkScaledImageCache (keyed by the source's generation ID
+ *  and the level index), so a level is only computed when it is actually
+ *  sampled, is allocated through the cache's allocator (discardable memory if
+ *  the cache was created with a DiscardableFactory), and can be purged
+ *  independently of the other levels.
+ */
+class SkMipMap {
 public:
-    static SkMipMap* Build(const SkBitmap& src);
-
-    struct Level {
-        void*       fPixels;
-        uint32_t    fRowBytes;
-        uint32_t    fWidth, fHeight;
-        float       fScale; // < 1.0
-    };
-
-    bool extractLevel(SkScalar scale, Level*) const;
-
-    size_t getSize() const { return fSize; }
-
-private:
-    size_t  fSize;
-    Level*  fLevels;
-    int     fCount;
-
-    // we take ownership of levels, and will free it with sk_free()
-    SkMipMap(Level* levels, int count, size_t size);
-    virtual ~SkMipMap();
-
-    static Level* AllocLevels(int levelCount, size_t pixelSize);
+    /**
+     *  Returns the level (1 == half-size, 2 == quarter-size, ...) whose
+     *  resolution best matches drawing at the specified scale, or 0 if the
+     *  original image should be used.
+     */
+    static int ComputeLevel(SkScalar scale);
+
+    /**
+     *  Returns the number of levels that can be built from src (i.e. the
+     *  number of times it can be halved before a dimension goes to zero).
+     */
+    static int CountLevels(const SkBitmap& src);
+
+    /**
+     *  Find the requested level of src in the cache, building it if needed.
+     *  Only the requested level is added to the cache; it is derived from the
+     *  deepest already-resident level above it (or from src itself), using
+     *  scratch memory for any intermediate levels. The level is clamped to
+     *  CountLevels(src).
+     *
+     *  On success, returns a locked ID and sets level to the (locked) pixels.
+     *  The caller must call SkScaledImageCache::Unlock() on the ID when done.
+     *  Returns NULL if the level could not be found or built.
+     */
+    static SkScaledImageCache::ID* FindAndLockLevel(const SkBitmap& src, int level,
+                                                    SkBitmap* result);
 };
 
 #endif
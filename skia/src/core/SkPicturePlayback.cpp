@@ -34,9 +34,6 @@ SkPicturePlayback::PlaybackReplacements::push() {
 }
 
 void SkPicturePlayback::PlaybackReplacements::freeAll() {
-    for (int i = 0; i < fReplacements.count(); ++i) {
-        SkDELETE(fReplacements[i].fBM);
-    }
     fReplacements.reset();
 }
 
@@ -755,7 +752,7 @@ const SkPicture::OperationList& SkPicturePlayback::getActiveOps(const SkIRect& q
     fCachedActiveOps->fOps.rewind();
 
     fBoundingHierarchy->search(query, &(fCachedActiveOps->fOps));
-    if (0 != fCachedActiveOps->fOps.count()) {
+    if (0 != fCachedActiveOps->fOps.count() && !fBoundingHierarchy->searchIsOrdered()) {
         SkTQSort<SkPictureStateTree::Draw>(
             reinterpret_cast<SkPictureStateTree::Draw**>(fCachedActiveOps->fOps.begin()),
             reinterpret_cast<SkPictureStateTree::Draw**>(fCachedActiveOps->fOps.end()-1));
@@ -901,7 +898,16 @@ void SkPicturePlayback::draw(SkCanvas& canvas, SkDrawPictureCallback* callback)
                 SkASSERT(NULL != temp->fPaint);
                 canvas.save();
                 canvas.setMatrix(initialMatrix);
-                canvas.drawBitmap(*temp->fBM, temp->fPos.fX, temp->fPos.fY, temp->fPaint);
+                if (temp->fSrcRect == SkIRect::MakeWH(temp->fBM->width(),
+                                                      temp->fBM->height())) {
+                    canvas.drawBitmap(*temp->fBM, temp->fPos.fX, temp->fPos.fY, temp->fPaint);
+                } else {
+                    SkRect src = SkRect::Make(temp->fSrcRect);
+                    SkRect dst = SkRect::MakeXYWH(SkIntToScalar(temp->fPos.fX),
+                                                  SkIntToScalar(temp->fPos.fY),
+                                                  src.width(), src.height());
+                    canvas.drawBitmapRectToRect(*temp->fBM, &src, dst, temp->fPaint);
+                }
                 canvas.restore();
 
                 if (it.isValid()) {
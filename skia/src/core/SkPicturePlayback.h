@@ -341,11 +341,14 @@ private:
         // All the operations between fStart and fStop (inclusive) will be replaced with
         // a single drawBitmap call using fPos, fBM and fPaint.
         // fPaint will be NULL if the picture's paint wasn't copyable
+        // fSrcRect is the part of fBM holding the layer's pixels (e.g., when fBM is an atlas).
+        // fBM is owned by the caller and must outlive the playback.
         struct ReplacementInfo {
             size_t          fStart;
             size_t          fStop;
             SkIPoint        fPos;
-            SkBitmap*       fBM;
+            const SkBitmap* fBM;
+            SkIRect         fSrcRect;
             const SkPaint*  fPaint;  // Note: this object doesn't own the paint
         };
 
@@ -44,6 +44,15 @@ SkPictureRecord::SkPictureRecord(const SkISize& dimensions, uint32_t flags)
     , fPaints(&fFlattenableHeap)
     , fRecordFlags(flags)
     , fOptsEnabled(kBeClever) {
+    sk_bzero(fRecentPaintChecksums, sizeof(fRecentPaintChecksums));
+    sk_bzero(fRecentPaintFlats, sizeof(fRecentPaintFlats));
+    sk_bzero(fRecentPaintMisses, sizeof(fRecentPaintMisses));
+    fRecentPaintLookups = 0;
+    fRecentPaintHits = 0;
+    fRecentPaintSkips = 0;
+    fRecentPath.fGenerationID = 0;
+    fRecentBitmap.fGenerationID = 0;
+
 #ifdef SK_DEBUG_SIZE
     fPointBytes = fRectBytes = fTextBytes = 0;
     fPointWrites = fRectWrites = fTextWrites = 0;
@@ -1577,12 +1586,27 @@ SkSurface* SkPictureRecord::onNewSurface(const SkImageInfo& info) {
 }
 
 int SkPictureRecord::addBitmap(const SkBitmap& bitmap) {
+    const uint32_t genID = bitmap.getGenerationID();
+    if (0 != genID && genID == fRecentBitmap.fGenerationID &&
+        bitmap.pixelRefOrigin() == fRecentBitmap.fPixelOrigin &&
+        bitmap.width() == fRecentBitmap.fWidth && bitmap.height() == fRecentBitmap.fHeight) {
+        this->addInt(fRecentBitmap.fSlot);
+        return fRecentBitmap.fSlot;
+    }
+
     const int index = fBitmapHeap->insert(bitmap);
     // In debug builds, a bad return value from insert() will crash, allowing for debugging. In
     // release builds, the invalid value will be recorded so that the reader will know that there
     // was a problem.
     SkASSERT(index != SkBitmapHeap::INVALID_SLOT);
     this->addInt(index);
+    if (index != SkBitmapHeap::INVALID_SLOT) {
+        fRecentBitmap.fGenerationID = genID;
+        fRecentBitmap.fPixelOrigin = bitmap.pixelRefOrigin();
+        fRecentBitmap.fWidth = bitmap.width();
+        fRecentBitmap.fHeight = bitmap.height();
+        fRecentBitmap.fSlot = index;
+    }
     return index;
 }
 
@@ -1590,8 +1614,54 @@ void SkPictureRecord::addMatrix(const SkMatrix& matrix) {
     fWriter.writeMatrix(matrix);
 }
 
+// Only has to tell most paints that differ apart quickly: paints with the same checksum are then
+// compared field by field.
+static uint32_t paint_checksum(const SkPaint& paint) {
+    uint32_t hash = paint.getColor();
+    hash = hash * 31 + paint.getFlags();
+    hash = hash * 31 + SkFloat2Bits(SkScalarToFloat(paint.getStrokeWidth()));
+    hash = hash * 31 + SkFloat2Bits(SkScalarToFloat(paint.getTextSize()));
+    hash = hash * 31 + paint.getStyle();
+    hash = hash * 31 + (uint32_t)(uintptr_t)paint.getShader();
+    hash = hash * 31 + (uint32_t)(uintptr_t)paint.getTypeface();
+    return hash;
+}
+
 const SkFlatData* SkPictureRecord::getFlatPaintData(const SkPaint& paint) {
-    return fPaints.findAndReturnFlat(paint);
+    if (fRecentPaintSkips > 0) {
+        fRecentPaintSkips--;
+        return fPaints.findAndReturnFlat(paint);
+    }
+    if (++fRecentPaintLookups == kRecentPaintProbeCount) {
+        if (fRecentPaintHits * kRecentPaintMinHitRatio < kRecentPaintProbeCount) {
+            fRecentPaintSkips = kRecentPaintSkipCount;
+        }
+        fRecentPaintLookups = 0;
+        fRecentPaintHits = 0;
+    }
+
+    const uint32_t checksum = paint_checksum(paint);
+    // The low bits of the checksum are mostly the color's; multiplying mixes in the other fields.
+    const int slot = (checksum * 0x9E3779B1) >> (32 - kRecentPaintBits);
+    if (fRecentPaintChecksums[slot] == checksum && NULL != fRecentPaintFlats[slot] &&
+        fRecentPaints[slot] == paint) {
+        fRecentPaintMisses[slot] = checksum;
+        fRecentPaintHits++;
+        return fRecentPaintFlats[slot];
+    }
+
+    const int count = fPaints.count();
+    const SkFlatData* flat = fPaints.findAndReturnFlat(paint);
+    if (fPaints.count() > count || fRecentPaintMisses[slot] != checksum) {
+        // Only copy paints that keep coming back: copying paints that are new, or that are used
+        // in turn with the one in the slot, would slow down recording more than it saves.
+        fRecentPaintMisses[slot] = checksum;
+        return flat;
+    }
+    fRecentPaints[slot] = paint;
+    fRecentPaintChecksums[slot] = checksum;
+    fRecentPaintFlats[slot] = flat;
+    return flat;
 }
 
 const SkFlatData* SkPictureRecord::addPaintPtr(const SkPaint* paint) {
@@ -1610,14 +1680,23 @@ void SkPictureRecord::addFlatPaint(const SkFlatData* flatPaint) {
 }
 
 int SkPictureRecord::addPathToHeap(const SkPath& path) {
+    const uint32_t genID = path.getGenerationID();
+    if (genID == fRecentPath.fGenerationID && path.getFillType() == fRecentPath.fFillType) {
+        return fRecentPath.fSlot;
+    }
+
     if (NULL == fPathHeap) {
         fPathHeap.reset(SkNEW(SkPathHeap));
     }
 #ifdef SK_DEDUP_PICTURE_PATHS
-    return fPathHeap->insert(path);
+    const int slot = fPathHeap->insert(path);
 #else
-    return fPathHeap->append(path);
+    const int slot = fPathHeap->append(path);
 #endif
+    fRecentPath.fGenerationID = genID;
+    fRecentPath.fFillType = path.getFillType();
+    fRecentPath.fSlot = slot;
+    return slot;
 }
 
 void SkPictureRecord::addPath(const SkPath& path) {
@@ -316,6 +316,46 @@ private:
 
     SkPaintDictionary fPaints;
 
+    // Paints found in fPaints, so that drawing again with one of them, or with a paint equal to
+    // one of them, doesn't flatten it and look it up in fPaints. A paint can only go in the slot
+    // its checksum picks, and only replaces the paint there once it missed twice in a row in that
+    // slot: paints that take turns in a slot, or that are used only once, are never copied. A slot
+    // with a NULL flat was never used. When fewer than one in kRecentPaintMinHitRatio of the last
+    // kRecentPaintProbeCount paints were found there, the next kRecentPaintSkipCount paints go
+    // straight to fPaints, so that content that never draws with the same paints again doesn't
+    // pay for the lookups.
+    enum {
+        kRecentPaintBits = 5,
+        kRecentPaintCount = 1 << kRecentPaintBits,
+        kRecentPaintProbeCount = 64,
+        kRecentPaintMinHitRatio = 16,
+        kRecentPaintSkipCount = 8192,
+    };
+    SkPaint           fRecentPaints[kRecentPaintCount];
+    uint32_t          fRecentPaintChecksums[kRecentPaintCount];
+    const SkFlatData* fRecentPaintFlats[kRecentPaintCount];
+    // The checksum of the last paint that missed in each slot, or of the paint in it after a hit.
+    uint32_t          fRecentPaintMisses[kRecentPaintCount];
+    int               fRecentPaintLookups;
+    int               fRecentPaintHits;
+    int               fRecentPaintSkips;
+
+    // The last path and bitmap added to their heaps, so that drawing the same one again reuses
+    // its slot. A path is identified by its generation ID and fill type, and a bitmap the way
+    // SkBitmapHeap does.
+    struct RecentPath {
+        uint32_t         fGenerationID;  // 0 if no path was added yet
+        SkPath::FillType fFillType;
+        int              fSlot;
+    } fRecentPath;
+    struct RecentBitmap {
+        uint32_t fGenerationID;  // 0 if no bitmap was added yet
+        SkIPoint fPixelOrigin;
+        int      fWidth;
+        int      fHeight;
+        int      fSlot;
+    } fRecentBitmap;
+
     SkWriter32 fWriter;
 
     // we ref each item in these arrays
@@ -7,33 +7,47 @@
 
 #include "SkRTree.h"
 #include "SkTSort.h"
+#include "SkUtilsArm.h"
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #include <emmintrin.h>
+#elif SK_ARM_NEON_IS_ALWAYS
+    #include <arm_neon.h>
+#endif
 
 static inline uint32_t get_area(const SkIRect& rect);
 static inline uint32_t get_overlap(const SkIRect& rect1, const SkIRect& rect2);
 static inline uint32_t get_margin(const SkIRect& rect);
 static inline uint32_t get_area_increase(const SkIRect& rect1, SkIRect rect2);
 static inline void join_no_empty_check(const SkIRect& joinWith, SkIRect* out);
+static inline uint32_t hilbert_index(uint32_t x, uint32_t y);
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 SkRTree* SkRTree::Create(int minChildren, int maxChildren, SkScalar aspectRatio,
-            bool sortWhenBulkLoading) {
+            BulkLoadOrder bulkLoadOrder) {
     if (minChildren < maxChildren && (maxChildren + 1) / 2 >= minChildren &&
-        minChildren > 0 && maxChildren < static_cast<int>(SK_MaxU16)) {
-        return new SkRTree(minChildren, maxChildren, aspectRatio, sortWhenBulkLoading);
+        minChildren > 0 && maxChildren < static_cast<int>(SK_MaxU16) - kChildrenPerTest) {
+        return new SkRTree(minChildren, maxChildren, aspectRatio, bulkLoadOrder);
     }
     return NULL;
 }
 
 SkRTree::SkRTree(int minChildren, int maxChildren, SkScalar aspectRatio,
-        bool sortWhenBulkLoading)
+        BulkLoadOrder bulkLoadOrder)
     : fMinChildren(minChildren)
     , fMaxChildren(maxChildren)
-    , fNodeSize(sizeof(Node) + sizeof(Branch) * maxChildren)
+    , fNodeCapacity(SkAlign4(maxChildren))
+    , fNodeSize((kNodeHeaderSize + (4 * sizeof(int32_t) + sizeof(Child)) * fNodeCapacity +
+                 kCacheLineSize - 1) & ~(size_t)(kCacheLineSize - 1))
     , fCount(0)
-    , fNodes(fNodeSize * 256)
+    , fNodes(fNodeSize * kNodesPerSlab + kCacheLineSize)
+    , fNextNode(NULL)
+    , fEndOfSlab(NULL)
     , fAspectRatio(aspectRatio)
-    , fSortWhenBulkLoading(sortWhenBulkLoading) {
+    , fBulkLoadOrder(bulkLoadOrder) {
+    SK_COMPILE_ASSERT(sizeof(Node) <= kNodeHeaderSize, node_header_too_big);
+    SK_COMPILE_ASSERT(4 == kChildrenPerTest, children_per_test_must_match_SkAlign4);
     SkASSERT(minChildren < maxChildren && minChildren > 0 && maxChildren <
              static_cast<int>(SK_MaxU16));
     SkASSERT((maxChildren + 1) / 2 >= minChildren);
@@ -72,8 +86,8 @@ void SkRTree::insert(void* data, const SkIRect& bounds, bool defer) {
         Node* oldRoot = fRoot.fChild.subtree;
         Node* newRoot = this->allocateNode(oldRoot->fLevel + 1);
         newRoot->fNumChildren = 2;
-        *newRoot->child(0) = fRoot;
-        *newRoot->child(1) = *newSibling;
+        newRoot->setBranch(0, fRoot);
+        newRoot->setBranch(1, *newSibling);
         fRoot.fChild.subtree = newRoot;
         fRoot.fBounds = this->computeBounds(fRoot.fChild.subtree);
     }
@@ -116,15 +130,25 @@ void SkRTree::search(const SkIRect& query, SkTDArray<void*>* results) {
 void SkRTree::clear() {
     this->validate();
     fNodes.reset();
+    fNextNode = fEndOfSlab = NULL;
     fDeferredInserts.rewind();
     fCount = 0;
     this->validate();
 }
 
 SkRTree::Node* SkRTree::allocateNode(uint16_t level) {
-    Node* out = static_cast<Node*>(fNodes.allocThrow(fNodeSize));
+    if (fNextNode == fEndOfSlab) {
+        char* slab = static_cast<char*>(fNodes.allocThrow(fNodeSize * kNodesPerSlab +
+                                                          kCacheLineSize));
+        slab += (kCacheLineSize - (uintptr_t)slab % kCacheLineSize) % kCacheLineSize;
+        fNextNode = slab;
+        fEndOfSlab = slab + fNodeSize * kNodesPerSlab;
+    }
+    Node* out = reinterpret_cast<Node*>(fNextNode);
+    fNextNode += fNodeSize;
     out->fNumChildren = 0;
     out->fLevel = level;
+    out->fCapacity = fNodeCapacity;
     return out;
 }
 
@@ -132,9 +156,8 @@ SkRTree::Branch* SkRTree::insert(Node* root, Branch* branch, uint16_t level) {
     Branch* toInsert = branch;
     if (root->fLevel != level) {
         int childIndex = this->chooseSubtree(root, branch);
-        toInsert = this->insert(root->child(childIndex)->fChild.subtree, branch, level);
-        root->child(childIndex)->fBounds = this->computeBounds(
-            root->child(childIndex)->fChild.subtree);
+        toInsert = this->insert(root->child(childIndex).subtree, branch, level);
+        root->setBounds(childIndex, this->computeBounds(root->child(childIndex).subtree));
     }
     if (NULL != toInsert) {
         if (root->fNumChildren == fMaxChildren) {
@@ -144,7 +167,7 @@ SkRTree::Branch* SkRTree::insert(Node* root, Branch* branch, uint16_t level) {
             Node* newSibling = this->allocateNode(root->fLevel);
             Branch* toDivide = SkNEW_ARRAY(Branch, fMaxChildren + 1);
             for (int i = 0; i < fMaxChildren; ++i) {
-                toDivide[i] = *root->child(i);
+                toDivide[i] = root->branch(i);
             }
             toDivide[fMaxChildren] = *toInsert;
             int splitIndex = this->distributeChildren(toDivide);
@@ -153,10 +176,10 @@ SkRTree::Branch* SkRTree::insert(Node* root, Branch* branch, uint16_t level) {
             root->fNumChildren = splitIndex;
             newSibling->fNumChildren = fMaxChildren + 1 - splitIndex;
             for (int i = 0; i < splitIndex; ++i) {
-                *root->child(i) = toDivide[i];
+                root->setBranch(i, toDivide[i]);
             }
             for (int i = splitIndex; i < fMaxChildren + 1; ++i) {
-                *newSibling->child(i - splitIndex) = toDivide[i];
+                newSibling->setBranch(i - splitIndex, toDivide[i]);
             }
             SkDELETE_ARRAY(toDivide);
 
@@ -165,7 +188,7 @@ SkRTree::Branch* SkRTree::insert(Node* root, Branch* branch, uint16_t level) {
             branch->fBounds = this->computeBounds(newSibling);
             return branch;
         } else {
-            *root->child(root->fNumChildren) = *toInsert;
+            root->setBranch(root->fNumChildren, *toInsert);
             ++root->fNumChildren;
             return NULL;
         }
@@ -181,7 +204,7 @@ int SkRTree::chooseSubtree(Node* root, Branch* branch) {
         int32_t minArea         = SK_MaxS32;
         int32_t bestSubtree     = -1;
         for (int i = 0; i < root->fNumChildren; ++i) {
-            const SkIRect& subtreeBounds = root->child(i)->fBounds;
+            const SkIRect subtreeBounds = root->bounds(i);
             int32_t areaIncrease = get_area_increase(subtreeBounds, branch->fBounds);
             // break ties in favor of subtree with smallest area
             if (areaIncrease < minAreaIncrease || (areaIncrease == minAreaIncrease &&
@@ -199,7 +222,7 @@ int SkRTree::chooseSubtree(Node* root, Branch* branch) {
         int32_t minAreaIncrease    = SK_MaxS32;
         int32_t bestSubtree = -1;
         for (int32_t i = 0; i < root->fNumChildren; ++i) {
-            const SkIRect& subtreeBounds = root->child(i)->fBounds;
+            const SkIRect subtreeBounds = root->bounds(i);
             SkIRect expandedBounds = subtreeBounds;
             join_no_empty_check(branch->fBounds, &expandedBounds);
             int32_t overlap = 0;
@@ -208,7 +231,7 @@ int SkRTree::chooseSubtree(Node* root, Branch* branch) {
                 // Note: this would be more correct if we subtracted the original pre-expanded
                 // overlap, but computing overlaps is expensive and omitting it doesn't seem to
                 // hurt query performance. See get_overlap_increase()
-                overlap += get_overlap(expandedBounds, root->child(j)->fBounds);
+                overlap += get_overlap(expandedBounds, root->bounds(j));
             }
             // break ties with lowest area increase
             if (overlap < minOverlapIncrease || (overlap == minOverlapIncrease &&
@@ -227,9 +250,9 @@ int SkRTree::chooseSubtree(Node* root, Branch* branch) {
 }
 
 SkIRect SkRTree::computeBounds(Node* n) {
-    SkIRect r = n->child(0)->fBounds;
+    SkIRect r = n->bounds(0);
     for (int i = 1; i < n->fNumChildren; ++i) {
-        join_no_empty_check(n->child(i)->fBounds, &r);
+        join_no_empty_check(n->bounds(i), &r);
     }
     return r;
 }
@@ -302,13 +325,67 @@ int SkRTree::distributeChildren(Branch* children) {
     return fMinChildren - 1 + k;
 }
 
+// Returns a mask with bit i set if the bounds of child i intersect the query, for kChildrenPerTest
+// children whose sides start at lefts, tops, rights and bottoms. Like
+// SkIRect::IntersectsNoEmptyCheck, this expects no empty rects.
+static inline unsigned intersect_4(const int32_t* lefts, const int32_t* tops,
+                                   const int32_t* rights, const int32_t* bottoms,
+                                   const SkIRect& query) {
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    const __m128i l = _mm_load_si128(reinterpret_cast<const __m128i*>(lefts));
+    const __m128i t = _mm_load_si128(reinterpret_cast<const __m128i*>(tops));
+    const __m128i r = _mm_load_si128(reinterpret_cast<const __m128i*>(rights));
+    const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(bottoms));
+    const __m128i x = _mm_and_si128(_mm_cmplt_epi32(l, _mm_set1_epi32(query.fRight)),
+                                    _mm_cmplt_epi32(_mm_set1_epi32(query.fLeft), r));
+    const __m128i y = _mm_and_si128(_mm_cmplt_epi32(t, _mm_set1_epi32(query.fBottom)),
+                                    _mm_cmplt_epi32(_mm_set1_epi32(query.fTop), b));
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(x, y)));
+#elif SK_ARM_NEON_IS_ALWAYS
+    const int32x4_t l = vld1q_s32(lefts);
+    const int32x4_t t = vld1q_s32(tops);
+    const int32x4_t r = vld1q_s32(rights);
+    const int32x4_t b = vld1q_s32(bottoms);
+    const uint32x4_t x = vandq_u32(vcltq_s32(l, vdupq_n_s32(query.fRight)),
+                                   vcltq_s32(vdupq_n_s32(query.fLeft), r));
+    const uint32x4_t y = vandq_u32(vcltq_s32(t, vdupq_n_s32(query.fBottom)),
+                                   vcltq_s32(vdupq_n_s32(query.fTop), b));
+    // Keep one bit per lane, and add the lanes up.
+    static const uint32_t kLaneBits[4] = { 1, 2, 4, 8 };
+    const uint32x4_t bits = vandq_u32(vandq_u32(x, y), vld1q_u32(kLaneBits));
+    uint32x2_t sum = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+    sum = vpadd_u32(sum, sum);
+    return vget_lane_u32(sum, 0);
+#else
+    unsigned mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (lefts[i] < query.fRight && query.fLeft < rights[i] &&
+            tops[i] < query.fBottom && query.fTop < bottoms[i]) {
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+#endif
+}
+
 void SkRTree::search(Node* root, const SkIRect query, SkTDArray<void*>* results) const {
-    for (int i = 0; i < root->fNumChildren; ++i) {
-        if (SkIRect::IntersectsNoEmptyCheck(root->child(i)->fBounds, query)) {
-            if (root->isLeaf()) {
-                results->push(root->child(i)->fChild.data);
-            } else {
-                this->search(root->child(i)->fChild.subtree, query, results);
+    const int32_t* lefts = root->side(0);
+    const int32_t* tops = root->side(1);
+    const int32_t* rights = root->side(2);
+    const int32_t* bottoms = root->side(3);
+    for (int i = 0; i < root->fNumChildren; i += kChildrenPerTest) {
+        unsigned hits = intersect_4(lefts + i, tops + i, rights + i, bottoms + i, query);
+        if (root->fNumChildren - i < kChildrenPerTest) {
+            // The entries past the last child hold garbage.
+            hits &= (1 << (root->fNumChildren - i)) - 1;
+        }
+        for (int j = i; 0 != hits; ++j, hits >>= 1) {
+            if (hits & 1) {
+                if (root->isLeaf()) {
+                    results->push(root->child(j).data);
+                } else {
+                    this->search(root->child(j).subtree, query, results);
+                }
             }
         }
     }
@@ -326,8 +403,12 @@ SkRTree::Branch SkRTree::bulkLoad(SkTDArray<Branch>* branches, int level) {
         // We expect Webkit / Blink to give us a reasonable x,y order.
         // Avoiding this call resulted in a 17% win for recording with
         // negligible difference in playback speed.
-        if (fSortWhenBulkLoading) {
+        if (kSortTileRecursive_BulkLoadOrder == fBulkLoadOrder) {
             SkTQSort(branches->begin(), branches->end() - 1, RectLessY());
+        } else if (kHilbert_BulkLoadOrder == fBulkLoadOrder && 0 == level) {
+            // The nodes made out of runs of the sorted branches come out in the order of the
+            // curve too, so the levels above don't need sorting again.
+            this->sortAlongHilbertCurve(branches);
         }
 
         int numBranches = branches->count() / fMaxChildren;
@@ -349,11 +430,16 @@ SkRTree::Branch SkRTree::bulkLoad(SkTDArray<Branch>* branches, int level) {
                                      SkScalarInvert(fAspectRatio)));
         int numTiles = SkScalarCeilToInt(SkIntToScalar(numBranches) /
                                     SkIntToScalar(numStrips));
+        if (kHilbert_BulkLoadOrder == fBulkLoadOrder) {
+            // A single strip: pack the branches in order.
+            numStrips = 1;
+            numTiles = numBranches;
+        }
         int currentBranch = 0;
 
         for (int i = 0; i < numStrips; ++i) {
             // Once again, if we are told to do so, we sort by x.
-            if (fSortWhenBulkLoading) {
+            if (kSortTileRecursive_BulkLoadOrder == fBulkLoadOrder) {
                 int begin = currentBranch;
                 int end = currentBranch + numTiles * fMaxChildren - SkMin32(remainder,
                         (fMaxChildren - fMinChildren) * numTiles);
@@ -379,14 +465,14 @@ SkRTree::Branch SkRTree::bulkLoad(SkTDArray<Branch>* branches, int level) {
                 }
                 Node* n = allocateNode(level);
                 n->fNumChildren = 1;
-                *n->child(0) = (*branches)[currentBranch];
+                n->setBranch(0, (*branches)[currentBranch]);
                 Branch b;
                 b.fBounds = (*branches)[currentBranch].fBounds;
                 b.fChild.subtree = n;
                 ++currentBranch;
                 for (int k = 1; k < incrementBy && currentBranch < branches->count(); ++k) {
                     b.fBounds.join((*branches)[currentBranch].fBounds);
-                    *n->child(k) = (*branches)[currentBranch];
+                    n->setBranch(k, (*branches)[currentBranch]);
                     ++n->fNumChildren;
                     ++currentBranch;
                 }
@@ -399,6 +485,38 @@ SkRTree::Branch SkRTree::bulkLoad(SkTDArray<Branch>* branches, int level) {
     }
 }
 
+void SkRTree::sortAlongHilbertCurve(SkTDArray<Branch>* branches) {
+    // Map the centers of the branches onto the 2^16 x 2^16 grid the curve fills.
+    int32_t minX = SK_MaxS32, minY = SK_MaxS32, maxX = SK_MinS32, maxY = SK_MinS32;
+    for (int i = 0; i < branches->count(); ++i) {
+        const SkIRect& bounds = (*branches)[i].fBounds;
+        minX = SkMin32(minX, bounds.centerX());
+        minY = SkMin32(minY, bounds.centerY());
+        maxX = SkMax32(maxX, bounds.centerX());
+        maxY = SkMax32(maxY, bounds.centerY());
+    }
+    const int64_t width = SkTMax<int64_t>((int64_t)maxX - minX, 1);
+    const int64_t height = SkTMax<int64_t>((int64_t)maxY - minY, 1);
+
+    // Sort the keys along with the indices of their branches, which is cheaper than moving the
+    // branches around.
+    SkAutoTMalloc<uint64_t> sorted(branches->count());
+    for (int i = 0; i < branches->count(); ++i) {
+        const SkIRect& bounds = (*branches)[i].fBounds;
+        const int64_t x = ((int64_t)bounds.centerX() - minX) * 0xFFFF / width;
+        const int64_t y = ((int64_t)bounds.centerY() - minY) * 0xFFFF / height;
+        const uint32_t key = hilbert_index(static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+        sorted[i] = ((uint64_t)key << 32) | i;
+    }
+    SkTQSort(sorted.get(), sorted.get() + branches->count() - 1);
+
+    SkAutoTMalloc<Branch> unsorted(branches->count());
+    memcpy(unsorted.get(), branches->begin(), branches->count() * sizeof(Branch));
+    for (int i = 0; i < branches->count(); ++i) {
+        (*branches)[i] = unsorted[static_cast<uint32_t>(sorted[i])];
+    }
+}
+
 void SkRTree::validate() {
 #ifdef SK_DEBUG
     if (this->isEmpty()) {
@@ -424,7 +542,7 @@ int SkRTree::validateSubtree(Node* root, SkIRect bounds, bool isRoot) {
     }
 
     for (int i = 0; i < root->fNumChildren; ++i) {
-        SkASSERT(bounds.contains(root->child(i)->fBounds));
+        SkASSERT(bounds.contains(root->bounds(i)));
     }
 
     if (root->isLeaf()) {
@@ -433,9 +551,8 @@ int SkRTree::validateSubtree(Node* root, SkIRect bounds, bool isRoot) {
     } else {
         int childCount = 0;
         for (int i = 0; i < root->fNumChildren; ++i) {
-            SkASSERT(root->child(i)->fChild.subtree->fLevel == root->fLevel - 1);
-            childCount += this->validateSubtree(root->child(i)->fChild.subtree,
-                                                root->child(i)->fBounds);
+            SkASSERT(root->child(i).subtree->fLevel == root->fLevel - 1);
+            childCount += this->validateSubtree(root->child(i).subtree, root->bounds(i));
         }
         return childCount;
     }
@@ -480,3 +597,23 @@ static inline void join_no_empty_check(const SkIRect& joinWith, SkIRect* out) {
     if (joinWith.fRight > out->fRight) { out->fRight = joinWith.fRight; }
     if (joinWith.fBottom > out->fBottom) { out->fBottom = joinWith.fBottom; }
 }
+
+// Returns the distance of (x, y) along a Hilbert curve filling a 2^16 x 2^16 grid.
+static inline uint32_t hilbert_index(uint32_t x, uint32_t y) {
+    uint32_t index = 0;
+    for (int bit = 15; bit >= 0; --bit) {
+        const uint32_t rx = (x >> bit) & 1;
+        const uint32_t ry = (y >> bit) & 1;
+        index += ((3 * rx) ^ ry) << (2 * bit);
+        // Rotate the quadrant so that the curve inside it starts and ends where it should:
+        // flip it if rx && !ry, and transpose it if !ry. Without branches, since the bits of
+        // the centers are as good as random.
+        const uint32_t flip = 0xFFFF & (0 - (rx & (ry ^ 1)));
+        x ^= flip;
+        y ^= flip;
+        const uint32_t swap = (x ^ y) & (0 - (ry ^ 1));
+        x ^= swap;
+        y ^= swap;
+    }
+    return index;
+}
@@ -39,11 +39,29 @@
  * It also supports bulk-loading from a batch of bounds and values; if you don't require the tree
  * to be usable in its intermediate states while it is being constructed, this is significantly
  * quicker than individual insertions and produces more consistent trees.
+ *
+ * Each node keeps the bounds of its children together as a structure of arrays, so that searching
+ * tests four children against the query at once with SSE2 or NEON.
  */
 class SkRTree : public SkBBoxHierarchy {
 public:
     SK_DECLARE_INST_COUNT(SkRTree)
 
+    /**
+     * How bulk-loading groups the deferred inserts into nodes.
+     */
+    enum BulkLoadOrder {
+        // Tiles the inserts in the order they came in, which works well when they come in a
+        // reasonable x,y order already and saves sorting them.
+        kUnsorted_BulkLoadOrder,
+        // Sorts the inserts by y into strips, and each strip by x (sort-tile-recursive).
+        kSortTileRecursive_BulkLoadOrder,
+        // Sorts the inserts by the position of their centers along a Hilbert curve, and packs runs
+        // of them into nodes. This tends to make nodes that overlap less when the inserts vary a
+        // lot in size.
+        kHilbert_BulkLoadOrder,
+    };
+
     /**
      * Create a new R-Tree with specified min/max child counts.
      * The child counts are valid iff:
@@ -52,11 +70,11 @@ public:
      * - min > 0
      * - max < SK_MaxU16
      * If you have some prior information about the distribution of bounds you're expecting, you
-     * can provide an optional aspect ratio parameter. This allows the bulk-load algorithm to create
-     * better proportioned tiles of rectangles.
+     * can provide an optional aspect ratio parameter. This allows the sort-tile-recursive
+     * bulk-load to create better proportioned tiles of rectangles.
      */
     static SkRTree* Create(int minChildren, int maxChildren, SkScalar aspectRatio = 1,
-            bool orderWhenBulkLoading = true);
+            BulkLoadOrder bulkLoadOrder = kSortTileRecursive_BulkLoadOrder);
     virtual ~SkRTree();
 
     /**
@@ -98,30 +116,75 @@ public:
 
 private:
 
+    enum {
+        kCacheLineSize = 64,
+        // The children's bounds start this far into a node, aligned for SIMD loads.
+        kNodeHeaderSize = 16,
+        // The number of children that search() tests at once.
+        kChildrenPerTest = 4,
+        kNodesPerSlab = 256,
+    };
+
     struct Node;
 
+    /**
+     * What a branch points to: another interior node, or a data value
+     */
+    union Child {
+        Node* subtree;
+        void* data;
+    };
+
     /**
      * A branch of the tree, this may contain a pointer to another interior node, or a data value
      */
     struct Branch {
-        union {
-            Node* subtree;
-            void* data;
-        } fChild;
+        Child fChild;
         SkIRect fBounds;
     };
 
     /**
      * A node in the tree, has between fMinChildren and fMaxChildren (the root is a special case)
+     *
+     * Nodes start on a cache line. Since we want to be able to pick min/max child counts at
+     * runtime, we assume the creator has allocated sufficient space directly after the header,
+     * where the children are stored as arrays of fCapacity entries each: the left sides of their
+     * bounds, then the top, right and bottom sides, then the children themselves. fCapacity is
+     * fMaxChildren rounded up to a multiple of kChildrenPerTest.
      */
     struct Node {
         uint16_t fNumChildren;
         uint16_t fLevel;
+        uint16_t fCapacity;
         bool isLeaf() { return 0 == fLevel; }
-        // Since we want to be able to pick min/max child counts at runtime, we assume the creator
-        // has allocated sufficient space directly after us in memory, and index into that space
-        Branch* child(size_t index) {
-            return reinterpret_cast<Branch*>(this + 1) + index;
+
+        // The array of one side of the children's bounds, in the order of SkIRect's fields.
+        int32_t* side(int index) {
+            return reinterpret_cast<int32_t*>(reinterpret_cast<char*>(this) + kNodeHeaderSize) +
+                   index * fCapacity;
+        }
+        Child& child(int index) {
+            return reinterpret_cast<Child*>(this->side(4))[index];
+        }
+        SkIRect bounds(int index) {
+            return SkIRect::MakeLTRB(this->side(0)[index], this->side(1)[index],
+                                     this->side(2)[index], this->side(3)[index]);
+        }
+        void setBounds(int index, const SkIRect& bounds) {
+            this->side(0)[index] = bounds.fLeft;
+            this->side(1)[index] = bounds.fTop;
+            this->side(2)[index] = bounds.fRight;
+            this->side(3)[index] = bounds.fBottom;
+        }
+        Branch branch(int index) {
+            Branch branch;
+            branch.fChild = this->child(index);
+            branch.fBounds = this->bounds(index);
+            return branch;
+        }
+        void setBranch(int index, const Branch& branch) {
+            this->child(index) = branch.fChild;
+            this->setBounds(index, branch.fBounds);
         }
     };
 
@@ -151,7 +214,7 @@ private:
         }
     };
 
-    SkRTree(int minChildren, int maxChildren, SkScalar aspectRatio, bool orderWhenBulkLoading);
+    SkRTree(int minChildren, int maxChildren, SkScalar aspectRatio, BulkLoadOrder bulkLoadOrder);
 
     /**
      * Recursively descend the tree to find an insertion position for 'branch', updates
@@ -169,29 +232,36 @@ private:
      * seems to generally produce better, more consistent trees at significantly lower cost than
      * repeated insertions.
      *
+     * With kHilbert_BulkLoadOrder, it packs runs of branches sorted along a Hilbert curve instead
+     * of tiles.
+     *
      * This consumes the input array.
      *
-     * TODO: Experiment with other bulk-load algorithms (in particular the Hilbert pack variant,
-     * which groups rects by position on the Hilbert curve, is probably worth a look). There also
-     * exist top-down bulk load variants (VAMSplit, TopDownGreedy, etc).
+     * TODO: Experiment with other bulk-load algorithms. There also exist top-down bulk load
+     * variants (VAMSplit, TopDownGreedy, etc).
      */
     Branch bulkLoad(SkTDArray<Branch>* branches, int level = 0);
+    void sortAlongHilbertCurve(SkTDArray<Branch>* branches);
 
     void validate();
     int validateSubtree(Node* root, SkIRect bounds, bool isRoot = false);
 
     const int fMinChildren;
     const int fMaxChildren;
+    const int fNodeCapacity;
     const size_t fNodeSize;
 
     // This is the count of data elements (rather than total nodes in the tree)
     int fCount;
 
     Branch fRoot;
+    // Nodes are carved out of slabs of kNodesPerSlab nodes, aligned on a cache line.
     SkChunkAlloc fNodes;
+    char* fNextNode;
+    char* fEndOfSlab;
     SkTDArray<Branch> fDeferredInserts;
     SkScalar fAspectRatio;
-    bool fSortWhenBulkLoading;
+    BulkLoadOrder fBulkLoadOrder;
 
     Node* allocateNode(uint16_t level);
 
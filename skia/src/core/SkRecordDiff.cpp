@@ -0,0 +1,348 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRecordDiff.h"
+
+#include "SkBitmapHeap.h"
+#include "SkChecksum.h"
+#include "SkRecord.h"
+#include "SkRecordDraw.h"
+#include "SkRegion.h"
+#include "SkTDArray.h"
+#include "SkTypeface.h"
+#include "SkWriteBuffer.h"
+#include "SkWriter32.h"
+
+using namespace SkRecords;
+
+namespace {
+
+static void write_bitmap_key(SkWriter32* writer, const SkBitmap& bitmap) {
+    // Recorded bitmaps are immutable, so bitmaps sharing pixels draw the same.
+    const SkIPoint origin = bitmap.pixelRefOrigin();
+    writer->write32(bitmap.getGenerationID());
+    writer->writeInt(origin.fX);
+    writer->writeInt(origin.fY);
+    writer->writeInt(bitmap.width());
+    writer->writeInt(bitmap.height());
+    writer->writeInt(bitmap.colorType());
+}
+
+// Given to the SkBitmapHeap a paint is flattened with, so that the bitmaps in its effects are
+// written as their key rather than as their pixels.
+class BitmapKeyWriter : public SkBitmapHeap::ExternalStorage {
+public:
+    explicit BitmapKeyWriter(SkWriter32* writer) : fWriter(writer) {}
+
+    virtual bool insert(const SkBitmap& bitmap, int32_t) SK_OVERRIDE {
+        write_bitmap_key(fWriter, bitmap);
+        return true;
+    }
+
+private:
+    SkWriter32* fWriter;
+};
+
+// An SkRecord visitor that hashes the type and arguments of a command.  The arguments are written
+// much as SkRecordSerialize() writes them, except that paints, paths and bitmaps are written in
+// full, or as a key, instead of as an index into a table shared with the commands before them, so
+// that the hash of a command doesn't depend on the rest of the record.
+class Hasher : SkNoncopyable {
+public:
+    Hasher() : fBitmapKeys(&fArgs) {}
+
+    template <typename T> uint32_t operator()(const T& r) {
+        fArgs.reset();
+        fArgs.write32(T::kType);
+        this->writeArgs(r);
+        return SkChecksum::Murmur3(fArgs.contiguousArray(), fArgs.bytesWritten());
+    }
+
+private:
+    // No base case, so we'll be compile-time checked that we implement all possibilities.
+    template <typename T> void writeArgs(const T&);
+
+    void writePaint(const SkPaint*);
+    void writeBitmap(const SkBitmap&);
+    void writeMatrix(const SkMatrix&);
+
+    SkSWriter32<1024> fArgs;
+    BitmapKeyWriter fBitmapKeys;
+    uint32_t fPaintStorage[128];
+};
+
+void Hasher::writePaint(const SkPaint* paint) {
+    fArgs.writeBool(NULL != paint);
+    if (NULL == paint) {
+        return;
+    }
+    // Without a typeface recorder, the buffer leaves the typeface out and writes the effects with
+    // the address of their factory, which is as good as its name within a process. A bitmap in an
+    // effect is written to the buffer as a slot in a heap that only lives for this paint, which
+    // writes its key to fArgs.
+    SkBitmapHeap bitmapHeap(&fBitmapKeys);
+    SkWriteBuffer buffer(fPaintStorage, sizeof(fPaintStorage));
+    buffer.setBitmapHeap(&bitmapHeap);
+    buffer.writePaint(*paint);
+    fArgs.write32(SkChecksum::Murmur3(buffer.getWriter32()->contiguousArray(),
+                                      buffer.bytesWritten()));
+    const SkTypeface* typeface = paint->getTypeface();
+    fArgs.write32(NULL != typeface ? typeface->uniqueID() : 0);
+}
+
+void Hasher::writeBitmap(const SkBitmap& bitmap) {
+    write_bitmap_key(&fArgs, bitmap);
+}
+
+void Hasher::writeMatrix(const SkMatrix& matrix) {
+    for (int i = 0; i < 9; i++) {
+        fArgs.writeScalar(matrix[i]);
+    }
+}
+
+template <> void Hasher::writeArgs(const NoOp&) {}
+template <> void Hasher::writeArgs(const Restore&) {}
+template <> void Hasher::writeArgs(const Save& r) { fArgs.write32(r.flags); }
+template <> void Hasher::writeArgs(const SaveLayer& r) {
+    fArgs.writeBool(NULL != r.bounds);
+    if (NULL != r.bounds) {
+        fArgs.writeRect(*r.bounds);
+    }
+    this->writePaint(r.paint);
+    fArgs.write32(r.flags);
+}
+template <> void Hasher::writeArgs(const PushCull& r) { fArgs.writeRect(r.rect); }
+template <> void Hasher::writeArgs(const PopCull&) {}
+template <> void Hasher::writeArgs(const PairedPushCull& r) {
+    fArgs.writeRect(r.base->rect);
+    fArgs.write32(r.skip);
+}
+template <> void Hasher::writeArgs(const Concat& r) { this->writeMatrix(r.matrix); }
+template <> void Hasher::writeArgs(const SetMatrix& r) { this->writeMatrix(r.matrix); }
+
+template <> void Hasher::writeArgs(const ClipPath& r) {
+    fArgs.writePath(r.path);
+    fArgs.write32(r.op);
+    fArgs.writeBool(r.doAA);
+}
+template <> void Hasher::writeArgs(const ClipRRect& r) {
+    fArgs.writeRRect(r.rrect);
+    fArgs.write32(r.op);
+    fArgs.writeBool(r.doAA);
+}
+template <> void Hasher::writeArgs(const ClipRect& r) {
+    fArgs.writeRect(r.rect);
+    fArgs.write32(r.op);
+    fArgs.writeBool(r.doAA);
+}
+template <> void Hasher::writeArgs(const ClipRegion& r) {
+    fArgs.writeRegion(r.region);
+    fArgs.write32(r.op);
+}
+
+template <> void Hasher::writeArgs(const Clear& r) { fArgs.write32(r.color); }
+
+template <> void Hasher::writeArgs(const DrawBitmap& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fArgs.writeScalar(r.left);
+    fArgs.writeScalar(r.top);
+}
+template <> void Hasher::writeArgs(const DrawBitmapMatrix& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    this->writeMatrix(r.matrix);
+}
+template <> void Hasher::writeArgs(const DrawBitmapNine& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fArgs.writeIRect(r.center);
+    fArgs.writeRect(r.dst);
+}
+template <> void Hasher::writeArgs(const DrawBitmapRectToRect& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fArgs.writeBool(NULL != r.src);
+    if (NULL != r.src) {
+        fArgs.writeRect(*r.src);
+    }
+    fArgs.writeRect(r.dst);
+    fArgs.write32(r.flags);
+}
+template <> void Hasher::writeArgs(const DrawDRRect& r) {
+    this->writePaint(&r.paint);
+    fArgs.writeRRect(r.outer);
+    fArgs.writeRRect(r.inner);
+}
+template <> void Hasher::writeArgs(const DrawOval& r) {
+    this->writePaint(&r.paint);
+    fArgs.writeRect(r.oval);
+}
+template <> void Hasher::writeArgs(const DrawPaint& r) { this->writePaint(&r.paint); }
+template <> void Hasher::writeArgs(const DrawPath& r) {
+    this->writePaint(&r.paint);
+    fArgs.writePath(r.path);
+}
+template <> void Hasher::writeArgs(const DrawPoints& r) {
+    this->writePaint(&r.paint);
+    fArgs.write32(r.mode);
+    fArgs.write32(SkToU32(r.count));
+    fArgs.write(r.pts, r.count * sizeof(SkPoint));
+}
+template <> void Hasher::writeArgs(const DrawPosText& r) {
+    this->writePaint(&r.paint);
+    const int points = r.paint.countText(r.text, r.byteLength);
+    fArgs.write32(SkToU32(r.byteLength));
+    fArgs.writePad(r.text, r.byteLength);
+    fArgs.write(r.pos, points * sizeof(SkPoint));
+}
+template <> void Hasher::writeArgs(const DrawPosTextH& r) {
+    this->writePaint(&r.paint);
+    const int points = r.paint.countText(r.text, r.byteLength);
+    fArgs.write32(SkToU32(r.byteLength));
+    fArgs.writeScalar(r.y);
+    fArgs.writePad(r.text, r.byteLength);
+    fArgs.write(r.xpos, points * sizeof(SkScalar));
+}
+template <> void Hasher::writeArgs(const BoundedDrawPosTextH& r) {
+    fArgs.writeScalar(r.minY);
+    fArgs.writeScalar(r.maxY);
+    this->writeArgs(*r.base);
+}
+template <> void Hasher::writeArgs(const DrawRRect& r) {
+    this->writePaint(&r.paint);
+    fArgs.writeRRect(r.rrect);
+}
+template <> void Hasher::writeArgs(const DrawRect& r) {
+    this->writePaint(&r.paint);
+    fArgs.writeRect(r.rect);
+}
+template <> void Hasher::writeArgs(const DrawSprite& r) {
+    this->writePaint(r.paint);
+    this->writeBitmap(r.bitmap);
+    fArgs.writeInt(r.left);
+    fArgs.writeInt(r.top);
+}
+template <> void Hasher::writeArgs(const DrawText& r) {
+    this->writePaint(&r.paint);
+    fArgs.write32(SkToU32(r.byteLength));
+    fArgs.writeScalar(r.x);
+    fArgs.writeScalar(r.y);
+    fArgs.writePad(r.text, r.byteLength);
+}
+template <> void Hasher::writeArgs(const DrawTextOnPath& r) {
+    this->writePaint(&r.paint);
+    fArgs.write32(SkToU32(r.byteLength));
+    fArgs.writePath(r.path);
+    fArgs.writeBool(NULL != r.matrix);
+    if (NULL != r.matrix) {
+        this->writeMatrix(*r.matrix);
+    }
+    fArgs.writePad(r.text, r.byteLength);
+}
+template <> void Hasher::writeArgs(const DrawVertices& r) {
+    this->writePaint(&r.paint);
+    fArgs.write32(r.vmode);
+    fArgs.write32(r.vertexCount);
+    fArgs.write32(r.indexCount);
+    fArgs.writeBool(NULL != r.texs);
+    fArgs.writeBool(NULL != r.colors);
+    // The xfermode is hashed as the only effect of a paint.
+    if (NULL != r.xmode.get()) {
+        SkPaint xmodePaint;
+        xmodePaint.setXfermode(r.xmode.get());
+        this->writePaint(&xmodePaint);
+    } else {
+        this->writePaint(NULL);
+    }
+    fArgs.write(r.vertices, r.vertexCount * sizeof(SkPoint));
+    if (NULL != r.texs) {
+        fArgs.write(r.texs, r.vertexCount * sizeof(SkPoint));
+    }
+    if (NULL != r.colors) {
+        fArgs.write(r.colors, r.vertexCount * sizeof(SkColor));
+    }
+    fArgs.writePad(r.indices, r.indexCount * sizeof(uint16_t));
+}
+
+// Sets region to the union of rects.  Adding the rects one at a time to a region that grows with
+// each of them is quadratic, so halves are joined instead.
+static void union_rects(const SkIRect rects[], int count, SkRegion* region) {
+    if (count <= 2) {
+        region->setEmpty();
+        for (int i = 0; i < count; i++) {
+            region->op(rects[i], SkRegion::kUnion_Op);
+        }
+        return;
+    }
+    SkRegion second;
+    union_rects(rects, count / 2, region);
+    union_rects(rects + count / 2, count - count / 2, &second);
+    region->op(second, SkRegion::kUnion_Op);
+}
+
+static void push_bounds(const SkIRect& bounds, SkTDArray<SkIRect>* damaged) {
+    if (!bounds.isEmpty()) {
+        *damaged->append() = bounds;
+    }
+}
+
+}  // namespace
+
+SkRecordSummary::SkRecordSummary(const SkRecord& record, const SkIRect& cullBounds)
+    : fCount(record.count())
+    , fCullBounds(cullBounds)
+    , fHashes(record.count())
+    , fBounds(record.count()) {
+    Hasher hasher;
+    for (unsigned i = 0; i < fCount; i++) {
+        fHashes[i] = record.visit<uint32_t>(i, hasher);
+    }
+    SkRecordComputeBounds(record, fCullBounds, fBounds.get());
+}
+
+void SkRecordDiff(const SkRecordSummary& before, const SkRecordSummary& after, SkRegion* damage) {
+    SkASSERT(NULL != damage);
+    if (before.cullBounds() != after.cullBounds()) {
+        damage->setRect(after.cullBounds());
+        damage->op(before.cullBounds(), SkRegion::kUnion_Op);
+        return;
+    }
+
+    // Skip the commands both records start with, then those they end with.
+    unsigned start = 0;
+    const unsigned common = SkTMin(before.count(), after.count());
+    while (start < common && before.sameOp(start, after, start)) {
+        start++;
+    }
+    unsigned beforeStop = before.count();
+    unsigned afterStop = after.count();
+    while (beforeStop > start && afterStop > start &&
+           before.sameOp(beforeStop - 1, after, afterStop - 1)) {
+        beforeStop--;
+        afterStop--;
+    }
+
+    SkTDArray<SkIRect> damaged;
+    if (beforeStop - start == afterStop - start) {
+        for (unsigned i = start; i < beforeStop; i++) {
+            if (!before.sameOp(i, after, i)) {
+                push_bounds(before.bounds(i), &damaged);
+                push_bounds(after.bounds(i), &damaged);
+            }
+        }
+    } else {
+        // Commands were added or removed, so the ones in between can't be paired up.
+        for (unsigned i = start; i < beforeStop; i++) {
+            push_bounds(before.bounds(i), &damaged);
+        }
+        for (unsigned i = start; i < afterStop; i++) {
+            push_bounds(after.bounds(i), &damaged);
+        }
+    }
+    union_rects(damaged.begin(), damaged.count(), damage);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRecordDiff_DEFINED
+#define SkRecordDiff_DEFINED
+
+#include "SkRect.h"
+#include "SkTemplates.h"
+
+class SkRecord;
+class SkRegion;
+
+// What SkRecordDiff() needs to know about each command of an SkRecord: a hash of its type and of
+// its arguments, flattened, and its device bounds as SkRecordFillBounds() computes them.  Keeping
+// the summary of the last frame is enough to find what the next one changes; the SkRecord itself
+// can be thrown away.
+class SkRecordSummary : SkNoncopyable {
+public:
+    SkRecordSummary(const SkRecord&, const SkIRect& cullBounds);
+
+    unsigned count() const { return fCount; }
+    const SkIRect& cullBounds() const { return fCullBounds; }
+
+    uint32_t hash(unsigned i) const { SkASSERT(i < fCount); return fHashes[i]; }
+    const SkIRect& bounds(unsigned i) const { SkASSERT(i < fCount); return fBounds[i]; }
+
+    // Whether the i-th command of this record and the j-th command of other draw the same.
+    bool sameOp(unsigned i, const SkRecordSummary& other, unsigned j) const {
+        return this->hash(i) == other.hash(j) && this->bounds(i) == other.bounds(j);
+    }
+
+private:
+    const unsigned           fCount;
+    const SkIRect            fCullBounds;
+    SkAutoTMalloc<uint32_t>  fHashes;
+    SkAutoTMalloc<SkIRect>   fBounds;
+};
+
+// Sets damage to the device area that may look different when the commands summarized by after
+// are drawn instead of those summarized by before, so that a raster backend that keeps what
+// before drew only has to draw after again in damage.
+//
+// The commands both records start and end with are left out.  The ones in between are compared
+// one by one if there are as many on both sides, and then only the bounds, before and after, of
+// the ones that differ are damaged; otherwise all their bounds are.  A Save, a matrix or a clip
+// change has the bounds of the draws it affects, so changing one damages all of them.  Two
+// commands whose hashes collide are taken to be the same.
+void SkRecordDiff(const SkRecordSummary& before, const SkRecordSummary& after, SkRegion* damage);
+
+#endif//SkRecordDiff_DEFINED
@@ -7,12 +7,130 @@
 
 #include "SkRecordDraw.h"
 
-void SkRecordDraw(const SkRecord& record, SkCanvas* canvas) {
+#include "SkBBoxHierarchy.h"
+#include "SkTSort.h"
+
+namespace SkRecords {
+
+// This is an SkRecord visitor that computes the device bounds of each command, for an
+// SkBBoxHierarchy or to tell where two SkRecords draw differently.
+//
+// The bounds of a draw are those of its geometry, adjusted for its paint, mapped by the current
+// matrix and clipped to the current clip.  Commands that don't draw (Saves, Restores, matrix and
+// clip changes) only need to be played back if a draw they affect is, so they get the union of
+// the bounds of the draws in their Save block.  Those are known when the block's Restore is
+// reached; until then the commands are kept on a stack.
+class FillBounds : SkNoncopyable {
+public:
+    // Sets bounds[i] to the bounds of the i-th command.
+    FillBounds(const SkRecord&, const SkIRect& cullBounds, SkIRect bounds[]);
+
+    template <typename T> void operator()(const T& op) { this->trackBounds(op); }
+
+private:
+    struct SaveBounds {
+        int      fControlOps;       // The number of control commands before this block.
+        SkIRect  fBounds;           // The union of the bounds of the draws in this block.
+        SkMatrix fCTM;              // The matrix and clip when the block was opened.
+        SkIRect  fClipBounds;
+        bool     fDrawsEverywhere;  // True for layers that may draw outside their draws.
+        // The paint of a layer that may spread what is drawn into it when it is restored, or NULL.
+        const SkPaint* fLayerPaint;
+    };
+
+    // No base case, so we'll be compile-time checked that we implement all possibilities.
+    template <typename T> void trackBounds(const T&);
+
+    void trackDraw(SkIRect bounds) {
+        bounds = this->adjustForLayerPaints(bounds);
+        fBounds[fCurrentOp] = bounds;
+        this->updateSaveBounds(bounds);
+    }
+    void pushControl() { fControlIndices.push(fCurrentOp); }
+
+    void pushSaveBlock(const SkPaint*);
+    SkIRect popSaveBlock();
+    void updateSaveBounds(const SkIRect&);
+
+    void updateClipBounds(const SkRect& localBounds, SkRegion::Op);
+    void updateClipDeviceBounds(const SkIRect& devBounds, SkRegion::Op);
+    void intersectClipBounds(const SkIRect&);
+
+    // Returns the device bounds of rect drawn with paint, clipped to the current clip.
+    SkIRect adjustAndMap(SkRect rect, const SkPaint* paint) const;
+    SkIRect adjustForLayerPaints(SkIRect bounds) const;
+    SkIRect clipBoundsFor(const SkPaint*) const;
+    SkIRect bounds(const DrawPosText&) const;
+    SkIRect bounds(const DrawPosTextH&) const;
+
+    const SkIRect fCullBounds;
+    SkIRect* fBounds;  // One for each command in the SkRecord.
+    unsigned fCurrentOp;
+
+    SkMatrix fCTM;
+    SkIRect fClipBounds;  // Device bounds of the current clip.
+
+    SkTDArray<SaveBounds> fSaveStack;
+    SkTDArray<unsigned> fControlIndices;  // Control commands waiting for their block's bounds.
+};
+
+}  // namespace SkRecords
+
+void SkRecordDraw(const SkRecord& record, SkCanvas* canvas, SkBBoxHierarchy* bbh) {
+    if (NULL != bbh) {
+        SkRect clipBounds;
+        if (!canvas->getClipBounds(&clipBounds)) {
+            return;
+        }
+        SkIRect query;
+        clipBounds.roundOut(&query);
+
+        // The BBH holds the index of each command, but not all BBHs return them in order.
+        SkTDArray<void*> ops;
+        bbh->search(query, &ops);
+        if (ops.isEmpty()) {
+            return;
+        }
+        if (!bbh->searchIsOrdered()) {
+            SkTQSort(ops.begin(), ops.end() - 1, SkTCompareLT<void*>());
+        }
+
+        SkRecords::Draw draw(canvas);
+        for (int i = 0; i < ops.count(); i++) {
+            const unsigned index = (unsigned)(uintptr_t)ops[i];
+            if (index < draw.index()) {
+                continue;  // A PairedPushCull has skipped past this command.
+            }
+            draw.setIndex(index);
+            record.visit<void>(index, draw);
+            draw.next();
+        }
+        return;
+    }
+
     for (SkRecords::Draw draw(canvas); draw.index() < record.count(); draw.next()) {
         record.visit<void>(draw.index(), draw);
     }
 }
 
+void SkRecordComputeBounds(const SkRecord& record, const SkIRect& cullBounds, SkIRect bounds[]) {
+    SkRecords::FillBounds fill(record, cullBounds, bounds);
+}
+
+void SkRecordFillBounds(const SkRecord& record, const SkIRect& cullBounds, SkBBoxHierarchy* bbh) {
+    SkASSERT(NULL != bbh);
+    // The bounds of a Save block's commands are only known once its Restore is reached, so all
+    // the bounds are computed first and fed to the BBH in order at the end.
+    SkAutoTMalloc<SkIRect> bounds(record.count());
+    SkRecordComputeBounds(record, cullBounds, bounds.get());
+    for (unsigned i = 0; i < record.count(); i++) {
+        if (!bounds[i].isEmpty()) {
+            bbh->insert((void*)(uintptr_t)i, bounds[i], true/*ok to defer*/);
+        }
+    }
+    bbh->flushDeferredInserts();
+}
+
 namespace SkRecords {
 
 bool Draw::skip(const PairedPushCull& r) {
@@ -68,4 +186,354 @@ DRAW(DrawVertices, drawVertices(r.vmode, r.vertexCount, r.vertices, r.texs, r.co
 template <> void Draw::draw(const PairedPushCull& r) { this->draw(*r.base); }
 template <> void Draw::draw(const BoundedDrawPosTextH& r) { this->draw(*r.base); }
 
+FillBounds::FillBounds(const SkRecord& record, const SkIRect& cullBounds, SkIRect bounds[])
+    : fCullBounds(cullBounds)
+    , fBounds(bounds) {
+    fCTM.reset();
+    fClipBounds = fCullBounds;
+
+    for (fCurrentOp = 0; fCurrentOp < record.count(); fCurrentOp++) {
+        record.visit<void>(fCurrentOp, *this);
+    }
+
+    // Close any Save blocks left open by a missing Restore.
+    while (!fSaveStack.isEmpty()) {
+        this->popSaveBlock();
+    }
+
+    // Commands outside of any Save block may affect any draw.
+    while (!fControlIndices.isEmpty()) {
+        fBounds[fControlIndices.top()] = fCullBounds;
+        fControlIndices.pop();
+    }
+}
+
+void FillBounds::pushSaveBlock(const SkPaint* paint) {
+    SaveBounds* block = fSaveStack.push();
+    block->fControlOps = fControlIndices.count();
+    block->fBounds.setEmpty();
+    block->fCTM = fCTM;
+    block->fClipBounds = fClipBounds;
+    // For now, assume all filters affect transparent black, i.e. that the layer
+    // may draw everywhere in its bounds when it is restored.
+    block->fDrawsEverywhere = NULL != paint &&
+                              (NULL != paint->getImageFilter() || NULL != paint->getColorFilter());
+    const bool spreads = NULL != paint && (NULL != paint->getImageFilter() ||
+                                           NULL != paint->getMaskFilter() ||
+                                           NULL != paint->getLooper());
+    block->fLayerPaint = spreads ? paint : NULL;
+}
+
+SkIRect FillBounds::popSaveBlock() {
+    SaveBounds block;
+    fSaveStack.pop(&block);
+
+    // The layer is drawn when it is restored, under the clip it was saved with: any clip inside
+    // the block may have narrowed fClipBounds since.
+    SkIRect bounds = block.fDrawsEverywhere ? block.fClipBounds : block.fBounds;
+
+    // The Save, the Restore and everything else that changes the state inside the block only
+    // matter to the draws in it.
+    while (fControlIndices.count() > block.fControlOps) {
+        fBounds[fControlIndices.top()] = bounds;
+        fControlIndices.pop();
+    }
+
+    fCTM = block.fCTM;
+    fClipBounds = block.fClipBounds;
+    this->updateSaveBounds(bounds);
+    return bounds;
+}
+
+void FillBounds::updateSaveBounds(const SkIRect& bounds) {
+    if (!fSaveStack.isEmpty()) {
+        fSaveStack.top().fBounds.join(bounds);
+    }
+}
+
+void FillBounds::updateClipBounds(const SkRect& localBounds, SkRegion::Op op) {
+    SkRect devRect;
+    fCTM.mapRect(&devRect, localBounds);
+    SkIRect devBounds;
+    devRect.roundOut(&devBounds);
+    this->updateClipDeviceBounds(devBounds, op);
+}
+
+void FillBounds::updateClipDeviceBounds(const SkIRect& devBounds, SkRegion::Op op) {
+    switch (op) {
+        case SkRegion::kIntersect_Op:
+            this->intersectClipBounds(devBounds);
+            break;
+        case SkRegion::kDifference_Op:
+            break;  // can only shrink the clip
+        case SkRegion::kReplace_Op:
+        case SkRegion::kReverseDifference_Op:
+            fClipBounds = fCullBounds;
+            this->intersectClipBounds(devBounds);
+            break;
+        default:  // union and xor may grow the clip
+            fClipBounds.join(devBounds);
+            this->intersectClipBounds(fCullBounds);
+            break;
+    }
+}
+
+void FillBounds::intersectClipBounds(const SkIRect& bounds) {
+    if (!fClipBounds.intersect(bounds)) {
+        fClipBounds.setEmpty();
+    }
+}
+
+SkIRect FillBounds::adjustAndMap(SkRect rect, const SkPaint* paint) const {
+    rect.sort();
+    if (NULL != paint) {
+        // account for stroking, path effects, shadows, etc
+        if (!paint->canComputeFastBounds()) {
+            return fClipBounds;
+        }
+        SkRect storage;
+        rect = paint->computeFastBounds(rect, &storage);
+    }
+
+    fCTM.mapRect(&rect);
+    SkIRect devBounds;
+    rect.roundOut(&devBounds);
+    // Antialiasing may touch the pixels just outside of the geometry.
+    devBounds.outset(1, 1);
+    if (!devBounds.intersect(fClipBounds)) {
+        devBounds.setEmpty();
+    }
+    return devBounds;
+}
+
+// A blur, a shadow or an offset in a layer's paint moves or spreads the pixels drawn into the
+// layer when it is restored, so a draw in the layer also touches the pixels its layers' paints
+// take it to.  Those paints work in the space the layer was saved in.
+SkIRect FillBounds::adjustForLayerPaints(SkIRect bounds) const {
+    for (int i = fSaveStack.count() - 1; i >= 0 && !bounds.isEmpty(); i--) {
+        const SaveBounds& block = fSaveStack[i];
+        if (NULL == block.fLayerPaint) {
+            continue;
+        }
+        SkMatrix inverse;
+        if (!block.fLayerPaint->canComputeFastBounds() || !block.fCTM.invert(&inverse)) {
+            bounds = block.fClipBounds;
+            continue;
+        }
+        SkRect rect = SkRect::Make(bounds);
+        inverse.mapRect(&rect);
+        SkRect storage;
+        rect = block.fLayerPaint->computeFastBounds(rect, &storage);
+        block.fCTM.mapRect(&rect);
+        rect.roundOut(&bounds);
+        if (!bounds.intersect(block.fClipBounds)) {
+            bounds.setEmpty();
+        }
+    }
+    return bounds;
+}
+
+SkIRect FillBounds::clipBoundsFor(const SkPaint* paint) const {
+    // Ops that draw everywhere may be drawn with a paint that draws nothing.
+    return NULL != paint && paint->nothingToDraw() ? SkIRect::MakeEmpty() : fClipBounds;
+}
+
+// The Save block ops.
+template <> void FillBounds::trackBounds(const Save&) {
+    this->pushSaveBlock(NULL);
+    this->pushControl();
+}
+template <> void FillBounds::trackBounds(const SaveLayer& op) {
+    this->pushSaveBlock(op.paint);
+    this->pushControl();
+    // Nothing is drawn outside the layer's bounds.
+    if (NULL != op.bounds) {
+        this->intersectClipBounds(this->adjustAndMap(*op.bounds, NULL));
+    }
+}
+template <> void FillBounds::trackBounds(const Restore&) {
+    this->pushControl();
+    // Like SkCanvas, ignore a Restore without a Save, which SkRecordOptimize may leave behind.
+    if (!fSaveStack.isEmpty()) {
+        this->popSaveBlock();
+    }
+}
+
+// Ops that change the state for the ops after them.
+template <> void FillBounds::trackBounds(const Concat& op) {
+    fCTM.preConcat(op.matrix);
+    this->pushControl();
+}
+template <> void FillBounds::trackBounds(const SetMatrix& op) {
+    fCTM = op.matrix;
+    this->pushControl();
+}
+template <> void FillBounds::trackBounds(const ClipPath& op) {
+    if (op.path.isInverseFillType()) {
+        this->updateClipDeviceBounds(fCullBounds, op.op);
+    } else {
+        this->updateClipBounds(op.path.getBounds(), op.op);
+    }
+    this->pushControl();
+}
+template <> void FillBounds::trackBounds(const ClipRRect& op) {
+    this->updateClipBounds(op.rrect.getBounds(), op.op);
+    this->pushControl();
+}
+template <> void FillBounds::trackBounds(const ClipRect& op) {
+    this->updateClipBounds(op.rect, op.op);
+    this->pushControl();
+}
+template <> void FillBounds::trackBounds(const ClipRegion& op) {
+    // Regions are in device space.
+    this->updateClipDeviceBounds(op.region.getBounds(), op.op);
+    this->pushControl();
+}
+template <> void FillBounds::trackBounds(const PushCull&) { this->pushControl(); }
+template <> void FillBounds::trackBounds(const PopCull&) { this->pushControl(); }
+template <> void FillBounds::trackBounds(const PairedPushCull&) { this->pushControl(); }
+
+// NoOps draw nothing.
+template <> void FillBounds::trackBounds(const NoOp&) { fBounds[fCurrentOp].setEmpty(); }
+
+// Draws.
+#define BOUNDS(T, call) \
+    template <> void FillBounds::trackBounds(const T& op) { this->trackDraw(call); }
+BOUNDS(Clear, fCullBounds);  // clear() ignores the clip
+BOUNDS(DrawPaint, this->clipBoundsFor(&op.paint));
+
+BOUNDS(DrawBitmap, this->adjustAndMap(SkRect::MakeXYWH(op.left, op.top,
+                                                       SkIntToScalar(op.bitmap.width()),
+                                                       SkIntToScalar(op.bitmap.height())),
+                                      op.paint));
+BOUNDS(DrawBitmapNine, this->adjustAndMap(op.dst, op.paint));
+BOUNDS(DrawBitmapRectToRect, this->adjustAndMap(op.dst, op.paint));
+BOUNDS(DrawDRRect, this->adjustAndMap(op.outer.rect(), &op.paint));
+BOUNDS(DrawOval, this->adjustAndMap(op.oval, &op.paint));
+BOUNDS(DrawRRect, this->adjustAndMap(op.rrect.rect(), &op.paint));
+BOUNDS(DrawRect, this->adjustAndMap(op.rect, &op.paint));
+BOUNDS(DrawPath, op.path.isInverseFillType() ? this->clipBoundsFor(&op.paint)
+                                             : this->adjustAndMap(op.path.getBounds(), &op.paint));
+BOUNDS(BoundedDrawPosTextH, this->bounds(*op.base));
+#undef BOUNDS
+
+template <> void FillBounds::trackBounds(const DrawBitmapMatrix& op) {
+    SkRect dst = SkRect::MakeWH(SkIntToScalar(op.bitmap.width()),
+                                SkIntToScalar(op.bitmap.height()));
+    op.matrix.mapRect(&dst);
+    this->trackDraw(this->adjustAndMap(dst, op.paint));
+}
+
+template <> void FillBounds::trackBounds(const DrawSprite& op) {
+    // Sprites are drawn in device space, ignoring the matrix.
+    SkIRect dst = SkIRect::MakeXYWH(op.left, op.top, op.bitmap.width(), op.bitmap.height());
+    if (!dst.intersect(fClipBounds)) {
+        dst.setEmpty();
+    }
+    this->trackDraw(dst);
+}
+
+template <> void FillBounds::trackBounds(const DrawPoints& op) {
+    SkRect dst;
+    dst.set(op.pts, SkToInt(op.count));
+    // Points are always drawn stroked, so hairlines need some width to not be empty.
+    static const SkScalar kMinWidth = 0.01f;
+    SkScalar halfStrokeWidth = SkMaxScalar(op.paint.getStrokeWidth(), kMinWidth) / 2;
+    dst.outset(halfStrokeWidth, halfStrokeWidth);
+    this->trackDraw(this->adjustAndMap(dst, &op.paint));
+}
+
+template <> void FillBounds::trackBounds(const DrawVertices& op) {
+    SkRect dst;
+    dst.set(op.vertices, op.vertexCount);
+    this->trackDraw(this->adjustAndMap(dst, &op.paint));
+}
+
+// The text bounds follow SkBBoxRecord: the glyphs are assumed to fit in the font's vertical
+// extents, and to stick out horizontally by no more than a multiple of them.
+template <> void FillBounds::trackBounds(const DrawText& op) {
+    SkRect dst;
+    op.paint.measureText(op.text, op.byteLength, &dst);
+    SkPaint::FontMetrics metrics;
+    op.paint.getFontMetrics(&metrics);
+
+    if (op.paint.isVerticalText()) {
+        SkScalar h = dst.height();
+        if (op.paint.getTextAlign() == SkPaint::kCenter_Align) {
+            dst.offset(0, -h / 2);
+        }
+        dst.fTop += metrics.fTop;
+        dst.fBottom += metrics.fBottom;
+    } else {
+        SkScalar w = dst.width();
+        if (op.paint.getTextAlign() == SkPaint::kCenter_Align) {
+            dst.offset(-w / 2, 0);
+        } else if (op.paint.getTextAlign() == SkPaint::kRight_Align) {
+            dst.offset(-w, 0);
+        }
+        dst.fTop = metrics.fTop;
+        dst.fBottom = metrics.fBottom;
+    }
+    SkScalar pad = (metrics.fBottom - metrics.fTop) / 2;
+    dst.outset(pad, 0);
+    dst.offset(op.x, op.y);
+    this->trackDraw(this->adjustAndMap(dst, &op.paint));
+}
+
+template <> void FillBounds::trackBounds(const DrawPosText& op) {
+    this->trackDraw(this->bounds(op));
+}
+
+template <> void FillBounds::trackBounds(const DrawPosTextH& op) {
+    this->trackDraw(this->bounds(op));
+}
+
+template <> void FillBounds::trackBounds(const DrawTextOnPath& op) {
+    SkRect dst = op.path.getBounds();
+    if (NULL != op.matrix) {
+        op.matrix->mapRect(&dst);
+    }
+    SkPaint::FontMetrics metrics;
+    op.paint.getFontMetrics(&metrics);
+    // pad out all sides by the max glyph height above baseline
+    SkScalar pad = -metrics.fTop;
+    dst.outset(pad, pad);
+    this->trackDraw(this->adjustAndMap(dst, &op.paint));
+}
+
+SkIRect FillBounds::bounds(const DrawPosText& op) const {
+    int count = op.paint.countText(op.text, op.byteLength);
+    if (0 == count) {
+        return SkIRect::MakeEmpty();
+    }
+    SkRect dst;
+    dst.set(op.pos, count);
+    SkPaint::FontMetrics metrics;
+    op.paint.getFontMetrics(&metrics);
+    dst.fTop += metrics.fTop;
+    dst.fBottom += metrics.fBottom;
+    SkScalar pad = 4 * (metrics.fBottom - metrics.fTop) / 2;
+    dst.outset(pad, 0);
+    return this->adjustAndMap(dst, &op.paint);
+}
+
+SkIRect FillBounds::bounds(const DrawPosTextH& op) const {
+    int count = op.paint.countText(op.text, op.byteLength);
+    if (0 == count) {
+        return SkIRect::MakeEmpty();
+    }
+    SkRect dst = SkRect::MakeLTRB(op.xpos[0], op.y, op.xpos[0], op.y);
+    for (int i = 1; i < count; i++) {
+        dst.fLeft = SkMinScalar(dst.fLeft, op.xpos[i]);
+        dst.fRight = SkMaxScalar(dst.fRight, op.xpos[i]);
+    }
+    SkPaint::FontMetrics metrics;
+    op.paint.getFontMetrics(&metrics);
+    dst.fTop += metrics.fTop;
+    dst.fBottom += metrics.fBottom;
+    SkScalar pad = 4 * (metrics.fBottom - metrics.fTop);
+    dst.outset(pad, 0);
+    return this->adjustAndMap(dst, &op.paint);
+}
+
 }  // namespace SkRecords
@@ -11,8 +11,19 @@
 #include "SkRecord.h"
 #include "SkCanvas.h"
 
+class SkBBoxHierarchy;
+
 // Draw an SkRecord into an SkCanvas.  A convenience wrapper around SkRecords::Draw.
-void SkRecordDraw(const SkRecord&, SkCanvas*);
+// If bbh is not NULL, only the commands it finds in the canvas' clip are drawn.
+void SkRecordDraw(const SkRecord&, SkCanvas*, SkBBoxHierarchy* bbh = NULL);
+
+// Fill bbh with the bounds of each command of the SkRecord for SkRecordDraw().  Commands that
+// may draw anywhere, or that must be drawn regardless of where they draw, get cullBounds.
+void SkRecordFillBounds(const SkRecord&, const SkIRect& cullBounds, SkBBoxHierarchy* bbh);
+
+// Set bounds[i] to the bounds SkRecordFillBounds() gives the i-th command of the SkRecord, or to
+// an empty rect if it draws nothing.  bounds must have room for record.count() SkIRects.
+void SkRecordComputeBounds(const SkRecord&, const SkIRect& cullBounds, SkIRect bounds[]);
 
 namespace SkRecords {
 
@@ -23,6 +34,7 @@ public:
         : fInitialCTM(canvas->getTotalMatrix()), fCanvas(canvas), fIndex(0) {}
 
     unsigned index() const { return fIndex; }
+    void setIndex(unsigned index) { fIndex = index; }
     void next() { ++fIndex; }
 
     template <typename T> void operator()(const T& r) {
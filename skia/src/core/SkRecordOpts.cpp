@@ -9,12 +9,16 @@
 
 #include "SkRecordPattern.h"
 #include "SkRecords.h"
+#include "SkRegion.h"
+#include "SkShader.h"
 #include "SkTDArray.h"
+#include "SkXfermode.h"
 
 using namespace SkRecords;
 
 void SkRecordOptimize(SkRecord* record) {
     // TODO(mtklein): fuse independent optimizations to reduce number of passes?
+    SkRecordNoopOccludedDraws(record);  // Run first so the passes below see the new NoOps.
     SkRecordNoopCulls(record);
     SkRecordNoopSaveRestores(record);
     // TODO(mtklein): figure out why we draw differently and reenable
@@ -75,9 +79,10 @@ struct SaveOnlyDrawsRestoreNooper {
 };
 // Turns logical no-op Save-[non-drawing command]*-Restore patterns into actual no-ops.
 struct SaveNoDrawsRestoreNooper {
-    // Star matches greedily, so we also have to exclude Save and Restore.
+    // Star matches greedily, so we also have to exclude Save and Restore.  SaveLayer is excluded
+    // too: otherwise its Restore would be taken for the Save's, leaving the Save's unbalanced.
     typedef Pattern3<Is<Save>,
-                     Star<Not<Or3<Is<Save>,
+                     Star<Not<Or3<Or<Is<Save>, Is<SaveLayer> >,
                                   Is<Restore>,
                                   IsDraw> > >,
                      Is<Restore> >
@@ -301,3 +306,298 @@ void SkRecordAnnotateCullingPairs(SkRecord* record) {
     CullAnnotator pass;
     pass.apply(record);
 }
+
+// Turns draws that are entirely painted over by later opaque draws into NoOps.
+// This is not a pattern either: a first pass works out the device bounds of every draw and the
+// device area that each opaque draw is sure to paint over, then a second pass walks backwards,
+// accumulating the area painted over by the draws that follow each one.
+class OcclusionNooper {
+public:
+    OcclusionNooper() : fLayerDepth(0) {
+        fState.fCTM.reset();
+        fState.fClipBounds = Unbounded();
+        fState.fClipInterior = Unbounded();
+        fState.fFlags = SkCanvas::kMatrixClip_SaveFlag;
+        fState.fIsLayer = false;
+    }
+
+    int apply(SkRecord* record) {
+        fOps.setCount(record->count());
+        for (fIndex = 0; fIndex < record->count(); fIndex++) {
+            fOps[fIndex].fCanNoop = false;
+            fOps[fIndex].fCovers.setEmpty();
+            record->visit<void>(fIndex, *this);
+        }
+
+        SkRegion covered;
+        int nooped = 0;
+        for (unsigned i = record->count(); i-- > 0;) {
+            const Op& op = fOps[i];
+            if (op.fCanNoop && !op.fBounds.isEmpty() && covered.contains(op.fBounds)) {
+                record->replace<NoOp>(i);
+                nooped++;
+            } else if (!op.fCovers.isEmpty()) {
+                covered.op(op.fCovers, SkRegion::kUnion_Op);
+            }
+        }
+        return nooped;
+    }
+
+    // Draws we know nothing about may paint anywhere in the clip, and cover nothing.
+    template <typename T> void operator()(const T&) { this->drawsInClip(); }
+
+    void operator()(const NoOp&) {}
+    void operator()(const PushCull&) {}
+    void operator()(const PopCull&) {}
+    void operator()(const PairedPushCull&) {}
+
+    void operator()(const Save& r) { this->save(r.flags, false); }
+    void operator()(const SaveLayer& r) { this->save(r.flags, true); }
+    void operator()(const Restore&) {
+        if (fSaveStack.isEmpty()) {
+            return;  // SkCanvas ignores unbalanced restores.
+        }
+        const State& saved = fSaveStack.top();
+        if (fState.fFlags & SkCanvas::kMatrix_SaveFlag) {
+            fState.fCTM = saved.fCTM;
+        }
+        if (fState.fFlags & SkCanvas::kClip_SaveFlag) {
+            fState.fClipBounds = saved.fClipBounds;
+            fState.fClipInterior = saved.fClipInterior;
+        }
+        if (fState.fIsLayer) {
+            fLayerDepth--;
+        }
+        fState.fFlags = saved.fFlags;
+        fState.fIsLayer = saved.fIsLayer;
+        fSaveStack.pop();
+    }
+
+    void operator()(const Concat& r) { fState.fCTM.preConcat(r.matrix); }
+    void operator()(const SetMatrix& r) { fState.fCTM = r.matrix; }
+
+    void operator()(const ClipRect& r) { this->clip(r.rect, r.op, true); }
+    void operator()(const ClipRRect& r) { this->clip(r.rrect.rect(), r.op, r.rrect.isRect()); }
+    void operator()(const ClipPath& r) {
+        SkRect rect;
+        const bool isRect = !r.path.isInverseFillType() && r.path.isRect(&rect);
+        this->clip(r.path.getBounds(), r.op, isRect);
+    }
+    void operator()(const ClipRegion& r) {
+        // Regions are already in device space.
+        const SkIRect& bounds = r.region.getBounds();
+        this->clipDevice(bounds, r.region.isRect() ? bounds : SkIRect::MakeEmpty(), r.op);
+    }
+
+    void operator()(const Clear&) {
+        // Clear ignores the clip, and it replaces every pixel whatever the color.
+        if (0 == fLayerDepth) {
+            Op& op = fOps[fIndex];
+            op.fCanNoop = true;
+            op.fBounds = Unbounded();
+            op.fCovers = Unbounded();
+        }
+    }
+
+    void operator()(const DrawPaint& r) {
+        this->drawsInClip();
+        if (0 == fLayerDepth && PaintCovers(&r.paint, true)) {
+            fOps[fIndex].fCovers = fState.fClipInterior;
+        }
+    }
+
+    void operator()(const DrawRect& r) {
+        this->drawsIn(r.rect, &r.paint);
+        this->covers(r.rect, &r.paint, true);
+    }
+    void operator()(const DrawOval& r) { this->drawsIn(r.oval, &r.paint); }
+    void operator()(const DrawRRect& r) { this->drawsIn(r.rrect.rect(), &r.paint); }
+    void operator()(const DrawDRRect& r) { this->drawsIn(r.outer.rect(), &r.paint); }
+    void operator()(const DrawPath& r) {
+        if (r.path.isInverseFillType()) {
+            this->drawsInClip();
+        } else {
+            this->drawsIn(r.path.getBounds(), &r.paint);
+        }
+    }
+
+    void operator()(const DrawBitmap& r) {
+        const SkRect rect = SkRect::MakeXYWH(r.left, r.top, SkIntToScalar(r.bitmap.width()),
+                                             SkIntToScalar(r.bitmap.height()));
+        this->drawsIn(rect, r.paint);
+        this->covers(rect, r.paint, r.bitmap.isOpaque());
+    }
+    void operator()(const DrawBitmapRectToRect& r) {
+        this->drawsIn(r.dst, r.paint);
+        // When src sticks out of the bitmap, only part of dst is drawn.
+        const SkRect bitmapBounds = SkRect::MakeWH(SkIntToScalar(r.bitmap.width()),
+                                                   SkIntToScalar(r.bitmap.height()));
+        if (NULL == r.src || bitmapBounds.contains(*r.src)) {
+            this->covers(r.dst, r.paint, r.bitmap.isOpaque());
+        }
+    }
+    void operator()(const DrawBitmapNine& r) { this->drawsIn(r.dst, r.paint); }
+    void operator()(const DrawSprite& r) {
+        // Sprites ignore the matrix.
+        const SkMatrix ctm = fState.fCTM;
+        fState.fCTM.reset();
+        const SkRect rect = SkRect::MakeXYWH(SkIntToScalar(r.left), SkIntToScalar(r.top),
+                                             SkIntToScalar(r.bitmap.width()),
+                                             SkIntToScalar(r.bitmap.height()));
+        this->drawsIn(rect, r.paint);
+        this->covers(rect, r.paint, r.bitmap.isOpaque());
+        fState.fCTM = ctm;
+    }
+
+private:
+    // Bounds larger than any device, but small enough that SkRegion and SkIRect::width() are happy.
+    static SkIRect Unbounded() {
+        static const int32_t kMax = 1 << 29;
+        return SkIRect::MakeLTRB(-kMax, -kMax, kMax, kMax);
+    }
+
+    // Returns true if drawing the geometry with paint leaves nothing of what was under it.
+    static bool PaintCovers(const SkPaint* paint, bool contentIsOpaque) {
+        if (NULL == paint) {
+            return contentIsOpaque;
+        }
+        if (SkPaint::kFill_Style != paint->getStyle() ||
+            paint->getPathEffect()  ||
+            paint->getMaskFilter()  ||
+            paint->getColorFilter() ||
+            paint->getRasterizer()  ||
+            paint->getLooper()      ||
+            paint->getImageFilter()) {
+            return false;
+        }
+        SkXfermode::Mode mode;
+        if (!SkXfermode::AsMode(paint->getXfermode(), &mode)) {
+            return false;
+        }
+        if (SkXfermode::kSrc_Mode == mode) {
+            return true;
+        }
+        return SkXfermode::kSrcOver_Mode == mode &&
+               contentIsOpaque &&
+               0xFF == paint->getAlpha() &&
+               (NULL == paint->getShader() || paint->getShader()->isOpaque());
+    }
+
+    void save(SkCanvas::SaveFlags flags, bool isLayer) {
+        fSaveStack.push(fState);
+        fState.fFlags = flags;
+        fState.fIsLayer = isLayer;
+        if (isLayer) {
+            fLayerDepth++;
+        }
+    }
+
+    void clip(const SkRect& rect, SkRegion::Op op, bool isRect) {
+        SkRect mapped;
+        fState.fCTM.mapRect(&mapped, rect);
+        SkIRect bounds, interior;
+        mapped.roundOut(&bounds);
+        if (isRect && fState.fCTM.rectStaysRect()) {
+            // An anti-aliased clip only partly covers its edge pixels.
+            mapped.roundIn(&interior);
+        } else {
+            interior.setEmpty();
+        }
+        this->clipDevice(bounds, interior, op);
+    }
+
+    void clipDevice(const SkIRect& bounds, const SkIRect& interior, SkRegion::Op op) {
+        switch (op) {
+            case SkRegion::kIntersect_Op:
+                Intersect(&fState.fClipBounds, bounds);
+                Intersect(&fState.fClipInterior, interior);
+                break;
+            case SkRegion::kReplace_Op:
+                fState.fClipBounds = bounds;
+                fState.fClipInterior = interior;
+                break;
+            case SkRegion::kDifference_Op:
+                fState.fClipInterior.setEmpty();
+                break;
+            default:
+                // Union, XOR and reverse difference may grow the clip.
+                fState.fClipBounds = Unbounded();
+                fState.fClipInterior.setEmpty();
+                break;
+        }
+    }
+
+    static void Intersect(SkIRect* dst, const SkIRect& src) {
+        if (!dst->intersect(src)) {
+            dst->setEmpty();
+        }
+    }
+
+    // Draws inside layers are composited later with the layer's paint, so they are never
+    // NoOp'd, and they cover nothing of the device.
+    void drawsInClip() {
+        if (0 == fLayerDepth) {
+            fOps[fIndex].fCanNoop = true;
+            fOps[fIndex].fBounds = fState.fClipBounds;
+        }
+    }
+
+    void drawsIn(const SkRect& rect, const SkPaint* paint) {
+        if (0 != fLayerDepth) {
+            return;
+        }
+        if (NULL != paint && !paint->canComputeFastBounds()) {
+            this->drawsInClip();
+            return;
+        }
+        SkRect storage;
+        const SkRect& adjusted = NULL != paint ? paint->computeFastBounds(rect, &storage) : rect;
+        SkRect mapped;
+        fState.fCTM.mapRect(&mapped, adjusted);
+        Op& op = fOps[fIndex];
+        mapped.roundOut(&op.fBounds);
+        op.fBounds.outset(1, 1);  // Slop for anti-aliasing.
+        Intersect(&op.fBounds, fState.fClipBounds);
+        op.fCanNoop = true;
+    }
+
+    void covers(const SkRect& rect, const SkPaint* paint, bool contentIsOpaque) {
+        if (0 != fLayerDepth || !fState.fCTM.rectStaysRect() ||
+            !PaintCovers(paint, contentIsOpaque)) {
+            return;
+        }
+        SkRect mapped;
+        fState.fCTM.mapRect(&mapped, rect);
+        SkIRect& covers = fOps[fIndex].fCovers;
+        mapped.roundIn(&covers);
+        // Keep a pixel of slop, so draws are only NoOp'd when they end at least two pixels
+        // inside the opaque draw. That's enough for anti-aliased edges to match under any
+        // playback matrix that doesn't scale down.
+        covers.inset(1, 1);
+        Intersect(&covers, fState.fClipInterior);
+    }
+
+    struct State {
+        SkMatrix            fCTM;
+        SkIRect             fClipBounds;    // no pixel outside of this is drawn
+        SkIRect             fClipInterior;  // every pixel inside of this is drawn
+        SkCanvas::SaveFlags fFlags;         // what the Restore of this save restores
+        bool                fIsLayer;
+    };
+
+    struct Op {
+        SkIRect fBounds;    // device bounds of the draw, if fCanNoop
+        SkIRect fCovers;    // device area the draw leaves nothing under
+        bool    fCanNoop;
+    };
+
+    State fState;
+    SkTDArray<State> fSaveStack;
+    int fLayerDepth;
+    SkTDArray<Op> fOps;
+    unsigned fIndex;
+};
+int SkRecordNoopOccludedDraws(SkRecord* record) {
+    OcclusionNooper pass;
+    return pass.apply(record);
+}
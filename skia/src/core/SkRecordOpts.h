@@ -13,6 +13,10 @@
 // Run all optimizations in recommended order.
 void SkRecordOptimize(SkRecord*);
 
+// NoOp away draws that later opaque draws paint over entirely.  Draws inside layers are left
+// alone.  Returns the number of draws NoOp'd.
+int SkRecordNoopOccludedDraws(SkRecord*);
+
 // NoOp away pointless PushCull/PopCull pairs with nothing between them.
 void SkRecordNoopCulls(SkRecord*);
 
@@ -7,24 +7,93 @@
 
 #include "../../include/record/SkRecording.h"
 
+#include "SkBBHFactory.h"
+#include "SkBBoxHierarchy.h"
+#include "SkMappedRecord.h"
 #include "SkRecord.h"
+#include "SkRecordDiff.h"
 #include "SkRecordOpts.h"
 #include "SkRecordDraw.h"
 #include "SkRecorder.h"
+#include "SkStream.h"
+#include "SkThreadPriv.h"
 
 namespace EXPERIMENTAL {
 
-SkPlayback::SkPlayback(const SkRecord* record) : fRecord(record) {}
+SkPlayback::SkPlayback(const SkRecord* record, SkBBoxHierarchy* bbh, int width, int height)
+    : fRecord(record)
+    , fBBH(bbh)
+    , fWidth(width)
+    , fHeight(height)
+    , fSummary(NULL) {}
 
-SkPlayback::~SkPlayback() {}
+SkPlayback::SkPlayback(const SkMappedRecord* mapped)
+    : fMapped(mapped)
+    , fWidth(0)
+    , fHeight(0)
+    , fSummary(NULL) {}
+
+SkPlayback::~SkPlayback() {
+    SkDELETE(fSummary);
+}
 
 void SkPlayback::draw(SkCanvas* canvas) const {
+    if (fMapped.get() != NULL) {
+        fMapped->draw(canvas);
+        return;
+    }
+    SkASSERT(fRecord.get() != NULL);
+    SkRecordDraw(*fRecord, canvas, fBBH.get());
+}
+
+void SkPlayback::serialize(SkWStream* stream) const {
+    if (fMapped.get() != NULL) {
+        stream->write(fMapped->data()->data(), fMapped->data()->size());
+        return;
+    }
     SkASSERT(fRecord.get() != NULL);
-    SkRecordDraw(*fRecord, canvas);
+    SkRecordSerialize(*fRecord, stream);
+}
+
+const SkRecordSummary* SkPlayback::summary() const {
+    if (fRecord.get() == NULL) {
+        return NULL;
+    }
+    SkRecordSummary* summary = sk_acquire_load(&fSummary);
+    if (NULL != summary) {
+        return summary;
+    }
+    // Threads that race to make it each make one, and all but the first throw theirs away.
+    summary = SkNEW_ARGS(SkRecordSummary, (*fRecord, SkIRect::MakeWH(fWidth, fHeight)));
+    SkRecordSummary* prev = (SkRecordSummary*)sk_atomic_cas((void**)&fSummary, NULL, summary);
+    if (NULL != prev) {
+        SkDELETE(summary);
+        return prev;
+    }
+    return summary;
+}
+
+bool SkPlayback::computeDamage(const SkPlayback& previous, SkRegion* damage) const {
+    SkASSERT(NULL != damage);
+    const SkRecordSummary* before = previous.summary();
+    const SkRecordSummary* after = this->summary();
+    if (NULL == before || NULL == after) {
+        return false;
+    }
+    SkRecordDiff(*before, *after, damage);
+    return true;
 }
 
-SkRecording::SkRecording(int width, int height)
-    : fRecord(SkNEW(SkRecord))
+SkPlayback* SkPlayback::CreateFromData(SkData* data) {
+    SkMappedRecord* mapped = SkMappedRecord::Create(data);
+    return mapped ? SkNEW_ARGS(SkPlayback, (mapped)) : NULL;
+}
+
+SkRecording::SkRecording(int width, int height, SkBBHFactory* bbhFactory)
+    : fWidth(width)
+    , fHeight(height)
+    , fBBHFactory(bbhFactory)
+    , fRecord(SkNEW(SkRecord))
     , fRecorder(SkNEW_ARGS(SkRecorder, (fRecord.get(), width, height)))
     {}
 
@@ -32,7 +101,14 @@ SkPlayback* SkRecording::releasePlayback() {
     SkASSERT(fRecorder->unique());
     fRecorder->forgetRecord();
     SkRecordOptimize(fRecord.get());
-    return SkNEW_ARGS(SkPlayback, (fRecord.detach()));
+
+    SkBBoxHierarchy* bbh = NULL;
+    if (NULL != fBBHFactory) {
+        bbh = (*fBBHFactory)(fWidth, fHeight);
+        SkASSERT(NULL != bbh);
+        SkRecordFillBounds(*fRecord, SkIRect::MakeWH(fWidth, fHeight), bbh);
+    }
+    return SkNEW_ARGS(SkPlayback, (fRecord.detach(), bbh, fWidth, fHeight));
 }
 
 SkRecording::~SkRecording() {}
@@ -176,6 +176,10 @@ public:
 
     operator const SkBitmap& () const { return fBitmap; }
 
+    int width() const { return fBitmap.width(); }
+    int height() const { return fBitmap.height(); }
+    bool isOpaque() const { return fBitmap.isOpaque(); }
+
 private:
     SkBitmap fBitmap;
 };
@@ -8,6 +8,8 @@
 
 
 #include "SkRegionPriv.h"
+#include "SkTDArray.h"
+#include "SkTSort.h"
 #include "SkTemplates.h"
 #include "SkThread.h"
 #include "SkUtils.h"
@@ -281,14 +283,21 @@ bool SkRegion::setRuns(RunType runs[], int count) {
 
     //  if we get here, we need to become a complex region
 
-    if (!this->isComplex() || fRunHead->fRunCount != count) {
+    // If no one else shares our runs and they are big enough, write into them
+    // in place, so that accumulating ops into one region does not allocate a
+    // new RunHead for every op.
+    if (this->isComplex() && 1 == fRunHead->fRefCnt && fRunHead->fCapacity >= count) {
+        fRunHead->fRunCount = count;
+    } else {
+        int capacity = count;
+        if (this->isComplex() && 1 == fRunHead->fRefCnt) {
+            // we are growing, so leave some room for the next op
+            capacity += count >> 1;
+        }
         this->freeRuns();
-        this->allocateRuns(count);
+        fRunHead = RunHead::AllocWithCapacity(count, capacity);
     }
 
-    // must call this before we can write directly into runs()
-    // in case we are sharing the buffer with another region (copy on write)
-    fRunHead = fRunHead->ensureWritable();
     memcpy(fRunHead->writable_runs(), runs, count * sizeof(RunType));
     fRunHead->computeRunBounds(&fBounds);
 
@@ -585,16 +594,106 @@ void SkRegion::translate(int dx, int dy, SkRegion* dst) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static bool rect_top_lt(const SkIRect* a, const SkIRect* b) {
+    return a->fTop < b->fTop;
+}
+
+/*
+ *  Builds the region in one sweep down the rects, rather than one union per
+ *  rect. Each band between consecutive top/bottom edges is the union of the
+ *  rects active in it; the active rects are kept sorted by left, so each
+ *  band's intervals are found by merging them in a single pass.
+ */
 bool SkRegion::setRects(const SkIRect rects[], int count) {
-    if (0 == count) {
-        this->setEmpty();
-    } else {
-        this->setRect(rects[0]);
-        for (int i = 1; i < count; i++) {
-            this->op(rects[i], kUnion_Op);
+    SkTDArray<const SkIRect*> sorted;
+    SkTDArray<int32_t> bottoms;
+    sorted.setReserve(count);
+    bottoms.setReserve(count);
+    for (int i = 0; i < count; i++) {
+        if (!rects[i].isEmpty()) {
+            *sorted.append() = &rects[i];
+            *bottoms.append() = rects[i].fBottom;
+        }
+    }
+    if (sorted.count() <= 1) {
+        return sorted.isEmpty() ? this->setEmpty() : this->setRect(*sorted[0]);
+    }
+    SkTQSort(sorted.begin(), sorted.end() - 1, rect_top_lt);
+    SkTQSort(bottoms.begin(), bottoms.end() - 1);
+
+    SkTDArray<const SkIRect*> active;   // sorted by left
+    SkTDArray<RunType> runs;
+    int next = 0;
+    int nextBottom = 0;
+    int prevScanline = -1;  // index of the previous scanline's bottom in runs
+    int y = sorted[0]->fTop;
+
+    *runs.append() = y; // top
+    while (next < sorted.count() || !active.isEmpty()) {
+        for (; next < sorted.count() && sorted[next]->fTop == y; next++) {
+            const SkIRect* rect = sorted[next];
+            int index = active.count();
+            while (index > 0 && active[index - 1]->fLeft > rect->fLeft) {
+                index -= 1;
+            }
+            *active.insert(index) = rect;
+        }
+
+        while (bottoms[nextBottom] <= y) {
+            nextBottom += 1;
+        }
+        int bottom = bottoms[nextBottom];
+        if (next < sorted.count() && sorted[next]->fTop < bottom) {
+            bottom = sorted[next]->fTop;
         }
+
+        // [B N [L R]... S] for this band
+        int scanline = runs.count();
+        *runs.append() = bottom;
+        *runs.append() = 0;
+        for (int i = 0; i < active.count(); ++i) {
+            int left = active[i]->fLeft;
+            int right = active[i]->fRight;
+            while (i + 1 < active.count() && active[i + 1]->fLeft <= right) {
+                right = SkMax32(right, active[++i]->fRight);
+            }
+            *runs.append() = left;
+            *runs.append() = right;
+        }
+        *runs.append() = kRunTypeSentinel;
+        runs[scanline + 1] = (runs.count() - scanline - 3) >> 1;
+
+        // if this band matches the one above, just extend that one down
+        if (prevScanline >= 0 && runs[prevScanline + 1] == runs[scanline + 1] &&
+                !memcmp(&runs[prevScanline + 2], &runs[scanline + 2],
+                        runs[scanline + 1] * 2 * sizeof(RunType))) {
+            runs[prevScanline] = bottom;
+            runs.setCount(scanline);
+        } else {
+            prevScanline = scanline;
+        }
+
+        y = bottom;
+        int kept = 0;
+        for (int i = 0; i < active.count(); ++i) {
+            if (active[i]->fBottom > y) {
+                active[kept++] = active[i];
+            }
+        }
+        active.setCount(kept);
+    }
+    *runs.append() = kRunTypeSentinel;
+
+    return this->setRuns(runs.begin(), runs.count());
+}
+
+bool SkRegion::op(const SkIRect rects[], int count, Op op) {
+    if (kUnion_Op == op && this->isEmpty()) {
+        return this->setRects(rects, count);
     }
-    return !this->isEmpty();
+    SkRegion tmp;
+    tmp.setRects(rects, count);
+    return this->op(*this, tmp, op);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -39,6 +39,7 @@ private:
 public:
     int32_t fRefCnt;
     int32_t fRunCount;
+    int32_t fCapacity;  // number of RunTypes allocated, >= fRunCount
 
     /**
      *  Number of spans with different Y values. This does not count the initial
@@ -60,14 +61,25 @@ public:
     }
 
     static RunHead* Alloc(int count) {
+        return AllocWithCapacity(count, count);
+    }
+
+    /**
+     *  Allocate room for capacity runs, of which only the first count are in
+     *  use. The rest is kept so that later ops into the same region can reuse
+     *  this allocation (see SkRegion::setRuns).
+     */
+    static RunHead* AllocWithCapacity(int count, int capacity) {
         //SkDEBUGCODE(sk_atomic_inc(&gRgnAllocCounter);)
         //SkDEBUGF(("************** gRgnAllocCounter::alloc %d\n", gRgnAllocCounter));
 
         SkASSERT(count >= SkRegion::kRectRegionRuns);
+        SkASSERT(capacity >= count);
 
-        RunHead* head = (RunHead*)sk_malloc_throw(sizeof(RunHead) + count * sizeof(RunType));
+        RunHead* head = (RunHead*)sk_malloc_throw(sizeof(RunHead) + capacity * sizeof(RunType));
         head->fRefCnt = 1;
         head->fRunCount = count;
+        head->fCapacity = capacity;
         // these must be filled in later, otherwise we will be invalid
         head->fYSpanCount = 0;
         head->fIntervalCount = 0;
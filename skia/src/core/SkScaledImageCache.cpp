@@ -6,7 +6,6 @@
  */
 
 #include "SkScaledImageCache.h"
-#include "SkMipMap.h"
 #include "SkPixelRef.h"
 #include "SkRect.h"
 
@@ -102,24 +101,13 @@ struct SkScaledImageCache::Key {
 struct SkScaledImageCache::Rec {
     Rec(const Key& key, const SkBitmap& bm) : fKey(key), fBitmap(bm) {
         fLockCount = 1;
-        fMip = NULL;
-    }
-
-    Rec(const Key& key, const SkMipMap* mip) : fKey(key) {
-        fLockCount = 1;
-        fMip = mip;
-        mip->ref();
-    }
-
-    ~Rec() {
-        SkSafeUnref(fMip);
     }
 
     static const Key& GetKey(const Rec& rec) { return rec.fKey; }
     static uint32_t Hash(const Key& key) { return key.fHash; }
 
     size_t bytesUsed() const {
-        return fMip ? fMip->getSize() : fBitmap.getSize();
+        return fBitmap.getSize();
     }
 
     Rec*    fNext;
@@ -130,9 +118,7 @@ struct SkScaledImageCache::Rec {
 
     int32_t fLockCount;
 
-    // we use either fBitmap or fMip, but not both
     SkBitmap fBitmap;
-    const SkMipMap* fMip;
 };
 
 #include "SkTDynamicHash.h"
@@ -364,7 +350,6 @@ SkScaledImageCache::ID* SkScaledImageCache::findAndLock(uint32_t genID,
     Rec* rec = this->findAndLock(genID, SK_Scalar1, SK_Scalar1,
                                  SkIRect::MakeWH(width, height));
     if (rec) {
-        SkASSERT(NULL == rec->fMip);
         SkASSERT(rec->fBitmap.pixelRef());
         *bitmap = rec->fBitmap;
     }
@@ -382,21 +367,23 @@ SkScaledImageCache::ID* SkScaledImageCache::findAndLock(const SkBitmap& orig,
     Rec* rec = this->findAndLock(orig.getGenerationID(), scaleX,
                                  scaleY, get_bounds_from_bitmap(orig));
     if (rec) {
-        SkASSERT(NULL == rec->fMip);
         SkASSERT(rec->fBitmap.pixelRef());
         *scaled = rec->fBitmap;
     }
     return rec_to_id(rec);
 }
 
+// Mipmap levels are keyed with a zero scaleX (which is never a valid scale),
+// and the level index as scaleY.
 SkScaledImageCache::ID* SkScaledImageCache::findAndLockMip(const SkBitmap& orig,
-                                                           SkMipMap const ** mip) {
-    Rec* rec = this->findAndLock(orig.getGenerationID(), 0, 0,
+                                                           int level,
+                                                           SkBitmap* levelBitmap) {
+    SkASSERT(level > 0);
+    Rec* rec = this->findAndLock(orig.getGenerationID(), 0, SkIntToScalar(level),
                                  get_bounds_from_bitmap(orig));
     if (rec) {
-        SkASSERT(rec->fMip);
-        SkASSERT(NULL == rec->fBitmap.pixelRef());
-        *mip = rec->fMip;
+        SkASSERT(rec->fBitmap.pixelRef());
+        *levelBitmap = rec->fBitmap;
     }
     return rec_to_id(rec);
 }
@@ -456,13 +443,15 @@ SkScaledImageCache::ID* SkScaledImageCache::addAndLock(const SkBitmap& orig,
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::addAndLockMip(const SkBitmap& orig,
-                                                          const SkMipMap* mip) {
+                                                          int level,
+                                                          const SkBitmap& levelBitmap) {
+    SkASSERT(level > 0);
     SkIRect bounds = get_bounds_from_bitmap(orig);
     if (bounds.isEmpty()) {
         return NULL;
     }
-    Key key(orig.getGenerationID(), 0, 0, bounds);
-    Rec* rec = SkNEW_ARGS(Rec, (key, mip));
+    Key key(orig.getGenerationID(), 0, SkIntToScalar(level), bounds);
+    Rec* rec = SkNEW_ARGS(Rec, (key, levelBitmap));
     return this->addAndLock(rec);
 }
 
@@ -736,9 +725,10 @@ SkScaledImageCache::ID* SkScaledImageCache::FindAndLock(const SkBitmap& orig,
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::FindAndLockMip(const SkBitmap& orig,
-                                                       SkMipMap const ** mip) {
+                                                           int level,
+                                                           SkBitmap* levelBitmap) {
     SkAutoMutexAcquire am(gMutex);
-    return get_cache()->findAndLockMip(orig, mip);
+    return get_cache()->findAndLockMip(orig, level, levelBitmap);
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(const SkBitmap& orig,
@@ -750,9 +740,10 @@ SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(const SkBitmap& orig,
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::AddAndLockMip(const SkBitmap& orig,
-                                                          const SkMipMap* mip) {
+                                                          int level,
+                                                          const SkBitmap& levelBitmap) {
     SkAutoMutexAcquire am(gMutex);
-    return get_cache()->addAndLockMip(orig, mip);
+    return get_cache()->addAndLockMip(orig, level, levelBitmap);
 }
 
 void SkScaledImageCache::Unlock(SkScaledImageCache::ID* id) {
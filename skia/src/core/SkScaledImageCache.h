@@ -11,7 +11,6 @@
 #include "SkBitmap.h"
 
 class SkDiscardableMemory;
-class SkMipMap;
 
 /**
  *  Cache object for bitmaps (with possible scale in X Y as part of the key).
@@ -45,8 +44,8 @@ public:
 
     static ID* FindAndLock(const SkBitmap& original, SkScalar scaleX,
                            SkScalar scaleY, SkBitmap* returnedBitmap);
-    static ID* FindAndLockMip(const SkBitmap& original,
-                              SkMipMap const** returnedMipMap);
+    static ID* FindAndLockMip(const SkBitmap& original, int level,
+                              SkBitmap* returnedLevel);
 
 
     static ID* AddAndLock(uint32_t pixelGenerationID,
@@ -56,7 +55,8 @@ public:
 
     static ID* AddAndLock(const SkBitmap& original, SkScalar scaleX,
                           SkScalar scaleY, const SkBitmap& bitmap);
-    static ID* AddAndLockMip(const SkBitmap& original, const SkMipMap* mipMap);
+    static ID* AddAndLockMip(const SkBitmap& original, int level,
+                             const SkBitmap& levelBitmap);
 
     static void Unlock(ID*);
 
@@ -122,22 +122,29 @@ public:
      */
     ID* findAndLock(const SkBitmap& original, SkScalar scaleX,
                     SkScalar scaleY, SkBitmap* returnedBitmap);
-    ID* findAndLockMip(const SkBitmap& original,
-                       SkMipMap const** returnedMipMap);
 
     /**
-     *  To add a new bitmap (or mipMap) to the cache, call
+     *  Search the cache for a single mipmap level (1 == half-size) of
+     *  original. Each level is a separate entry, so levels are built and
+     *  purged independently (see SkMipMap).
+     */
+    ID* findAndLockMip(const SkBitmap& original, int level,
+                       SkBitmap* returnedLevel);
+
+    /**
+     *  To add a new bitmap (or mipmap level) to the cache, call
      *  AddAndLock. Use the returned ptr to unlock the cache when you
      *  are done using scaled.
      *
      *  Use (generationID, width, and height) or (original, scaleX,
-     *  scaleY) or (original) as a search key
+     *  scaleY) or (original, level) as a search key
      */
     ID* addAndLock(uint32_t pixelGenerationID, int32_t width, int32_t height,
                    const SkBitmap& bitmap);
     ID* addAndLock(const SkBitmap& original, SkScalar scaleX,
                    SkScalar scaleY, const SkBitmap& bitmap);
-    ID* addAndLockMip(const SkBitmap& original, const SkMipMap* mipMap);
+    ID* addAndLockMip(const SkBitmap& original, int level,
+                      const SkBitmap& levelBitmap);
 
     /**
      *  Given a non-null ID ptr returned by either findAndLock or addAndLock,
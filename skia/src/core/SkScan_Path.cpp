@@ -407,11 +407,40 @@ static bool operator<(const SkEdge& a, const SkEdge& b) {
 }
 #endif
 
+#ifndef SK_USE_STD_SORT_FOR_EDGES
+/*
+ *  Edges are built in path order, so for many paths (e.g. polygons walked
+ *  top to bottom, or lots of horizontal strips) the list is already nearly
+ *  sorted. Insertion sort is linear in that case, so try it first, but give up
+ *  (leaving a valid permutation behind) once it has done more than a linear
+ *  amount of work, and let the caller fall back to SkTQSort.
+ */
+static bool insertion_sort_nearly_sorted_edges(SkEdge* list[], int count) {
+    int budget = count << 1;
+    for (int i = 1; i < count; ++i) {
+        SkEdge* edge = list[i];
+        int j = i;
+        while (j > 0 && *edge < *list[j - 1]) {
+            list[j] = list[j - 1];
+            --j;
+            if (--budget < 0) {
+                list[j] = edge;
+                return false;
+            }
+        }
+        list[j] = edge;
+    }
+    return true;
+}
+#endif
+
 static SkEdge* sort_edges(SkEdge* list[], int count, SkEdge** last) {
 #ifdef SK_USE_STD_SORT_FOR_EDGES
     qsort(list, count, sizeof(SkEdge*), edge_compare);
 #else
-    SkTQSort(list, list + count - 1);
+    if (!insertion_sort_nearly_sorted_edges(list, count)) {
+        SkTQSort(list, list + count - 1);
+    }
 #endif
 
     // now make the edges linked in sorted order
@@ -434,10 +463,10 @@ void sk_fill_path(const SkPath& path, const SkIRect* clipRect, SkBlitter* blitte
                   const SkRegion& clipRgn) {
     SkASSERT(&path && blitter);
 
-    SkEdgeBuilder   builder;
+    SkAutoEdgeBuilder builder;
 
-    int count = builder.build(path, clipRect, shiftEdgesUp);
-    SkEdge**    list = builder.edgeList();
+    int count = builder->build(path, clipRect, shiftEdgesUp);
+    SkEdge**    list = builder->edgeList();
 
     if (count < 2) {
         if (path.isInverseFillType()) {
@@ -7,9 +7,59 @@
  */
 
 #include "SkTileGrid.h"
+#include "SkTSort.h"
+#include "SkTemplates.h"
+#include "SkThreadPool.h"
 
-SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::TileGridInfo& info,
-                       SkTileGridNextDatumFunctionPtr nextDatumFunction) {
+// A position in the entries of a tile, for merging several tiles in search().
+struct SkTileGrid::Cursor {
+    const Entry*   fEntry;
+    const Entry*   fStop;
+    // The bounds of fEntry if the tile keeps them, or NULL.
+    const SkIRect* fBounds;
+
+    // Skips the entries whose bounds miss query. Returns false once there is no entry left.
+    bool skipMisses(const SkIRect& query) {
+        if (fBounds) {
+            while (fEntry < fStop && !SkIRect::Intersects(*fBounds, query)) {
+                ++fEntry;
+                ++fBounds;
+            }
+        }
+        return fEntry < fStop;
+    }
+
+    bool next(const SkIRect& query) {
+        ++fEntry;
+        if (fBounds) {
+            ++fBounds;
+        }
+        return this->skipMisses(query);
+    }
+
+    // Orders the heap of cursors in search() so that the one with the earliest entry is on top.
+    struct Later {
+        bool operator()(const Cursor& a, const Cursor& b) const {
+            return a.fEntry->fOrder > b.fEntry->fOrder;
+        }
+    };
+};
+
+// Fills some rows of the tiles of one level, on a thread of an SkThreadPool.
+struct SkTileGrid::FillTask : public SkRunnable {
+    SkTileGrid* fGrid;
+    int         fLevel;
+    int         fStartY;
+    int         fStopY;
+
+    virtual void run() SK_OVERRIDE {
+        fGrid->fillRows(fLevel, fStartY, fStopY);
+    }
+};
+
+SkTileGrid::SkTileGrid(int xTileCount, int yTileCount,
+                       const SkTileGridFactory::TileGridInfo& info,
+                       SkTileGridFactory::Layout layout) {
     fXTileCount = xTileCount;
     fYTileCount = yTileCount;
     fInfo = info;
@@ -21,23 +71,65 @@ SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::
     fInsertionCount = 0;
     fGridBounds = SkIRect::MakeXYWH(0, 0, fInfo.fTileInterval.width() * fXTileCount,
         fInfo.fTileInterval.height() * fYTileCount);
-    fNextDatumFunction = nextDatumFunction;
-    fTileData = SkNEW_ARRAY(SkTDArray<void *>, fTileCount);
+
+    Level* level = fLevels.append();
+    level->fXTileCount = fXTileCount;
+    level->fYTileCount = fYTileCount;
+    level->fTileInterval = fInfo.fTileInterval;
+    level->fTiles = SkNEW_ARRAY(SkTDArray<Entry>, fTileCount);
+    level->fBounds = NULL;
+    if (SkTileGridFactory::kAdaptive_Layout == layout) {
+        // Stack coarser and coarser levels until a single tile covers the whole grid.
+        while (level->fXTileCount > 1 || level->fYTileCount > 1) {
+            Level coarser;
+            coarser.fXTileCount = (level->fXTileCount + kLevelScale - 1) / kLevelScale;
+            coarser.fYTileCount = (level->fYTileCount + kLevelScale - 1) / kLevelScale;
+            coarser.fTileInterval.set(level->fTileInterval.width() * kLevelScale,
+                                      level->fTileInterval.height() * kLevelScale);
+            const int tileCount = coarser.fXTileCount * coarser.fYTileCount;
+            coarser.fTiles = SkNEW_ARRAY(SkTDArray<Entry>, tileCount);
+            coarser.fBounds = SkNEW_ARRAY(SkTDArray<SkIRect>, tileCount);
+            level = fLevels.append();
+            *level = coarser;
+        }
+    }
 }
 
 SkTileGrid::~SkTileGrid() {
-    SkDELETE_ARRAY(fTileData);
+    for (int i = 0; i < fLevels.count(); ++i) {
+        SkDELETE_ARRAY(fLevels[i].fTiles);
+        SkDELETE_ARRAY(fLevels[i].fBounds);
+    }
 }
 
 int SkTileGrid::tileCount(int x, int y) {
+    this->flushDeferredInserts();
     return this->tile(x, y).count();
 }
 
-SkTDArray<void *>& SkTileGrid::tile(int x, int y) {
-    return fTileData[y * fXTileCount + x];
+SkTDArray<SkTileGrid::Entry>& SkTileGrid::tile(int x, int y) {
+    return fLevels[0].fTiles[y * fXTileCount + x];
+}
+
+int SkTileGrid::place(const SkIRect& bounds, SkIRect* tiles) const {
+    for (int i = 0;; ++i) {
+        const Level& level = fLevels[i];
+        const int width = level.fTileInterval.width();
+        const int height = level.fTileInterval.height();
+        // Note: SkIRects are non-inclusive of the right() column and bottom() row,
+        // hence the "-1"s in the computations of the last tiles.
+        tiles->fLeft = SkPin32(bounds.left() / width, 0, level.fXTileCount - 1);
+        tiles->fRight = SkPin32((bounds.right() - 1) / width, 0, level.fXTileCount - 1);
+        tiles->fTop = SkPin32(bounds.top() / height, 0, level.fYTileCount - 1);
+        tiles->fBottom = SkPin32((bounds.bottom() - 1) / height, 0, level.fYTileCount - 1);
+        if (i == fLevels.count() - 1 ||
+            (tiles->width() + 1) * (tiles->height() + 1) <= kMaxTilesPerDatum) {
+            return i;
+        }
+    }
 }
 
-void SkTileGrid::insert(void* data, const SkIRect& bounds, bool) {
+void SkTileGrid::insert(void* data, const SkIRect& bounds, bool defer) {
     SkASSERT(!bounds.isEmpty());
     SkIRect dilatedBounds = bounds;
     dilatedBounds.outset(fInfo.fMargin.width(), fInfo.fMargin.height());
@@ -46,26 +138,83 @@ void SkTileGrid::insert(void* data, const SkIRect& bounds, bool) {
         return;
     }
 
-    // Note: SkIRects are non-inclusive of the right() column and bottom() row,
-    // hence the "-1"s in the computations of maxTileX and maxTileY.
-    int minTileX = SkMax32(SkMin32(dilatedBounds.left() / fInfo.fTileInterval.width(),
-        fXTileCount - 1), 0);
-    int maxTileX = SkMax32(SkMin32((dilatedBounds.right() - 1) / fInfo.fTileInterval.width(),
-        fXTileCount - 1), 0);
-    int minTileY = SkMax32(SkMin32(dilatedBounds.top() / fInfo.fTileInterval.height(),
-        fYTileCount -1), 0);
-    int maxTileY = SkMax32(SkMin32((dilatedBounds.bottom() -1) / fInfo.fTileInterval.height(),
-        fYTileCount -1), 0);
+    // The tiles must be filled in insertion order, so an insertion that can't wait goes in after
+    // the deferred ones.
+    DeferredEntry* deferred = fDeferred.append();
+    deferred->fEntry.fData = data;
+    deferred->fEntry.fOrder = fInsertionCount++;
+    deferred->fBounds = dilatedBounds;
+    deferred->fLevel = this->place(dilatedBounds, &deferred->fTiles);
+    if (!defer) {
+        this->flushDeferredInserts();
+    }
+}
+
+void SkTileGrid::flushDeferredInserts() {
+    if (fDeferred.isEmpty()) {
+        return;
+    }
+
+    int threadCount = 1;
+    if (fDeferred.count() >= kParallelFlushThreshold) {
+        threadCount = SkMin32(num_cores(), fYTileCount);
+    }
+    if (threadCount > 1) {
+        // Each task fills rows of tiles no other task touches, so the tasks don't need a lock.
+        // Level 0 is split in bands of rows, one per thread; the coarser levels hold few data and
+        // get a task each.
+        const int taskCount = threadCount + fLevels.count() - 1;
+        SkAutoTArray<FillTask> tasks(taskCount);
+        for (int i = 0; i < taskCount; ++i) {
+            FillTask& task = tasks[i];
+            task.fGrid = this;
+            if (i < threadCount) {
+                task.fLevel = 0;
+                task.fStartY = fYTileCount * i / threadCount;
+                task.fStopY = fYTileCount * (i + 1) / threadCount;
+            } else {
+                task.fLevel = i - threadCount + 1;
+                task.fStartY = 0;
+                task.fStopY = fLevels[task.fLevel].fYTileCount;
+            }
+        }
+        SkThreadPool pool(threadCount);
+        for (int i = 0; i < taskCount; ++i) {
+            pool.add(&tasks[i]);
+        }
+        pool.wait();
+    } else {
+        for (int i = 0; i < fLevels.count(); ++i) {
+            this->fillRows(i, 0, fLevels[i].fYTileCount);
+        }
+    }
+    fDeferred.rewind();
+}
 
-    for (int x = minTileX; x <= maxTileX; x++) {
-        for (int y = minTileY; y <= maxTileY; y++) {
-            this->tile(x, y).push(data);
+void SkTileGrid::fillRows(int levelIndex, int startY, int stopY) {
+    const Level& level = fLevels[levelIndex];
+    for (int i = 0; i < fDeferred.count(); ++i) {
+        const DeferredEntry& deferred = fDeferred[i];
+        if (deferred.fLevel != levelIndex) {
+            continue;
+        }
+        const int top = SkMax32(deferred.fTiles.fTop, startY);
+        const int bottom = SkMin32(deferred.fTiles.fBottom, stopY - 1);
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = deferred.fTiles.fLeft; x <= deferred.fTiles.fRight; ++x) {
+                const int index = y * level.fXTileCount + x;
+                level.fTiles[index].push(deferred.fEntry);
+                if (level.fBounds) {
+                    level.fBounds[index].push(deferred.fBounds);
+                }
+            }
         }
     }
-    fInsertionCount++;
 }
 
 void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
+    this->flushDeferredInserts();
+
     SkIRect adjustedQuery = query;
     // The inset is to counteract the outset that was applied in 'insert'
     // The outset/inset is to optimize for lookups of size
@@ -90,43 +239,137 @@ void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
 
     int queryTileCount = (tileEndX - tileStartX) * (tileEndY - tileStartY);
     SkASSERT(queryTileCount);
-    if (queryTileCount == 1) {
-        *results = this->tile(tileStartX, tileStartY);
-    } else {
-        results->reset();
-        SkAutoSTArray<kStackAllocationTileCount, int> curPositions(queryTileCount);
-        SkAutoSTArray<kStackAllocationTileCount, SkTDArray<void *>*> storage(queryTileCount);
-        SkTDArray<void *>** tileRange = storage.get();
-        int tile = 0;
-        for (int x = tileStartX; x < tileEndX; ++x) {
-            for (int y = tileStartY; y < tileEndY; ++y) {
-                tileRange[tile] = &this->tile(x, y);
-                curPositions[tile] = tileRange[tile]->count() ? 0 : kTileFinished;
-                ++tile;
+    if (queryTileCount == 1 && 1 == fLevels.count()) {
+        const SkTDArray<Entry>& entries = this->tile(tileStartX, tileStartY);
+        results->setCount(entries.count());
+        for (int i = 0; i < entries.count(); ++i) {
+            (*results)[i] = entries[i].fData;
+        }
+        return;
+    }
+
+    results->rewind();
+    // The tiles of level 0 that the query touches. A coarser level returns the data that overlap
+    // them, which are the data that level 0 would have held in those tiles.
+    const SkIRect covered = SkIRect::MakeLTRB(tileStartX * fInfo.fTileInterval.width(),
+                                              tileStartY * fInfo.fTileInterval.height(),
+                                              tileEndX * fInfo.fTileInterval.width(),
+                                              tileEndY * fInfo.fTileInterval.height());
+    // No level has more tiles under the query than level 0.
+    SkAutoSTArray<kStackAllocationTileCount, Cursor> cursors(queryTileCount * fLevels.count());
+    int cursorCount = 0;
+    for (int i = 0; i < fLevels.count(); ++i) {
+        const Level& level = fLevels[i];
+        const int width = level.fTileInterval.width();
+        const int height = level.fTileInterval.height();
+        const int stopX = SkMin32((covered.right() - 1) / width + 1, level.fXTileCount);
+        const int stopY = SkMin32((covered.bottom() - 1) / height + 1, level.fYTileCount);
+        for (int y = covered.top() / height; y < stopY; ++y) {
+            for (int x = covered.left() / width; x < stopX; ++x) {
+                const int index = y * level.fXTileCount + x;
+                const SkTDArray<Entry>& entries = level.fTiles[index];
+                Cursor& cursor = cursors[cursorCount];
+                cursor.fEntry = entries.begin();
+                cursor.fStop = entries.end();
+                cursor.fBounds = level.fBounds ? level.fBounds[index].begin() : NULL;
+                if (cursor.skipMisses(covered)) {
+                    ++cursorCount;
+                }
+            }
+        }
+    }
+
+    // Make room for every entry of these tiles, so that the merge can write the results straight.
+    int maxCount = 0;
+    for (int i = 0; i < cursorCount; ++i) {
+        maxCount += SkToInt(cursors[i].fStop - cursors[i].fEntry);
+    }
+    results->setCount(maxCount);
+    void** out = results->begin();
+
+    // Merge the tiles by insertion order, through a heap of cursors with the earliest entry on
+    // top. A datum that spans several tiles has the same order in each of them and is only
+    // returned once.
+    Cursor::Later later;
+    for (int i = cursorCount / 2; i >= 1; --i) {
+        SkTHeapSort_SiftDown(cursors.get(), i, cursorCount, later);
+    }
+    int lastOrder = -1;
+    while (cursorCount > 1) {
+        Cursor& first = cursors[0];
+        // The entries of the first tile that come before those of the tiles under it in the
+        // heap can all be returned before the heap is fixed.
+        int stopOrder = cursors[1].fEntry->fOrder;
+        if (cursorCount > 2) {
+            stopOrder = SkMin32(stopOrder, cursors[2].fEntry->fOrder);
+        }
+        bool more;
+        do {
+            if (first.fEntry->fOrder != lastOrder) {
+                lastOrder = first.fEntry->fOrder;
+                *out++ = first.fEntry->fData;
             }
+            more = first.next(covered);
+        } while (more && first.fEntry->fOrder < stopOrder);
+        if (!more) {
+            first = cursors[--cursorCount];
         }
-        void *nextElement;
-        while(NULL != (nextElement = fNextDatumFunction(tileRange, curPositions))) {
-            results->push(nextElement);
+        SkTHeapSort_SiftDown(cursors.get(), 1, cursorCount, later);
+    }
+    // The last tile needs no merging.
+    if (1 == cursorCount) {
+        Cursor& last = cursors[0];
+        bool more = last.fEntry->fOrder != lastOrder || last.next(covered);
+        if (more && NULL == last.fBounds) {
+            for (const Entry* entry = last.fEntry; entry < last.fStop; ++entry) {
+                *out++ = entry->fData;
+            }
+        } else if (more) {
+            do {
+                *out++ = last.fEntry->fData;
+            } while (last.next(covered));
         }
     }
+    results->setCount(SkToInt(out - results->begin()));
 }
 
 void SkTileGrid::clear() {
-    for (int i = 0; i < fTileCount; i++) {
-        fTileData[i].reset();
+    for (int i = 0; i < fLevels.count(); ++i) {
+        const Level& level = fLevels[i];
+        for (int j = 0; j < level.fXTileCount * level.fYTileCount; ++j) {
+            level.fTiles[j].reset();
+            if (level.fBounds) {
+                level.fBounds[j].reset();
+            }
+        }
     }
+    fDeferred.reset();
+    fInsertionCount = 0;
 }
 
 int SkTileGrid::getCount() const {
-    return fInsertionCount;
+    return fInsertionCount - fDeferred.count();
 }
 
 void SkTileGrid::rewindInserts() {
     SkASSERT(fClient);
-    for (int i = 0; i < fTileCount; ++i) {
-        while (!fTileData[i].isEmpty() && fClient->shouldRewind(fTileData[i].top())) {
-            fTileData[i].pop();
+    while (!fDeferred.isEmpty() && fClient->shouldRewind(fDeferred.top().fEntry.fData)) {
+        fDeferred.pop();
+        --fInsertionCount;
+    }
+    if (!fDeferred.isEmpty()) {
+        return;
+    }
+    for (int i = 0; i < fLevels.count(); ++i) {
+        const Level& level = fLevels[i];
+        for (int j = 0; j < level.fXTileCount * level.fYTileCount; ++j) {
+            SkTDArray<Entry>& entries = level.fTiles[j];
+            while (!entries.isEmpty() && fClient->shouldRewind(entries.top().fData)) {
+                entries.pop();
+                if (level.fBounds) {
+                    level.fBounds[j].pop();
+                }
+            }
         }
     }
 }
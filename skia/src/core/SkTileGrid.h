@@ -11,7 +11,6 @@
 
 #include "SkBBHFactory.h"
 #include "SkBBoxHierarchy.h"
-#include "SkPictureStateTree.h"
 
 /**
  * Subclass of SkBBoxHierarchy that stores elements in buckets that correspond
@@ -33,10 +32,8 @@ public:
         kStackAllocationTileCount = 1024
     };
 
-    typedef void* (*SkTileGridNextDatumFunctionPtr)(SkTDArray<void*>** tileData, SkAutoSTArray<kStackAllocationTileCount, int>& tileIndices);
-
     SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::TileGridInfo& info,
-        SkTileGridNextDatumFunctionPtr nextDatumFunction);
+               SkTileGridFactory::Layout layout = SkTileGridFactory::kFlat_Layout);
 
     virtual ~SkTileGrid();
 
@@ -44,18 +41,22 @@ public:
      * Insert a data pointer and corresponding bounding box
      * @param data The data pointer, may be NULL
      * @param bounds The bounding box, should not be empty
-     * @param defer Ignored, TileArray does not defer insertions
+     * @param defer Whether the tiles may be filled later. Deferred insertions are put in the
+     *        tiles all at once, on several threads if there are many of them.
      */
-    virtual void insert(void* data, const SkIRect& bounds, bool) SK_OVERRIDE;
+    virtual void insert(void* data, const SkIRect& bounds, bool defer = false) SK_OVERRIDE;
 
-    virtual void flushDeferredInserts() SK_OVERRIDE {};
+    virtual void flushDeferredInserts() SK_OVERRIDE;
 
     /**
      * Populate 'results' with data pointers corresponding to bounding boxes that intersect 'query'
      * The query argument is expected to be an exact match to a tile of the grid
+     * The results are in the order in which they were inserted.
      */
     virtual void search(const SkIRect& query, SkTDArray<void*>* results) SK_OVERRIDE;
 
+    virtual bool searchIsOrdered() const SK_OVERRIDE { return true; }
+
     virtual void clear() SK_OVERRIDE;
 
     /**
@@ -67,76 +68,64 @@ public:
 
     virtual void rewindInserts() SK_OVERRIDE;
 
-    // Used by search() and in SkTileGridHelper implementations
+    int tileCount(int x, int y);  // For testing only.
+
+private:
     enum {
-        kTileFinished = -1,
+        // In the adaptive layout, each tile of a level covers kLevelScale x kLevelScale tiles of
+        // the level below it, and a datum goes in the finest level where it overlaps at most
+        // kMaxTilesPerDatum tiles.
+        kLevelScale = 4,
+        kMaxTilesPerDatum = 64,
+
+        // Deferred insertions are spread over several threads once there are this many.
+        kParallelFlushThreshold = 8 * 1024,
     };
 
-    int tileCount(int x, int y);  // For testing only.
+    // Each datum is tagged with its insertion order, so that the data of several tiles can be
+    // merged back into that order without knowing anything about the data themselves.
+    struct Entry {
+        void* fData;
+        int   fOrder;
+    };
 
-private:
-    SkTDArray<void*>& tile(int x, int y);
+    // One grid of tiles. Level 0 is the grid the tile grid was created with. The tiles of the
+    // levels above are too coarse to tell whether a datum touches the query, so they also keep
+    // the bounds of their data, in the same order.
+    struct Level {
+        int                 fXTileCount, fYTileCount;
+        SkISize             fTileInterval;
+        SkTDArray<Entry>*   fTiles;
+        SkTDArray<SkIRect>* fBounds;  // NULL for level 0
+    };
+
+    // An insertion waiting for flushDeferredInserts(). fTiles is inclusive.
+    struct DeferredEntry {
+        Entry   fEntry;
+        SkIRect fBounds;
+        int     fLevel;
+        SkIRect fTiles;
+    };
+
+    struct Cursor;
+    struct FillTask;
+
+    // Returns the level a datum with these (dilated) bounds goes in, and sets tiles to the
+    // range of tiles it overlaps in that level, inclusive.
+    int place(const SkIRect& bounds, SkIRect* tiles) const;
+    // Adds the deferred entries of the given level whose tiles overlap rows [startY, stopY).
+    void fillRows(int level, int startY, int stopY);
+
+    SkTDArray<Entry>& tile(int x, int y);
 
     int fXTileCount, fYTileCount, fTileCount;
     SkTileGridFactory::TileGridInfo fInfo;
-    SkTDArray<void*>* fTileData;
+    SkTDArray<Level> fLevels;
+    SkTDArray<DeferredEntry> fDeferred;
     int fInsertionCount;
     SkIRect fGridBounds;
-    SkTileGridNextDatumFunctionPtr fNextDatumFunction;
 
     typedef SkBBoxHierarchy INHERITED;
 };
 
-/**
- * Generic implementation for SkTileGridNextDatumFunctionPtr. user code may instantiate
- * this template to get a valid SkTileGridNextDatumFunction implementation
- *
- * Returns the next element of tileData[i][tileIndices[i]] for all i and advances
- * tileIndices[] past them. The order in which data are returned by successive
- * calls to this method must reflect the order in which the were originally
- * recorded into the tile grid.
- *
- * \param tileData array of pointers to arrays of tile data
- * \param tileIndices per-tile data indices, indices are incremented for tiles that contain
- *     the next datum.
- * \tparam T a type to which it is safe to cast a datum and that has an operator <
- *     such that 'a < b' is true if 'a' was inserted into the tile grid before 'b'.
- */
-template <typename T>
-void* SkTileGridNextDatum(SkTDArray<void*>** tileData, SkAutoSTArray<SkTileGrid::kStackAllocationTileCount, int>& tileIndices) {
-    T* minVal = NULL;
-    int tileCount = tileIndices.count();
-    int minIndex = tileCount;
-    int maxIndex = 0;
-    // Find the next Datum; track where it's found so we reduce the size of the second loop.
-    for (int tile = 0; tile < tileCount; ++tile) {
-        int pos = tileIndices[tile];
-        if (pos != SkTileGrid::kTileFinished) {
-            T* candidate = (T*)(*tileData[tile])[pos];
-            if (NULL == minVal || (*candidate) < (*minVal)) {
-                minVal = candidate;
-                minIndex = tile;
-                maxIndex = tile;
-            } else if (!((*minVal) < (*candidate))) {
-                // We don't require operator==; if !(candidate<minVal) && !(minVal<candidate),
-                // candidate==minVal and we have to add this tile to the range searched.
-                maxIndex = tile;
-            }
-        }
-    }
-    // Increment indices past the next datum
-    if (minVal != NULL) {
-        for (int tile = minIndex; tile <= maxIndex; ++tile) {
-            int pos = tileIndices[tile];
-            if (pos != SkTileGrid::kTileFinished && (*tileData[tile])[pos] == minVal) {
-                if (++(tileIndices[tile]) >= tileData[tile]->count()) {
-                    tileIndices[tile] = SkTileGrid::kTileFinished;
-                }
-            }
-        }
-        return minVal;
-    }
-    return NULL;
-}
-
 #endif
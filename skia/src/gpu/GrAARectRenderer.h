@@ -14,6 +14,7 @@
 #include "SkStrokeRec.h"
 
 class GrGpu;
+class GrDrawState;
 class GrDrawTarget;
 class GrIndexBuffer;
 
@@ -75,6 +76,12 @@ public:
                            const SkMatrix& combinedMatrix,
                            bool useVertexCoverage);
 
+    /**
+     * Sets the vertex layout that the AA rect fills and strokes are drawn with on drawState: each
+     * vertex has a position and either a coverage, if useVertexCoverage, or a color.
+     */
+    static void SetVertexAttribs(GrDrawState* drawState, bool useVertexCoverage);
+
 private:
     GrIndexBuffer*              fAAFillRectIndexBuffer;
     GrIndexBuffer*              fAAMiterStrokeRectIndexBuffer;
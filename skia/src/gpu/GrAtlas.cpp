@@ -37,10 +37,11 @@ GrPlot::~GrPlot() {
     delete fRects;
 }
 
-void GrPlot::init(GrAtlasMgr* mgr, int offX, int offY, int width, int height, size_t bpp,
-                  bool batchUploads) {
+void GrPlot::init(GrAtlasMgr* mgr, GrTexture* texture, int offX, int offY, int width, int height,
+                  size_t bpp, bool batchUploads) {
     fRects = GrRectanizer::Factory(width, height);
     fAtlasMgr = mgr;
+    fTexture = texture;
     fOffset.set(offX * width, offY * height);
     fBytesPerPixel = bpp;
     fPlotData = NULL;
@@ -61,6 +62,11 @@ bool GrPlot::addSubImage(int width, int height, const void* image,
         return false;
     }
 
+    if (NULL == image) {
+        adjust_for_offset(loc, fOffset);
+        return true;
+    }
+
     // if batching uploads, create backing memory on first use
     // once the plot is nearly full we will revert to uploading each subimage individually
     int plotWidth = fRects->width();
@@ -86,7 +92,10 @@ bool GrPlot::addSubImage(int width, int height, const void* image,
 
         fDirtyRect.join(loc->fX, loc->fY, loc->fX + width, loc->fY + height);
         adjust_for_offset(loc, fOffset);
-        fDirty = true;
+        if (!fDirty) {
+            *fAtlasMgr->fDirtyPlots.append() = this;
+            fDirty = true;
+        }
     // otherwise, just upload the image directly
     } else {
         adjust_for_offset(loc, fOffset);
@@ -146,48 +155,33 @@ void GrPlot::resetRects() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-GrAtlasMgr::GrAtlasMgr(GrGpu* gpu, GrPixelConfig config,
+GrAtlasMgr::GrAtlasMgr(GrGpu* gpu, GrPixelConfig config, GrTextureFlags flags,
                        const SkISize& backingTextureSize,
-                       int numPlotsX, int numPlotsY, bool batchUploads) {
+                       int numPlotsX, int numPlotsY, bool batchUploads, int maxPages) {
     fGpu = SkRef(gpu);
     fPixelConfig = config;
+    fFlags = flags;
     fBackingTextureSize = backingTextureSize;
     fNumPlotsX = numPlotsX;
     fNumPlotsY = numPlotsY;
     fBatchUploads = batchUploads;
-    fTexture = NULL;
+    fMaxPages = maxPages;
 
-    int textureWidth = fBackingTextureSize.width();
-    int textureHeight = fBackingTextureSize.height();
-
-    int plotWidth = textureWidth / fNumPlotsX;
-    int plotHeight = textureHeight / fNumPlotsY;
-
-    SkASSERT(plotWidth * fNumPlotsX == textureWidth);
-    SkASSERT(plotHeight * fNumPlotsY == textureHeight);
+    SkASSERT(fMaxPages > 0);
+    SkASSERT(fBackingTextureSize.width() % fNumPlotsX == 0);
+    SkASSERT(fBackingTextureSize.height() % fNumPlotsY == 0);
 
     // We currently do not support compressed atlases...
     SkASSERT(!GrPixelConfigIsCompressed(config));
 
-    // set up allocated plots
-    size_t bpp = GrBytesPerPixel(fPixelConfig);
-    fPlotArray = SkNEW_ARRAY(GrPlot, (fNumPlotsX*fNumPlotsY));
-
-    GrPlot* currPlot = fPlotArray;
-    for (int y = numPlotsY-1; y >= 0; --y) {
-        for (int x = numPlotsX-1; x >= 0; --x) {
-            currPlot->init(this, x, y, plotWidth, plotHeight, bpp, batchUploads);
-
-            // build LRU list
-            fPlotList.addToHead(currPlot);
-            ++currPlot;
-        }
-    }
+    // The first page is allocated on first use in addToAtlas().
 }
 
 GrAtlasMgr::~GrAtlasMgr() {
-    SkSafeUnref(fTexture);
-    SkDELETE_ARRAY(fPlotArray);
+    for (int i = 0; i < fPages.count(); ++i) {
+        SkSafeUnref(fPages[i].fTexture);
+        SkDELETE_ARRAY(fPages[i].fPlots);
+    }
 
     fGpu->unref();
 #if FONT_CACHE_STATS
@@ -218,18 +212,8 @@ GrPlot* GrAtlasMgr::addToAtlas(GrAtlas* atlas,
     }
 
     // before we get a new plot, make sure we have a backing texture
-    if (NULL == fTexture) {
-        // TODO: Update this to use the cache rather than directly creating a texture.
-        GrTextureDesc desc;
-        desc.fFlags = kDynamicUpdate_GrTextureFlagBit;
-        desc.fWidth = fBackingTextureSize.width();
-        desc.fHeight = fBackingTextureSize.height();
-        desc.fConfig = fPixelConfig;
-
-        fTexture = fGpu->createTexture(desc, NULL, 0);
-        if (NULL == fTexture) {
-            return NULL;
-        }
+    if (0 == fPages.count() && !this->addPage()) {
+        return NULL;
     }
 
     // now look through all allocated plots for one we can share, in MRU order
@@ -237,8 +221,6 @@ GrPlot* GrAtlasMgr::addToAtlas(GrAtlas* atlas,
     plotIter.init(fPlotList, GrPlotList::Iter::kHead_IterStart);
     GrPlot* plot;
     while (NULL != (plot = plotIter.get())) {
-        // make sure texture is set for quick lookup
-        plot->fTexture = fTexture;
         if (plot->addSubImage(width, height, image, loc)) {
             this->moveToHead(plot);
             // new plot for atlas, put at end of array
@@ -252,6 +234,44 @@ GrPlot* GrAtlasMgr::addToAtlas(GrAtlas* atlas,
     return NULL;
 }
 
+bool GrAtlasMgr::addPage() {
+    if (fPages.count() >= fMaxPages) {
+        return false;
+    }
+
+    // TODO: Update this to use the cache rather than directly creating a texture.
+    GrTextureDesc desc;
+    desc.fFlags = fFlags;
+    desc.fWidth = fBackingTextureSize.width();
+    desc.fHeight = fBackingTextureSize.height();
+    desc.fConfig = fPixelConfig;
+
+    GrTexture* texture = fGpu->createTexture(desc, NULL, 0);
+    if (NULL == texture) {
+        return false;
+    }
+
+    Page* page = fPages.append();
+    page->fTexture = texture;
+    page->fPlots = SkNEW_ARRAY(GrPlot, (fNumPlotsX*fNumPlotsY));
+
+    int plotWidth = fBackingTextureSize.width() / fNumPlotsX;
+    int plotHeight = fBackingTextureSize.height() / fNumPlotsY;
+    size_t bpp = GrBytesPerPixel(fPixelConfig);
+
+    // The new plots are empty, so put them at the head of the LRU list where addToAtlas() finds
+    // them first and getUnusedPlot() finds them last.
+    GrPlot* currPlot = page->fPlots;
+    for (int y = fNumPlotsY-1; y >= 0; --y) {
+        for (int x = fNumPlotsX-1; x >= 0; --x) {
+            currPlot->init(this, texture, x, y, plotWidth, plotHeight, bpp, fBatchUploads);
+            fPlotList.addToHead(currPlot);
+            ++currPlot;
+        }
+    }
+    return true;
+}
+
 bool GrAtlasMgr::removePlot(GrAtlas* atlas, const GrPlot* plot) {
     // iterate through plot list for this atlas
     int count = atlas->fPlots.count();
@@ -282,12 +302,9 @@ GrPlot* GrAtlasMgr::getUnusedPlot() {
 
 void GrAtlasMgr::uploadPlotsToTexture() {
     if (fBatchUploads) {
-        GrPlotList::Iter plotIter;
-        plotIter.init(fPlotList, GrPlotList::Iter::kHead_IterStart);
-        GrPlot* plot;
-        while (NULL != (plot = plotIter.get())) {
-            plot->uploadToTexture();
-            plotIter.next();
+        for (int i = 0; i < fDirtyPlots.count(); ++i) {
+            fDirtyPlots[i]->uploadToTexture();
         }
+        fDirtyPlots.rewind();
     }
 }
@@ -19,15 +19,19 @@ class GrRectanizer;
 class GrAtlasMgr;
 class GrAtlas;
 
-// The backing GrTexture for a set of GrAtlases is broken into a spatial grid of GrPlots. When
+// The backing GrTextures for a set of GrAtlases are broken into a spatial grid of GrPlots. When
 // a GrAtlas needs space on the texture, it requests a GrPlot. Each GrAtlas can claim one
 // or more GrPlots. The GrPlots keep track of subimage placement via their GrRectanizer. Once a
 // GrPlot is "full" (i.e. there is no room for the new subimage according to the GrRectanizer), the
 // GrAtlas can request a new GrPlot via GrAtlasMgr::addToAtlas().
 //
+// The GrAtlasMgr starts out with a single backing texture (a page) and can be grown to a fixed
+// maximum number of pages with GrAtlasMgr::addPage().
+//
 // If all GrPlots are allocated, the replacement strategy is up to the client. The drawToken is
-// available to ensure that all draw calls are finished for that particular GrPlot.
-// GrAtlasMgr::removeUnusedPlots() will free up any finished plots for a given GrAtlas.
+// available to ensure that all draw calls are finished for that particular GrPlot. Setting the
+// drawToken also marks the GrPlot as most recently used, so GrAtlasMgr::getUnusedPlot() returns
+// the least recently used GrPlot whose draws are finished.
 
 class GrPlot {
 public:
@@ -38,7 +42,7 @@ public:
     bool addSubImage(int width, int height, const void*, SkIPoint16*);
 
     GrDrawTarget::DrawToken drawToken() const { return fDrawToken; }
-    void setDrawToken(GrDrawTarget::DrawToken draw) { fDrawToken = draw; }
+    inline void setDrawToken(GrDrawTarget::DrawToken draw);
 
     void uploadToTexture();
 
@@ -47,8 +51,8 @@ public:
 private:
     GrPlot();
     ~GrPlot(); // does not try to delete the fNext field
-    void init(GrAtlasMgr* mgr, int offX, int offY, int width, int height, size_t bpp,
-              bool batchUploads);
+    void init(GrAtlasMgr* mgr, GrTexture* texture, int offX, int offY, int width, int height,
+              size_t bpp, bool batchUploads);
 
     // for recycling
     GrDrawTarget::DrawToken fDrawToken;
@@ -70,12 +74,13 @@ typedef SkTInternalLList<GrPlot> GrPlotList;
 
 class GrAtlasMgr {
 public:
-    GrAtlasMgr(GrGpu*, GrPixelConfig, const SkISize& backingTextureSize,
-               int numPlotsX, int numPlotsY, bool batchUploads);
+    GrAtlasMgr(GrGpu*, GrPixelConfig, GrTextureFlags, const SkISize& backingTextureSize,
+               int numPlotsX, int numPlotsY, bool batchUploads, int maxPages = 1);
     ~GrAtlasMgr();
 
     // add subimage of width, height dimensions to atlas
     // returns the containing GrPlot and location relative to the backing texture
+    // if the image is NULL the space is only reserved, e.g. to be rendered to later
     GrPlot* addToAtlas(GrAtlas*, int width, int height, const void*, SkIPoint16*);
 
     // remove reference to this plot
@@ -85,29 +90,51 @@ public:
     // this allows us to overwrite this plot without flushing
     GrPlot* getUnusedPlot();
 
-    GrTexture* getTexture() const {
-        return fTexture;
+    // add another backing texture whose plots are all free
+    // returns false if the maximum number of pages has been reached or the texture can't be made
+    bool addPage();
+
+    int pageCount() const { return fPages.count(); }
+    int maxPages() const { return fMaxPages; }
+
+    GrTexture* getTexture(int page) const {
+        return fPages[page].fTexture;
     }
 
+    // upload the dirty rect of each plot that was written to since the last upload
     void uploadPlotsToTexture();
 
 private:
     void moveToHead(GrPlot* plot);
 
-    GrGpu*        fGpu;
-    GrPixelConfig fPixelConfig;
-    GrTexture*    fTexture;
-    SkISize       fBackingTextureSize;
-    int           fNumPlotsX;
-    int           fNumPlotsY;
-    bool          fBatchUploads;
-
-    // allocated array of GrPlots
-    GrPlot*       fPlotArray;
-    // LRU list of GrPlots
-    GrPlotList    fPlotList;
+    struct Page {
+        GrTexture*  fTexture;
+        GrPlot*     fPlots;     // allocated array of GrPlots
+    };
+
+    GrGpu*         fGpu;
+    GrPixelConfig  fPixelConfig;
+    GrTextureFlags fFlags;
+    SkISize        fBackingTextureSize;
+    int            fNumPlotsX;
+    int            fNumPlotsY;
+    bool           fBatchUploads;
+    int            fMaxPages;
+
+    SkTDArray<Page>    fPages;
+    // LRU list of GrPlots from all pages
+    GrPlotList         fPlotList;
+    // plots with data waiting for uploadPlotsToTexture()
+    SkTDArray<GrPlot*> fDirtyPlots;
+
+    friend class GrPlot;
 };
 
+inline void GrPlot::setDrawToken(GrDrawTarget::DrawToken draw) {
+    fDrawToken = draw;
+    fAtlasMgr->moveToHead(this);
+}
+
 class GrAtlas {
 public:
     GrAtlas() { }
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrBitmapAtlas.h"
+
+#include "GrContext.h"
+#include "GrGpu.h"
+#include "SkBitmap.h"
+
+/**
+ *  BitmapKey identifies the pixels of a bitmap by its pixel ref's generation ID and the
+ *  bitmap's bounds in the pixel ref.
+ */
+class GrBitmapAtlas::BitmapKey {
+public:
+    BitmapKey(const SkBitmap& bitmap)
+        : fGenID(bitmap.getGenerationID())
+        , fOrigin(bitmap.pixelRefOrigin())
+        , fWidth(bitmap.width())
+        , fHeight(bitmap.height()) {
+    }
+
+    BitmapKey(const GrCachedBitmap& entry)
+        : fGenID(entry.fGenID)
+        , fOrigin(entry.fOrigin)
+        , fWidth(entry.fWidth)
+        , fHeight(entry.fHeight) {
+    }
+
+    uint32_t genID() const { return fGenID; }
+    const SkIPoint& origin() const { return fOrigin; }
+
+    uint32_t getHash() const {
+        return fGenID ^ (fOrigin.fX << 8) ^ (fOrigin.fY << 16);
+    }
+
+    static bool LessThan(const GrCachedBitmap& entry, const BitmapKey& key) {
+        if (entry.fGenID != key.fGenID) {
+            return entry.fGenID < key.fGenID;
+        }
+        if (entry.fOrigin.fY != key.fOrigin.fY) {
+            return entry.fOrigin.fY < key.fOrigin.fY;
+        }
+        if (entry.fOrigin.fX != key.fOrigin.fX) {
+            return entry.fOrigin.fX < key.fOrigin.fX;
+        }
+        if (entry.fWidth != key.fWidth) {
+            return entry.fWidth < key.fWidth;
+        }
+        return entry.fHeight < key.fHeight;
+    }
+
+    static bool Equals(const GrCachedBitmap& entry, const BitmapKey& key) {
+        return entry.fGenID == key.fGenID &&
+               entry.fOrigin == key.fOrigin &&
+               entry.fWidth == key.fWidth &&
+               entry.fHeight == key.fHeight;
+    }
+
+private:
+    uint32_t fGenID;
+    SkIPoint fOrigin;
+    int      fWidth;
+    int      fHeight;
+};
+
+namespace {
+
+// The atlased bitmaps are surrounded by a copy of their edge pixels so that filtering up to the
+// bitmap's edge samples the same colors as a clamped texture of its own would.
+static const int kPadding = 1;
+
+static const int kAtlasTextureWidth = 1024;
+static const int kAtlasTextureHeight = 1024;
+static const int kNumPlotsX = 4;
+static const int kNumPlotsY = 4;
+static const int kMaxPages = 2;
+
+}
+
+GrBitmapAtlas::GrBitmapAtlas(GrContext* context)
+    : fContext(context) {
+}
+
+GrBitmapAtlas::~GrBitmapAtlas() {
+    this->freeAll();
+}
+
+bool GrBitmapAtlas::CanAtlas(const SkBitmap& bitmap, const GrTextureParams& params) {
+    return NULL == bitmap.getTexture() &&
+           NULL != bitmap.pixelRef() &&
+           kN32_SkColorType == bitmap.colorType() &&
+           !bitmap.empty() &&
+           bitmap.width() <= kMaxBitmapSize &&
+           bitmap.height() <= kMaxBitmapSize &&
+           !params.isTiled() &&
+           GrTextureParams::kMipMap_FilterMode != params.filterMode();
+}
+
+GrTexture* GrBitmapAtlas::findOrAddBitmap(const SkBitmap& bitmap, SkIPoint16* location) {
+    SkASSERT(NULL == bitmap.getTexture());
+    SkASSERT(bitmap.width() <= kMaxBitmapSize && bitmap.height() <= kMaxBitmapSize);
+
+    GrCachedBitmap* entry = fBitmapHash.find(BitmapKey(bitmap));
+    if (NULL == entry) {
+        entry = this->addBitmap(bitmap);
+        if (NULL == entry) {
+            return NULL;
+        }
+        ++fContext->getGpu()->stats()->fBitmapAtlasMisses;
+    } else {
+        ++fContext->getGpu()->stats()->fBitmapAtlasHits;
+    }
+
+    // Keep the plot from being evicted until the draw that is about to use it is flushed.
+    entry->fPlot->setDrawToken(fContext->getTextTarget()->getCurrentDrawToken());
+    *location = entry->fLocation;
+    return entry->fPlot->texture();
+}
+
+GrCachedBitmap* GrBitmapAtlas::addBitmap(const SkBitmap& bitmap) {
+    SkAutoLockPixels alp(bitmap);
+    if (!bitmap.readyToDraw()) {
+        return NULL;
+    }
+
+    if (NULL == fAtlasMgr.get()) {
+        SkISize textureSize = SkISize::Make(kAtlasTextureWidth, kAtlasTextureHeight);
+        fAtlasMgr.reset(SkNEW_ARGS(GrAtlasMgr, (fContext->getGpu(), kSkia8888_GrPixelConfig,
+                                                kDynamicUpdate_GrTextureFlagBit, textureSize,
+                                                kNumPlotsX, kNumPlotsY, true, kMaxPages)));
+        fAtlas.reset(SkNEW(GrAtlas));
+    }
+
+    int width = bitmap.width();
+    int height = bitmap.height();
+    int paddedWidth = width + 2 * kPadding;
+    int paddedHeight = height + 2 * kPadding;
+    SkAutoTMalloc<uint32_t> padded(paddedWidth * paddedHeight);
+    uint32_t* dst = padded.get();
+    for (int y = -kPadding; y < height + kPadding; ++y) {
+        const uint32_t* src = bitmap.getAddr32(0, SkPin32(y, 0, height - 1));
+        for (int x = 0; x < kPadding; ++x) {
+            *dst++ = src[0];
+        }
+        memcpy(dst, src, width * sizeof(uint32_t));
+        dst += width;
+        for (int x = 0; x < kPadding; ++x) {
+            *dst++ = src[width - 1];
+        }
+    }
+
+    SkIPoint16 loc;
+    GrPlot* plot = fAtlasMgr->addToAtlas(fAtlas.get(), paddedWidth, paddedHeight,
+                                         padded.get(), &loc);
+    if (NULL == plot && this->freeUnusedPlot()) {
+        plot = fAtlasMgr->addToAtlas(fAtlas.get(), paddedWidth, paddedHeight,
+                                     padded.get(), &loc);
+    }
+    if (NULL == plot) {
+        return NULL;
+    }
+
+    BitmapKey key(bitmap);
+    GrCachedBitmap* entry = SkNEW_ARGS(GrCachedBitmap, (key.genID(), key.origin(),
+                                                        width, height));
+    entry->fPlot = plot;
+    entry->fLocation.set(loc.fX + kPadding, loc.fY + kPadding);
+    fBitmapHash.insert(key, entry);
+    return entry;
+}
+
+bool GrBitmapAtlas::freeUnusedPlot() {
+    GrPlot* plot = fAtlasMgr->getUnusedPlot();
+    if (NULL == plot) {
+        // Every plot is referenced by a pending draw. Add a page of empty plots if we are
+        // allowed to, otherwise the bitmap gets a texture of its own.
+        return fAtlasMgr->addPage();
+    }
+    plot->resetRects();
+    this->removePlot(plot);
+    return true;
+}
+
+void GrBitmapAtlas::removePlot(const GrPlot* plot) {
+    SkTDArray<GrCachedBitmap*>& entries = fBitmapHash.getArray();
+    // Removing an entry only moves the entries after it, so walk the array backwards.
+    for (int i = entries.count() - 1; i >= 0; --i) {
+        GrCachedBitmap* entry = entries[i];
+        if (plot == entry->fPlot) {
+            fBitmapHash.remove(BitmapKey(*entry), entry);
+            SkDELETE(entry);
+        }
+    }
+
+    fAtlasMgr->removePlot(fAtlas.get(), plot);
+}
+
+void GrBitmapAtlas::uploadToTexture() {
+    if (NULL != fAtlasMgr.get()) {
+        fAtlasMgr->uploadPlotsToTexture();
+    }
+}
+
+void GrBitmapAtlas::freeAll() {
+    fBitmapHash.deleteAll();
+    fAtlas.free();
+    fAtlasMgr.free();
+}
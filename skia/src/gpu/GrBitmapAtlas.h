@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrBitmapAtlas_DEFINED
+#define GrBitmapAtlas_DEFINED
+
+#include "GrAtlas.h"
+#include "GrTHashTable.h"
+#include "SkTemplates.h"
+
+class GrContext;
+class SkBitmap;
+
+// GrCachedBitmap records where the pixels of a small bitmap were copied into the bitmap atlas.
+struct GrCachedBitmap {
+public:
+    GrCachedBitmap(uint32_t genID, const SkIPoint& origin, int width, int height)
+        : fGenID(genID)
+        , fOrigin(origin)
+        , fWidth(width)
+        , fHeight(height)
+        , fPlot(NULL) {
+    }
+
+    uint32_t    fGenID;         // generation ID of the bitmap's pixel ref
+    SkIPoint    fOrigin;        // the bitmap's origin in its pixel ref
+    int         fWidth;
+    int         fHeight;
+
+    GrPlot*     fPlot;          // the plot holding the pixels
+    SkIPoint16  fLocation;      // top left of the bitmap in the plot's texture, inside the padding
+};
+
+/**
+ * GrBitmapAtlas packs small N32 bitmaps into shared textures so that drawing many different
+ * small bitmaps (sprites, icons) doesn't require a texture switch, and therefore a new draw,
+ * per bitmap. Bitmaps are found by the generation ID of their pixel ref and their bounds in it,
+ * so editing a bitmap's pixels gives it a new entry and the stale one is evicted along with its
+ * plot. When every plot is in use by a pending draw, new bitmaps are not atlased and the caller
+ * falls back to a texture of its own.
+ */
+class GrBitmapAtlas {
+public:
+    GrBitmapAtlas(GrContext*);
+    ~GrBitmapAtlas();
+
+    // Bitmaps with a width or height larger than this are never atlased.
+    static const int kMaxBitmapSize = 64;
+
+    /**
+     * Returns true if bitmap may be drawn from the atlas when sampled with the given params.
+     */
+    static bool CanAtlas(const SkBitmap& bitmap, const GrTextureParams& params);
+
+    /**
+     * Finds or adds bitmap, which must pass CanAtlas(), and marks it as used by the next draw.
+     * Returns the atlas texture and sets location to the bitmap's top left in it. Returns NULL
+     * if there is no room for the bitmap without flushing. The texture is not reffed.
+     */
+    GrTexture* findOrAddBitmap(const SkBitmap& bitmap, SkIPoint16* location);
+
+    // upload the atlased bitmaps added since the last call; called before the draws are flushed
+    void uploadToTexture();
+
+    void freeAll();
+
+private:
+    class BitmapKey;
+
+    GrCachedBitmap* addBitmap(const SkBitmap& bitmap);
+
+    // Evicts the least recently used plot that has no pending draws. Returns false if there is
+    // no such plot.
+    bool freeUnusedPlot();
+
+    // Removes the entries of all the bitmaps in plot.
+    void removePlot(const GrPlot* plot);
+
+    GrContext*                                  fContext;
+    SkAutoTDelete<GrAtlasMgr>                   fAtlasMgr;
+    SkAutoTDelete<GrAtlas>                      fAtlas;
+    GrTHashTable<GrCachedBitmap, BitmapKey, 7>  fBitmapHash;
+};
+
+#endif
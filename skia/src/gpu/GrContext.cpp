@@ -14,6 +14,7 @@
 #include "effects/GrSingleTextureEffect.h"
 
 #include "GrAARectRenderer.h"
+#include "GrBitmapAtlas.h"
 #include "GrBufferAllocPool.h"
 #include "GrGpu.h"
 #include "GrDrawTargetCaps.h"
@@ -130,6 +131,8 @@ bool GrContext::init( GrBackendContext backendContext) {
 
     fLayerCache.reset(SkNEW_ARGS(GrLayerCache, (fGpu)));
 
+    fBitmapAtlas.reset(SkNEW_ARGS(GrBitmapAtlas, (this)));
+
     fLastDrawWasBuffered = kNo_BufferedDraw;
 
     fAARectRenderer = SkNEW(GrAARectRenderer);
@@ -204,6 +207,7 @@ void GrContext::contextDestroyed() {
 
     fFontCache->freeAll();
     fLayerCache->freeAll();
+    fBitmapAtlas->freeAll();
     fGpu->markContextDirty();
 }
 
@@ -222,11 +226,77 @@ void GrContext::freeGpuResources() {
     fResourceCache->purgeAllUnlocked();
     fFontCache->freeAll();
     fLayerCache->freeAll();
+    fBitmapAtlas->freeAll();
     // a path renderer may be holding onto resources
     SkSafeSetNull(fPathRendererChain);
     SkSafeSetNull(fSoftwarePathRenderer);
 }
 
+int GrContext::getProgramCacheLimit() const {
+    return fGpu->getProgramCacheLimit();
+}
+
+void GrContext::setProgramCacheLimit(int maxPrograms) {
+    fGpu->setProgramCacheLimit(maxPrograms);
+}
+
+void GrContext::setPersistentCache(GrPersistentCache* cache) {
+    fGpu->setPersistentCache(cache);
+}
+
+// Sets up drawState the way GrInOrderDrawBuffer::onDrawRect() does before drawing a rect.
+static void set_rect_draw_state(GrDrawState* drawState, const GrDrawTargetCaps& caps, bool hasUVs) {
+    int colorOffset, localOffset;
+    GrInOrderDrawBuffer::SetRectVertexAttribs(drawState, caps, hasUVs, &colorOffset, &localOffset);
+    if (colorOffset >= 0) {
+        drawState->setColor(0xFFFFFFFF);
+    }
+}
+
+int GrContext::precompilePrograms(const GrPaint paints[], int count) {
+    if (NULL == fRenderTarget.get()) {
+        return 0;
+    }
+    const GrDrawTargetCaps& caps = *fGpu->caps();
+    int compiled = 0;
+    for (int i = 0; i < count; ++i) {
+        const GrPaint& paint = paints[i];
+        GrDrawState paintState;
+        paintState.setFromPaint(paint, SkMatrix::I(), fRenderTarget.get());
+
+        // Filled rects that aren't antialiased.
+        GrDrawState drawState(paintState);
+        set_rect_draw_state(&drawState, caps, false);
+        if (fGpu->precompileProgram(drawState, GrGpu::kDrawTriangles_DrawType)) {
+            ++compiled;
+        }
+
+        // Bitmap rects, which drawRectToRect() draws with local coords for the paint's effects.
+        if (paint.numTotalStages() > 0) {
+            drawState = paintState;
+            set_rect_draw_state(&drawState, caps, true);
+            if (fGpu->precompileProgram(drawState, GrGpu::kDrawTriangles_DrawType)) {
+                ++compiled;
+            }
+        }
+
+        // Antialiased rects, for which GrAARectRenderer ramps the coverage in the vertices. See
+        // apply_aa_to_rect().
+        if (paint.isAntiAlias() && !fRenderTarget->isMultisampled()) {
+            bool useVertexCoverage = !paintState.canTweakAlphaForCoverage();
+            if (!useVertexCoverage || caps.dualSourceBlendingSupport() ||
+                GrDrawState::kNone_BlendOpt != paintState.getBlendOpts(true)) {
+                drawState = paintState;
+                GrAARectRenderer::SetVertexAttribs(&drawState, useVertexCoverage);
+                if (fGpu->precompileProgram(drawState, GrGpu::kDrawTriangles_DrawType)) {
+                    ++compiled;
+                }
+            }
+        }
+    }
+    return compiled;
+}
+
 void GrContext::getResourceCacheUsage(int* resourceCount, size_t* resourceBytes) const {
   if (NULL != resourceCount) {
     *resourceCount = fResourceCache->getCachedResourceCount();
@@ -591,6 +661,40 @@ void GrContext::setResourceCacheLimits(int maxTextures, size_t maxTextureBytes)
     fResourceCache->setLimits(maxTextures, maxTextureBytes);
 }
 
+size_t GrContext::getResourceCategoryLimit(GrResourceCategory category) const {
+    return fResourceCache->getCategoryLimit(category);
+}
+
+void GrContext::setResourceCategoryLimit(GrResourceCategory category, size_t maxResourceBytes) {
+    fResourceCache->setCategoryLimit(category, maxResourceBytes);
+}
+
+void GrContext::getResourceCategoryUsage(GrResourceCategory category, int* resourceCount,
+                                         size_t* resourceBytes) const {
+    if (NULL != resourceCount) {
+        *resourceCount = fResourceCache->getCategoryResourceCount(category);
+    }
+    if (NULL != resourceBytes) {
+        *resourceBytes = fResourceCache->getCategoryResourceBytes(category);
+    }
+}
+
+void GrContext::setResourceCacheMaxUnusedFlushes(int flushes) {
+    fResourceCache->setMaxUnusedFlushes(flushes);
+}
+
+void GrContext::handleMemoryPressure(MemoryPressureLevel level) {
+    if (kCritical_MemoryPressureLevel == level) {
+        this->freeGpuResources();
+        return;
+    }
+
+    SkASSERT(kModerate_MemoryPressureLevel == level);
+    // Scratch textures are cheap to recreate and are typically the largest resources.
+    fResourceCache->purgeCategory(kScratch_GrResourceCategory);
+    fResourceCache->purgeUnusedFor(1);
+}
+
 int GrContext::getMaxTextureSize() const {
     return SkTMin(fGpu->caps()->maxTextureSize(), fMaxTextureSizeOverride);
 }
@@ -1311,6 +1415,39 @@ void GrContext::flush(int flagsBitfield) {
         fDrawBuffer->flush();
     }
     fFlushToReduceCacheSize = false;
+    fResourceCache->didFlush();
+
+    const GpuStats& stats = fGpu->getStats();
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats",
+                   "draws", stats.fDraws, "programSwitches", stats.fProgramSwitches);
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats binds",
+                   "textureBinds", stats.fTextureBinds,
+                   "renderTargetChanges", stats.fRenderTargetChanges);
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats scissor",
+                   "scissorChanges", stats.fScissorChanges,
+                   "drawBufferFlushes", stats.fDrawBufferFlushes);
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats uploads",
+                   "bufferUploads", stats.fBufferUploads,
+                   "textureUploads", stats.fTextureUploads);
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats upload bytes",
+                   "bufferBytes", stats.fBufferUploadBytes,
+                   "textureBytes", stats.fTextureUploadBytes);
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats batching",
+                   "concatenatedDraws", stats.fConcatenatedDraws,
+                   "mergedDraws", stats.fMergedDraws);
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats bitmap atlas",
+                   "hits", stats.fBitmapAtlasHits, "misses", stats.fBitmapAtlasMisses);
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("skia.gpu"), "GrContext::GpuStats programs",
+                   "programCacheMisses", stats.fProgramCacheMisses,
+                   "programCompileMSecs", stats.fProgramCompileMSecs);
+}
+
+const GrContext::GpuStats& GrContext::getGpuStats() const {
+    return fGpu->getStats();
+}
+
+void GrContext::resetGpuStats() {
+    fGpu->stats()->reset();
 }
 
 bool GrContext::writeTexturePixels(GrTexture* texture,
@@ -1023,6 +1023,25 @@ public:
             return true;
         }
 
+        bool isEqual(const DeferredState& state) const {
+            if (fRenderTarget != state.fRenderTarget ||
+                fColorStageCnt != state.fColorStageCnt ||
+                fStages.count() != state.fStages.count() ||
+                fCommon != state.fCommon) {
+                return false;
+            }
+            bool explicitLocalCoords = -1 != fCommon.fFixedFunctionVertexAttribIndices[
+                                                        kLocalCoord_GrVertexAttribBinding];
+            for (int i = 0; i < fStages.count(); ++i) {
+                if (!fStages[i].isEqual(state.fStages[i], explicitLocalCoords)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        GrRenderTarget* getRenderTarget() const { return fRenderTarget; }
+
     private:
         typedef SkAutoSTArray<8, GrEffectStage::DeferredStage> DeferredStageArray;
 
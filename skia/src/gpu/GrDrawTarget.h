@@ -855,6 +855,7 @@ protected:
         DrawInfo() { fDevBounds = NULL; }
 
         friend class GrDrawTarget;
+        friend class GrInOrderDrawBuffer; // merges instanced draws at flush time
 
         GrPrimitiveType         fPrimitiveType;
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrPersistentCache.h"
+
+#include "SkChecksum.h"
+#include "SkData.h"
+#include "SkOSFile.h"
+#include "SkString.h"
+
+namespace {
+
+// Each entry is a file named after the hash of its key. The file starts with a header, then holds
+// the key (to detect hash collisions) and the data. The data checksum catches files that were
+// truncated or corrupted since they were written.
+struct FileHeader {
+    uint32_t fMagic;
+    uint32_t fKeySize;
+    uint32_t fDataSize;
+    uint32_t fDataChecksum;
+};
+
+static const uint32_t kFileMagic = SkSetFourByteTag('G', 'r', 'P', 'C');
+
+uint32_t hash_data(const SkData& data) {
+    size_t alignedSize = data.size() & ~3;
+    // SkData's storage is allocated with sk_malloc or comes from the client, either way it is at
+    // least 4 byte aligned.
+    SkASSERT(SkIsAlign4(reinterpret_cast<intptr_t>(data.data())));
+    uint32_t hash = SkChecksum::Murmur3(static_cast<const uint32_t*>(data.data()), alignedSize);
+    if (alignedSize != data.size()) {
+        uint32_t tail = 0;
+        memcpy(&tail, data.bytes() + alignedSize, data.size() - alignedSize);
+        hash = SkChecksum::Murmur3(&tail, sizeof(tail), hash);
+    }
+    return hash;
+}
+
+class GrFilePersistentCache : public GrPersistentCache {
+public:
+    GrFilePersistentCache(const char directory[]) : fDirectory(directory) {}
+
+    virtual SkData* load(const SkData& key) SK_OVERRIDE {
+        SkString path = this->pathForKey(key);
+        SkAutoTUnref<SkData> file(SkData::NewFromFileName(path.c_str()));
+        if (NULL == file.get() || file->size() < sizeof(FileHeader)) {
+            return NULL;
+        }
+        FileHeader header;
+        memcpy(&header, file->data(), sizeof(FileHeader));
+        if (kFileMagic != header.fMagic ||
+            header.fKeySize != key.size() ||
+            file->size() - sizeof(FileHeader) - header.fKeySize != header.fDataSize) {
+            return NULL;
+        }
+        const uint8_t* fileKey = file->bytes() + sizeof(FileHeader);
+        if (0 != memcmp(fileKey, key.data(), key.size())) {
+            // A different key that hashes to the same file name.
+            return NULL;
+        }
+        SkData* data = SkData::NewWithCopy(fileKey + header.fKeySize, header.fDataSize);
+        if (hash_data(*data) != header.fDataChecksum) {
+            data->unref();
+            return NULL;
+        }
+        return data;
+    }
+
+    virtual void store(const SkData& key, const SkData& data) SK_OVERRIDE {
+        SkString path = this->pathForKey(key);
+        SkFILE* file = sk_fopen(path.c_str(), kWrite_SkFILE_Flag);
+        if (NULL == file) {
+            return;
+        }
+        FileHeader header;
+        header.fMagic = kFileMagic;
+        header.fKeySize = SkToU32(key.size());
+        header.fDataSize = SkToU32(data.size());
+        header.fDataChecksum = hash_data(data);
+        // A short write leaves a file that load() rejects by its size.
+        if (sk_fwrite(&header, sizeof(header), file) == sizeof(header) &&
+            sk_fwrite(key.data(), key.size(), file) == key.size()) {
+            sk_fwrite(data.data(), data.size(), file);
+        }
+        sk_fclose(file);
+    }
+
+private:
+    SkString pathForKey(const SkData& key) const {
+        SkString name;
+        name.printf("%08x_%x.grpc", hash_data(key), SkToU32(key.size()));
+        return SkOSPath::SkPathJoin(fDirectory.c_str(), name.c_str());
+    }
+
+    SkString fDirectory;
+
+    typedef GrPersistentCache INHERITED;
+};
+
+}
+
+GrPersistentCache* GrPersistentCache::CreateFileCache(const char directory[]) {
+    if (NULL == directory || !sk_mkdir(directory)) {
+        return NULL;
+    }
+    return SkNEW_ARGS(GrFilePersistentCache, (directory));
+}
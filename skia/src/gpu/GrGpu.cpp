@@ -38,6 +38,7 @@ GrGpu::GrGpu(GrContext* context)
     , fQuadIndexBuffer(NULL) {
 
     fClipMaskManager.setGpu(this);
+    fStats.reset();
 
     fGeomPoolStateStack.push_back();
 #ifdef SK_DEBUG
@@ -134,6 +135,11 @@ GrTexture* GrGpu::createTexture(const GrTextureDesc& desc,
     } else {
         this->handleDirtyContext();
         tex = this->onCreateTexture(desc, srcData, rowBytes);
+        if (NULL != tex && NULL != srcData) {
+            ++fStats.fTextureUploads;
+            fStats.fTextureUploadBytes += desc.fWidth * desc.fHeight *
+                                          GrBytesPerPixel(desc.fConfig);
+        }
         if (NULL != tex &&
             (kRenderTarget_GrTextureFlagBit & desc.fFlags) &&
             !(kNoStencil_GrTextureFlagBit & desc.fFlags)) {
@@ -248,8 +254,13 @@ bool GrGpu::writeTexturePixels(GrTexture* texture,
                                GrPixelConfig config, const void* buffer,
                                size_t rowBytes) {
     this->handleDirtyContext();
-    return this->onWriteTexturePixels(texture, left, top, width, height,
-                                      config, buffer, rowBytes);
+    if (!this->onWriteTexturePixels(texture, left, top, width, height,
+                                    config, buffer, rowBytes)) {
+        return false;
+    }
+    ++fStats.fTextureUploads;
+    fStats.fTextureUploadBytes += width * height * GrBytesPerPixel(config);
+    return true;
 }
 
 void GrGpu::resolveRenderTarget(GrRenderTarget* target) {
@@ -390,6 +401,7 @@ void GrGpu::onDraw(const DrawInfo& info) {
                                       info.getDstCopy(), &are, info.getDevBounds())) {
         return;
     }
+    ++fStats.fDraws;
     this->onGpuDraw(info);
 }
 
@@ -415,6 +427,7 @@ void GrGpu::onDrawPath(const GrPath* path, SkPath::FillType fill,
     if (!this->setupClipAndFlushState(kDrawPath_DrawType, dstCopy, &are, NULL)) {
         return;
     }
+    ++fStats.fDraws;
 
     this->onGpuDrawPath(path, fill);
 }
@@ -431,6 +444,7 @@ void GrGpu::onDrawPaths(int pathCount, const GrPath** paths,
     if (!this->setupClipAndFlushState(kDrawPaths_DrawType, dstCopy, &are, NULL)) {
         return;
     }
+    ++fStats.fDraws;
 
     this->onGpuDrawPaths(pathCount, paths, transforms, fill, style);
 }
@@ -18,6 +18,7 @@ class GrIndexBufferAllocPool;
 class GrPath;
 class GrPathRenderer;
 class GrPathRendererChain;
+class GrPersistentCache;
 class GrStencilBuffer;
 class GrVertexBufferAllocPool;
 
@@ -54,6 +55,13 @@ public:
     GrContext* getContext() { return this->INHERITED::getContext(); }
     const GrContext* getContext() const { return this->INHERITED::getContext(); }
 
+    /**
+     * Counts of the work issued to the 3D API. These are incremented by GrGpu, its backend
+     * subclasses, and the draw buffer that plays back into it. See GrContext::getGpuStats().
+     */
+    GrContext::GpuStats* stats() { return &fStats; }
+    const GrContext::GpuStats& getStats() const { return fStats; }
+
     /**
      * The GrGpu object normally assumes that no outsider is setting state
      * within the underlying 3D API's context/device/whatever. This call informs
@@ -247,6 +255,19 @@ public:
      */
     virtual void abandonResources();
 
+    /**
+     * The maximum number of compiled shader programs the GrGpu keeps alive. Backends without a
+     * program cache ignore the limit and report 0.
+     */
+    virtual int getProgramCacheLimit() const { return 0; }
+    virtual void setProgramCacheLimit(int maxPrograms) {}
+
+    /**
+     * Sets the storage used to save compiled programs across runs. NULL disables it. Backends that
+     * can't save programs ignore it.
+     */
+    virtual void setPersistentCache(GrPersistentCache*) {}
+
     /**
      * Called to tell GrGpu to release all GrGpuObjects. Overrides must call
      * INHERITED::releaseResources().
@@ -342,6 +363,12 @@ public:
         kDrawPaths_DrawType,
     };
 
+    /**
+     * Compiles and caches the program that would be used to draw with the draw state, so that the
+     * first real draw doesn't pay for the compile. Returns false if no program was compiled.
+     */
+    virtual bool precompileProgram(const GrDrawState&, DrawType) { return false; }
+
 protected:
     DrawType PrimTypeToDrawType(GrPrimitiveType type) {
         switch (type) {
@@ -529,6 +556,7 @@ private:
     // Used to abandon/release all resources created by this GrGpu. TODO: Move this
     // functionality to GrResourceCache.
     ObjectList                                                          fObjectList;
+    GrContext::GpuStats                                                 fStats;
 
     typedef GrDrawTarget INHERITED;
 };
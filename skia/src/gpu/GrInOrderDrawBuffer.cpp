@@ -7,6 +7,7 @@
 
 #include "GrInOrderDrawBuffer.h"
 
+#include "GrBitmapAtlas.h"
 #include "GrBufferAllocPool.h"
 #include "GrDrawTargetCaps.h"
 #include "GrTextStrike.h"
@@ -39,6 +40,7 @@ GrInOrderDrawBuffer::GrInOrderDrawBuffer(GrGpu* gpu,
     GeometryPoolState& poolState = fGeoPoolStateStack.push_back();
     poolState.fUsedPoolVertexBytes = 0;
     poolState.fUsedPoolIndexBytes = 0;
+    poolState.fVertices = NULL;
 #ifdef SK_DEBUG
     poolState.fPoolVertexBuffer = (GrVertexBuffer*)~0;
     poolState.fPoolStartVertex = ~0;
@@ -89,9 +91,13 @@ extern const GrVertexAttrib kRectPosUVAttribs[] = {
     {kVec2f_GrVertexAttribType, sizeof(SkPoint), kLocalCoord_GrVertexAttribBinding},
 };
 
-static void set_vertex_attributes(GrDrawState* drawState,
-                                  bool hasColor, bool hasUVs,
-                                  int* colorOffset, int* localOffset) {
+};
+
+void GrInOrderDrawBuffer::SetRectVertexAttribs(GrDrawState* drawState,
+                                               const GrDrawTargetCaps& caps,
+                                               bool hasUVs,
+                                               int* colorOffset, int* localOffset) {
+    bool hasColor = caps.dualSourceBlendingSupport() || drawState->hasSolidCoverage();
     *colorOffset = -1;
     *localOffset = -1;
 
@@ -116,8 +122,6 @@ static void set_vertex_attributes(GrDrawState* drawState,
     }
 }
 
-};
-
 enum {
     kTraceCmdBit = 0x80,
     kCmdMask = 0x7f,
@@ -146,10 +150,7 @@ void GrInOrderDrawBuffer::onDrawRect(const SkRect& rect,
     GrColor color = drawState->getColor();
 
     int colorOffset, localOffset;
-    set_vertex_attributes(drawState,
-                   this->caps()->dualSourceBlendingSupport() || drawState->hasSolidCoverage(),
-                   NULL != localRect,
-                   &colorOffset, &localOffset);
+    SetRectVertexAttribs(drawState, *this->caps(), NULL != localRect, &colorOffset, &localOffset);
     if (colorOffset >= 0) {
         // We set the draw state's color to white here. This is done so that any batching performed
         // in our subclass's onDraw() won't get a false from GrDrawState::op== due to a color
@@ -159,12 +160,6 @@ void GrInOrderDrawBuffer::onDrawRect(const SkRect& rect,
         acr.set(drawState, 0xFFFFFFFF);
     }
 
-    AutoReleaseGeometry geo(this, 4, 0);
-    if (!geo.succeeded()) {
-        GrPrintf("Failed to get space for vertices!\n");
-        return;
-    }
-
     // Go to device coords to allow batching across matrix changes
     SkMatrix combinedMatrix;
     if (NULL != matrix) {
@@ -183,16 +178,33 @@ void GrInOrderDrawBuffer::onDrawRect(const SkRect& rect,
 
     size_t vsize = drawState->getVertexSize();
 
-    geo.positions()->setRectFan(rect.fLeft, rect.fTop, rect.fRight, rect.fBottom, vsize);
-    combinedMatrix.mapPointsWithStride(geo.positions(), vsize, 4);
+    SkPoint devQuad[4];
+    devQuad[0].setRectFan(rect.fLeft, rect.fTop, rect.fRight, rect.fBottom, sizeof(SkPoint));
+    combinedMatrix.mapPoints(devQuad, 4);
 
     SkRect devBounds;
     // since we already computed the dev verts, set the bounds hint. This will help us avoid
     // unnecessary clipping in our onDraw().
-    get_vertex_bounds(geo.vertices(), vsize, 4, &devBounds);
+    devBounds.set(devQuad, 4);
+
+    // Runs of rects with the same state (e.g. sprites drawn from one texture) skip the geometry
+    // reservation and the general draw path.
+    AutoReleaseGeometry geo;
+    void* vertices = this->appendQuadToPreviousDraw(devBounds);
+    if (NULL == vertices) {
+        if (!geo.set(this, 4, 0)) {
+            GrPrintf("Failed to get space for vertices!\n");
+            return;
+        }
+        vertices = geo.vertices();
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        *GrTCast<SkPoint*>(GrTCast<intptr_t>(vertices) + i * vsize) = devQuad[i];
+    }
 
     if (localOffset >= 0) {
-        SkPoint* coords = GrTCast<SkPoint*>(GrTCast<intptr_t>(geo.vertices()) + localOffset);
+        SkPoint* coords = GrTCast<SkPoint*>(GrTCast<intptr_t>(vertices) + localOffset);
         coords->setRectFan(localRect->fLeft, localRect->fTop,
                            localRect->fRight, localRect->fBottom,
                             vsize);
@@ -202,15 +214,17 @@ void GrInOrderDrawBuffer::onDrawRect(const SkRect& rect,
     }
 
     if (colorOffset >= 0) {
-        GrColor* vertColor = GrTCast<GrColor*>(GrTCast<intptr_t>(geo.vertices()) + colorOffset);
+        GrColor* vertColor = GrTCast<GrColor*>(GrTCast<intptr_t>(vertices) + colorOffset);
         for (int i = 0; i < 4; ++i) {
             *vertColor = color;
             vertColor = (GrColor*) ((intptr_t) vertColor + vsize);
         }
     }
 
-    this->setIndexSourceToBuffer(this->getContext()->getQuadIndexBuffer());
-    this->drawIndexedInstances(kTriangles_GrPrimitiveType, 1, 4, 6, &devBounds);
+    if (geo.succeeded()) {
+        this->setIndexSourceToBuffer(this->getContext()->getQuadIndexBuffer());
+        this->drawIndexedInstances(kTriangles_GrPrimitiveType, 1, 4, 6, &devBounds);
+    }
 
     // to ensure that stashing the drawState ptr is valid
     SkASSERT(this->drawState() == drawState);
@@ -258,7 +272,7 @@ bool GrInOrderDrawBuffer::quickInsideClip(const SkRect& devBounds) {
     return this->getClip()->fClipStack->quickContains(clipSpaceBounds);
 }
 
-int GrInOrderDrawBuffer::concatInstancedDraw(const DrawInfo& info) {
+int GrInOrderDrawBuffer::concatInstancedDraw(const DrawInfo& info, const SkRect* bounds) {
     SkASSERT(info.isInstanced());
 
     const GeometrySrcState& geomSrc = this->getGeomSrc();
@@ -307,7 +321,15 @@ int GrInOrderDrawBuffer::concatInstancedDraw(const DrawInfo& info) {
                          drawState.getVertexSize();
     poolState.fUsedPoolVertexBytes = SkTMax(poolState.fUsedPoolVertexBytes, vertexBytes);
 
+    if (NULL != bounds) {
+        draw->fBounds.join(*bounds);
+    } else {
+        draw->fCanReorder = false;
+    }
     draw->adjustInstanceCount(instancesToConcat);
+    if (instancesToConcat > 0) {
+        ++this->getContext()->getGpu()->stats()->fConcatenatedDraws;
+    }
 
     // update last fGpuCmdMarkers to include any additional trace markers that have been added
     if (this->getActiveTraceMarkers().count() > 0) {
@@ -340,6 +362,97 @@ private:
     GrDrawState*    fDrawState;
 };
 
+void* GrInOrderDrawBuffer::appendQuadToPreviousDraw(const SkRect& devBounds) {
+    const GrDrawState& drawState = this->getDrawState();
+    // Trace markers and dst copies are handled by the general path.
+    if (fCmds.empty() ||
+        kDraw_Cmd != fCmds.back() ||
+        this->getActiveTraceMarkers().count() > 0 ||
+        drawState.willEffectReadDstColor()) {
+        return NULL;
+    }
+
+    DrawRecord* draw = &fDraws.back();
+    const GrIndexBuffer* quadIndexBuffer = this->getContext()->getQuadIndexBuffer();
+    if (!draw->isInstanced() ||
+        kTriangles_GrPrimitiveType != draw->primitiveType() ||
+        4 != draw->verticesPerInstance() ||
+        6 != draw->indicesPerInstance() ||
+        draw->fIndexBuffer != quadIndexBuffer ||
+        draw->instanceCount() >= quadIndexBuffer->maxQuads()) {
+        return NULL;
+    }
+
+    // Match the clip and state that onDraw() would record for this quad.
+    AutoClipReenable acr;
+    if (drawState.isClipState() && this->quickInsideClip(devBounds)) {
+        acr.set(this->drawState());
+    }
+    if (this->needsNewClip() || this->needsNewState()) {
+        return NULL;
+    }
+
+    size_t vertexSize = drawState.getVertexSize();
+    const GrVertexBuffer* vertexBuffer;
+    int startVertex;
+    void* vertices = fVertexPool.makeSpace(vertexSize, 4, &vertexBuffer, &startVertex);
+    if (NULL == vertices) {
+        return NULL;
+    }
+    if (vertexBuffer != draw->fVertexBuffer ||
+        startVertex != draw->startVertex() + draw->vertexCount()) {
+        fVertexPool.putBack(4 * vertexSize);
+        return NULL;
+    }
+
+    if (draw->fCanReorder) {
+        // Same test as getReorderBounds(). The view matrix is identity in onDrawRect.
+        if (drawState.getStencil().isDisabled()) {
+            SkRect bounds = devBounds;
+            bounds.outset(SK_Scalar1, SK_Scalar1);
+            draw->fBounds.join(bounds);
+        } else {
+            draw->fCanReorder = false;
+        }
+    }
+    draw->adjustInstanceCount(1);
+    ++this->getContext()->getGpu()->stats()->fConcatenatedDraws;
+    return vertices;
+}
+
+bool GrInOrderDrawBuffer::getReorderBounds(const DrawInfo& info, SkRect* bounds) {
+    const GrDrawState& drawState = this->getDrawState();
+    // Draws that read the dst or use the stencil buffer depend on more than the pixels they cover.
+    if (NULL != info.getDstCopy() ||
+        !drawState.getStencil().isDisabled() ||
+        drawState.getViewMatrix().hasPerspective()) {
+        return false;
+    }
+    if (NULL != info.getDevBounds()) {
+        *bounds = *info.getDevBounds();
+    } else {
+        // Fall back to the vertex positions when they were written through this buffer.
+        const void* vertices = fGeoPoolStateStack.back().fVertices;
+        const GrVertexAttrib& position =
+            drawState.getVertexAttribs()[drawState.positionAttributeIndex()];
+        if (NULL == vertices ||
+            kBuffer_GeometrySrcType == this->getGeomSrc().fVertexSrc ||
+            kVec2f_GrVertexAttribType != position.fType ||
+            info.vertexCount() <= 0) {
+            return false;
+        }
+        size_t vertexSize = drawState.getVertexSize();
+        const void* positions = GrTCast<const void*>(GrTCast<intptr_t>(vertices) +
+                                                     info.startVertex() * vertexSize +
+                                                     position.fOffset);
+        get_vertex_bounds(positions, vertexSize, info.vertexCount(), bounds);
+        drawState.getViewMatrix().mapRect(bounds);
+    }
+    // Allow for antialiasing and pixel centers.
+    bounds->outset(SK_Scalar1, SK_Scalar1);
+    return bounds->isFinite();
+}
+
 void GrInOrderDrawBuffer::onDraw(const DrawInfo& info) {
 
     GeometryPoolState& poolState = fGeoPoolStateStack.back();
@@ -359,9 +472,12 @@ void GrInOrderDrawBuffer::onDraw(const DrawInfo& info) {
         this->recordState();
     }
 
+    SkRect bounds;
+    bool canReorder = this->getReorderBounds(info, &bounds);
+
     DrawRecord* draw;
     if (info.isInstanced()) {
-        int instancesConcated = this->concatInstancedDraw(info);
+        int instancesConcated = this->concatInstancedDraw(info, canReorder ? &bounds : NULL);
         if (info.instanceCount() > instancesConcated) {
             draw = this->recordDraw(info);
             draw->adjustInstanceCount(-instancesConcated);
@@ -371,6 +487,10 @@ void GrInOrderDrawBuffer::onDraw(const DrawInfo& info) {
     } else {
         draw = this->recordDraw(info);
     }
+    draw->fCanReorder = canReorder;
+    if (canReorder) {
+        draw->fBounds = bounds;
+    }
 
     switch (this->getGeomSrc().fVertexSrc) {
         case kBuffer_GeometrySrcType:
@@ -550,6 +670,7 @@ void GrInOrderDrawBuffer::reset() {
     fClipOrigins.reset();
     fCopySurfaces.reset();
     fGpuCmdMarkers.reset();
+    fPlayback.rewind();
     fClipSet = true;
 }
 
@@ -559,6 +680,7 @@ void GrInOrderDrawBuffer::flush() {
     }
 
     this->getContext()->getFontCache()->updateTextures();
+    this->getContext()->getBitmapAtlas()->uploadToTexture();
 
     SkASSERT(kReserved_GeometrySrcType != this->getGeomSrc().fVertexSrc);
     SkASSERT(kReserved_GeometrySrcType != this->getGeomSrc().fIndexSrc);
@@ -570,6 +692,14 @@ void GrInOrderDrawBuffer::flush() {
 
     GrAutoTRestore<bool> flushRestore(&fFlushing);
     fFlushing = true;
+    ++this->getContext()->getGpu()->stats()->fDrawBufferFlushes;
+
+    // Trace markers are attached to commands in recorded order so we don't reorder around them.
+    if (fDraws.count() > 1 && fGpuCmdMarkers.empty()) {
+        this->reorderDraws();
+    }
+    bool reordered = !fPlayback.isEmpty();
+    int numPlayback = reordered ? fPlayback.count() : numCmds;
 
     fVertexPool.unmap();
     fIndexPool.unmap();
@@ -595,17 +725,18 @@ void GrInOrderDrawBuffer::flush() {
     int currCmdMarker   = 0;
 
     fDstGpu->saveActiveTraceMarkers();
-    for (int c = 0; c < numCmds; ++c) {
+    for (int c = 0; c < numPlayback; ++c) {
+        uint8_t cmd = reordered ? fPlayback[c].fCmd : fCmds[c];
         GrGpuTraceMarker newMarker("", -1);
-        if (cmd_has_trace_marker(fCmds[c])) {
+        if (cmd_has_trace_marker(cmd)) {
             SkString traceString = fGpuCmdMarkers[currCmdMarker].toString();
             newMarker.fMarker = traceString.c_str();
             fDstGpu->addGpuTraceMarker(&newMarker);
             ++currCmdMarker;
         }
-        switch (strip_trace_bit(fCmds[c])) {
+        switch (strip_trace_bit(cmd)) {
             case kDraw_Cmd: {
-                const DrawRecord& draw = fDraws[currDraw];
+                const DrawRecord& draw = fDraws[reordered ? fPlayback[c].fIndex : currDraw];
                 fDstGpu->setVertexSourceToBuffer(draw.fVertexBuffer);
                 if (draw.isIndexed()) {
                     fDstGpu->setIndexSourceToBuffer(draw.fIndexBuffer);
@@ -638,15 +769,17 @@ void GrInOrderDrawBuffer::flush() {
                 break;
             }
             case kSetState_Cmd:
-                fStates[currState].restoreTo(&playbackState);
+                fStates[reordered ? fPlayback[c].fIndex : currState].restoreTo(&playbackState);
                 ++currState;
                 break;
-            case kSetClip_Cmd:
-                clipData.fClipStack = &fClips[currClip];
-                clipData.fOrigin = fClipOrigins[currClip];
+            case kSetClip_Cmd: {
+                int clip = reordered ? fPlayback[c].fIndex : currClip;
+                clipData.fClipStack = &fClips[clip];
+                clipData.fOrigin = fClipOrigins[clip];
                 fDstGpu->setClip(&clipData);
                 ++currClip;
                 break;
+            }
             case kClear_Cmd:
                 if (GrColor_ILLEGAL == fClears[currClear].fColor) {
                     fDstGpu->discard(fClears[currClear].fRenderTarget);
@@ -666,17 +799,18 @@ void GrInOrderDrawBuffer::flush() {
                 ++currCopySurface;
                 break;
         }
-        if (cmd_has_trace_marker(fCmds[c])) {
+        if (cmd_has_trace_marker(cmd)) {
             fDstGpu->removeGpuTraceMarker(&newMarker);
         }
     }
     fDstGpu->restoreActiveTraceMarkers();
-    // we should have consumed all the states, clips, etc.
-    SkASSERT(fStates.count() == currState);
-    SkASSERT(fClips.count() == currClip);
-    SkASSERT(fClipOrigins.count() == currClip);
+    // we should have consumed all the states, clips, etc. Reordering skips redundant states and
+    // clips and merges draws.
+    SkASSERT(reordered || fStates.count() == currState);
+    SkASSERT(reordered || fClips.count() == currClip);
+    SkASSERT(reordered || fClipOrigins.count() == currClip);
     SkASSERT(fClears.count() == currClear);
-    SkASSERT(fDraws.count()  == currDraw);
+    SkASSERT(reordered || fDraws.count()  == currDraw);
     SkASSERT(fCopySurfaces.count() == currCopySurface);
     SkASSERT(fGpuCmdMarkers.count() == currCmdMarker);
 
@@ -686,6 +820,260 @@ void GrInOrderDrawBuffer::flush() {
     ++fDrawID;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// A run of draws, in recorded order, that share a state and clip and will be played back together.
+struct GrInOrderDrawBuffer::DrawBatch {
+    int     fHead;
+    int     fTail;
+    int     fState;
+    int     fClip;
+    // Union of the member's bounds. Only meaningful when fCanReorder is true.
+    SkRect  fBounds;
+    bool    fCanReorder;
+};
+
+namespace {
+// How many batches back a draw may be moved. This bounds the cost of reordering at O(draws).
+static const int kMaxBatchLookBack = 16;
+// Merged quads are addressed by 16 bit indices relative to the first quad's vertex.
+static const int kMaxMergedVertexSpan = 1 << 16;
+static const uint16_t kQuadIndexPattern[] = { 0, 1, 2, 0, 2, 3 };
+}
+
+bool GrInOrderDrawBuffer::statesMatch(int stateA, int stateB) const {
+    return stateA == stateB ||
+           (stateA >= 0 && stateB >= 0 && fStates[stateA].isEqual(fStates[stateB]));
+}
+
+bool GrInOrderDrawBuffer::clipsMatch(int clipA, int clipB) const {
+    return clipA == clipB ||
+           (clipA >= 0 && clipB >= 0 &&
+            fClips[clipA] == fClips[clipB] &&
+            fClipOrigins[clipA] == fClipOrigins[clipB]);
+}
+
+void GrInOrderDrawBuffer::addToPlayback(uint8_t cmd, int index) {
+    PlaybackCmd* playback = fPlayback.append();
+    playback->fCmd = cmd;
+    playback->fIndex = index;
+}
+
+void GrInOrderDrawBuffer::reorderDraws() {
+    SkASSERT(fPlayback.isEmpty());
+    SkASSERT(fGpuCmdMarkers.empty());
+
+    int numDraws = fDraws.count();
+    SkAutoTMalloc<int> nextInBatch(numDraws);
+    SkTDArray<DrawBatch> batches;
+
+    int currState = -1;
+    int currClip = -1;
+    int currDraw = 0;
+    int emittedState = -1;
+    int emittedClip = -1;
+
+    int numCmds = fCmds.count();
+    for (int c = 0; c < numCmds; ++c) {
+        uint8_t cmd = strip_trace_bit(fCmds[c]);
+        switch (cmd) {
+            case kSetState_Cmd:
+                ++currState;
+                break;
+            case kSetClip_Cmd:
+                ++currClip;
+                break;
+            case kDraw_Cmd: {
+                int d = currDraw++;
+                const DrawRecord& draw = fDraws[d];
+                nextInBatch[d] = -1;
+                // Look for an earlier batch with the same state and clip. The draw may only be
+                // moved past batches that render to the same target and that it doesn't overlap.
+                int target = -1;
+                int stop = SkTMax(0, batches.count() - kMaxBatchLookBack);
+                for (int b = batches.count() - 1; b >= stop; --b) {
+                    const DrawBatch& batch = batches[b];
+                    if (this->statesMatch(batch.fState, currState) &&
+                        this->clipsMatch(batch.fClip, currClip)) {
+                        target = b;
+                        break;
+                    }
+                    if (!draw.fCanReorder || !batch.fCanReorder ||
+                        currState < 0 || batch.fState < 0 ||
+                        fStates[batch.fState].getRenderTarget() !=
+                            fStates[currState].getRenderTarget() ||
+                        SkRect::Intersects(batch.fBounds, draw.fBounds)) {
+                        break;
+                    }
+                }
+                if (target >= 0) {
+                    DrawBatch& batch = batches[target];
+                    nextInBatch[batch.fTail] = d;
+                    batch.fTail = d;
+                    batch.fCanReorder = batch.fCanReorder && draw.fCanReorder;
+                    if (batch.fCanReorder) {
+                        batch.fBounds.join(draw.fBounds);
+                    }
+                } else {
+                    DrawBatch* batch = batches.append();
+                    batch->fHead = batch->fTail = d;
+                    batch->fState = currState;
+                    batch->fClip = currClip;
+                    batch->fCanReorder = draw.fCanReorder;
+                    if (draw.fCanReorder) {
+                        batch->fBounds = draw.fBounds;
+                    }
+                }
+                break;
+            }
+            default:
+                // Everything else is played back in order after all preceding draws.
+                this->emitDrawBatches(batches, nextInBatch.get(), &emittedState, &emittedClip);
+                batches.rewind();
+                if (kStencilPath_Cmd == cmd || kDrawPath_Cmd == cmd || kDrawPaths_Cmd == cmd) {
+                    if (currClip >= 0 && !this->clipsMatch(emittedClip, currClip)) {
+                        this->addToPlayback(kSetClip_Cmd, currClip);
+                        emittedClip = currClip;
+                    }
+                    if (currState >= 0 && !this->statesMatch(emittedState, currState)) {
+                        this->addToPlayback(kSetState_Cmd, currState);
+                        emittedState = currState;
+                    }
+                }
+                this->addToPlayback(cmd, -1);
+                break;
+        }
+    }
+    this->emitDrawBatches(batches, nextInBatch.get(), &emittedState, &emittedClip);
+}
+
+void GrInOrderDrawBuffer::emitDrawBatches(const SkTDArray<DrawBatch>& batches,
+                                          const int* nextInBatch,
+                                          int* emittedState,
+                                          int* emittedClip) {
+    const GrIndexBuffer* quadIndexBuffer = this->getContext()->getQuadIndexBuffer();
+    SkSTArray<16, int, true> run;
+    for (int b = 0; b < batches.count(); ++b) {
+        const DrawBatch& batch = batches[b];
+        if (batch.fClip >= 0 && !this->clipsMatch(*emittedClip, batch.fClip)) {
+            this->addToPlayback(kSetClip_Cmd, batch.fClip);
+            *emittedClip = batch.fClip;
+        }
+        if (batch.fState >= 0 && !this->statesMatch(*emittedState, batch.fState)) {
+            this->addToPlayback(kSetState_Cmd, batch.fState);
+            *emittedState = batch.fState;
+        }
+        // Consecutive quad draws from the same vertex buffer are merged into one indexed draw.
+        int runStart = 0;
+        int runEnd = 0;
+        run.reset();
+        for (int d = batch.fHead; d >= 0; d = nextInBatch[d]) {
+            const DrawRecord& draw = fDraws[d];
+            bool isQuads = draw.isInstanced() &&
+                           kTriangles_GrPrimitiveType == draw.primitiveType() &&
+                           4 == draw.verticesPerInstance() &&
+                           6 == draw.indicesPerInstance() &&
+                           quadIndexBuffer == draw.fIndexBuffer;
+            if (run.count() > 0) {
+                const DrawRecord& first = fDraws[run[0]];
+                int start = SkTMin(runStart, draw.startVertex());
+                int end = SkTMax(runEnd, draw.startVertex() + draw.vertexCount());
+                if (!isQuads ||
+                    first.fVertexBuffer != draw.fVertexBuffer ||
+                    end - start > kMaxMergedVertexSpan) {
+                    this->emitMergedDraws(run.begin(), run.count());
+                    run.reset();
+                }
+            }
+            if (!isQuads) {
+                this->addToPlayback(kDraw_Cmd, d);
+                continue;
+            }
+            if (run.empty()) {
+                runStart = draw.startVertex();
+                runEnd = draw.startVertex() + draw.vertexCount();
+            } else {
+                runStart = SkTMin(runStart, draw.startVertex());
+                runEnd = SkTMax(runEnd, draw.startVertex() + draw.vertexCount());
+            }
+            run.push_back(d);
+        }
+        if (run.count() > 0) {
+            this->emitMergedDraws(run.begin(), run.count());
+        }
+    }
+}
+
+void GrInOrderDrawBuffer::emitMergedDraws(const int* draws, int count) {
+    SkASSERT(count > 0);
+    if (1 == count) {
+        this->addToPlayback(kDraw_Cmd, draws[0]);
+        return;
+    }
+    int quadCount = 0;
+    int startVertex = fDraws[draws[0]].startVertex();
+    int endVertex = startVertex;
+    for (int i = 0; i < count; ++i) {
+        const DrawRecord& draw = fDraws[draws[i]];
+        quadCount += draw.instanceCount();
+        startVertex = SkTMin(startVertex, draw.startVertex());
+        endVertex = SkTMax(endVertex, draw.startVertex() + draw.vertexCount());
+    }
+    SkASSERT(endVertex - startVertex <= kMaxMergedVertexSpan);
+
+    const GrIndexBuffer* indexBuffer;
+    int startIndex;
+    uint16_t* indices = static_cast<uint16_t*>(fIndexPool.makeSpace(6 * quadCount,
+                                                                    &indexBuffer,
+                                                                    &startIndex));
+    if (NULL == indices) {
+        for (int i = 0; i < count; ++i) {
+            this->addToPlayback(kDraw_Cmd, draws[i]);
+        }
+        return;
+    }
+
+    SkRect devBounds;
+    devBounds.setEmpty();
+    bool hasDevBounds = true;
+    for (int i = 0; i < count; ++i) {
+        const DrawRecord& draw = fDraws[draws[i]];
+        int quadVertex = draw.startVertex() - startVertex;
+        for (int q = 0; q < draw.instanceCount(); ++q) {
+            for (int j = 0; j < 6; ++j) {
+                *indices++ = SkToU16(quadVertex + kQuadIndexPattern[j]);
+            }
+            quadVertex += 4;
+        }
+        if (NULL != draw.getDevBounds()) {
+            devBounds.join(*draw.getDevBounds());
+        } else {
+            hasDevBounds = false;
+        }
+    }
+
+    // The first draw of the run becomes a non-instanced indexed draw of all the quads. The others
+    // are dropped from playback; their buffer refs are released by reset().
+    DrawRecord& draw = fDraws[draws[0]];
+    draw.fIndexBuffer->unref();
+    draw.fIndexBuffer = indexBuffer;
+    indexBuffer->ref();
+    draw.fStartVertex = startVertex;
+    draw.fVertexCount = endVertex - startVertex;
+    draw.fStartIndex = startIndex;
+    draw.fIndexCount = 6 * quadCount;
+    draw.fInstanceCount = 0;
+    draw.fVerticesPerInstance = 0;
+    draw.fIndicesPerInstance = 0;
+    if (hasDevBounds) {
+        draw.setDevBounds(devBounds);
+    } else {
+        draw.fDevBounds = NULL;
+    }
+    this->addToPlayback(kDraw_Cmd, draws[0]);
+    this->getContext()->getGpu()->stats()->fMergedDraws += count - 1;
+}
+
 bool GrInOrderDrawBuffer::onCopySurface(GrSurface* dst,
                                         GrSurface* src,
                                         const SkIRect& srcRect,
@@ -790,6 +1178,7 @@ bool GrInOrderDrawBuffer::onReserveVertexSpace(size_t vertexSize,
                                       vertexCount,
                                       &poolState.fPoolVertexBuffer,
                                       &poolState.fPoolStartVertex);
+    poolState.fVertices = *vertices;
     return NULL != *vertices;
 }
 
@@ -824,6 +1213,7 @@ void GrInOrderDrawBuffer::releaseReservedVertexSpace() {
     poolState.fUsedPoolVertexBytes = 0;
     poolState.fPoolVertexBuffer = NULL;
     poolState.fPoolStartVertex = 0;
+    poolState.fVertices = NULL;
 }
 
 void GrInOrderDrawBuffer::releaseReservedIndexSpace() {
@@ -858,6 +1248,7 @@ void GrInOrderDrawBuffer::onSetVertexSourceToArray(const void* vertexArray,
                                &poolState.fPoolVertexBuffer,
                                &poolState.fPoolStartVertex);
     GR_DEBUGASSERT(success);
+    poolState.fVertices = vertexArray;
 }
 
 void GrInOrderDrawBuffer::onSetIndexSourceToArray(const void* indexArray,
@@ -890,6 +1281,7 @@ void GrInOrderDrawBuffer::geometrySourceWillPush() {
     GeometryPoolState& poolState = fGeoPoolStateStack.push_back();
     poolState.fUsedPoolVertexBytes = 0;
     poolState.fUsedPoolIndexBytes = 0;
+    poolState.fVertices = NULL;
 #ifdef SK_DEBUG
     poolState.fPoolVertexBuffer = (GrVertexBuffer*)~0;
     poolState.fPoolStartVertex = ~0;
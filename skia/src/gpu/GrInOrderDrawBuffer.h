@@ -14,6 +14,7 @@
 #include "GrPath.h"
 
 #include "SkClipStack.h"
+#include "SkTDArray.h"
 #include "SkTemplates.h"
 #include "SkTypes.h"
 
@@ -63,6 +64,18 @@ public:
      */
     void flush();
 
+    /**
+     * Sets the vertex layout that onDrawRect() writes rects with on drawState: positions, then a
+     * color if caps support dual-source blending or the state has solid coverage, then local
+     * coords if hasUVs. colorOffset and localOffset are set to where those are in a vertex, or to -1
+     * if the layout doesn't have them. When there is a color the state's color should be white.
+     */
+    static void SetRectVertexAttribs(GrDrawState* drawState,
+                                     const GrDrawTargetCaps& caps,
+                                     bool hasUVs,
+                                     int* colorOffset,
+                                     int* localOffset);
+
     // tracking for draws
     virtual DrawToken getCurrentDrawToken() { return DrawToken(this, fDrawID); }
 
@@ -95,9 +108,21 @@ private:
 
     class DrawRecord : public DrawInfo {
     public:
-        DrawRecord(const DrawInfo& info) : DrawInfo(info) {}
+        DrawRecord(const DrawInfo& info) : DrawInfo(info), fCanReorder(false) {}
         const GrVertexBuffer*   fVertexBuffer;
         const GrIndexBuffer*    fIndexBuffer;
+        // Conservative device space bounds of the draw. Only valid when fCanReorder is true, in
+        // which case the draw may be moved past other draws that it does not overlap.
+        SkRect                  fBounds;
+        bool                    fCanReorder;
+    };
+
+    // When the draws are reordered at flush time the commands are played back from this list
+    // rather than from fCmds. The index refers into the record array of the command's type.
+    // Clears, copies, and path commands are never reordered and are consumed in sequence.
+    struct PlaybackCmd {
+        uint8_t fCmd;
+        int     fIndex;
     };
 
     struct StencilPath : public ::SkNoncopyable {
@@ -192,7 +217,30 @@ private:
 
     // Attempts to concat instances from info onto the previous draw. info must represent an
     // instanced draw. The caller must have already recorded a new draw state and clip if necessary.
-    int concatInstancedDraw(const DrawInfo& info);
+    // If bounds is not NULL it is the conservative device space bounds of info's geometry.
+    int concatInstancedDraw(const DrawInfo& info, const SkRect* bounds);
+
+    // Fast path for onDrawRect. If the previous command is a quad draw with the current draw state
+    // and clip, and its vertices end where the vertex pool's free space begins, this grows it by
+    // one quad and returns the space for the quad's vertices. Otherwise returns NULL and nothing
+    // is recorded. devBounds are the device space bounds of the quad.
+    void* appendQuadToPreviousDraw(const SkRect& devBounds);
+
+    // Computes conservative device space bounds for a draw about to be recorded. Returns false if
+    // the draw must not be reordered relative to other draws.
+    bool getReorderBounds(const DrawInfo& info, SkRect* bounds);
+
+    // Fills fPlayback with an order of the recorded commands in which draws that share a state and
+    // clip are brought together, when doing so cannot change the result, and merges runs of quads
+    // drawn with the shared quad index buffer into single draws.
+    struct DrawBatch;
+    void reorderDraws();
+    bool statesMatch(int stateA, int stateB) const;
+    bool clipsMatch(int clipA, int clipB) const;
+    void emitDrawBatches(const SkTDArray<DrawBatch>& batches, const int* nextInBatch,
+                         int* emittedState, int* emittedClip);
+    void emitMergedDraws(const int* draws, int count);
+    void addToPlayback(uint8_t cmd, int index);
 
     // we lazily record state and clip changes in order to skip clips and states that have no
     // effect.
@@ -234,6 +282,7 @@ private:
     GrSTAllocator<kClipPreallocCnt, SkClipStack>                       fClips;
     GrSTAllocator<kClipPreallocCnt, SkIPoint>                          fClipOrigins;
     SkTArray<GrTraceMarkerSet, false>                                  fGpuCmdMarkers;
+    SkTDArray<PlaybackCmd>                                             fPlayback;
 
     GrDrawTarget*                   fDstGpu;
 
@@ -261,6 +310,8 @@ private:
         // can only do this if there isn't an intervening pushGeometrySource()
         size_t                          fUsedPoolVertexBytes;
         size_t                          fUsedPoolIndexBytes;
+        // CPU copy of the current vertex source when it is reserved or an array, else NULL.
+        const void*                     fVertices;
     };
     SkSTArray<kGeoPoolStatePreAllocCnt, GeometryPoolState> fGeoPoolStateStack;
 
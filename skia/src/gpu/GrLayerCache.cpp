@@ -6,6 +6,7 @@
  */
 
 #include "GrAtlas.h"
+#include "GrContext.h"
 #include "GrGpu.h"
 #include "GrLayerCache.h"
 
@@ -42,40 +43,43 @@ private:
 };
 
 GrLayerCache::GrLayerCache(GrGpu* gpu)
-    : fGpu(SkRef(gpu))
-    , fLayerPool(16) {      // TODO: may need to increase this later
+    : fGpu(SkRef(gpu)) {
 }
 
 GrLayerCache::~GrLayerCache() {
+    this->freeAll();
 }
 
-void GrLayerCache::init() {
+void GrLayerCache::initAtlas() {
     static const int kAtlasTextureWidth = 1024;
     static const int kAtlasTextureHeight = 1024;
+    static const int kNumPlotsX = 2;
+    static const int kNumPlotsY = 2;
 
     SkASSERT(NULL == fAtlasMgr.get());
 
-    // The layer cache only gets 1 plot
+    // The layers are drawn directly into the atlas, so its texture must be a render target
     SkISize textureSize = SkISize::Make(kAtlasTextureWidth, kAtlasTextureHeight);
     fAtlasMgr.reset(SkNEW_ARGS(GrAtlasMgr, (fGpu, kSkia8888_GrPixelConfig,
-                                            textureSize, 1, 1, false)));
+                                            kRenderTarget_GrTextureFlagBit, textureSize,
+                                            kNumPlotsX, kNumPlotsY, false)));
+    fPlotUsage.reset(SkNEW(GrAtlas));
 }
 
 void GrLayerCache::freeAll() {
     fLayerHash.deleteAll();
+
+    fPlotUsage.free();
     fAtlasMgr.free();
 }
 
 GrCachedLayer* GrLayerCache::createLayer(const SkPicture* picture, int layerID) {
-    GrCachedLayer* layer = fLayerPool.alloc();
-
     SkASSERT(picture->uniqueID() != SK_InvalidGenID);
-    layer->init(picture->uniqueID(), layerID);
+    GrCachedLayer* layer = SkNEW_ARGS(GrCachedLayer, (picture->uniqueID(), layerID));
     fLayerHash.insert(PictureLayerKey(picture->uniqueID(), layerID), layer);
     return layer;
 }
 
-
 GrCachedLayer* GrLayerCache::findLayerOrCreate(const SkPicture* picture, int layerID) {
     SkASSERT(picture->uniqueID() != SK_InvalidGenID);
     GrCachedLayer* layer = fLayerHash.find(PictureLayerKey(picture->uniqueID(), layerID));
@@ -84,3 +88,80 @@ GrCachedLayer* GrLayerCache::findLayerOrCreate(const SkPicture* picture, int lay
     }
     return layer;
 }
+
+bool GrLayerCache::lock(GrCachedLayer* layer, const GrTextureDesc& desc, bool* needsRendering) {
+    GrDrawTarget::DrawToken drawToken =
+                            fGpu->getContext()->getTextTarget()->getCurrentDrawToken();
+
+    if (NULL != layer->getTexture()) {
+        // The layer was rendered on an earlier draw and its pixels are still valid
+        layer->plot()->setDrawToken(drawToken);
+        *needsRendering = false;
+        return true;
+    }
+
+    if (NULL == fAtlasMgr.get()) {
+        this->initAtlas();
+    }
+
+    // Reserve room for the layer in the atlas. Its pixels are drawn there directly
+    // by the caller so nothing needs to be uploaded.
+    SkIPoint16 loc;
+    GrPlot* plot = fAtlasMgr->addToAtlas(fPlotUsage.get(), desc.fWidth, desc.fHeight,
+                                         NULL, &loc);
+    if (NULL == plot && this->purgeUnusedPlot()) {
+        plot = fAtlasMgr->addToAtlas(fPlotUsage.get(), desc.fWidth, desc.fHeight,
+                                     NULL, &loc);
+    }
+    if (NULL == plot) {
+        // The layer is too big for a plot or every plot is in use by a pending draw
+        return false;
+    }
+
+    GrIRect16 bounds;
+    bounds.set(SkIRect::MakeXYWH(loc.fX, loc.fY, desc.fWidth, desc.fHeight));
+    layer->setPlot(plot);
+    layer->setTexture(SkRef(plot->texture()), bounds);
+    plot->setDrawToken(drawToken);
+
+    *needsRendering = true;
+    return true;
+}
+
+void GrLayerCache::unlock(GrCachedLayer* layer) {
+    // The atlas space is reclaimed when the layer's plot is purged
+    layer->setPlot(NULL);
+    layer->setTexture(NULL, GrIRect16::MakeEmpty());
+}
+
+bool GrLayerCache::purgeUnusedPlot() {
+    GrPlot* plot = fAtlasMgr->getUnusedPlot();
+    if (NULL == plot) {
+        return false;
+    }
+
+    SkTDArray<GrCachedLayer*>& layers = fLayerHash.getArray();
+    for (int i = 0; i < layers.count(); ++i) {
+        if (plot == layers[i]->plot()) {
+            this->unlock(layers[i]);
+        }
+    }
+
+    fAtlasMgr->removePlot(fPlotUsage.get(), plot);
+    plot->resetRects();
+    return true;
+}
+
+void GrLayerCache::purge(const SkPicture* picture) {
+    SkTDArray<GrCachedLayer*>& layers = fLayerHash.getArray();
+    // Removing a layer only moves the layers after it, so walk the array backwards.
+    for (int i = layers.count() - 1; i >= 0; --i) {
+        GrCachedLayer* layer = layers[i];
+        if (picture->uniqueID() == layer->pictureID()) {
+            // The layer's space in its plot is reclaimed along with the plot's
+            // other layers when the plot is purged.
+            fLayerHash.remove(PictureLayerKey(layer->pictureID(), layer->layerID()), layer);
+            SkDELETE(layer);
+        }
+    }
+}
@@ -8,11 +8,11 @@
 #ifndef GrLayerCache_DEFINED
 #define GrLayerCache_DEFINED
 
-#include "GrAllocPool.h"
 #include "GrTHashTable.h"
 #include "GrPictureUtils.h"
 #include "GrRect.h"
 
+class GrAtlas;
 class GrAtlasMgr;
 class GrGpu;
 class GrPlot;
@@ -30,7 +30,7 @@ public:
         fBounds = bounds;
     }
 
-    const GrPlot* plot() const {
+    GrPlot* plot() const {
         return fPlot;
     }
 
@@ -45,34 +45,39 @@ private:
 
 // GrCachedLayer encapsulates the caching information for a single saveLayer.
 //
-// Atlased layers get a ref to their atlas GrTexture and their GrAtlasLocation
-// is filled in.
-// In this case GrCachedLayer is roughly equivalent to a GrGlyph in the font
+// Cached layers get a ref to their atlas GrTexture and their GrAtlasLocation
+// is filled in. GrCachedLayer is roughly equivalent to a GrGlyph in the font
 // caching system.
-//
-// Non-atlased layers get a ref to the GrTexture in which they reside.
-// TODO: can we easily reuse the empty space in the non-atlased GrTexture's?
 struct GrCachedLayer {
 public:
-    uint32_t pictureID() const { return fPictureID; }
-    int layerID() const { return fLayerID; }
-
-    void init(uint32_t pictureID, int layerID) {
-        fPictureID = pictureID;
-        fLayerID   = layerID;
-        fTexture   = NULL;
+    GrCachedLayer(uint32_t pictureID, int layerID)
+        : fPictureID(pictureID)
+        , fLayerID(layerID)
+        , fTexture(NULL) {
         fLocation.set(NULL, GrIRect16::MakeEmpty());
     }
 
-    // This call takes over the caller's ref
-    void setTexture(GrTexture* texture) {
+    ~GrCachedLayer() {
+        SkSafeUnref(fTexture);
+    }
+
+    uint32_t pictureID() const { return fPictureID; }
+    int layerID() const { return fLayerID; }
+
+    // This call takes over the caller's ref. bounds is where the layer's pixels are in texture.
+    void setTexture(GrTexture* texture, const GrIRect16& bounds) {
         if (NULL != fTexture) {
             fTexture->unref();
         }
 
         fTexture = texture; // just take over caller's ref
+        fLocation.set(fLocation.plot(), bounds);
     }
     GrTexture* getTexture() { return fTexture; }
+    const GrIRect16& bounds() const { return fLocation.bounds(); }
+
+    void setPlot(GrPlot* plot) { fLocation.set(plot, fLocation.bounds()); }
+    GrPlot* plot() const { return fLocation.plot(); }
 
 private:
     uint32_t        fPictureID;
@@ -80,21 +85,23 @@ private:
     // is the index of this layer in the picture (one of 0 .. #layers).
     int             fLayerID;
 
-    // fTexture is a ref on the atlasing texture for atlased layers and a
-    // ref on a GrTexture for non-atlased textures. In both cases, if this is
-    // non-NULL, that means that the texture is locked in the texture cache.
+    // fTexture is a ref on the atlas texture. If this is non-NULL the layer's
+    // pixels are valid at fLocation.
     GrTexture*      fTexture;
 
-    GrAtlasLocation fLocation;       // only valid if the layer is atlased
+    GrAtlasLocation fLocation;       // only valid if fTexture is non-NULL
 };
 
 // The GrLayerCache caches pre-computed saveLayers for later rendering.
-// Non-atlased layers are stored in their own GrTexture while the atlased
-// layers share a single GrTexture.
-// Unlike the GrFontCache, the GrTexture atlas only has one GrAtlasMgr (for 8888)
-// and one GrPlot (for the entire atlas). As such, the GrLayerCache
-// roughly combines the functionality of the GrFontCache and GrTextStrike
-// classes.
+// The layers share a single GrTexture atlas. Layers that can't be given room in
+// the atlas aren't cached and must be drawn normally.
+// Unlike the GrFontCache, the GrTexture atlas only has one GrAtlasMgr (for 8888),
+// whose texture is a render target the layers are drawn into. As such, the
+// GrLayerCache roughly combines the functionality of the GrFontCache and
+// GrTextStrike classes.
+// Since pictures are immutable a layer stays valid for as long as its picture
+// is alive, so layers are kept across draws until their picture is purged or
+// the atlas space they use is needed for other layers.
 class GrLayerCache {
 public:
     GrLayerCache(GrGpu*);
@@ -104,17 +111,33 @@ public:
 
     GrCachedLayer* findLayerOrCreate(const SkPicture* picture, int id);
 
+    // Gives the layer room of the size in desc in the atlas and keeps the
+    // layer from being evicted until the next flush. Sets needsRendering to
+    // true if the layer's pixels aren't valid yet. Returns false if there is
+    // no room for the layer.
+    bool lock(GrCachedLayer* layer, const GrTextureDesc& desc, bool* needsRendering);
+
+    // Releases the layer's place in the atlas so that its contents must be
+    // rendered again before it is used.
+    void unlock(GrCachedLayer* layer);
+
+    // Removes all the layers of picture from the cache.
+    void purge(const SkPicture* picture);
+
 private:
     SkAutoTUnref<GrGpu>       fGpu;
-    SkAutoTDelete<GrAtlasMgr> fAtlasMgr; // TODO: could lazily allocate
+    SkAutoTDelete<GrAtlasMgr> fAtlasMgr;
+    SkAutoTDelete<GrAtlas>    fPlotUsage;   // the plots in use by layers
 
     class PictureLayerKey;
     GrTHashTable<GrCachedLayer, PictureLayerKey, 7> fLayerHash;
-    GrTAllocPool<GrCachedLayer> fLayerPool;
 
-    void init();
+    void initAtlas();
     GrCachedLayer* createLayer(const SkPicture* picture, int id);
 
+    // Unlocks all the layers in the least recently used plot that isn't used
+    // by a pending draw. Returns false if there is no such plot.
+    bool purgeUnusedPlot();
 };
 
 #endif
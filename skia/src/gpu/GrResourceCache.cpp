@@ -10,6 +10,7 @@
 
 #include "GrResourceCache.h"
 #include "GrCacheable.h"
+#include "GrTexture.h"
 
 DECLARE_SKMESSAGEBUS_MESSAGE(GrResourceInvalidatedMessage);
 
@@ -43,7 +44,9 @@ GrResourceCacheEntry::GrResourceCacheEntry(GrResourceCache* resourceCache,
           fKey(key),
           fResource(resource),
           fCachedSize(resource->gpuMemorySize()),
-          fIsExclusive(false) {
+          fIsExclusive(false),
+          fCategory(GrResourceCache::CategoryForKey(key)),
+          fLastUsedFlush(0) {
     // we assume ownership of the resource, and will unref it when we die
     SkASSERT(resource);
     resource->ref();
@@ -91,6 +94,15 @@ GrResourceCache::GrResourceCache(int maxCount, size_t maxBytes) :
     fClientDetachedCount          = 0;
     fClientDetachedBytes          = 0;
 
+    for (int i = 0; i < kGrResourceCategoryCnt; ++i) {
+        fCategoryCount[i]         = 0;
+        fCategoryBytes[i]         = 0;
+        fCategoryMaxBytes[i]      = (size_t) -1;
+    }
+
+    fFlushCount                   = 0;
+    fMaxUnusedFlushes             = 0;
+
     fPurging                      = false;
 
     fOverbudgetCB                 = NULL;
@@ -136,6 +148,38 @@ void GrResourceCache::setLimits(int maxResources, size_t maxResourceBytes) {
     }
 }
 
+GrResourceCategory GrResourceCache::CategoryForKey(const GrResourceKey& key) {
+    if (key.isScratch()) {
+        return kScratch_GrResourceCategory;
+    }
+    if (GrTextureImpl::IsTextureKey(key)) {
+        return kTexture_GrResourceCategory;
+    }
+    return kOther_GrResourceCategory;
+}
+
+void GrResourceCache::setCategoryLimit(GrResourceCategory category, size_t maxBytes) {
+    bool smaller = maxBytes < fCategoryMaxBytes[category];
+
+    fCategoryMaxBytes[category] = maxBytes;
+
+    if (smaller) {
+        this->purgeAsNeeded();
+    }
+}
+
+void GrResourceCache::setMaxUnusedFlushes(int flushes) {
+    SkASSERT(flushes >= 0);
+    fMaxUnusedFlushes = flushes;
+}
+
+void GrResourceCache::didFlush() {
+    ++fFlushCount;
+    if (fMaxUnusedFlushes > 0) {
+        this->purgeUnusedFor(fMaxUnusedFlushes);
+    }
+}
+
 void GrResourceCache::internalDetach(GrResourceCacheEntry* entry,
                                      BudgetBehaviors behavior) {
     fList.remove(entry);
@@ -159,12 +203,15 @@ void GrResourceCache::internalDetach(GrResourceCacheEntry* entry,
 
         fEntryCount -= 1;
         fEntryBytes -= entry->fCachedSize;
+        fCategoryCount[entry->fCategory] -= 1;
+        fCategoryBytes[entry->fCategory] -= entry->fCachedSize;
     }
 }
 
 void GrResourceCache::attachToHead(GrResourceCacheEntry* entry,
                                    BudgetBehaviors behavior) {
     fList.addToHead(entry);
+    entry->fLastUsedFlush = fFlushCount;
 
     // update our stats
     if (kIgnore_BudgetBehavior == behavior) {
@@ -175,6 +222,8 @@ void GrResourceCache::attachToHead(GrResourceCacheEntry* entry,
 
         fEntryCount += 1;
         fEntryBytes += entry->fCachedSize;
+        fCategoryCount[entry->fCategory] += 1;
+        fCategoryBytes[entry->fCategory] += entry->fCachedSize;
 
 #if GR_CACHE_STATS
         if (fHighWaterEntryCount < fEntryCount) {
@@ -246,6 +295,10 @@ void GrResourceCache::addResource(const GrResourceKey& key,
         this->makeExclusive(entry);
     }
 
+    // The caller made room in the cache as a whole, but not in the resource's category.
+    if (fCategoryBytes[entry->fCategory] > fCategoryMaxBytes[entry->fCategory]) {
+        this->purgeAsNeeded();
+    }
 }
 
 void GrResourceCache::makeExclusive(GrResourceCacheEntry* entry) {
@@ -275,6 +328,8 @@ void GrResourceCache::removeInvalidResource(GrResourceCacheEntry* entry) {
     fEntryCount -= 1;
     fClientDetachedBytes -= entry->fCachedSize;
     fEntryBytes -= entry->fCachedSize;
+    fCategoryCount[entry->fCategory] -= 1;
+    fCategoryBytes[entry->fCategory] -= entry->fCachedSize;
     entry->fCachedSize = 0;
 }
 
@@ -301,6 +356,7 @@ void GrResourceCache::makeNonExclusive(GrResourceCacheEntry* entry) {
 
 void GrResourceCache::didIncreaseResourceSize(const GrResourceCacheEntry* entry, size_t amountInc) {
     fEntryBytes += amountInc;
+    fCategoryBytes[entry->fCategory] += amountInc;
     if (entry->fIsExclusive) {
         fClientDetachedBytes += amountInc;
     }
@@ -309,6 +365,7 @@ void GrResourceCache::didIncreaseResourceSize(const GrResourceCacheEntry* entry,
 
 void GrResourceCache::didDecreaseResourceSize(const GrResourceCacheEntry* entry, size_t amountDec) {
     fEntryBytes -= amountDec;
+    fCategoryBytes[entry->fCategory] -= amountDec;
     if (entry->fIsExclusive) {
         fClientDetachedBytes -= amountDec;
     }
@@ -386,6 +443,15 @@ void GrResourceCache::deleteResource(GrResourceCacheEntry* entry) {
 void GrResourceCache::internalPurge(int extraCount, size_t extraBytes) {
     SkASSERT(fPurging);
 
+    // Categories over their own limit are purged first, so that they don't evict the resources
+    // of other categories when the cache as a whole is over budget.
+    for (int i = 0; i < kGrResourceCategoryCnt; ++i) {
+        GrResourceCategory category = static_cast<GrResourceCategory>(i);
+        if (fCategoryBytes[category] > fCategoryMaxBytes[category]) {
+            this->internalPurgeCategory(category, fCategoryMaxBytes[category]);
+        }
+    }
+
     bool withinBudget = false;
     bool changed = false;
 
@@ -421,6 +487,80 @@ void GrResourceCache::internalPurge(int extraCount, size_t extraBytes) {
     } while (!withinBudget && changed);
 }
 
+void GrResourceCache::internalPurgeCategory(GrResourceCategory category, size_t maxBytes) {
+    SkASSERT(fPurging);
+
+    bool changed;
+    do {
+        EntryList::Iter iter;
+
+        changed = false;
+
+        GrResourceCacheEntry* entry = iter.init(fList, EntryList::Iter::kTail_IterStart);
+
+        while (NULL != entry && fCategoryBytes[category] > maxBytes) {
+            GrAutoResourceCacheValidate atcv(this);
+
+            GrResourceCacheEntry* prev = iter.prev();
+            if (category == entry->fCategory && entry->fResource->unique()) {
+                changed = true;
+                this->deleteResource(entry);
+            }
+            entry = prev;
+        }
+    } while (changed && fCategoryBytes[category] > maxBytes);
+}
+
+void GrResourceCache::internalPurgeUnusedFor(int flushes) {
+    SkASSERT(fPurging);
+
+    bool changed;
+    do {
+        EntryList::Iter iter;
+
+        changed = false;
+
+        // The list is ordered by last use, so the walk can stop at the first entry that was used
+        // recently.
+        GrResourceCacheEntry* entry = iter.init(fList, EntryList::Iter::kTail_IterStart);
+
+        while (NULL != entry &&
+               fFlushCount - entry->fLastUsedFlush >= static_cast<uint32_t>(flushes)) {
+            GrAutoResourceCacheValidate atcv(this);
+
+            GrResourceCacheEntry* prev = iter.prev();
+            if (entry->fResource->unique()) {
+                changed = true;
+                this->deleteResource(entry);
+            }
+            entry = prev;
+        }
+    } while (changed);
+}
+
+void GrResourceCache::purgeUnusedFor(int flushes) {
+    SkASSERT(flushes >= 0);
+    if (fPurging) {
+        return;
+    }
+
+    fPurging = true;
+    this->purgeInvalidated();
+    this->internalPurgeUnusedFor(flushes);
+    fPurging = false;
+}
+
+void GrResourceCache::purgeCategory(GrResourceCategory category) {
+    if (fPurging) {
+        return;
+    }
+
+    fPurging = true;
+    this->purgeInvalidated();
+    this->internalPurgeCategory(category, 0);
+    fPurging = false;
+}
+
 void GrResourceCache::purgeAllUnlocked() {
     GrAutoResourceCacheValidate atcv(this);
 
@@ -481,6 +621,15 @@ void GrResourceCache::validate() const {
     SkASSERT(fClientDetachedCount <= fEntryCount);
     SkASSERT((fEntryCount - fClientDetachedCount) == fCache.count());
 
+    int categoryCount = 0;
+    size_t categoryBytes = 0;
+    for (int i = 0; i < kGrResourceCategoryCnt; ++i) {
+        categoryCount += fCategoryCount[i];
+        categoryBytes += fCategoryBytes[i];
+    }
+    SkASSERT(categoryCount == fEntryCount);
+    SkASSERT(categoryBytes == fEntryBytes);
+
     EntryList::Iter iter;
 
     // check that the exclusively held entries are okay
@@ -538,6 +687,12 @@ void GrResourceCache::printStats() {
                 fClientDetachedCount, fHighWaterClientDetachedCount);
     SkDebugf("\t\tDetached Bytes: current %d high %d\n",
                 fClientDetachedBytes, fHighWaterClientDetachedBytes);
+    static const char* kCategoryNames[] = { "Scratch", "Texture", "Other" };
+    GR_STATIC_ASSERT(SK_ARRAY_COUNT(kCategoryNames) == kGrResourceCategoryCnt);
+    for (int i = 0; i < kGrResourceCategoryCnt; ++i) {
+        SkDebugf("\t\t%s: count %d bytes %d\n",
+                 kCategoryNames[i], fCategoryCount[i], fCategoryBytes[i]);
+    }
 }
 
 #endif
@@ -142,11 +142,14 @@ private:
                          GrCacheable* resource);
     ~GrResourceCacheEntry();
 
-    GrResourceCache* fResourceCache;
-    GrResourceKey    fKey;
-    GrCacheable*     fResource;
-    size_t           fCachedSize;
-    bool             fIsExclusive;
+    GrResourceCache*    fResourceCache;
+    GrResourceKey       fKey;
+    GrCacheable*        fResource;
+    size_t              fCachedSize;
+    bool                fIsExclusive;
+    GrResourceCategory  fCategory;
+    // The value of the cache's flush counter when the entry was last found or added.
+    uint32_t            fLastUsedFlush;
 
     // Linked list for the LRU ordering.
     SK_DECLARE_INTERNAL_LLIST_INTERFACE(GrResourceCacheEntry);
@@ -167,6 +170,12 @@ private:
  *  head of the list. If/when we must purge some of the entries, we walk the
  *  list backwards from the tail, since those are the least recently used.
  *
+ *  Each entry belongs to a GrResourceCategory, which can have a byte limit of
+ *  its own. Entries of a category that is over its limit are purged before
+ *  any others. The cache also counts flushes, so entries that haven't been
+ *  used for a number of flushes can be purged even when the cache is within
+ *  its limits.
+ *
  *  For fast searches, we maintain a hash map based on the GrResourceKey.
  *
  *  It is a goal to make the GrResourceCache the central repository and bookkeeper
@@ -218,6 +227,64 @@ public:
         fOverbudgetData = data;
     }
 
+    /**
+     *  Returns the category of the resources cached with key.
+     */
+    static GrResourceCategory CategoryForKey(const GrResourceKey& key);
+
+    /**
+     *  Returns the maximum number of bytes of gpu memory the resources of
+     *  category can hold. By default the categories have no limit beyond the
+     *  cache's own.
+     */
+    size_t getCategoryLimit(GrResourceCategory category) const {
+        return fCategoryMaxBytes[category];
+    }
+
+    /**
+     *  Specify the maximum number of bytes of gpu memory the resources of
+     *  category can hold. If the category exceeds it, its least recently used
+     *  resources are purged even if the cache is within its own limits.
+     */
+    void setCategoryLimit(GrResourceCategory category, size_t maxBytes);
+
+    /**
+     *  Returns the number of resources and bytes of category, including
+     *  resources that are exclusively held.
+     */
+    int getCategoryResourceCount(GrResourceCategory category) const {
+        return fCategoryCount[category];
+    }
+    size_t getCategoryResourceBytes(GrResourceCategory category) const {
+        return fCategoryBytes[category];
+    }
+
+    /**
+     *  Advances the cache's flush counter. Called each time the context
+     *  flushes. If a maximum age has been set, resources that have not been
+     *  used for that many flushes are purged.
+     */
+    void didFlush();
+
+    /**
+     *  Returns the number of flushes after which an unused resource is purged.
+     *  0, the default, means resources are only purged to stay within the
+     *  limits.
+     */
+    int getMaxUnusedFlushes() const { return fMaxUnusedFlushes; }
+    void setMaxUnusedFlushes(int flushes);
+
+    /**
+     *  Removes every unlocked resource that hasn't been found or added during
+     *  the last 'flushes' flushes. Passing 0 removes every unlocked resource.
+     */
+    void purgeUnusedFor(int flushes);
+
+    /**
+     *  Removes every unlocked resource of category.
+     */
+    void purgeCategory(GrResourceCategory category);
+
     /**
      * Returns the number of bytes consumed by cached resources.
      */
@@ -362,6 +429,13 @@ private:
     int            fClientDetachedCount;
     size_t         fClientDetachedBytes;
 
+    int            fCategoryCount[kGrResourceCategoryCnt];
+    size_t         fCategoryBytes[kGrResourceCategoryCnt];
+    size_t         fCategoryMaxBytes[kGrResourceCategoryCnt];
+
+    uint32_t       fFlushCount;
+    int            fMaxUnusedFlushes;
+
     // prevents recursive purging
     bool           fPurging;
 
@@ -369,6 +443,9 @@ private:
     void*          fOverbudgetData;
 
     void internalPurge(int extraCount, size_t extraBytes);
+    // Purges unlocked resources of category until it holds at most maxBytes.
+    void internalPurgeCategory(GrResourceCategory category, size_t maxBytes);
+    void internalPurgeUnusedFor(int flushes);
 
     // Listen for messages that a resource has been invalidated and purge cached junk proactively.
     SkMessageBus<GrResourceInvalidatedMessage>::Inbox fInvalidationInbox;
@@ -24,6 +24,12 @@
 #define GR_NUM_PLOTS_X   (GR_ATLAS_TEXTURE_WIDTH / GR_PLOT_WIDTH)
 #define GR_NUM_PLOTS_Y   (GR_ATLAS_TEXTURE_HEIGHT / GR_PLOT_HEIGHT)
 
+// Text with many distinct glyphs (e.g. CJK) can reference every plot of a page in a single
+// flush. Up to this many pages are allocated per mask format before we resort to flushing.
+#ifndef GR_ATLAS_MAX_PAGES
+#define GR_ATLAS_MAX_PAGES 4
+#endif
+
 #define FONT_CACHE_STATS 0
 #if FONT_CACHE_STATS
 static int g_PurgeCount = 0;
@@ -83,10 +89,12 @@ GrTextStrike* GrFontCache::generateStrike(GrFontScaler* scaler,
         SkISize textureSize = SkISize::Make(GR_ATLAS_TEXTURE_WIDTH,
                                             GR_ATLAS_TEXTURE_HEIGHT);
         fAtlasMgr[atlasIndex] = SkNEW_ARGS(GrAtlasMgr, (fGpu, config,
+                                                        kDynamicUpdate_GrTextureFlagBit,
                                                         textureSize,
                                                         GR_NUM_PLOTS_X,
                                                         GR_NUM_PLOTS_Y,
-                                                        true));
+                                                        true,
+                                                        GR_ATLAS_MAX_PAGES));
     }
     GrTextStrike* strike = SkNEW_ARGS(GrTextStrike,
                                       (this, scaler->getKey(), format, fAtlasMgr[atlasIndex]));
@@ -128,7 +136,9 @@ bool GrFontCache::freeUnusedPlot(GrTextStrike* preserveStrike) {
     GrAtlasMgr* atlasMgr = preserveStrike->fAtlasMgr;
     GrPlot* plot = atlasMgr->getUnusedPlot();
     if (NULL == plot) {
-        return false;
+        // Every plot is referenced by a pending draw. Rather than making the caller flush, add a
+        // page of empty plots if we are allowed to.
+        return atlasMgr->addPage();
     }
     plot->resetRects();
 
@@ -191,13 +201,13 @@ void GrFontCache::dump() const {
     static int gDumpCount = 0;
     for (int i = 0; i < kAtlasCount; ++i) {
         if (NULL != fAtlasMgr[i]) {
-            GrTexture* texture = fAtlasMgr[i]->getTexture();
-            if (NULL != texture) {
+            for (int page = 0; page < fAtlasMgr[i]->pageCount(); ++page) {
+                GrTexture* texture = fAtlasMgr[i]->getTexture(page);
                 SkString filename;
 #ifdef SK_BUILD_FOR_ANDROID
-                filename.printf("/sdcard/fontcache_%d%d.png", gDumpCount, i);
+                filename.printf("/sdcard/fontcache_%d%d_%d.png", gDumpCount, i, page);
 #else
-                filename.printf("fontcache_%d%d.png", gDumpCount, i);
+                filename.printf("fontcache_%d%d_%d.png", gDumpCount, i, page);
 #endif
                 texture->savePixels(filename.c_str());
             }
@@ -79,7 +79,8 @@ public:
 
     void freeAll();
 
-    // make an unused plot available
+    // make an unused plot available, either by evicting the least recently used plot whose draws
+    // have been issued or by adding an atlas page
     bool freeUnusedPlot(GrTextStrike* preserveStrike);
 
     // testing
@@ -235,6 +235,10 @@ GrResourceKey GrTextureImpl::ComputeScratchKey(const GrTextureDesc& desc) {
     return GrResourceKey(cacheID, texture_resource_type(), 0);
 }
 
+bool GrTextureImpl::IsTextureKey(const GrResourceKey& key) {
+    return texture_resource_type() == key.getResourceType();
+}
+
 bool GrTextureImpl::NeedsResizing(const GrResourceKey& key) {
     return SkToBool(key.getResourceFlags() & kStretchToPOT_TextureFlag);
 }
@@ -12,6 +12,7 @@
 #include "effects/GrTextureDomain.h"
 #include "effects/GrSimpleTextureEffect.h"
 
+#include "GrBitmapAtlas.h"
 #include "GrContext.h"
 #include "GrBitmapTextContext.h"
 #include "GrDistanceFieldTextContext.h"
@@ -1323,20 +1324,34 @@ void SkGpuDevice::internalDrawBitmap(const SkBitmap& bitmap,
     SkASSERT(bitmap.width() <= fContext->getMaxTextureSize() &&
              bitmap.height() <= fContext->getMaxTextureSize());
 
-    GrTexture* texture;
-    SkAutoCachedTexture act(this, bitmap, &params, &texture);
+    // Small bitmaps are drawn from a texture shared with other small bitmaps so that draws of
+    // different bitmaps can be batched. srcRect is moved to where the bitmap is in the atlas.
+    GrTexture* texture = NULL;
+    SkRect textureSrcRect = srcRect;
+    if (!bicubic && GrBitmapAtlas::CanAtlas(bitmap, params)) {
+        SkIPoint16 location;
+        texture = fContext->getBitmapAtlas()->findOrAddBitmap(bitmap, &location);
+        if (NULL != texture) {
+            textureSrcRect.offset(SkIntToScalar(location.fX), SkIntToScalar(location.fY));
+        }
+    }
+
+    SkAutoCachedTexture act;
     if (NULL == texture) {
-        return;
+        texture = act.set(this, bitmap, &params);
+        if (NULL == texture) {
+            return;
+        }
     }
 
     SkRect dstRect = {0, 0, srcRect.width(), srcRect.height() };
     SkRect paintRect;
     SkScalar wInv = SkScalarInvert(SkIntToScalar(texture->width()));
     SkScalar hInv = SkScalarInvert(SkIntToScalar(texture->height()));
-    paintRect.setLTRB(SkScalarMul(srcRect.fLeft,   wInv),
-                      SkScalarMul(srcRect.fTop,    hInv),
-                      SkScalarMul(srcRect.fRight,  wInv),
-                      SkScalarMul(srcRect.fBottom, hInv));
+    paintRect.setLTRB(SkScalarMul(textureSrcRect.fLeft,   wInv),
+                      SkScalarMul(textureSrcRect.fTop,    hInv),
+                      SkScalarMul(textureSrcRect.fRight,  wInv),
+                      SkScalarMul(textureSrcRect.fBottom, hInv));
 
     SkRect textureDomain = SkRect::MakeEmpty();
     SkAutoTUnref<GrEffectRef> effect;
@@ -1372,7 +1387,15 @@ void SkGpuDevice::internalDrawBitmap(const SkBitmap& bitmap,
         SkShader::TileMode tileModes[2] = { params.getTileModeX(), params.getTileModeY() };
         effect.reset(GrBicubicEffect::Create(texture, SkMatrix::I(), tileModes));
     } else {
-        effect.reset(GrSimpleTextureEffect::Create(texture, SkMatrix::I(), params));
+        // The cached effect holds a ref on its texture, so comparing the pointers is safe.
+        if (NULL == fCachedBitmapEffect.get() ||
+            (*fCachedBitmapEffect)->texture(0) != texture ||
+            fCachedBitmapEffectParams != params) {
+            fCachedBitmapEffect.reset(GrSimpleTextureEffect::Create(texture, SkMatrix::I(),
+                                                                    params));
+            fCachedBitmapEffectParams = params;
+        }
+        effect.reset(SkRef(fCachedBitmapEffect.get()));
     }
 
     // Construct a GrPaint by setting the bitmap texture as the first effect and then configuring
@@ -1838,7 +1861,7 @@ static void wrap_texture(GrTexture* texture, int width, int height, SkBitmap* re
 }
 
 void SkGpuDevice::EXPERIMENTAL_purge(const SkPicture* picture) {
-
+    fContext->getLayerCache()->purge(picture);
 }
 
 bool SkGpuDevice::EXPERIMENTAL_drawPicture(SkCanvas* canvas, const SkPicture* picture) {
@@ -1937,79 +1960,101 @@ bool SkGpuDevice::EXPERIMENTAL_drawPicture(SkCanvas* canvas, const SkPicture* pi
         }
     }
 
+    if (NULL == picture->fPlayback) {
+        return false;
+    }
+
+    GrLayerCache* layerCache = fContext->getLayerCache();
     SkPicturePlayback::PlaybackReplacements replacements;
+    SkBitmap atlasBitmap;   // all the cached layers are drawn from the atlas
+    SkTDArray<GrCachedLayer*> needRendering;
 
+    // Find a home for all the layers before rendering any of them. Locking a layer can
+    // evict the layers of an atlas plot that isn't used by a pending draw, and rendering
+    // may flush, which would make the plots of the layers locked so far evictable.
     for (int i = 0; i < gpuData->numSaveLayers(); ++i) {
-        if (pullForward[i]) {
-            GrCachedLayer* layer = fContext->getLayerCache()->findLayerOrCreate(picture, i);
-
-            const GPUAccelData::SaveLayerInfo& info = gpuData->saveLayerInfo(i);
-
-            if (NULL != picture->fPlayback) {
-                SkPicturePlayback::PlaybackReplacements::ReplacementInfo* layerInfo =
-                                                                        replacements.push();
-                layerInfo->fStart = info.fSaveLayerOpID;
-                layerInfo->fStop = info.fRestoreOpID;
-                layerInfo->fPos = info.fOffset;
-
-                GrTextureDesc desc;
-                desc.fFlags = kRenderTarget_GrTextureFlagBit;
-                desc.fWidth = info.fSize.fWidth;
-                desc.fHeight = info.fSize.fHeight;
-                desc.fConfig = kSkia8888_GrPixelConfig;
-                // TODO: need to deal with sample count
-
-                bool bNeedsRendering = true;
-
-                // This just uses scratch textures and doesn't cache the texture.
-                // This can yield a lot of re-rendering
-                if (NULL == layer->getTexture()) {
-                    layer->setTexture(fContext->lockAndRefScratchTexture(desc,
-                                                        GrContext::kApprox_ScratchTexMatch));
-                    if (NULL == layer->getTexture()) {
-                        continue;
-                    }
-                } else {
-                    bNeedsRendering = false;
-                }
+        if (!pullForward[i]) {
+            continue;
+        }
 
-                layerInfo->fBM = SkNEW(SkBitmap);
-                wrap_texture(layer->getTexture(), desc.fWidth, desc.fHeight, layerInfo->fBM);
+        GrCachedLayer* layer = layerCache->findLayerOrCreate(picture, i);
 
-                SkASSERT(info.fPaint);
-                layerInfo->fPaint = info.fPaint;
+        const GPUAccelData::SaveLayerInfo& info = gpuData->saveLayerInfo(i);
 
-                if (bNeedsRendering) {
-                    SkAutoTUnref<SkSurface> surface(SkSurface::NewRenderTargetDirect(
-                                                        layer->getTexture()->asRenderTarget()));
+        GrTextureDesc desc;
+        desc.fFlags = kRenderTarget_GrTextureFlagBit;
+        desc.fWidth = info.fSize.fWidth;
+        desc.fHeight = info.fSize.fHeight;
+        desc.fConfig = kSkia8888_GrPixelConfig;
+        // TODO: need to deal with sample count
 
-                    SkCanvas* canvas = surface->getCanvas();
+        bool needsRendering;
+        if (!layerCache->lock(layer, desc, &needsRendering)) {
+            continue;
+        }
 
-                    canvas->setMatrix(info.fCTM);
-                    canvas->clear(SK_ColorTRANSPARENT);
+        if (needsRendering) {
+            *needRendering.append() = layer;
+        }
 
-                    picture->fPlayback->setDrawLimits(info.fSaveLayerOpID, info.fRestoreOpID);
-                    picture->fPlayback->draw(*canvas, NULL);
-                    picture->fPlayback->setDrawLimits(0, 0);
-                    canvas->flush();
-                }
-            }
+        SkPicturePlayback::PlaybackReplacements::ReplacementInfo* layerInfo =
+                                                                    replacements.push();
+        layerInfo->fStart = info.fSaveLayerOpID;
+        layerInfo->fStop = info.fRestoreOpID;
+        layerInfo->fPos = info.fOffset;
+
+        const GrIRect16& bounds = layer->bounds();
+        layerInfo->fSrcRect = SkIRect::MakeLTRB(bounds.fLeft, bounds.fTop,
+                                                bounds.fRight, bounds.fBottom);
+        if (NULL == atlasBitmap.getTexture()) {
+            wrap_texture(layer->getTexture(), layer->getTexture()->width(),
+                         layer->getTexture()->height(), &atlasBitmap);
         }
+        SkASSERT(atlasBitmap.getTexture() == layer->getTexture());
+        layerInfo->fBM = &atlasBitmap;
+
+        SkASSERT(info.fPaint);
+        layerInfo->fPaint = info.fPaint;
     }
 
-    // Playback using new layers
-    picture->fPlayback->setReplacements(&replacements);
-    picture->fPlayback->draw(*canvas, NULL);
-    picture->fPlayback->setReplacements(NULL);
+    // Render the layers that aren't already cached from an earlier draw. The
+    // layers share a render target so each one is clipped to its own rect.
+    if (needRendering.count() > 0) {
+        SkAutoTUnref<SkSurface> surface(SkSurface::NewRenderTargetDirect(
+                                    needRendering[0]->getTexture()->asRenderTarget()));
 
-    for (int i = 0; i < gpuData->numSaveLayers(); ++i) {
-        GrCachedLayer* layer = fContext->getLayerCache()->findLayerOrCreate(picture, i);
+        SkCanvas* layerCanvas = surface->getCanvas();
 
-        if (NULL != layer->getTexture()) {
-            fContext->unlockScratchTexture(layer->getTexture());
-            layer->setTexture(NULL);
+        for (int i = 0; i < needRendering.count(); ++i) {
+            GrCachedLayer* layer = needRendering[i];
+            const GPUAccelData::SaveLayerInfo& info = gpuData->saveLayerInfo(layer->layerID());
+
+            const GrIRect16& bounds = layer->bounds();
+            SkRect bound = SkRect::MakeLTRB(SkIntToScalar(bounds.fLeft),
+                                            SkIntToScalar(bounds.fTop),
+                                            SkIntToScalar(bounds.fRight),
+                                            SkIntToScalar(bounds.fBottom));
+
+            layerCanvas->save();
+            layerCanvas->clipRect(bound);
+            layerCanvas->translate(bound.fLeft, bound.fTop);
+            // clear() ignores the clip and would wipe the other layers in the atlas
+            layerCanvas->drawColor(SK_ColorTRANSPARENT, SkXfermode::kSrc_Mode);
+            layerCanvas->concat(info.fCTM);
+
+            picture->fPlayback->setDrawLimits(info.fSaveLayerOpID, info.fRestoreOpID);
+            picture->fPlayback->draw(*layerCanvas, NULL);
+            picture->fPlayback->setDrawLimits(0, 0);
+
+            layerCanvas->restore();
         }
     }
 
+    // Playback using new layers. The layers stay in the cache so later draws of
+    // the picture can reuse them.
+    picture->fPlayback->setReplacements(&replacements);
+    picture->fPlayback->draw(*canvas, NULL);
+    picture->fPlayback->setReplacements(NULL);
+
     return true;
 }
@@ -279,6 +279,12 @@ const GrGLInterface* GrGLAssembleGLInterface(void* ctx, GrGLGetProc get) {
         GET_PROC_SUFFIX(PopGroupMarker, EXT);
     }
 
+    if (glVer >= GR_GL_VER(4,1) || extensions.has("GL_ARB_get_program_binary")) {
+        GET_PROC(GetProgramBinary);
+        GET_PROC(ProgramBinary);
+        GET_PROC(ProgramParameteri);
+    }
+
     if (glVer >= GR_GL_VER(4,3) || extensions.has("GL_ARB_invalidate_subdata")) {
         GET_PROC(InvalidateBufferData);
         GET_PROC(InvalidateBufferSubData);
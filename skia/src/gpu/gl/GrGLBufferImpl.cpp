@@ -151,6 +151,9 @@ void GrGLBufferImpl::unmap(GrGpuGL* gpu) {
                 GR_GL_CALL(gpu->glInterface(), UnmapBufferSubData(fMapPtr));
                 break;
         }
+        // We don't know how much of the mapped buffer was written.
+        ++gpu->stats()->fBufferUploads;
+        gpu->stats()->fBufferUploadBytes += fGLSizeInBytes;
     }
     fMapPtr = NULL;
 }
@@ -172,6 +175,8 @@ bool GrGLBufferImpl::updateData(GrGpuGL* gpu, const void* src, size_t srcSizeInB
     }
     this->bind(gpu);
     GrGLenum usage = fDesc.fDynamic ? DYNAMIC_USAGE_PARAM : GR_GL_STATIC_DRAW;
+    ++gpu->stats()->fBufferUploads;
+    gpu->stats()->fBufferUploadBytes += srcSizeInBytes;
 
 #if GR_GL_USE_BUFFER_DATA_NULL_HINT
     if (fDesc.fSizeInBytes == srcSizeInBytes) {
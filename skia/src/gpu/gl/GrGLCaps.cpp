@@ -48,6 +48,7 @@ void GrGLCaps::reset() {
     fIsCoreProfile = false;
     fFullClearIsFree = false;
     fDropsTileOnZeroDivide = false;
+    fProgramBinarySupport = false;
 }
 
 GrGLCaps::GrGLCaps(const GrGLCaps& caps) : GrDrawTargetCaps() {
@@ -86,6 +87,7 @@ GrGLCaps& GrGLCaps::operator= (const GrGLCaps& caps) {
     fIsCoreProfile = caps.fIsCoreProfile;
     fFullClearIsFree = caps.fFullClearIsFree;
     fDropsTileOnZeroDivide = caps.fDropsTileOnZeroDivide;
+    fProgramBinarySupport = caps.fProgramBinarySupport;
 
     return *this;
 }
@@ -242,6 +244,14 @@ bool GrGLCaps::init(const GrGLContextInfo& ctxInfo, const GrGLInterface* gli) {
     // Adreno GPUs have a tendency to drop tiles when there is a divide-by-zero in a shader
     fDropsTileOnZeroDivide = kQualcomm_GrGLVendor == ctxInfo.vendor();
 
+    // The entry points are only loaded when the version or extension provides them. Drivers may
+    // still support no binary formats at all, in which case the binaries are useless.
+    if (NULL != gli->fFunctions.fGetProgramBinary && NULL != gli->fFunctions.fProgramBinary) {
+        GrGLint formatCount = 0;
+        GR_GL_GetIntegerv(gli, GR_GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        fProgramBinarySupport = formatCount > 0;
+    }
+
     this->initFSAASupport(ctxInfo, gli);
     this->initStencilFormats(ctxInfo);
 
@@ -788,5 +798,6 @@ SkString GrGLCaps::dump() const {
              (fUseNonVBOVertexAndIndexDynamicData ? "YES" : "NO"));
     r.appendf("Full screen clear is free: %s\n", (fFullClearIsFree ? "YES" : "NO"));
     r.appendf("Drops tile on zero divide: %s\n", (fDropsTileOnZeroDivide ? "YES" : "NO"));
+    r.appendf("Program binary support: %s\n", (fProgramBinarySupport ? "YES" : "NO"));
     return r;
 }
@@ -262,6 +262,9 @@ public:
 
     bool dropsTileOnZeroDivide() const { return fDropsTileOnZeroDivide; }
 
+    /// Can linked programs be retrieved and reloaded with glGetProgramBinary/glProgramBinary?
+    bool programBinarySupport() const { return fProgramBinarySupport; }
+
     /**
      * Returns a string containing the caps info.
      */
@@ -363,6 +366,7 @@ private:
     bool fIsCoreProfile : 1;
     bool fFullClearIsFree : 1;
     bool fDropsTileOnZeroDivide : 1;
+    bool fProgramBinarySupport : 1;
 
     typedef GrDrawTargetCaps INHERITED;
 };
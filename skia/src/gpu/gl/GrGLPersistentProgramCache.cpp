@@ -0,0 +1,200 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrGLPersistentProgramCache.h"
+
+#include "GrGLContext.h"
+#include "GrGLProgramDesc.h"
+#include "GrGLUtil.h"
+#include "SkBuffer.h"
+#include "SkWriter32.h"
+
+#define GL_CALL(X) GR_GL_CALL(fGLContext.interface(), X)
+
+namespace {
+
+// Bump these when the layout of the key or the entry changes.
+static const uint32_t kKeyVersion = 1;
+static const uint32_t kEntryMagic = SkSetFourByteTag('G', 'r', 'P', 'E');
+static const uint32_t kEntryVersion = 1;
+
+// Binaries larger than this are assumed to be garbage.
+static const GrGLint kMaxBinarySize = 16 * 1024 * 1024;
+
+void write_blob(SkWriter32* writer, const void* data, size_t size) {
+    writer->write32(SkToU32(size));
+    writer->writePad(data, size);
+}
+
+bool read_blob(SkRBufferWithSizeCheck* buffer, const SkData& data,
+               const void** blob, uint32_t* size) {
+    if (!buffer->readU32(size)) {
+        return false;
+    }
+    size_t pos = buffer->pos();
+    if (*size > data.size() || !buffer->read(NULL, SkAlign4(*size))) {
+        return false;
+    }
+    *blob = data.bytes() + pos;
+    return true;
+}
+
+void append_gl_string(const GrGLInterface* gl, GrGLenum name, SkString* str) {
+    const GrGLubyte* value;
+    GR_GL_CALL_RET(gl, value, GetString(name));
+    if (NULL != value) {
+        str->append(reinterpret_cast<const char*>(value));
+    }
+    str->append("\n");
+}
+
+}
+
+GrGLPersistentProgramCache::GrGLPersistentProgramCache(const GrGLContext& glContext,
+                                                       GrPersistentCache* storage)
+    : fGLContext(glContext)
+    , fStorage(SkRef(storage)) {
+    // Binaries are only valid for the exact driver that produced them and the generated source
+    // can depend on the GLSL version, so the key includes everything the driver tells us about
+    // itself.
+    const GrGLInterface* gl = glContext.interface();
+    append_gl_string(gl, GR_GL_VENDOR, &fDriverID);
+    append_gl_string(gl, GR_GL_RENDERER, &fDriverID);
+    append_gl_string(gl, GR_GL_VERSION, &fDriverID);
+    append_gl_string(gl, GR_GL_SHADING_LANGUAGE_VERSION, &fDriverID);
+}
+
+void GrGLPersistentProgramCache::willLinkProgram(GrGLuint programID) {
+    if (fGLContext.caps()->programBinarySupport() &&
+        NULL != fGLContext.interface()->fFunctions.fProgramParameteri) {
+        GL_CALL(ProgramParameteri(programID, GR_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GR_GL_TRUE));
+    }
+}
+
+bool GrGLPersistentProgramCache::loadProgram(const GrGLProgramDesc& desc,
+                                             const GrGLShaderSourceArray& sources,
+                                             GrGLuint programID) {
+    if (!fGLContext.caps()->programBinarySupport()) {
+        return false;
+    }
+    SkAutoTUnref<SkData> key(CreateKey(desc, fDriverID.c_str()));
+    SkAutoTUnref<SkData> data(fStorage->load(*key));
+    if (NULL == data.get()) {
+        return false;
+    }
+    Entry entry;
+    if (!DeserializeEntry(*data, &entry) ||
+        NULL == entry.fBinary.get() ||
+        !SourcesMatch(entry, sources)) {
+        return false;
+    }
+
+    GL_CALL(ProgramBinary(programID, entry.fBinaryFormat,
+                          entry.fBinary->data(), static_cast<GrGLsizei>(entry.fBinary->size())));
+    // Drivers reject binaries after an update, so this is checked even where GetProgramiv is
+    // slow.
+    GrGLint linked = GR_GL_INIT_ZERO;
+    GL_CALL(GetProgramiv(programID, GR_GL_LINK_STATUS, &linked));
+    return SkToBool(linked);
+}
+
+void GrGLPersistentProgramCache::storeProgram(const GrGLProgramDesc& desc,
+                                              const GrGLShaderSourceArray& sources,
+                                              GrGLuint programID) {
+    // loadProgram() only uses entries with a binary, so there is nothing worth writing without
+    // one.
+    if (!fGLContext.caps()->programBinarySupport()) {
+        return;
+    }
+    GrGLint length = 0;
+    GL_CALL(GetProgramiv(programID, GR_GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0 || length > kMaxBinarySize) {
+        return;
+    }
+    SkAutoMalloc binary(length);
+    GrGLsizei written = 0;
+    Entry entry;
+    GL_CALL(GetProgramBinary(programID, length, &written, &entry.fBinaryFormat, binary.get()));
+    if (written <= 0 || written > length) {
+        return;
+    }
+    entry.fSources = sources;
+    entry.fBinary.reset(SkData::NewWithCopy(binary.get(), written));
+    SkAutoTUnref<SkData> key(CreateKey(desc, fDriverID.c_str()));
+    SkAutoTUnref<SkData> data(SerializeEntry(entry));
+    fStorage->store(*key, *data);
+}
+
+SkData* GrGLPersistentProgramCache::CreateKey(const GrGLProgramDesc& desc, const char driverID[]) {
+    SkWriter32 writer;
+    writer.write32(kKeyVersion);
+    write_blob(&writer, desc.asKey(), desc.keyLength());
+    write_blob(&writer, driverID, strlen(driverID));
+    return writer.snapshotAsData();
+}
+
+SkData* GrGLPersistentProgramCache::SerializeEntry(const Entry& entry) {
+    SkWriter32 writer;
+    writer.write32(kEntryMagic);
+    writer.write32(kEntryVersion);
+    writer.write32(entry.fSources.count());
+    for (int i = 0; i < entry.fSources.count(); ++i) {
+        writer.write32(entry.fSources[i].fType);
+        write_blob(&writer, entry.fSources[i].fSource.c_str(), entry.fSources[i].fSource.size());
+    }
+    writer.write32(entry.fBinaryFormat);
+    if (NULL != entry.fBinary.get()) {
+        write_blob(&writer, entry.fBinary->data(), entry.fBinary->size());
+    } else {
+        write_blob(&writer, NULL, 0);
+    }
+    return writer.snapshotAsData();
+}
+
+bool GrGLPersistentProgramCache::DeserializeEntry(const SkData& data, Entry* entry) {
+    SkRBufferWithSizeCheck buffer(data.data(), data.size());
+    uint32_t magic, version, sourceCount;
+    if (!buffer.readU32(&magic) || kEntryMagic != magic ||
+        !buffer.readU32(&version) || kEntryVersion != version ||
+        !buffer.readU32(&sourceCount) || sourceCount > data.size()) {
+        return false;
+    }
+    entry->fSources.reset();
+    for (uint32_t i = 0; i < sourceCount; ++i) {
+        uint32_t type, size;
+        const void* source;
+        if (!buffer.readU32(&type) || !read_blob(&buffer, data, &source, &size)) {
+            return false;
+        }
+        GrGLShaderSource& shader = entry->fSources.push_back();
+        shader.fType = type;
+        shader.fSource.set(static_cast<const char*>(source), size);
+    }
+    uint32_t binaryFormat, binarySize;
+    const void* binary;
+    if (!buffer.readU32(&binaryFormat) || !read_blob(&buffer, data, &binary, &binarySize) ||
+        !buffer.eof()) {
+        return false;
+    }
+    entry->fBinaryFormat = binaryFormat;
+    entry->fBinary.reset(binarySize > 0 ? SkData::NewWithCopy(binary, binarySize) : NULL);
+    return true;
+}
+
+bool GrGLPersistentProgramCache::SourcesMatch(const Entry& entry,
+                                              const GrGLShaderSourceArray& sources) {
+    if (entry.fSources.count() != sources.count()) {
+        return false;
+    }
+    for (int i = 0; i < sources.count(); ++i) {
+        if (entry.fSources[i].fType != sources[i].fType ||
+            !entry.fSources[i].fSource.equals(sources[i].fSource)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrGLPersistentProgramCache_DEFINED
+#define GrGLPersistentProgramCache_DEFINED
+
+#include "gl/GrGLFunctions.h"
+#include "GrPersistentCache.h"
+#include "SkData.h"
+#include "SkString.h"
+#include "SkTArray.h"
+
+class GrGLContext;
+class GrGLProgramDesc;
+
+/**
+ * The source of one shader of a program, as generated by GrGLShaderBuilder.
+ */
+struct GrGLShaderSource {
+    GrGLenum    fType;      // GR_GL_VERTEX_SHADER, GR_GL_FRAGMENT_SHADER, ...
+    SkString    fSource;
+};
+
+typedef SkTArray<GrGLShaderSource> GrGLShaderSourceArray;
+
+/**
+ * Saves the programs built by GrGLShaderBuilder in a GrPersistentCache so that later runs can skip
+ * compiling them. Entries are keyed by the GrGLProgramDesc and a string that identifies the driver.
+ * Each entry holds the generated shader source and the linked binary, so nothing is stored unless
+ * the driver supports glProgramBinary. A binary is only loaded if the stored source matches the
+ * source generated for the program, so entries written by a different version of Skia are never
+ * used.
+ */
+class GrGLPersistentProgramCache : public SkNoncopyable {
+public:
+    GrGLPersistentProgramCache(const GrGLContext&, GrPersistentCache*);
+
+    const SkString& driverID() const { return fDriverID; }
+
+    /**
+     * Must be called before programID is linked so that its binary can be retrieved afterwards.
+     */
+    void willLinkProgram(GrGLuint programID);
+
+    /**
+     * Tries to load the binary stored for a program with desc and sources into programID. Returns
+     * true if programID was successfully linked from the binary. If it returns false, programID
+     * must be compiled and linked from sources and then passed to storeProgram().
+     */
+    bool loadProgram(const GrGLProgramDesc& desc,
+                     const GrGLShaderSourceArray& sources,
+                     GrGLuint programID);
+
+    /**
+     * Stores the sources and the binary of the linked program programID. Does nothing if the
+     * driver can't give the binary back.
+     */
+    void storeProgram(const GrGLProgramDesc& desc,
+                      const GrGLShaderSourceArray& sources,
+                      GrGLuint programID);
+
+    struct Entry {
+        Entry() : fBinaryFormat(0) {}
+
+        GrGLShaderSourceArray   fSources;
+        GrGLenum                fBinaryFormat;
+        SkAutoTUnref<SkData>    fBinary;        // NULL if there is no binary
+    };
+
+    // The key and entry formats don't depend on a GL context so that they can be tested without
+    // one.
+
+    /** Returns the key for a program with desc on the driver identified by driverID. */
+    static SkData* CreateKey(const GrGLProgramDesc& desc, const char driverID[]);
+
+    static SkData* SerializeEntry(const Entry&);
+
+    /** Returns false if data isn't a well formed entry. */
+    static bool DeserializeEntry(const SkData& data, Entry*);
+
+    /** Returns true if entry holds exactly the given sources. */
+    static bool SourcesMatch(const Entry& entry, const GrGLShaderSourceArray& sources);
+
+private:
+    const GrGLContext&                  fGLContext;
+    SkAutoTUnref<GrPersistentCache>     fStorage;
+    SkString                            fDriverID;
+};
+
+#endif
@@ -82,6 +82,7 @@ void GrGLProgram::overrideBlend(GrBlendCoeff* srcCoeff,
 
 void GrGLProgram::initSamplerUniforms() {
     GL_CALL(UseProgram(fBuilderOutput.fProgramID));
+    fGpu->notifyProgramBound(fBuilderOutput.fProgramID);
     GrGLint texUnitIdx = 0;
     if (fBuilderOutput.fUniformHandles.fDstCopySamplerUni.isValid()) {
         fUniformManager->setSampler(fBuilderOutput.fUniformHandles.fDstCopySamplerUni, texUnitIdx);
@@ -664,9 +664,24 @@ bool GrGLShaderBuilder::finish() {
         return false;
     }
 
+    GrGLShaderSourceArray sources;
+    this->generateShaderSources(&sources);
+
+    GrGLPersistentProgramCache* persistentCache = fGpu->persistentProgramCache();
+    if (NULL != persistentCache &&
+        persistentCache->loadProgram(this->desc(), sources, fOutput.fProgramID)) {
+        // The attribute, frag data and uniform bindings were baked into the binary when it was
+        // linked. We only need to look up the uniform locations.
+        fUniformManager->getUniformLocations(fOutput.fProgramID, fUniforms);
+        return true;
+    }
+
     SkTDArray<GrGLuint> shadersToDelete;
 
-    if (!this->compileAndAttachShaders(fOutput.fProgramID, &shadersToDelete)) {
+    if (!this->compileAndAttachShaders(sources, fOutput.fProgramID, &shadersToDelete)) {
+        for (int i = 0; i < shadersToDelete.count(); ++i) {
+            GL_CALL(DeleteShader(shadersToDelete[i]));
+        }
         GL_CALL(DeleteProgram(fOutput.fProgramID));
         return false;
     }
@@ -676,6 +691,9 @@ bool GrGLShaderBuilder::finish() {
         fUniformManager->getUniformLocations(fOutput.fProgramID, fUniforms);
     }
 
+    if (NULL != persistentCache) {
+        persistentCache->willLinkProgram(fOutput.fProgramID);
+    }
     GL_CALL(LinkProgram(fOutput.fProgramID));
 
     // Calling GetProgramiv is expensive in Chromium. Assume success in release builds.
@@ -715,6 +733,10 @@ bool GrGLShaderBuilder::finish() {
       GL_CALL(DeleteShader(shadersToDelete[i]));
     }
 
+    if (NULL != persistentCache) {
+        persistentCache->storeProgram(this->desc(), sources, fOutput.fProgramID);
+    }
+
     return true;
 }
 
@@ -778,8 +800,25 @@ static GrGLuint attach_shader(const GrGLContext& glCtx,
     return shaderId;
 }
 
-bool GrGLShaderBuilder::compileAndAttachShaders(GrGLuint programId, SkTDArray<GrGLuint>* shaderIds) const {
-    SkString fragShaderSrc(GrGetGLSLVersionDecl(this->ctxInfo()));
+bool GrGLShaderBuilder::compileAndAttachShaders(const GrGLShaderSourceArray& sources,
+                                                GrGLuint programId,
+                                                SkTDArray<GrGLuint>* shaderIds) const {
+    for (int i = 0; i < sources.count(); ++i) {
+        GrGLuint shaderId = attach_shader(fGpu->glContext(), programId,
+                                          sources[i].fType, sources[i].fSource);
+        if (!shaderId) {
+            return false;
+        }
+        *shaderIds->append() = shaderId;
+    }
+    return true;
+}
+
+void GrGLShaderBuilder::generateShaderSources(GrGLShaderSourceArray* sources) const {
+    GrGLShaderSource& fragShader = sources->push_back();
+    fragShader.fType = GR_GL_FRAGMENT_SHADER;
+    SkString& fragShaderSrc = fragShader.fSource;
+    fragShaderSrc.set(GrGetGLSLVersionDecl(this->ctxInfo()));
     fragShaderSrc.append(fFSExtensions);
     append_default_precision_qualifier(kDefaultFragmentPrecision,
                                        fGpu->glStandard(),
@@ -793,15 +832,6 @@ bool GrGLShaderBuilder::compileAndAttachShaders(GrGLuint programId, SkTDArray<Gr
     fragShaderSrc.append("void main() {\n");
     fragShaderSrc.append(fFSCode);
     fragShaderSrc.append("}\n");
-
-    GrGLuint fragShaderId = attach_shader(fGpu->glContext(), programId, GR_GL_FRAGMENT_SHADER, fragShaderSrc);
-    if (!fragShaderId) {
-        return false;
-    }
-
-    *shaderIds->append() = fragShaderId;
-
-    return true;
 }
 
 void GrGLShaderBuilder::bindProgramLocations(GrGLuint programId) const {
@@ -983,26 +1013,25 @@ GrGLProgramEffects* GrGLFullShaderBuilder::createAndEmitEffects(
     return programEffectsBuilder.finish();
 }
 
-bool GrGLFullShaderBuilder::compileAndAttachShaders(GrGLuint programId,
-                                                    SkTDArray<GrGLuint>* shaderIds) const {
-    const GrGLContext& glCtx = this->gpu()->glContext();
-    SkString vertShaderSrc(GrGetGLSLVersionDecl(this->ctxInfo()));
+void GrGLFullShaderBuilder::generateShaderSources(GrGLShaderSourceArray* sources) const {
+    GrGLShaderSource& vertShader = sources->push_back();
+    vertShader.fType = GR_GL_VERTEX_SHADER;
+    SkString& vertShaderSrc = vertShader.fSource;
+    vertShaderSrc.set(GrGetGLSLVersionDecl(this->ctxInfo()));
     this->appendUniformDecls(kVertex_Visibility, &vertShaderSrc);
     this->appendDecls(fVSAttrs, &vertShaderSrc);
     this->appendDecls(fVSOutputs, &vertShaderSrc);
     vertShaderSrc.append("void main() {\n");
     vertShaderSrc.append(fVSCode);
     vertShaderSrc.append("}\n");
-    GrGLuint vertShaderId = attach_shader(glCtx, programId, GR_GL_VERTEX_SHADER, vertShaderSrc);
-    if (!vertShaderId) {
-        return false;
-    }
-    *shaderIds->append() = vertShaderId;
 
 #if GR_GL_EXPERIMENTAL_GS
     if (this->desc().getHeader().fExperimentalGS) {
         SkASSERT(this->ctxInfo().glslGeneration() >= k150_GrGLSLGeneration);
-        SkString geomShaderSrc(GrGetGLSLVersionDecl(this->ctxInfo()));
+        GrGLShaderSource& geomShader = sources->push_back();
+        geomShader.fType = GR_GL_GEOMETRY_SHADER;
+        SkString& geomShaderSrc = geomShader.fSource;
+        geomShaderSrc.set(GrGetGLSLVersionDecl(this->ctxInfo()));
         geomShaderSrc.append("layout(triangles) in;\n"
                              "layout(triangle_strip, max_vertices = 6) out;\n");
         this->appendDecls(fGSInputs, &geomShaderSrc);
@@ -1023,15 +1052,10 @@ bool GrGLFullShaderBuilder::compileAndAttachShaders(GrGLuint programId,
                              "\t}\n"
                              "\tEndPrimitive();\n");
         geomShaderSrc.append("}\n");
-        GrGLuint geomShaderId = attach_shader(glCtx, programId, GR_GL_GEOMETRY_SHADER, geomShaderSrc);
-        if (!geomShaderId) {
-            return false;
-        }
-        *shaderIds->append() = geomShaderId;
     }
 #endif
 
-    return this->INHERITED::compileAndAttachShaders(programId, shaderIds);
+    this->INHERITED::generateShaderSources(sources);
 }
 
 void GrGLFullShaderBuilder::bindProgramLocations(GrGLuint programId) const {
@@ -13,6 +13,7 @@
 #include "GrColor.h"
 #include "GrEffect.h"
 #include "SkTypes.h"
+#include "gl/GrGLPersistentProgramCache.h"
 #include "gl/GrGLProgramEffects.h"
 #include "gl/GrGLSL.h"
 #include "gl/GrGLUniformManager.h"
@@ -262,7 +263,12 @@ protected:
     // generating stage code.
     void nameVariable(SkString* out, char prefix, const char* name);
 
-    virtual bool compileAndAttachShaders(GrGLuint programId, SkTDArray<GrGLuint>* shaderIds) const;
+    // Appends the source of each of the program's shaders, in the order they are attached.
+    virtual void generateShaderSources(GrGLShaderSourceArray*) const;
+
+    bool compileAndAttachShaders(const GrGLShaderSourceArray&,
+                                 GrGLuint programId,
+                                 SkTDArray<GrGLuint>* shaderIds) const;
 
     virtual void bindProgramLocations(GrGLuint programId) const;
 
@@ -471,8 +477,7 @@ private:
 
     virtual void emitCodeAfterEffects() SK_OVERRIDE;
 
-    virtual bool compileAndAttachShaders(GrGLuint programId,
-                                         SkTDArray<GrGLuint>* shaderIds) const SK_OVERRIDE;
+    virtual void generateShaderSources(GrGLShaderSourceArray*) const SK_OVERRIDE;
 
     virtual void bindProgramLocations(GrGLuint programId) const SK_OVERRIDE;
 
@@ -15,6 +15,15 @@
          SkASSERT(arrayCount <= uni.fArrayCount || \
                   (1 == arrayCount && GrGLShaderVar::kNonArray == uni.fArrayCount))
 
+namespace {
+// The number of floats needed to shadow the value of a uniform of the given type.
+int shadow_float_count(GrSLType type, int arrayCount) {
+    static const int kFloatCounts[] = { 0, 1, 2, 3, 4, 9, 16, 0 };
+    GR_STATIC_ASSERT(SK_ARRAY_COUNT(kFloatCounts) == kGrSLTypeCount);
+    return kFloatCounts[type] * SkTMax(1, arrayCount);
+}
+}
+
 GrGLUniformManager::GrGLUniformManager(GrGpuGL* gpu) : fGpu(gpu) {
     // skbug.com/2056
     fUsingBindUniform = fGpu->glInterface()->fFunctions.fBindUniformLocation != NULL;
@@ -28,9 +37,26 @@ GrGLUniformManager::UniformHandle GrGLUniformManager::appendUniform(GrSLType typ
     uni.fType = type;
     uni.fVSLocation = kUnusedUniform;
     uni.fFSLocation = kUnusedUniform;
+    uni.fShadowOffset = fShadowValues.count();
+    fShadowValues.append(shadow_float_count(type, arrayCount));
+    *fShadowValidCounts.append() = 0;
     return GrGLUniformManager::UniformHandle::CreateFromUniformIndex(idx);
 }
 
+bool GrGLUniformManager::updateShadow(UniformHandle u, int count, const GrGLfloat v[]) const {
+    int idx = u.toUniformIndex();
+    GrGLfloat* shadow = fShadowValues.begin() + fUniforms[idx].fShadowOffset;
+    int& validCount = fShadowValidCounts[idx];
+    size_t size = count * sizeof(GrGLfloat);
+    if (count <= validCount && 0 == memcmp(shadow, v, size)) {
+        return false;
+    }
+    memcpy(shadow, v, size);
+    // An upload of fewer array elements leaves the tail of the array untouched.
+    validCount = SkTMax(validCount, count);
+    return true;
+}
+
 void GrGLUniformManager::setSampler(UniformHandle u, GrGLint texUnit) const {
     const Uniform& uni = fUniforms[u.toUniformIndex()];
     SkASSERT(uni.fType == kSampler2D_GrSLType);
@@ -52,6 +78,10 @@ void GrGLUniformManager::set1f(UniformHandle u, GrGLfloat v0) const {
     SkASSERT(uni.fType == kFloat_GrSLType);
     SkASSERT(GrGLShaderVar::kNonArray == uni.fArrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    const GrGLfloat v[] = { v0 };
+    if (!this->updateShadow(u, 1, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform1f(uni.fFSLocation, v0));
     }
@@ -71,6 +101,9 @@ void GrGLUniformManager::set1fv(UniformHandle u,
     // Once the uniform manager is responsible for inserting the duplicate uniform
     // arrays in VS and FS driver bug workaround, this can be enabled.
     //SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform1fv(uni.fFSLocation, arrayCount, v));
     }
@@ -84,6 +117,10 @@ void GrGLUniformManager::set2f(UniformHandle u, GrGLfloat v0, GrGLfloat v1) cons
     SkASSERT(uni.fType == kVec2f_GrSLType);
     SkASSERT(GrGLShaderVar::kNonArray == uni.fArrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    const GrGLfloat v[] = { v0, v1 };
+    if (!this->updateShadow(u, 2, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform2f(uni.fFSLocation, v0, v1));
     }
@@ -100,6 +137,9 @@ void GrGLUniformManager::set2fv(UniformHandle u,
     SkASSERT(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, arrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, 2 * arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform2fv(uni.fFSLocation, arrayCount, v));
     }
@@ -113,6 +153,10 @@ void GrGLUniformManager::set3f(UniformHandle u, GrGLfloat v0, GrGLfloat v1, GrGL
     SkASSERT(uni.fType == kVec3f_GrSLType);
     SkASSERT(GrGLShaderVar::kNonArray == uni.fArrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    const GrGLfloat v[] = { v0, v1, v2 };
+    if (!this->updateShadow(u, 3, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform3f(uni.fFSLocation, v0, v1, v2));
     }
@@ -129,6 +173,9 @@ void GrGLUniformManager::set3fv(UniformHandle u,
     SkASSERT(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, arrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, 3 * arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform3fv(uni.fFSLocation, arrayCount, v));
     }
@@ -146,6 +193,10 @@ void GrGLUniformManager::set4f(UniformHandle u,
     SkASSERT(uni.fType == kVec4f_GrSLType);
     SkASSERT(GrGLShaderVar::kNonArray == uni.fArrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    const GrGLfloat v[] = { v0, v1, v2, v3 };
+    if (!this->updateShadow(u, 4, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform4f(uni.fFSLocation, v0, v1, v2, v3));
     }
@@ -162,6 +213,9 @@ void GrGLUniformManager::set4fv(UniformHandle u,
     SkASSERT(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, arrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, 4 * arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), Uniform4fv(uni.fFSLocation, arrayCount, v));
     }
@@ -176,6 +230,9 @@ void GrGLUniformManager::setMatrix3f(UniformHandle u, const GrGLfloat matrix[])
     SkASSERT(GrGLShaderVar::kNonArray == uni.fArrayCount);
     // TODO: Re-enable this assert once texture matrices aren't forced on all effects
     // SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, 9, matrix)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), UniformMatrix3fv(uni.fFSLocation, 1, false, matrix));
     }
@@ -189,6 +246,9 @@ void GrGLUniformManager::setMatrix4f(UniformHandle u, const GrGLfloat matrix[])
     SkASSERT(uni.fType == kMat44f_GrSLType);
     SkASSERT(GrGLShaderVar::kNonArray == uni.fArrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, 16, matrix)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(), UniformMatrix4fv(uni.fFSLocation, 1, false, matrix));
     }
@@ -205,6 +265,9 @@ void GrGLUniformManager::setMatrix3fv(UniformHandle u,
     SkASSERT(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, arrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, 9 * arrayCount, matrices)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(),
                    UniformMatrix3fv(uni.fFSLocation, arrayCount, false, matrices));
@@ -223,6 +286,9 @@ void GrGLUniformManager::setMatrix4fv(UniformHandle u,
     SkASSERT(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, arrayCount);
     SkASSERT(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->updateShadow(u, 16 * arrayCount, matrices)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fGpu->glInterface(),
                    UniformMatrix4fv(uni.fFSLocation, arrayCount, false, matrices));
@@ -13,6 +13,7 @@
 #include "GrAllocator.h"
 
 #include "SkTArray.h"
+#include "SkTDArray.h"
 
 class GrGpuGL;
 class SkMatrix;
@@ -51,7 +52,10 @@ public:
     UniformHandle appendUniform(GrSLType type, int arrayCount = GrGLShaderVar::kNonArray);
 
     /** Functions for uploading uniform values. The varities ending in v can be used to upload to an
-     *  array of uniforms. arrayCount must be <= the array count of the uniform.
+     *  array of uniforms. arrayCount must be <= the array count of the uniform. The last value
+     *  uploaded to each uniform is shadowed and uploads of an unchanged value are skipped. Uniform
+     *  values are per-program object state so the shadow doesn't need to be invalidated when the
+     *  GrContext is reset.
      */
     void setSampler(UniformHandle, GrGLint texUnit) const;
     void set1f(UniformHandle, GrGLfloat v0) const;
@@ -108,10 +112,18 @@ private:
         GrGLint     fFSLocation;
         GrSLType    fType;
         int         fArrayCount;
+        int         fShadowOffset;  // index of the uniform's first value in fShadowValues
     };
 
+    // Records v as the value of the first count floats of the uniform. Returns false if they
+    // already hold that value and the upload can be skipped.
+    bool updateShadow(UniformHandle, int count, const GrGLfloat v[]) const;
+
     bool fUsingBindUniform;
     SkTArray<Uniform, true> fUniforms;
+    // Last uploaded values and, per uniform, how many of its leading floats are known.
+    mutable SkTDArray<GrGLfloat> fShadowValues;
+    mutable SkTDArray<int> fShadowValidCounts;
     GrGpuGL* fGpu;
 
     typedef SkRefCnt INHERITED;
@@ -262,6 +262,7 @@ void GrGpuGL::onResetContext(uint32_t resetBits) {
             // well.
         }
         fHWWriteToColor = kUnknown_TriState;
+        fHWClearColorValid = false;
         // we only ever use lines in hairline mode
         GL_CALL(LineWidth(1));
     }
@@ -290,6 +291,9 @@ void GrGpuGL::onResetContext(uint32_t resetBits) {
     if (resetBits & kStencil_GrGLBackendState) {
         fHWStencilSettings.invalidate();
         fHWStencilTestEnabled = kUnknown_TriState;
+        fHWStencilFaces[GrStencilSettings::kFront_Face].invalidate();
+        fHWStencilFaces[GrStencilSettings::kBack_Face].invalidate();
+        fHWClearStencilValid = false;
     }
 
     // Vertex
@@ -317,20 +321,10 @@ void GrGpuGL::onResetContext(uint32_t resetBits) {
         fHWPathStencilSettings.invalidate();
     }
 
-    // we assume these values
+    // pixel store values are set lazily by the upload and read paths, which put them back to the
+    // defaults when they are done
     if (resetBits & kPixelStore_GrGLBackendState) {
-        if (this->glCaps().unpackRowLengthSupport()) {
-            GL_CALL(PixelStorei(GR_GL_UNPACK_ROW_LENGTH, 0));
-        }
-        if (this->glCaps().packRowLengthSupport()) {
-            GL_CALL(PixelStorei(GR_GL_PACK_ROW_LENGTH, 0));
-        }
-        if (this->glCaps().unpackFlipYSupport()) {
-            GL_CALL(PixelStorei(GR_GL_UNPACK_FLIP_Y, GR_GL_FALSE));
-        }
-        if (this->glCaps().packFlipYSupport()) {
-            GL_CALL(PixelStorei(GR_GL_PACK_REVERSE_ROW_ORDER, GR_GL_FALSE));
-        }
+        fHWPixelStore.invalidate();
     }
 
     if (resetBits & kProgram_GrGLBackendState) {
@@ -596,7 +590,6 @@ bool GrGpuGL::uploadTexData(const GrGLTexture::Desc& desc,
      *  to trim those off here, since GL ES may not let us specify
      *  GL_UNPACK_ROW_LENGTH.
      */
-    bool restoreGLRowLength = false;
     bool swFlipY = false;
     bool glFlipY = false;
     if (NULL != data) {
@@ -609,11 +602,11 @@ bool GrGpuGL::uploadTexData(const GrGLTexture::Desc& desc,
         }
         if (this->glCaps().unpackRowLengthSupport() && !swFlipY) {
             // can't use this for flipping, only non-neg values allowed. :(
+            GrGLint rowLength = 0;
             if (rowBytes != trimRowBytes) {
-                GrGLint rowLength = static_cast<GrGLint>(rowBytes / bpp);
-                GL_CALL(PixelStorei(GR_GL_UNPACK_ROW_LENGTH, rowLength));
-                restoreGLRowLength = true;
+                rowLength = static_cast<GrGLint>(rowBytes / bpp);
             }
+            this->setPixelStore(GR_GL_UNPACK_ROW_LENGTH, rowLength);
         } else {
             if (trimRowBytes != rowBytes || swFlipY) {
                 // copy data into our new storage, skipping the trailing bytes
@@ -635,11 +628,14 @@ bool GrGpuGL::uploadTexData(const GrGLTexture::Desc& desc,
                 // now point data to our copied version
                 data = tempStorage.get();
             }
+            if (this->glCaps().unpackRowLengthSupport()) {
+                this->setPixelStore(GR_GL_UNPACK_ROW_LENGTH, 0);
+            }
         }
-        if (glFlipY) {
-            GL_CALL(PixelStorei(GR_GL_UNPACK_FLIP_Y, GR_GL_TRUE));
+        if (this->glCaps().unpackFlipYSupport()) {
+            this->setPixelStore(GR_GL_UNPACK_FLIP_Y, glFlipY ? GR_GL_TRUE : GR_GL_FALSE);
         }
-        GL_CALL(PixelStorei(GR_GL_UNPACK_ALIGNMENT, static_cast<GrGLint>(bpp)));
+        this->setPixelStore(GR_GL_UNPACK_ALIGNMENT, static_cast<GrGLint>(bpp));
     }
     bool succeeded = true;
     if (isNewTexture &&
@@ -702,12 +698,15 @@ bool GrGpuGL::uploadTexData(const GrGLTexture::Desc& desc,
                               externalFormat, externalType, data));
     }
 
-    if (restoreGLRowLength) {
-        SkASSERT(this->glCaps().unpackRowLengthSupport());
-        GL_CALL(PixelStorei(GR_GL_UNPACK_ROW_LENGTH, 0));
-    }
-    if (glFlipY) {
-        GL_CALL(PixelStorei(GR_GL_UNPACK_FLIP_Y, GR_GL_FALSE));
+    // Put the pixel store values back to GL's defaults: the context may be shared with code that
+    // relies on them. Through fHWPixelStore, this costs nothing when they were never changed.
+    if (NULL != data) {
+        if (this->glCaps().unpackRowLengthSupport()) {
+            this->setPixelStore(GR_GL_UNPACK_ROW_LENGTH, 0);
+        }
+        if (this->glCaps().unpackFlipYSupport()) {
+            this->setPixelStore(GR_GL_UNPACK_FLIP_Y, GR_GL_FALSE);
+        }
     }
     return succeeded;
 }
@@ -754,6 +753,15 @@ bool GrGpuGL::uploadCompressedTexData(const GrGLTexture::Desc& desc,
         return false;
     }
 
+    // Uploads leave the pixel store values at their defaults, but after a context reset they are
+    // unknown.
+    if (this->glCaps().unpackRowLengthSupport()) {
+        this->setPixelStore(GR_GL_UNPACK_ROW_LENGTH, 0);
+    }
+    if (this->glCaps().unpackFlipYSupport()) {
+        this->setPixelStore(GR_GL_UNPACK_FLIP_Y, GR_GL_FALSE);
+    }
+
     bool succeeded = true;
     CLEAR_ERROR_BEFORE_ALLOC(this->glInterface());
 
@@ -1386,10 +1394,12 @@ void GrGpuGL::flushScissor() {
             if (fHWScissorSettings.fRect != scissor) {
                 scissor.pushToGLScissor(this->glInterface());
                 fHWScissorSettings.fRect = scissor;
+                ++this->stats()->fScissorChanges;
             }
             if (kYes_TriState != fHWScissorSettings.fEnabled) {
                 GL_CALL(Enable(GR_GL_SCISSOR_TEST));
                 fHWScissorSettings.fEnabled = kYes_TriState;
+                ++this->stats()->fScissorChanges;
             }
             return;
         }
@@ -1397,6 +1407,7 @@ void GrGpuGL::flushScissor() {
     if (kNo_TriState != fHWScissorSettings.fEnabled) {
         GL_CALL(Disable(GR_GL_SCISSOR_TEST));
         fHWScissorSettings.fEnabled = kNo_TriState;
+        ++this->stats()->fScissorChanges;
         return;
     }
 }
@@ -1439,9 +1450,19 @@ void GrGpuGL::onClear(const SkIRect* rect, GrColor color, bool canIgnoreRect) {
     g = GrColorUnpackG(color) * scaleRGB;
     b = GrColorUnpackB(color) * scaleRGB;
 
-    GL_CALL(ColorMask(GR_GL_TRUE, GR_GL_TRUE, GR_GL_TRUE, GR_GL_TRUE));
-    fHWWriteToColor = kYes_TriState;
-    GL_CALL(ClearColor(r, g, b, a));
+    if (kYes_TriState != fHWWriteToColor) {
+        GL_CALL(ColorMask(GR_GL_TRUE, GR_GL_TRUE, GR_GL_TRUE, GR_GL_TRUE));
+        fHWWriteToColor = kYes_TriState;
+    }
+    if (!fHWClearColorValid || r != fHWClearColor[0] || g != fHWClearColor[1] ||
+        b != fHWClearColor[2] || a != fHWClearColor[3]) {
+        GL_CALL(ClearColor(r, g, b, a));
+        fHWClearColor[0] = r;
+        fHWClearColor[1] = g;
+        fHWClearColor[2] = b;
+        fHWClearColor[3] = a;
+        fHWClearColorValid = true;
+    }
     GL_CALL(Clear(GR_GL_COLOR_BUFFER_BIT));
 }
 
@@ -1510,8 +1531,12 @@ void GrGpuGL::clearStencil() {
     fScissorState.fEnabled = false;
     this->flushScissor();
 
-    GL_CALL(StencilMask(0xffffffff));
-    GL_CALL(ClearStencil(0));
+    this->setStencilClearMask(0xffffffff);
+    if (!fHWClearStencilValid || 0 != fHWClearStencil) {
+        GL_CALL(ClearStencil(0));
+        fHWClearStencil = 0;
+        fHWClearStencilValid = true;
+    }
     GL_CALL(Clear(GR_GL_STENCIL_BUFFER_BIT));
     fHWStencilSettings.invalidate();
 }
@@ -1549,8 +1574,12 @@ void GrGpuGL::clearStencilClip(const SkIRect& rect, bool insideClip) {
     fScissorState.fRect = rect;
     this->flushScissor();
 
-    GL_CALL(StencilMask((uint32_t) clipStencilMask));
-    GL_CALL(ClearStencil(value));
+    this->setStencilClearMask((uint32_t) clipStencilMask);
+    if (!fHWClearStencilValid || value != fHWClearStencil) {
+        GL_CALL(ClearStencil(value));
+        fHWClearStencil = value;
+        fHWClearStencilValid = true;
+    }
     GL_CALL(Clear(GR_GL_STENCIL_BUFFER_BIT));
     fHWStencilSettings.invalidate();
 }
@@ -1647,29 +1676,34 @@ bool GrGpuGL::onReadPixels(GrRenderTarget* target,
     // determine if GL can read using the passed rowBytes or if we need
     // a scratch buffer.
     SkAutoSMalloc<32 * sizeof(GrColor)> scratch;
+    GrGLint packRowLength = 0;
     if (rowBytes != tightRowBytes) {
         if (this->glCaps().packRowLengthSupport()) {
             SkASSERT(!(rowBytes % sizeof(GrColor)));
-            GL_CALL(PixelStorei(GR_GL_PACK_ROW_LENGTH,
-                                static_cast<GrGLint>(rowBytes / sizeof(GrColor))));
+            packRowLength = static_cast<GrGLint>(rowBytes / sizeof(GrColor));
             readDstRowBytes = rowBytes;
         } else {
             scratch.reset(tightRowBytes * height);
             readDst = scratch.get();
         }
     }
-    if (flipY && this->glCaps().packFlipYSupport()) {
-        GL_CALL(PixelStorei(GR_GL_PACK_REVERSE_ROW_ORDER, 1));
+    if (this->glCaps().packRowLengthSupport()) {
+        this->setPixelStore(GR_GL_PACK_ROW_LENGTH, packRowLength);
+    }
+    if (this->glCaps().packFlipYSupport()) {
+        this->setPixelStore(GR_GL_PACK_REVERSE_ROW_ORDER, flipY ? 1 : 0);
     }
     GL_CALL(ReadPixels(readRect.fLeft, readRect.fBottom,
                        readRect.fWidth, readRect.fHeight,
                        format, type, readDst));
-    if (readDstRowBytes != tightRowBytes) {
-        SkASSERT(this->glCaps().packRowLengthSupport());
-        GL_CALL(PixelStorei(GR_GL_PACK_ROW_LENGTH, 0));
+    // Put the pixel store values back to GL's defaults, as uploadTexData does.
+    if (this->glCaps().packRowLengthSupport()) {
+        this->setPixelStore(GR_GL_PACK_ROW_LENGTH, 0);
+    }
+    if (this->glCaps().packFlipYSupport()) {
+        this->setPixelStore(GR_GL_PACK_REVERSE_ROW_ORDER, 0);
     }
     if (flipY && this->glCaps().packFlipYSupport()) {
-        GL_CALL(PixelStorei(GR_GL_PACK_REVERSE_ROW_ORDER, 0));
         flipY = false;
     }
 
@@ -1723,6 +1757,7 @@ void GrGpuGL::flushRenderTarget(const SkIRect* bound) {
 
     if (fHWBoundRenderTarget != rt) {
         GL_CALL(BindFramebuffer(GR_GL_FRAMEBUFFER, rt->renderFBOID()));
+        ++this->stats()->fRenderTargetChanges;
 #ifdef SK_DEBUG
         // don't do this check in Chromium -- this is causing
         // lots of repeated command buffer flushes when the compositor is
@@ -2086,31 +2121,119 @@ GrGLenum gr_to_gl_stencil_op(GrStencilOp op) {
     SkASSERT((unsigned) op < kStencilOpCount);
     return gTable[op];
 }
+}
+
+void GrGpuGL::setStencilFace(GrGLenum glFace, GrStencilSettings::Face grFace) {
+    GrGLenum glFunc = gr_to_gl_stencil_func(fStencilSettings.func(grFace));
+    GrGLenum glFailOp = gr_to_gl_stencil_op(fStencilSettings.failOp(grFace));
+    GrGLenum glPassOp = gr_to_gl_stencil_op(fStencilSettings.passOp(grFace));
 
-void set_gl_stencil(const GrGLInterface* gl,
-                    const GrStencilSettings& settings,
-                    GrGLenum glFace,
-                    GrStencilSettings::Face grFace) {
-    GrGLenum glFunc = gr_to_gl_stencil_func(settings.func(grFace));
-    GrGLenum glFailOp = gr_to_gl_stencil_op(settings.failOp(grFace));
-    GrGLenum glPassOp = gr_to_gl_stencil_op(settings.passOp(grFace));
+    GrGLint ref = fStencilSettings.funcRef(grFace);
+    GrGLint mask = fStencilSettings.funcMask(grFace);
+    GrGLuint writeMask = fStencilSettings.writeMask(grFace);
 
-    GrGLint ref = settings.funcRef(grFace);
-    GrGLint mask = settings.funcMask(grFace);
-    GrGLint writeMask = settings.writeMask(grFace);
+    // When setting both faces at once the GL state is only known if both shadows agree.
+    HWStencilFace* faces[2];
+    int faceCount;
+    if (GR_GL_FRONT_AND_BACK == glFace) {
+        faces[0] = &fHWStencilFaces[GrStencilSettings::kFront_Face];
+        faces[1] = &fHWStencilFaces[GrStencilSettings::kBack_Face];
+        faceCount = 2;
+    } else {
+        faces[0] = &fHWStencilFaces[grFace];
+        faceCount = 1;
+    }
+
+    bool funcChanged = false;
+    bool writeMaskChanged = false;
+    bool opChanged = false;
+    for (int i = 0; i < faceCount; ++i) {
+        const HWStencilFace& hw = *faces[i];
+        funcChanged = funcChanged || !hw.fFuncValid || hw.fFunc != glFunc ||
+                      hw.fRef != ref || hw.fFuncMask != mask;
+        writeMaskChanged = writeMaskChanged || !hw.fWriteMaskValid || hw.fWriteMask != writeMask;
+        opChanged = opChanged || !hw.fOpValid || hw.fFailOp != glFailOp ||
+                    hw.fPassOp != glPassOp;
+    }
 
     if (GR_GL_FRONT_AND_BACK == glFace) {
         // we call the combined func just in case separate stencil is not
         // supported.
-        GR_GL_CALL(gl, StencilFunc(glFunc, ref, mask));
-        GR_GL_CALL(gl, StencilMask(writeMask));
-        GR_GL_CALL(gl, StencilOp(glFailOp, glPassOp, glPassOp));
+        if (funcChanged) {
+            GL_CALL(StencilFunc(glFunc, ref, mask));
+        }
+        if (writeMaskChanged) {
+            GL_CALL(StencilMask(writeMask));
+        }
+        if (opChanged) {
+            GL_CALL(StencilOp(glFailOp, glPassOp, glPassOp));
+        }
     } else {
-        GR_GL_CALL(gl, StencilFuncSeparate(glFace, glFunc, ref, mask));
-        GR_GL_CALL(gl, StencilMaskSeparate(glFace, writeMask));
-        GR_GL_CALL(gl, StencilOpSeparate(glFace, glFailOp, glPassOp, glPassOp));
+        if (funcChanged) {
+            GL_CALL(StencilFuncSeparate(glFace, glFunc, ref, mask));
+        }
+        if (writeMaskChanged) {
+            GL_CALL(StencilMaskSeparate(glFace, writeMask));
+        }
+        if (opChanged) {
+            GL_CALL(StencilOpSeparate(glFace, glFailOp, glPassOp, glPassOp));
+        }
+    }
+
+    for (int i = 0; i < faceCount; ++i) {
+        HWStencilFace* hw = faces[i];
+        hw->fFunc = glFunc;
+        hw->fRef = ref;
+        hw->fFuncMask = mask;
+        hw->fFuncValid = true;
+        hw->fWriteMask = writeMask;
+        hw->fWriteMaskValid = true;
+        hw->fFailOp = glFailOp;
+        hw->fPassOp = glPassOp;
+        hw->fOpValid = true;
+    }
+}
+
+void GrGpuGL::setStencilClearMask(GrGLuint writeMask) {
+    HWStencilFace& front = fHWStencilFaces[GrStencilSettings::kFront_Face];
+    HWStencilFace& back = fHWStencilFaces[GrStencilSettings::kBack_Face];
+    if (!front.fWriteMaskValid || front.fWriteMask != writeMask ||
+        !back.fWriteMaskValid || back.fWriteMask != writeMask) {
+        GL_CALL(StencilMask(writeMask));
+        front.fWriteMask = writeMask;
+        front.fWriteMaskValid = true;
+        back.fWriteMask = writeMask;
+        back.fWriteMaskValid = true;
     }
 }
+
+void GrGpuGL::setPixelStore(GrGLenum pname, GrGLint value) {
+    GrGLint* hwValue;
+    switch (pname) {
+        case GR_GL_UNPACK_ROW_LENGTH:
+            hwValue = &fHWPixelStore.fUnpackRowLength;
+            break;
+        case GR_GL_UNPACK_ALIGNMENT:
+            hwValue = &fHWPixelStore.fUnpackAlignment;
+            break;
+        case GR_GL_UNPACK_FLIP_Y:
+            hwValue = &fHWPixelStore.fUnpackFlipY;
+            break;
+        case GR_GL_PACK_ROW_LENGTH:
+            hwValue = &fHWPixelStore.fPackRowLength;
+            break;
+        case GR_GL_PACK_REVERSE_ROW_ORDER:
+            hwValue = &fHWPixelStore.fPackReverseRowOrder;
+            break;
+        default:
+            SkFAIL("Unexpected pixel store parameter.");
+            return;
+    }
+    SkASSERT(value >= 0);
+    if (*hwValue != value) {
+        GL_CALL(PixelStorei(pname, value));
+        *hwValue = value;
+    }
 }
 
 void GrGpuGL::flushStencil(DrawType type) {
@@ -2128,19 +2251,10 @@ void GrGpuGL::flushStencil(DrawType type) {
         }
         if (!fStencilSettings.isDisabled()) {
             if (this->caps()->twoSidedStencilSupport()) {
-                set_gl_stencil(this->glInterface(),
-                               fStencilSettings,
-                               GR_GL_FRONT,
-                               GrStencilSettings::kFront_Face);
-                set_gl_stencil(this->glInterface(),
-                               fStencilSettings,
-                               GR_GL_BACK,
-                               GrStencilSettings::kBack_Face);
+                this->setStencilFace(GR_GL_FRONT, GrStencilSettings::kFront_Face);
+                this->setStencilFace(GR_GL_BACK, GrStencilSettings::kBack_Face);
             } else {
-                set_gl_stencil(this->glInterface(),
-                               fStencilSettings,
-                               GR_GL_FRONT_AND_BACK,
-                               GrStencilSettings::kFront_Face);
+                this->setStencilFace(GR_GL_FRONT_AND_BACK, GrStencilSettings::kFront_Face);
             }
         }
         fHWStencilSettings = fStencilSettings;
@@ -2301,6 +2415,7 @@ void GrGpuGL::bindTexture(int unitIdx, const GrTextureParams& params, GrGLTextur
         this->setTextureUnit(unitIdx);
         GL_CALL(BindTexture(GR_GL_TEXTURE_2D, texture->textureID()));
         fHWBoundTextures[unitIdx] = texture;
+        ++this->stats()->fTextureBinds;
     }
 
     ResetTimestamp timestamp;
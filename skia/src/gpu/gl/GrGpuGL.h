@@ -13,6 +13,7 @@
 #include "GrGLContext.h"
 #include "GrGLIRect.h"
 #include "GrGLIndexBuffer.h"
+#include "GrGLPersistentProgramCache.h"
 #include "GrGLProgram.h"
 #include "GrGLStencilBuffer.h"
 #include "GrGLTexture.h"
@@ -20,6 +21,8 @@
 #include "GrGLVertexBuffer.h"
 #include "GrGpu.h"
 #include "GrTHashTable.h"
+#include "SkTDynamicHash.h"
+#include "SkTInternalLList.h"
 #include "SkTypes.h"
 
 #ifdef SK_DEVELOPER
@@ -82,6 +85,16 @@ public:
 
     virtual void abandonResources() SK_OVERRIDE;
 
+    virtual int getProgramCacheLimit() const SK_OVERRIDE;
+    virtual void setProgramCacheLimit(int maxPrograms) SK_OVERRIDE;
+    virtual bool precompileProgram(const GrDrawState&, DrawType) SK_OVERRIDE;
+    virtual void setPersistentCache(GrPersistentCache*) SK_OVERRIDE;
+
+    // NULL unless the client has set a GrPersistentCache.
+    GrGLPersistentProgramCache* persistentProgramCache() const {
+        return fPersistentProgramCache.get();
+    }
+
     // These functions should be used to bind GL objects. They track the GL state and skip redundant
     // bindings. Making the equivalent glBind calls directly will confuse the state tracking.
     void bindVertexArray(GrGLuint id) {
@@ -106,6 +119,11 @@ public:
         fHWGeometryState.notifyIndexBufferDelete(id);
     }
     void notifyTextureDelete(GrGLTexture* texture);
+    // Called by GrGLProgram when it binds its program object to initialize its samplers.
+    void notifyProgramBound(GrGLuint programID) {
+        fHWProgramID = programID;
+        ++this->stats()->fProgramSwitches;
+    }
     void notifyRenderTargetDelete(GrRenderTarget* renderTarget);
 
     // These functions should be used to generate and delete GL path names. They have their own
@@ -206,35 +224,34 @@ private:
                                 const GrEffectStage* colorStages[],
                                 const GrEffectStage* coverageStages[]);
 
+        // The maximum number of programs kept alive. When lowered the least recently used
+        // programs are deleted to get under the new limit.
+        int getMaxEntries() const { return fMaxEntries; }
+        void setMaxEntries(int maxEntries);
+
+        int count() const { return fHash.count(); }
+
     private:
         enum {
-            // We may actually have kMaxEntries+1 shaders in the GL context because we create a new
+            // We may actually have fMaxEntries+1 shaders in the GL context because we create a new
             // shader before evicting from the cache.
-            kMaxEntries = 128,
-            kHashBits = 6,
+            kDefaultMaxEntries = 256,
         };
 
         struct Entry;
 
-        struct ProgDescLess;
-
-        // binary search for entry matching desc. returns index into fEntries that matches desc or ~
-        // of the index of where it should be inserted.
-        int search(const GrGLProgramDesc& desc) const;
+        void purgeEntry(Entry* entry);
 
-        // sorted array of all the entries
-        Entry*                      fEntries[kMaxEntries];
-        // hash table based on lowest kHashBits bits of the program key. Used to avoid binary
-        // searching fEntries.
-        Entry*                      fHashTable[1 << kHashBits];
+        // All entries, keyed by their program's GrGLProgramDesc.
+        SkTDynamicHash<Entry, GrGLProgramDesc>  fHash;
+        // All entries ordered from most (head) to least (tail) recently used.
+        SkTInternalLList<Entry>                 fLRUList;
 
-        int                         fCount;
-        unsigned int                fCurrLRUStamp;
+        int                         fMaxEntries;
         GrGpuGL*                    fGpu;
 #ifdef PROGRAM_CACHE_STATS
         int                         fTotalRequests;
         int                         fCacheMisses;
-        int                         fHashMisses; // cache hit but hash table missed
 #endif
     };
 
@@ -258,6 +275,13 @@ private:
     // NULL means whole target. Can be an empty rect.
     void flushRenderTarget(const SkIRect* bound);
     void flushStencil(DrawType);
+    // Sets the stencil state of one face (or both when face is GR_GL_FRONT_AND_BACK), skipping
+    // calls that wouldn't change the shadowed state.
+    void setStencilFace(GrGLenum glFace, GrStencilSettings::Face grFace);
+    // Sets the stencil write mask of both faces for stencil clears.
+    void setStencilClearMask(GrGLuint writeMask);
+    // Calls glPixelStorei unless the shadowed value of pname is already value.
+    void setPixelStore(GrGLenum pname, GrGLint value);
     void flushAAState(DrawType);
     void flushPathStencilSettings(SkPath::FillType fill);
 
@@ -294,6 +318,7 @@ private:
 
     // GL program-related state
     ProgramCache*               fProgramCache;
+    SkAutoTDelete<GrGLPersistentProgramCache> fPersistentProgramCache;
     SkAutoTUnref<GrGLProgram>   fCurrentProgram;
 
     ///////////////////////////////////////////////////////////////////////////
@@ -461,6 +486,52 @@ private:
     TriState                    fHWStencilTestEnabled;
     GrStencilSettings           fHWPathStencilSettings;
 
+    // The GL stencil state of a single face. fHWStencilSettings only tells us whether anything
+    // changed, this lets us skip the individual func/mask/op calls whose values didn't.
+    struct HWStencilFace {
+        GrGLenum    fFunc;
+        GrGLint     fRef;
+        GrGLint     fFuncMask;
+        GrGLenum    fFailOp;
+        GrGLenum    fPassOp;
+        GrGLuint    fWriteMask;
+        bool        fFuncValid;
+        bool        fOpValid;
+        bool        fWriteMaskValid;
+
+        void invalidate() {
+            fFuncValid = false;
+            fOpValid = false;
+            fWriteMaskValid = false;
+        }
+    };
+    HWStencilFace               fHWStencilFaces[2];   // indexed by GrStencilSettings::Face
+    GrGLint                     fHWClearStencil;
+    bool                        fHWClearStencilValid;
+
+    GrGLfloat                   fHWClearColor[4];
+    bool                        fHWClearColorValid;
+
+    // Pixel store values. kUnknownPixelStoreValue means we don't know what GL has.
+    enum {
+        kUnknownPixelStoreValue = -1
+    };
+    struct {
+        GrGLint fUnpackRowLength;
+        GrGLint fUnpackAlignment;
+        GrGLint fUnpackFlipY;
+        GrGLint fPackRowLength;
+        GrGLint fPackReverseRowOrder;
+
+        void invalidate() {
+            fUnpackRowLength = kUnknownPixelStoreValue;
+            fUnpackAlignment = kUnknownPixelStoreValue;
+            fUnpackFlipY = kUnknownPixelStoreValue;
+            fPackRowLength = kUnknownPixelStoreValue;
+            fPackReverseRowOrder = kUnknownPixelStoreValue;
+        }
+    } fHWPixelStore;
+
     GrDrawState::DrawFace       fHWDrawFace;
     TriState                    fHWWriteToColor;
     TriState                    fHWDitherEnabled;
@@ -11,7 +11,7 @@
 #include "GrGLEffect.h"
 #include "SkRTConf.h"
 #include "GrGLNameAllocator.h"
-#include "SkTSearch.h"
+#include "SkTime.h"
 
 #ifdef PROGRAM_CACHE_STATS
 SK_CONF_DECLARE(bool, c_DisplayCache, "gpu.displayCache", false,
@@ -22,42 +22,31 @@ typedef GrGLUniformManager::UniformHandle UniformHandle;
 
 struct GrGpuGL::ProgramCache::Entry {
     SK_DECLARE_INST_COUNT_ROOT(Entry);
-    Entry() : fProgram(NULL), fLRUStamp(0) {}
+    Entry(GrGLProgram* program) : fProgram(program) {}
 
-    SkAutoTUnref<GrGLProgram>   fProgram;
-    unsigned int                fLRUStamp;
-};
-
-struct GrGpuGL::ProgramCache::ProgDescLess {
-    bool operator() (const GrGLProgramDesc& desc, const Entry* entry) {
-        SkASSERT(NULL != entry->fProgram.get());
-        return GrGLProgramDesc::Less(desc, entry->fProgram->getDesc());
+    static const GrGLProgramDesc& GetKey(const Entry& entry) {
+        return entry.fProgram->getDesc();
     }
+    static uint32_t Hash(const GrGLProgramDesc& desc) { return desc.getChecksum(); }
 
-    bool operator() (const Entry* entry, const GrGLProgramDesc& desc) {
-        SkASSERT(NULL != entry->fProgram.get());
-        return GrGLProgramDesc::Less(entry->fProgram->getDesc(), desc);
-    }
+    SkAutoTUnref<GrGLProgram>   fProgram;
+
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
 };
 
 GrGpuGL::ProgramCache::ProgramCache(GrGpuGL* gpu)
-    : fCount(0)
-    , fCurrLRUStamp(0)
+    : fMaxEntries(kDefaultMaxEntries)
     , fGpu(gpu)
 #ifdef PROGRAM_CACHE_STATS
     , fTotalRequests(0)
     , fCacheMisses(0)
-    , fHashMisses(0)
 #endif
 {
-    for (int i = 0; i < 1 << kHashBits; ++i) {
-        fHashTable[i] = NULL;
-    }
 }
 
 GrGpuGL::ProgramCache::~ProgramCache() {
-    for (int i = 0; i < fCount; ++i){
-        SkDELETE(fEntries[i]);
+    while (Entry* entry = fLRUList.head()) {
+        this->purgeEntry(entry);
     }
     // dump stats
 #ifdef PROGRAM_CACHE_STATS
@@ -68,25 +57,32 @@ GrGpuGL::ProgramCache::~ProgramCache() {
         SkDebugf("Cache miss %%: %f\n", (fTotalRequests > 0) ?
                                             100.f * fCacheMisses / fTotalRequests :
                                             0.f);
-        int cacheHits = fTotalRequests - fCacheMisses;
-        SkDebugf("Hash miss %%: %f\n", (cacheHits > 0) ? 100.f * fHashMisses / cacheHits : 0.f);
         SkDebugf("---------------------\n");
     }
 #endif
 }
 
 void GrGpuGL::ProgramCache::abandon() {
-    for (int i = 0; i < fCount; ++i) {
-        SkASSERT(NULL != fEntries[i]->fProgram.get());
-        fEntries[i]->fProgram->abandon();
-        fEntries[i]->fProgram.reset(NULL);
+    while (Entry* entry = fLRUList.head()) {
+        SkASSERT(NULL != entry->fProgram.get());
+        entry->fProgram->abandon();
+        this->purgeEntry(entry);
     }
-    fCount = 0;
 }
 
-int GrGpuGL::ProgramCache::search(const GrGLProgramDesc& desc) const {
-    ProgDescLess less;
-    return SkTSearch(fEntries, fCount, desc, sizeof(Entry*), less);
+void GrGpuGL::ProgramCache::purgeEntry(Entry* entry) {
+    fHash.remove(Entry::GetKey(*entry));
+    fLRUList.remove(entry);
+    SkDELETE(entry);
+}
+
+void GrGpuGL::ProgramCache::setMaxEntries(int maxEntries) {
+    SkASSERT(maxEntries > 0);
+    fMaxEntries = maxEntries;
+    while (fHash.count() > fMaxEntries) {
+        this->purgeEntry(fLRUList.tail());
+        ++fGpu->stats()->fProgramCacheEvictions;
+    }
 }
 
 GrGLProgram* GrGpuGL::ProgramCache::getProgram(const GrGLProgramDesc& desc,
@@ -96,105 +92,89 @@ GrGLProgram* GrGpuGL::ProgramCache::getProgram(const GrGLProgramDesc& desc,
     ++fTotalRequests;
 #endif
 
-    Entry* entry = NULL;
-
-    uint32_t hashIdx = desc.getChecksum();
-    hashIdx ^= hashIdx >> 16;
-    if (kHashBits <= 8) {
-        hashIdx ^= hashIdx >> 8;
-    }
-    hashIdx &=((1 << kHashBits) - 1);
-    Entry* hashedEntry = fHashTable[hashIdx];
-    if (NULL != hashedEntry && hashedEntry->fProgram->getDesc() == desc) {
-        SkASSERT(NULL != hashedEntry->fProgram);
-        entry = hashedEntry;
+    Entry* entry = fHash.find(desc);
+    if (NULL != entry) {
+        ++fGpu->stats()->fProgramCacheHits;
+        if (entry != fLRUList.head()) {
+            fLRUList.remove(entry);
+            fLRUList.addToHead(entry);
+        }
+        return entry->fProgram;
     }
 
-    int entryIdx;
-    if (NULL == entry) {
-        entryIdx = this->search(desc);
-        if (entryIdx >= 0) {
-            entry = fEntries[entryIdx];
+    // We have a cache miss
 #ifdef PROGRAM_CACHE_STATS
-            ++fHashMisses;
+    ++fCacheMisses;
 #endif
-        }
+    GrContext::GpuStats* stats = fGpu->stats();
+    ++stats->fProgramCacheMisses;
+    SkMSec compileStart = SkTime::GetMSecs();
+    GrGLProgram* program = GrGLProgram::Create(fGpu, desc, colorStages, coverageStages);
+    stats->fProgramCompileMSecs += SkTime::GetMSecs() - compileStart;
+    if (NULL == program) {
+        return NULL;
     }
 
-    if (NULL == entry) {
-        // We have a cache miss
-#ifdef PROGRAM_CACHE_STATS
-        ++fCacheMisses;
-#endif
-        GrGLProgram* program = GrGLProgram::Create(fGpu, desc, colorStages, coverageStages);
-        if (NULL == program) {
-            return NULL;
-        }
-        int purgeIdx = 0;
-        if (fCount < kMaxEntries) {
-            entry = SkNEW(Entry);
-            purgeIdx = fCount++;
-            fEntries[purgeIdx] = entry;
-        } else {
-            SkASSERT(fCount == kMaxEntries);
-            purgeIdx = 0;
-            for (int i = 1; i < kMaxEntries; ++i) {
-                if (fEntries[i]->fLRUStamp < fEntries[purgeIdx]->fLRUStamp) {
-                    purgeIdx = i;
-                }
-            }
-            entry = fEntries[purgeIdx];
-            int purgedHashIdx = entry->fProgram->getDesc().getChecksum() & ((1 << kHashBits) - 1);
-            if (fHashTable[purgedHashIdx] == entry) {
-                fHashTable[purgedHashIdx] = NULL;
-            }
-        }
-        SkASSERT(fEntries[purgeIdx] == entry);
-        entry->fProgram.reset(program);
-        // We need to shift fEntries around so that the entry currently at purgeIdx is placed
-        // just before the entry at ~entryIdx (in order to keep fEntries sorted by descriptor).
-        entryIdx = ~entryIdx;
-        if (entryIdx < purgeIdx) {
-            //  Let E and P be the entries at index entryIdx and purgeIdx, respectively.
-            //  If the entries array looks like this:
-            //       aaaaEbbbbbPccccc
-            //  we rearrange it to look like this:
-            //       aaaaPEbbbbbccccc
-            size_t copySize = (purgeIdx - entryIdx) * sizeof(Entry*);
-            memmove(fEntries + entryIdx + 1, fEntries + entryIdx, copySize);
-            fEntries[entryIdx] = entry;
-        } else if (purgeIdx < entryIdx) {
-            //  If the entries array looks like this:
-            //       aaaaPbbbbbEccccc
-            //  we rearrange it to look like this:
-            //       aaaabbbbbPEccccc
-            size_t copySize = (entryIdx - purgeIdx - 1) * sizeof(Entry*);
-            memmove(fEntries + purgeIdx, fEntries + purgeIdx + 1, copySize);
-            fEntries[entryIdx - 1] = entry;
-        }
-#ifdef SK_DEBUG
-        SkASSERT(NULL != fEntries[0]->fProgram.get());
-        for (int i = 0; i < fCount - 1; ++i) {
-            SkASSERT(NULL != fEntries[i + 1]->fProgram.get());
-            const GrGLProgramDesc& a = fEntries[i]->fProgram->getDesc();
-            const GrGLProgramDesc& b = fEntries[i + 1]->fProgram->getDesc();
-            SkASSERT(GrGLProgramDesc::Less(a, b));
-            SkASSERT(!GrGLProgramDesc::Less(b, a));
-        }
-#endif
+    if (fHash.count() >= fMaxEntries) {
+        this->purgeEntry(fLRUList.tail());
+        ++stats->fProgramCacheEvictions;
     }
+    entry = SkNEW_ARGS(Entry, (program));
+    fHash.add(entry);
+    fLRUList.addToHead(entry);
+    return entry->fProgram;
+}
 
-    fHashTable[hashIdx] = entry;
-    entry->fLRUStamp = fCurrLRUStamp;
+int GrGpuGL::getProgramCacheLimit() const {
+    return fProgramCache->getMaxEntries();
+}
 
-    if (SK_MaxU32 == fCurrLRUStamp) {
-        // wrap around! just trash our LRU, one time hit.
-        for (int i = 0; i < fCount; ++i) {
-            fEntries[i]->fLRUStamp = 0;
-        }
+void GrGpuGL::setProgramCacheLimit(int maxPrograms) {
+    fProgramCache->setMaxEntries(maxPrograms);
+}
+
+void GrGpuGL::setPersistentCache(GrPersistentCache* cache) {
+    if (NULL == cache) {
+        fPersistentProgramCache.free();
+    } else {
+        fPersistentProgramCache.reset(SkNEW_ARGS(GrGLPersistentProgramCache, (fGLContext, cache)));
     }
-    ++fCurrLRUStamp;
-    return entry->fProgram;
+}
+
+bool GrGpuGL::precompileProgram(const GrDrawState& drawState, DrawType type) {
+    SkASSERT(NULL != drawState.getRenderTarget());
+    if (kStencilPath_DrawType == type) {
+        // Stencilling paths doesn't use a program.
+        return false;
+    }
+    if (drawState.willEffectReadDstColor() && !this->caps()->dstReadInShaderSupport()) {
+        // The program's key depends on the dst copy texture made for the actual draw.
+        return false;
+    }
+
+    GrBlendCoeff srcCoeff;
+    GrBlendCoeff dstCoeff;
+    GrDrawState::BlendOptFlags blendOpts = drawState.getBlendOpts(false, &srcCoeff, &dstCoeff);
+    if (GrDrawState::kSkipDraw_BlendOptFlag & blendOpts) {
+        return false;
+    }
+
+    SkSTArray<8, const GrEffectStage*, true> colorStages;
+    SkSTArray<8, const GrEffectStage*, true> coverageStages;
+    GrGLProgramDesc desc;
+    GrGLProgramDesc::Build(drawState,
+                           type,
+                           blendOpts,
+                           srcCoeff,
+                           dstCoeff,
+                           this,
+                           NULL,
+                           &colorStages,
+                           &coverageStages,
+                           &desc);
+    return NULL != fProgramCache->getProgram(desc,
+                                             colorStages.begin(),
+                                             coverageStages.begin());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -262,6 +242,7 @@ bool GrGpuGL::flushGraphicsState(DrawType type, const GrDeviceCoordTexture* dstC
         if (fHWProgramID != programID) {
             GL_CALL(UseProgram(programID));
             fHWProgramID = programID;
+            ++this->stats()->fProgramSwitches;
         }
 
         fCurrentProgram->overrideBlend(&srcCoeff, &dstCoeff);
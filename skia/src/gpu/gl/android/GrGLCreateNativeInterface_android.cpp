@@ -232,6 +232,21 @@ static GrGLInterface* create_es_interface(GrGLVersion version,
     functions->fInvalidateFramebuffer = (GrGLInvalidateFramebufferProc) eglGetProcAddress("glInvalidateFramebuffer");
     functions->fInvalidateSubFramebuffer = (GrGLInvalidateSubFramebufferProc) eglGetProcAddress("glInvalidateSubFramebuffer");
 #endif
+    if (version >= GR_GL_VER(3,0)) {
+#if GL_ES_VERSION_3_0
+        functions->fGetProgramBinary = glGetProgramBinary;
+        functions->fProgramBinary = glProgramBinary;
+        functions->fProgramParameteri = glProgramParameteri;
+#else
+        functions->fGetProgramBinary = (GrGLGetProgramBinaryProc) eglGetProcAddress("glGetProgramBinary");
+        functions->fProgramBinary = (GrGLProgramBinaryProc) eglGetProcAddress("glProgramBinary");
+        functions->fProgramParameteri = (GrGLProgramParameteriProc) eglGetProcAddress("glProgramParameteri");
+#endif
+    } else if (extensions->has("GL_OES_get_program_binary")) {
+        functions->fGetProgramBinary = (GrGLGetProgramBinaryProc) eglGetProcAddress("glGetProgramBinaryOES");
+        functions->fProgramBinary = (GrGLProgramBinaryProc) eglGetProcAddress("glProgramBinaryOES");
+    }
+
     functions->fInvalidateBufferData = (GrGLInvalidateBufferDataProc) eglGetProcAddress("glInvalidateBufferData");
     functions->fInvalidateBufferSubData = (GrGLInvalidateBufferSubDataProc) eglGetProcAddress("glInvalidateBufferSubData");
     functions->fInvalidateTexImage = (GrGLInvalidateTexImageProc) eglGetProcAddress("glInvalidateTexImage");
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMap_opts_DEFINED
+#define SkMipMap_opts_DEFINED
+
+#include "SkImageInfo.h"
+
+/**
+ *  Averages each 2x2 block of the two source rows into one pixel of dst.
+ *  The source rows must each hold at least 2 * dstWidth pixels.
+ */
+typedef void (*SkMipMapDownsampleRowProc)(void* dst, const void* srcRow0,
+                                          const void* srcRow1, int dstWidth);
+
+/**
+ *  Returns a platform-optimized row proc for the colortype, or NULL if there
+ *  is none (in which case the portable version in SkMipMap.cpp is used).
+ */
+SkMipMapDownsampleRowProc SkMipMapGetPlatformRowProc(SkColorType);
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkColorPriv.h"
+#include "SkMipMap_opts_SSE2.h"
+
+/* SSE2 version of the 32bit 2x2 box downsample.
+ * portable version is in src/core/SkMipMap.cpp.
+ */
+
+void SkMipMapDownsampleRow32_SSE2(void* dst, const void* srcRow0,
+                                  const void* srcRow1, int dstWidth) {
+    const SkPMColor* p0 = static_cast<const SkPMColor*>(srcRow0);
+    const SkPMColor* p1 = static_cast<const SkPMColor*>(srcRow1);
+    SkPMColor* d = static_cast<SkPMColor*>(dst);
+    const __m128i zero = _mm_setzero_si128();
+
+    while (dstWidth >= 4) {
+        // Split each row's 8 source pixels into even and odd columns, so
+        // lane i of each register contributes to destination pixel i.
+        __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)p0));
+        __m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(p0 + 4)));
+        __m128i even0 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd0  = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)p1));
+        b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(p1 + 4)));
+        __m128i even1 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd1  = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        // Sum the four contributions per channel in 16 bits, then divide by 4.
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(even0, zero),
+                                                 _mm_unpacklo_epi8(odd0, zero)),
+                                   _mm_add_epi16(_mm_unpacklo_epi8(even1, zero),
+                                                 _mm_unpacklo_epi8(odd1, zero)));
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(even0, zero),
+                                                 _mm_unpackhi_epi8(odd0, zero)),
+                                   _mm_add_epi16(_mm_unpackhi_epi8(even1, zero),
+                                                 _mm_unpackhi_epi8(odd1, zero)));
+        lo = _mm_srli_epi16(lo, 2);
+        hi = _mm_srli_epi16(hi, 2);
+        _mm_storeu_si128((__m128i*)d, _mm_packus_epi16(lo, hi));
+
+        p0 += 8;
+        p1 += 8;
+        d += 4;
+        dstWidth -= 4;
+    }
+
+    while (dstWidth > 0) {
+        SkPMColor c, ag, rb;
+
+        c = p0[0]; ag  = (c >> 8) & 0xFF00FF; rb  = c & 0xFF00FF;
+        c = p0[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[0]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+
+        *d++ = ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        p0 += 2;
+        p1 += 2;
+        dstWidth -= 1;
+    }
+}
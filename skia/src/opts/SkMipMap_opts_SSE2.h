@@ -0,0 +1,14 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMap_opts_SSE2_DEFINED
+#define SkMipMap_opts_SSE2_DEFINED
+
+void SkMipMapDownsampleRow32_SSE2(void* dst, const void* srcRow0,
+                                  const void* srcRow1, int dstWidth);
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMipMap_opts.h"
+#include "SkMipMap_opts_neon.h"
+#include "SkUtilsArm.h"
+
+SkMipMapDownsampleRowProc SkMipMapGetPlatformRowProc(SkColorType ct) {
+#if SK_ARM_NEON_IS_NONE
+    return NULL;
+#else
+#if SK_ARM_NEON_IS_DYNAMIC
+    if (!sk_cpu_arm_has_neon()) {
+        return NULL;
+    }
+#endif
+    switch (ct) {
+        case kRGBA_8888_SkColorType:
+        case kBGRA_8888_SkColorType:
+            return SkMipMapDownsampleRow32_neon;
+        default:
+            return NULL;
+    }
+#endif
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkColorPriv.h"
+#include "SkMipMap_opts.h"
+#include "SkMipMap_opts_neon.h"
+
+#include <arm_neon.h>
+
+/* neon version of the 32bit 2x2 box downsample.
+ * portable version is in src/core/SkMipMap.cpp.
+ */
+
+void SkMipMapDownsampleRow32_neon(void* dst, const void* srcRow0,
+                                  const void* srcRow1, int dstWidth) {
+    const SkPMColor* p0 = static_cast<const SkPMColor*>(srcRow0);
+    const SkPMColor* p1 = static_cast<const SkPMColor*>(srcRow1);
+    SkPMColor* d = static_cast<SkPMColor*>(dst);
+
+    while (dstWidth >= 4) {
+        // vld2 de-interleaves even (val[0]) and odd (val[1]) source columns.
+        uint32x4x2_t r0 = vld2q_u32(p0);
+        uint32x4x2_t r1 = vld2q_u32(p1);
+        uint8x16_t e0 = vreinterpretq_u8_u32(r0.val[0]);
+        uint8x16_t o0 = vreinterpretq_u8_u32(r0.val[1]);
+        uint8x16_t e1 = vreinterpretq_u8_u32(r1.val[0]);
+        uint8x16_t o1 = vreinterpretq_u8_u32(r1.val[1]);
+
+        uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(e0), vget_low_u8(o0)),
+                                  vaddl_u8(vget_low_u8(e1), vget_low_u8(o1)));
+        uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(e0), vget_high_u8(o0)),
+                                  vaddl_u8(vget_high_u8(e1), vget_high_u8(o1)));
+        uint8x16_t result = vcombine_u8(vshrn_n_u16(lo, 2), vshrn_n_u16(hi, 2));
+        vst1q_u32(d, vreinterpretq_u32_u8(result));
+
+        p0 += 8;
+        p1 += 8;
+        d += 4;
+        dstWidth -= 4;
+    }
+
+    while (dstWidth > 0) {
+        SkPMColor c, ag, rb;
+
+        c = p0[0]; ag  = (c >> 8) & 0xFF00FF; rb  = c & 0xFF00FF;
+        c = p0[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[0]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+
+        *d++ = ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        p0 += 2;
+        p1 += 2;
+        dstWidth -= 1;
+    }
+}
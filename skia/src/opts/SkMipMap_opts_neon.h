@@ -0,0 +1,9 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+void SkMipMapDownsampleRow32_neon(void* dst, const void* srcRow0,
+                                  const void* srcRow1, int dstWidth);
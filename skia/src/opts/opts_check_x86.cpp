@@ -13,6 +13,8 @@
 #include "SkBlitRow.h"
 #include "SkBlitRow_opts_SSE2.h"
 #include "SkBlurImage_opts_SSE2.h"
+#include "SkMipMap_opts.h"
+#include "SkMipMap_opts_SSE2.h"
 #include "SkMorphology_opts.h"
 #include "SkMorphology_opts_SSE2.h"
 #include "SkRTConf.h"
@@ -333,6 +335,21 @@ SkMorphologyImageFilter::Proc SkMorphologyGetPlatformProc(SkMorphologyProcType t
 
 ////////////////////////////////////////////////////////////////////////////////
 
+SkMipMapDownsampleRowProc SkMipMapGetPlatformRowProc(SkColorType ct) {
+    if (!supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return NULL;
+    }
+    switch (ct) {
+        case kRGBA_8888_SkColorType:
+        case kBGRA_8888_SkColorType:
+            return SkMipMapDownsampleRow32_SSE2;
+        default:
+            return NULL;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool SkBoxBlurGetPlatformProcs(SkBoxBlurProc* boxBlurX,
                                SkBoxBlurProc* boxBlurY,
                                SkBoxBlurProc* boxBlurXY,
@@ -6,6 +6,7 @@
  */
 #include "SkAddIntersections.h"
 #include "SkPathOpsBounds.h"
+#include "SkTSort.h"
 
 #if DEBUG_ADD_INTERSECTING_TS
 
@@ -174,6 +175,303 @@ static void debugShowCubicIntersection(int , const SkIntersectionHelper& ,
 }
 #endif
 
+// Finds and records the intersections between one pair of segments, whose
+// bounds are already known to intersect.
+static void add_segment_intersect_ts(SkOpContour* test, SkIntersectionHelper& wt,
+                                     SkOpContour* next, SkIntersectionHelper& wn,
+                                     bool* foundCommonContour) {
+    int pts = 0;
+    SkIntersections ts;
+    bool swap = false;
+    switch (wt.segmentType()) {
+        case SkIntersectionHelper::kHorizontalLine_Segment:
+            swap = true;
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.lineHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.quadHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowQuadLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts.cubicHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowCubicLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kVerticalLine_Segment:
+            swap = true;
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.lineVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.quadVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowQuadLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts.cubicVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowCubicLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kLine_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts.lineHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts.lineVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.lineLine(wt.pts(), wn.pts());
+                    debugShowLineIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    swap = true;
+                    pts = ts.quadLine(wn.pts(), wt.pts());
+                    debugShowQuadLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    swap = true;
+                    pts = ts.cubicLine(wn.pts(), wt.pts());
+                    debugShowCubicLineIntersection(pts, wn, wt,  ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kQuad_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts.quadHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowQuadLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts.quadVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowQuadLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.quadLine(wt.pts(), wn.pts());
+                    debugShowQuadLineIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.quadQuad(wt.pts(), wn.pts());
+                    debugShowQuadIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    swap = true;
+                    pts = ts.cubicQuad(wn.pts(), wt.pts());
+                    debugShowCubicQuadIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kCubic_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts.cubicHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowCubicLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts.cubicVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowCubicLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.cubicLine(wt.pts(), wn.pts());
+                    debugShowCubicLineIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.cubicQuad(wt.pts(), wn.pts());
+                    debugShowCubicQuadIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts.cubicCubic(wt.pts(), wn.pts());
+                    debugShowCubicIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        default:
+            SkASSERT(0);
+    }
+    if (!*foundCommonContour && pts > 0) {
+        test->addCross(next);
+        next->addCross(test);
+        *foundCommonContour = true;
+    }
+    // in addition to recording T values, record matching segment
+    if (pts == 2) {
+        if (wn.segmentType() <= SkIntersectionHelper::kLine_Segment
+                && wt.segmentType() <= SkIntersectionHelper::kLine_Segment) {
+            if (wt.addCoincident(wn, ts, swap)) {
+                return;
+            }
+            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+            pts = 1;
+        } else if (wn.segmentType() >= SkIntersectionHelper::kQuad_Segment
+                && wt.segmentType() >= SkIntersectionHelper::kQuad_Segment
+                && ts.isCoincident(0)) {
+            SkASSERT(ts.coincidentUsed() == 2);
+            if (wt.addCoincident(wn, ts, swap)) {
+                return;
+            }
+            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+            pts = 1;
+        }
+    }
+    if (pts >= 2) {
+        for (int pt = 0; pt < pts - 1; ++pt) {
+            const SkDPoint& point = ts.pt(pt);
+            const SkDPoint& next = ts.pt(pt + 1);
+            if (wt.isPartial(ts[swap][pt], ts[swap][pt + 1], point, next)
+                    && wn.isPartial(ts[!swap][pt], ts[!swap][pt + 1], point, next)) {
+                if (!wt.addPartialCoincident(wn, ts, pt, swap)) {
+                    // remove extra point if two map to same float values
+                    ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+                    pts = 1;
+                }
+            }
+        }
+    }
+    for (int pt = 0; pt < pts; ++pt) {
+        SkASSERT(ts[0][pt] >= 0 && ts[0][pt] <= 1);
+        SkASSERT(ts[1][pt] >= 0 && ts[1][pt] <= 1);
+        SkPoint point = ts.pt(pt).asSkPoint();
+        wt.alignTPt(wn, swap, pt, &ts, &point);
+        int testTAt = wt.addT(wn, point, ts[swap][pt]);
+        int nextTAt = wn.addT(wt, point, ts[!swap][pt]);
+        wt.addOtherT(testTAt, ts[!swap][pt], nextTAt);
+        wn.addOtherT(nextTAt, ts[swap][pt], testTAt);
+    }
+}
+
+// Below this many segment pairs, testing every pair is cheaper than sorting.
+static const int kMinSweepPairs = 256;
+
+struct SkSegmentPair {
+    int fTest;
+    int fNext;
+
+    bool operator<(const SkSegmentPair& other) const {
+        return fTest < other.fTest || (fTest == other.fTest && fNext < other.fNext);
+    }
+};
+
+struct SkSweepEntry {
+    const SkPathOpsBounds* fBounds;
+    int fIndex;
+    bool fIsNext;
+
+    bool operator<(const SkSweepEntry& other) const {
+        return fBounds->fTop < other.fBounds->fTop;
+    }
+};
+
+static void add_sweep_entries(SkOpContour* contour, bool isNext,
+                              SkTDArray<SkSweepEntry>* entries) {
+    const SkTArray<SkOpSegment>& segments = contour->segments();
+    for (int index = 0; index < segments.count(); ++index) {
+        SkSweepEntry* entry = entries->append();
+        entry->fBounds = &segments[index].bounds();
+        entry->fIndex = index;
+        entry->fIsNext = isNext;
+    }
+}
+
+/*
+ *  Broad phase: sweep the segments of both contours from top to bottom,
+ *  keeping the segments whose vertical extent overlaps the sweep line active,
+ *  and only test bounds against those. The resulting pairs are sorted, so
+ *  that the narrow phase visits them in the same order as testing every pair
+ *  (the result of intersection depends on the order the Ts are added).
+ */
+static void find_overlapping_segments(SkOpContour* test, SkOpContour* next,
+                                      SkTDArray<SkSegmentPair>* pairs) {
+    const bool self = test == next;
+    SkTDArray<SkSweepEntry> entries;
+    add_sweep_entries(test, false, &entries);
+    if (!self) {
+        add_sweep_entries(next, true, &entries);
+    }
+    SkTQSort(entries.begin(), entries.end() - 1);
+
+    SkTDArray<const SkSweepEntry*> active;
+    for (int e = 0; e < entries.count(); ++e) {
+        const SkSweepEntry& entry = entries[e];
+        for (int a = 0; a < active.count(); ) {
+            const SkSweepEntry* other = active[a];
+            // entries are sorted by top, so once an active segment is above
+            // this top, it is above every remaining top as well
+            if (!AlmostLessOrEqualUlps(entry.fBounds->fTop, other->fBounds->fBottom)) {
+                active.removeShuffle(a);
+                continue;
+            }
+            if ((self || other->fIsNext != entry.fIsNext)
+                    && SkPathOpsBounds::Intersects(*entry.fBounds, *other->fBounds)) {
+                SkSegmentPair* pair = pairs->append();
+                if (self) {
+                    pair->fTest = SkTMin(entry.fIndex, other->fIndex);
+                    pair->fNext = SkTMax(entry.fIndex, other->fIndex);
+                } else if (entry.fIsNext) {
+                    pair->fTest = other->fIndex;
+                    pair->fNext = entry.fIndex;
+                } else {
+                    pair->fTest = entry.fIndex;
+                    pair->fNext = other->fIndex;
+                }
+            }
+            ++a;
+        }
+        *active.append() = &entry;
+    }
+    if (pairs->count() > 1) {
+        SkTQSort(pairs->begin(), pairs->end() - 1);
+    }
+}
+
 bool AddIntersectTs(SkOpContour* test, SkOpContour* next) {
     if (test != next) {
         if (AlmostLessUlps(test->bounds().fBottom, next->bounds().fTop)) {
@@ -187,6 +485,18 @@ bool AddIntersectTs(SkOpContour* test, SkOpContour* next) {
     SkIntersectionHelper wt;
     wt.init(test);
     bool foundCommonContour = test == next;
+    if (test->segments().count() * next->segments().count() >= kMinSweepPairs) {
+        SkTDArray<SkSegmentPair> pairs;
+        find_overlapping_segments(test, next, &pairs);
+        SkIntersectionHelper wn;
+        wn.init(next);
+        for (int index = 0; index < pairs.count(); ++index) {
+            wt.setIndex(pairs[index].fTest);
+            wn.setIndex(pairs[index].fNext);
+            add_segment_intersect_ts(test, wt, next, wn, &foundCommonContour);
+        }
+        return true;
+    }
     do {
         SkIntersectionHelper wn;
         wn.init(next);
@@ -197,212 +507,7 @@ bool AddIntersectTs(SkOpContour* test, SkOpContour* next) {
             if (!SkPathOpsBounds::Intersects(wt.bounds(), wn.bounds())) {
                 continue;
             }
-            int pts = 0;
-            SkIntersections ts;
-            bool swap = false;
-            switch (wt.segmentType()) {
-                case SkIntersectionHelper::kHorizontalLine_Segment:
-                    swap = true;
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowCubicLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kVerticalLine_Segment:
-                    swap = true;
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowCubicLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kLine_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.lineHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.lineVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineLine(wt.pts(), wn.pts());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            swap = true;
-                            pts = ts.quadLine(wn.pts(), wt.pts());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            swap = true;
-                            pts = ts.cubicLine(wn.pts(), wt.pts());
-                            debugShowCubicLineIntersection(pts, wn, wt,  ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kQuad_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.quadHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.quadVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.quadLine(wt.pts(), wn.pts());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadQuad(wt.pts(), wn.pts());
-                            debugShowQuadIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            swap = true;
-                            pts = ts.cubicQuad(wn.pts(), wt.pts());
-                            debugShowCubicQuadIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kCubic_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.cubicHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.cubicVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.cubicLine(wt.pts(), wn.pts());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.cubicQuad(wt.pts(), wn.pts());
-                            debugShowCubicQuadIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicCubic(wt.pts(), wn.pts());
-                            debugShowCubicIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                default:
-                    SkASSERT(0);
-            }
-            if (!foundCommonContour && pts > 0) {
-                test->addCross(next);
-                next->addCross(test);
-                foundCommonContour = true;
-            }
-            // in addition to recording T values, record matching segment
-            if (pts == 2) {
-                if (wn.segmentType() <= SkIntersectionHelper::kLine_Segment
-                        && wt.segmentType() <= SkIntersectionHelper::kLine_Segment) {
-                    if (wt.addCoincident(wn, ts, swap)) {
-                        continue;
-                    }
-                    ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                    pts = 1;
-                } else if (wn.segmentType() >= SkIntersectionHelper::kQuad_Segment
-                        && wt.segmentType() >= SkIntersectionHelper::kQuad_Segment
-                        && ts.isCoincident(0)) {
-                    SkASSERT(ts.coincidentUsed() == 2);
-                    if (wt.addCoincident(wn, ts, swap)) {
-                        continue;
-                    }
-                    ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                    pts = 1;
-                }
-            }
-            if (pts >= 2) {
-                for (int pt = 0; pt < pts - 1; ++pt) {
-                    const SkDPoint& point = ts.pt(pt);
-                    const SkDPoint& next = ts.pt(pt + 1);
-                    if (wt.isPartial(ts[swap][pt], ts[swap][pt + 1], point, next)
-                            && wn.isPartial(ts[!swap][pt], ts[!swap][pt + 1], point, next)) {
-                        if (!wt.addPartialCoincident(wn, ts, pt, swap)) {
-                            // remove extra point if two map to same float values
-                            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                            pts = 1;
-                        }
-                    }
-                }
-            }
-            for (int pt = 0; pt < pts; ++pt) {
-                SkASSERT(ts[0][pt] >= 0 && ts[0][pt] <= 1);
-                SkASSERT(ts[1][pt] >= 0 && ts[1][pt] <= 1);
-                SkPoint point = ts.pt(pt).asSkPoint();
-                wt.alignTPt(wn, swap, pt, &ts, &point);
-                int testTAt = wt.addT(wn, point, ts[swap][pt]);
-                int nextTAt = wn.addT(wt, point, ts[!swap][pt]);
-                wt.addOtherT(testTAt, ts[!swap][pt], nextTAt);
-                wn.addOtherT(nextTAt, ts[swap][pt], testTAt);
-            }
+            add_segment_intersect_ts(test, wt, next, wn, &foundCommonContour);
         } while (wn.advance());
     } while (wt.advance());
     return true;
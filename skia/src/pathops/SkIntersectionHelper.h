@@ -73,6 +73,11 @@ public:
         fLast = contour->segments().count();
     }
 
+    void setIndex(int index) {
+        SkASSERT(index >= 0 && index < fLast);
+        fIndex = index;
+    }
+
     bool isAdjacent(const SkIntersectionHelper& next) {
         return fContour == next.fContour && fIndex + 1 == next.fIndex;
     }
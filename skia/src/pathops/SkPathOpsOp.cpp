@@ -321,3 +321,181 @@ bool Op(const SkPath& one, const SkPath& two, SkPathOp op, SkPath* result) {
     }
     return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Splits a polygonal path into one path per contour.
+static void split_contours(const SkPath& path, SkTArray<SkPath>* contours) {
+    SkPath::RawIter iter(path);
+    SkPoint pts[4];
+    SkPath::Verb verb;
+    SkPath* contour = NULL;
+    while ((verb = iter.next(pts)) != SkPath::kDone_Verb) {
+        switch (verb) {
+            case SkPath::kMove_Verb:
+                contour = &contours->push_back();
+                contour->moveTo(pts[0]);
+                break;
+            case SkPath::kLine_Verb:
+                contour->lineTo(pts[1]);
+                break;
+            case SkPath::kClose_Verb:
+                contour->close();
+                break;
+            default:
+                SkDEBUGFAIL("unexpected verb");
+                break;
+        }
+    }
+}
+
+// Returns the middle of the contour's first edge. Since the contours of a
+// simplified path only meet at their end points, this is not on any other
+// contour.
+static bool contour_mid_point(const SkPath& contour, SkPoint* mid) {
+    SkPoint pts[2];
+    if (contour.countPoints() < 2) {
+        return false;
+    }
+    contour.getPoints(pts, 2);
+    mid->set(SkScalarAve(pts[0].fX, pts[1].fX), SkScalarAve(pts[0].fY, pts[1].fY));
+    return true;
+}
+
+/*
+ *  Appends path to accumulator, with its contours oriented so that the
+ *  winding number is 1 inside the path and 0 outside of it: outer contours
+ *  clockwise, and holes (contours nested an odd number of times) counter-
+ *  clockwise. Once every operand has been added this way, the union of the
+ *  operands is exactly the area with a non-zero winding number.
+ *  The path must be polygonal.
+ */
+static bool add_normalized_contours(const SkPath& path, SkPath* accumulator) {
+    SkPath::Direction dir;
+    if (path.isConvex()) {
+        // a convex path is a single contour, so nothing can be nested
+        if (!path.cheapComputeDirection(&dir)) {
+            return true;    // degenerate; contributes no area
+        }
+        if (SkPath::kCW_Direction == dir) {
+            accumulator->addPath(path);
+        } else {
+            accumulator->reverseAddPath(path);
+        }
+        return true;
+    }
+
+    SkPath simple;
+    if (!Simplify(path, &simple)) {
+        return false;
+    }
+    SkTArray<SkPath> contours;
+    split_contours(simple, &contours);
+    for (int index = 0; index < contours.count(); ++index) {
+        const SkPath& contour = contours[index];
+        SkPoint mid;
+        if (!contour_mid_point(contour, &mid) || !contour.cheapComputeDirection(&dir)) {
+            continue;
+        }
+        int depth = 0;
+        for (int other = 0; other < contours.count(); ++other) {
+            if (other != index && contours[other].contains(mid.fX, mid.fY)) {
+                ++depth;
+            }
+        }
+        SkPath::Direction wanted = (depth & 1) ? SkPath::kCCW_Direction : SkPath::kCW_Direction;
+        if (dir == wanted) {
+            accumulator->addPath(contour);
+        } else {
+            accumulator->reverseAddPath(contour);
+        }
+    }
+    return true;
+}
+
+// Combines paths[start, end) pairwise, as a balanced tree, so that each input
+// takes part in log(count) ops rather than the result growing by one path
+// per op.
+static bool op_tree(const SkPath paths[], int start, int end, SkPathOp op, SkPath* result) {
+    SkASSERT(end > start);
+    if (end - start == 1) {
+        *result = paths[start];
+        return true;
+    }
+    int mid = start + ((end - start) >> 1);
+    SkPath one, two;
+    if (!op_tree(paths, start, mid, op, &one) || !op_tree(paths, mid, end, op, &two)) {
+        return false;
+    }
+    return Op(one, two, op, result);
+}
+
+bool Op(const SkPath* paths, int count, SkPathOp op, SkPath* result) {
+    if (count <= 0) {
+        result->reset();
+        return true;
+    }
+    if (1 == count) {
+        // run it through the op anyway, so that the result is simplified
+        return Simplify(paths[0], result);
+    }
+
+    // Resolving every operand in one pass is much faster than combining them
+    // a pair at a time, but with many curves meeting at once, the angle sort
+    // is not reliable enough. So only polygons are combined in one pass.
+    bool onePass = true;
+    for (int index = 0; index < count; ++index) {
+        onePass &= !paths[index].isInverseFillType()
+                && !(paths[index].getSegmentMasks() & ~SkPath::kLine_SegmentMask);
+    }
+
+    switch (op) {
+        case kUnion_PathOp:
+            if (onePass) {
+                // Build every operand's contours into one winding path, and
+                // find all of the intersections in a single pass.
+                SkPath accumulator;
+                for (int index = 0; index < count; ++index) {
+                    if (!add_normalized_contours(paths[index], &accumulator)) {
+                        return op_tree(paths, 0, count, op, result);
+                    }
+                }
+                accumulator.setFillType(SkPath::kWinding_FillType);
+                return Simplify(accumulator, result);
+            }
+            return op_tree(paths, 0, count, op, result);
+        case kXOR_PathOp:
+            if (onePass) {
+                // Once each operand is even-odd, their xor is just all of
+                // their contours together with the even-odd rule.
+                SkPath accumulator;
+                for (int index = 0; index < count; ++index) {
+                    if (paths[index].getFillType() == SkPath::kEvenOdd_FillType) {
+                        accumulator.addPath(paths[index]);
+                        continue;
+                    }
+                    SkPath simple;
+                    if (!Simplify(paths[index], &simple)) {
+                        return op_tree(paths, 0, count, op, result);
+                    }
+                    accumulator.addPath(simple);
+                }
+                accumulator.setFillType(SkPath::kEvenOdd_FillType);
+                return Simplify(accumulator, result);
+            }
+            return op_tree(paths, 0, count, op, result);
+        case kIntersect_PathOp:
+            return op_tree(paths, 0, count, op, result);
+        default: {
+            // not associative, so apply the ops in order
+            SkPath accumulator(paths[0]);
+            for (int index = 1; index < count; ++index) {
+                if (!Op(accumulator, paths[index], op, &accumulator)) {
+                    return false;
+                }
+            }
+            *result = accumulator;
+            return true;
+        }
+    }
+}
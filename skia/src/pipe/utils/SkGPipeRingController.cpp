@@ -0,0 +1,198 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGPipeRingController.h"
+
+#include "SkCanvas.h"
+#include "SkThreadUtils.h"
+
+SkGPipeRingController::SkGPipeRingController(int blockCount, size_t blockSize)
+    : fBlockCount(blockCount)
+    , fBlockSize((blockSize + kCacheLineSize - 1) & ~(size_t)(kCacheLineSize - 1))
+    , fStorage(blockCount * fBlockSize + kCacheLineSize)
+    , fBlocks(blockCount)
+    , fCurrent(NULL)
+    , fSleepers(0)
+    , fAborted(false) {
+    SkASSERT(blockCount > 0);
+    fRing = fStorage.get();
+    fRing += (kCacheLineSize - (uintptr_t)fRing % kCacheLineSize) % kCacheLineSize;
+    for (int i = 0; i < blockCount; i++) {
+        fBlocks[i].fData = fRing + i * fBlockSize;
+        fBlocks[i].fSize = fBlockSize;
+        fBlocks[i].fBytes = 0;
+        fBlocks[i].fHeapData = NULL;
+        fBlocks[i].fFlushed = false;
+    }
+    fPublished.fValue = 0;
+    fConsumed.fValue = 0;
+}
+
+SkGPipeRingController::~SkGPipeRingController() {
+    for (int i = 0; i < fBlockCount; i++) {
+        sk_free(fBlocks[i].fHeapData);
+    }
+}
+
+void* SkGPipeRingController::requestBlock(size_t minRequest, size_t* actual) {
+    // The writer notifies us of everything it wrote before it asks for a new block, so the block
+    // it was filling only holds whole ops.
+    if (fCurrent) {
+        this->publish(false);
+    }
+
+    Block* block = this->acquireBlock();
+    if (NULL == block) {
+        return NULL;
+    }
+    if (minRequest > block->fSize) {
+        block->fHeapData = sk_malloc_throw(minRequest);
+        block->fData = block->fHeapData;
+        block->fSize = minRequest;
+    }
+    fCurrent = block;
+    *actual = block->fSize;
+    return block->fData;
+}
+
+void SkGPipeRingController::notifyWritten(size_t bytes) {
+    SkASSERT(fCurrent);
+    fCurrent->fBytes += bytes;
+}
+
+void SkGPipeRingController::flush() {
+    if (NULL == fCurrent) {
+        fCurrent = this->acquireBlock();
+        if (NULL == fCurrent) {
+            return;
+        }
+    }
+    this->publish(true);
+}
+
+SkGPipeReader::Status SkGPipeRingController::playbackBlock(SkGPipeReader* reader, bool* flushed) {
+    if (this->isEmpty() && !this->isAborted()) {
+        fCondVar.lock();
+        sk_atomic_inc(&fSleepers);
+        while (this->isEmpty() && !this->isAborted()) {
+            fCondVar.wait();
+        }
+        sk_atomic_dec(&fSleepers);
+        fCondVar.unlock();
+    }
+    if (this->isAborted()) {
+        return SkGPipeReader::kDone_Status;
+    }
+
+    const Block& block = fBlocks[fConsumed.fValue % fBlockCount];
+    SkGPipeReader::Status status = SkGPipeReader::kEOF_Status;
+    if (block.fBytes > 0) {
+        status = reader->playback(block.fData, block.fBytes);
+    }
+    if (flushed) {
+        *flushed = block.fFlushed;
+    }
+
+    // Give the block back to the writer.
+    sk_atomic_inc(&fConsumed.fValue);
+    this->wakeUp();
+    return status;
+}
+
+void SkGPipeRingController::abort() {
+    sk_release_store(&fAborted, true);
+    fCondVar.lock();
+    fCondVar.broadcast();
+    fCondVar.unlock();
+}
+
+SkGPipeRingController::Block* SkGPipeRingController::acquireBlock() {
+    if (this->isFull() && !this->isAborted()) {
+        fCondVar.lock();
+        sk_atomic_inc(&fSleepers);
+        while (this->isFull() && !this->isAborted()) {
+            fCondVar.wait();
+        }
+        sk_atomic_dec(&fSleepers);
+        fCondVar.unlock();
+    }
+    if (this->isAborted()) {
+        return NULL;
+    }
+
+    Block* block = &fBlocks[fPublished.fValue % fBlockCount];
+    if (block->fHeapData) {
+        sk_free(block->fHeapData);
+        block->fHeapData = NULL;
+        block->fData = fRing + (block - fBlocks.get()) * fBlockSize;
+        block->fSize = fBlockSize;
+    }
+    block->fBytes = 0;
+    block->fFlushed = false;
+    return block;
+}
+
+void SkGPipeRingController::publish(bool flushed) {
+    SkASSERT(fCurrent);
+    fCurrent->fFlushed = flushed;
+    fCurrent = NULL;
+    sk_atomic_inc(&fPublished.fValue);
+    this->wakeUp();
+}
+
+void SkGPipeRingController::wakeUp() {
+    // The thread that goes to sleep increments fSleepers before it checks the counters for the
+    // last time, and we changed a counter before checking fSleepers. Both are full barriers, so
+    // either it sees our change or we see it. Taking the lock makes sure it is waiting by the time
+    // we broadcast.
+    if (sk_acquire_load(&fSleepers) > 0) {
+        fCondVar.lock();
+        fCondVar.broadcast();
+        fCondVar.unlock();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkGPipeRingReaderThread::SkGPipeRingReaderThread(SkGPipeRingController* controller,
+                                                 SkCanvas* target)
+    : fController(controller)
+    , fReader(target)
+    , fThread(NULL)
+    , fStatus(SkGPipeReader::kEOF_Status) {}
+
+SkGPipeRingReaderThread::~SkGPipeRingReaderThread() {
+    this->join();
+}
+
+void SkGPipeRingReaderThread::start() {
+    SkASSERT(NULL == fThread);
+    fThread = SkNEW_ARGS(SkThread, (Run, this));
+    fThread->start();
+}
+
+SkGPipeReader::Status SkGPipeRingReaderThread::join() {
+    if (fThread) {
+        fThread->join();
+        SkDELETE(fThread);
+        fThread = NULL;
+    }
+    return fStatus;
+}
+
+void SkGPipeRingReaderThread::Run(void* data) {
+    SkGPipeRingReaderThread* self = static_cast<SkGPipeRingReaderThread*>(data);
+    SkGPipeReader::Status status;
+    do {
+        status = self->fController->playbackBlock(&self->fReader);
+    } while (SkGPipeReader::kEOF_Status == status);
+
+    if (SkGPipeReader::kError_Status == status) {
+        self->fController->abort();
+    }
+    self->fStatus = status;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGPipeRingController_DEFINED
+#define SkGPipeRingController_DEFINED
+
+#include "SkCondVar.h"
+#include "SkGPipe.h"
+#include "SkTemplates.h"
+#include "SkThread.h"
+
+class SkCanvas;
+class SkThread;
+
+/**
+ * An SkGPipeController that passes the blocks an SkGPipeWriter fills on one thread to a reader on
+ * another thread, through a ring of blocks allocated up front.
+ *
+ * The writer publishes the block it was filling when it asks for the next one, or when flush() is
+ * called; call flush() after SkGPipeWriter::endRecording() to publish the last block. The reader
+ * plays the published blocks back in order with playbackBlock(), and each block goes back to the
+ * writer once it has been played. When every block is waiting to be played, the writer waits for
+ * the reader to catch up.
+ *
+ * The two threads only share a count of the blocks published and a count of the blocks played
+ * back, each updated by one side without a lock. A thread only takes the lock of the condition
+ * variable to sleep, when the ring is full or empty, and to wake up a thread that sleeps.
+ *
+ * There may only be one writer thread and one reader thread. The writer must not be started with
+ * SkGPipeWriter::kSimultaneousReaders_Flag.
+ */
+class SkGPipeRingController : public SkGPipeController {
+public:
+    enum {
+        kDefaultBlockCount = 8,
+        kDefaultBlockSize  = 16 * 1024,
+    };
+
+    /**
+     * blockSize is rounded up to a multiple of the cache line size. Blocks are aligned on cache
+     * lines. If a single op needs more than blockSize bytes, the block it goes in is allocated
+     * separately.
+     */
+    explicit SkGPipeRingController(int blockCount = kDefaultBlockCount,
+                                   size_t blockSize = kDefaultBlockSize);
+    virtual ~SkGPipeRingController();
+
+    virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
+    virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
+
+    /**
+     * Publishes the block being written even though it is not full, marked so that the reader can
+     * tell where the writer flushed. If nothing was written since the last block was published,
+     * publishes an empty block. Call SkGPipeWriter::flushRecording(true) first, so that the writer
+     * starts a new block afterwards. Writer thread only.
+     */
+    void flush();
+
+    /**
+     * Waits for the next block and plays it back through reader. Returns the status of the
+     * playback, or kDone_Status after abort(). If flushed is not NULL, sets it to whether the block
+     * was published by flush(). Reader thread only.
+     */
+    SkGPipeReader::Status playbackBlock(SkGPipeReader* reader, bool* flushed = NULL);
+
+    /**
+     * Stops the transfer, whether or not the writer is done: from then on requestBlock() returns
+     * NULL, which ends the recording, and playbackBlock() returns kDone_Status. May be called from
+     * either thread, for instance by a reader that failed, so that the writer doesn't wait for it
+     * forever.
+     */
+    void abort();
+
+private:
+    enum {
+        kCacheLineSize = 64,
+    };
+
+    struct Block {
+        void*  fData;
+        size_t fSize;
+        size_t fBytes;
+        // Set when an op didn't fit in the ring's storage.
+        void*  fHeapData;
+        bool   fFlushed;
+    };
+
+    // A counter on a cache line of its own, so that one thread updating it doesn't make the other
+    // reload the counter it updates.
+    struct Counter {
+        int32_t fValue;
+        char    fPad[kCacheLineSize - sizeof(int32_t)];
+    };
+
+    Block* acquireBlock();
+    void publish(bool flushed);
+    void wakeUp();
+
+    bool isFull() {
+        return (uint32_t)fPublished.fValue - (uint32_t)sk_acquire_load(&fConsumed.fValue) >=
+               (uint32_t)fBlockCount;
+    }
+    bool isEmpty() {
+        return sk_acquire_load(&fPublished.fValue) == fConsumed.fValue;
+    }
+    bool isAborted() { return sk_acquire_load(&fAborted); }
+
+    const int            fBlockCount;
+    const size_t         fBlockSize;
+    SkAutoTMalloc<char>  fStorage;
+    char*                fRing;       // fStorage, aligned on a cache line
+    SkAutoTMalloc<Block> fBlocks;
+    // The block the writer is filling, or NULL.
+    Block*               fCurrent;
+
+    Counter              fPublished;  // changed by the writer
+    Counter              fConsumed;   // changed by the reader
+    int32_t              fSleepers;
+    bool                 fAborted;
+    SkCondVar            fCondVar;
+};
+
+/**
+ * Plays back everything written through an SkGPipeRingController into a canvas, on a thread of its
+ * own.
+ */
+class SkGPipeRingReaderThread : SkNoncopyable {
+public:
+    SkGPipeRingReaderThread(SkGPipeRingController*, SkCanvas* target);
+    ~SkGPipeRingReaderThread();
+
+    void start();
+
+    /**
+     * Waits for the writer to be done and for everything it wrote to be played back. Returns
+     * kDone_Status, or kError_Status if the stream could not be played back; in that case the
+     * controller was aborted.
+     */
+    SkGPipeReader::Status join();
+
+private:
+    static void Run(void*);
+
+    SkGPipeRingController* fController;
+    SkGPipeReader          fReader;
+    SkThread*              fThread;
+    SkGPipeReader::Status  fStatus;
+};
+
+#endif
@@ -11,6 +11,7 @@
 #include "SkBitmapDevice.h"
 #include "SkChunkAlloc.h"
 #include "SkColorFilter.h"
+#include "SkCondVar.h"
 #include "SkDrawFilter.h"
 #include "SkGPipe.h"
 #include "SkPaint.h"
@@ -18,10 +19,12 @@
 #include "SkRRect.h"
 #include "SkShader.h"
 #include "SkSurface.h"
+#include "SkThreadUtils.h"
 
 enum {
     // Deferred canvas will auto-flush when recording reaches this limit
     kDefaultMaxRecordingStorageBytes = 64*1024*1024,
+    kDefaultMaxRecordingCommands = SK_MaxS32, // Disables this feature
     kDeferredCanvasBitmapSizeThreshold = ~0U, // Disables this feature
 };
 
@@ -66,8 +69,19 @@ public:
     virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
     virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
     void playback(bool silent);
-    bool hasPendingCommands() const { return fAllocator.blockCount() != 0; }
-    size_t storageAllocatedForRecording() const { return fAllocator.totalCapacity(); }
+    bool hasPendingCommands() const { return fRecording->fAllocator.blockCount() != 0; }
+    size_t storageAllocatedForRecording() const {
+        return fRecording->fAllocator.totalCapacity();
+    }
+
+    // Starts or stops the thread that playbackInBackground() hands the recorded blocks to.
+    void setBackgroundPlayback(bool);
+    // Hands the recorded blocks to the playback thread and records into the other buffer from
+    // then on. The previous background playback must be done.
+    void playbackInBackground();
+    bool isPlayingBackInBackground();
+    void waitForBackgroundPlayback();
+
 private:
     enum {
         kMinBlockSize = 4096
@@ -77,35 +91,55 @@ private:
         void* fBlock;
         size_t fSize;
     };
+    // The blocks recorded between two playbacks.
+    struct Buffer {
+        Buffer() : fAllocator(kMinBlockSize) {}
+        SkChunkAlloc fAllocator;
+        SkTDArray<PipeBlock> fBlockList;
+    };
+
+    static void PlaybackThreadMain(void*);
+    void detachBlock();
+    void playback(Buffer*, bool silent);
+
     void* fBlock;
     size_t fBytesWritten;
-    SkChunkAlloc fAllocator;
-    SkTDArray<PipeBlock> fBlockList;
+    Buffer fBuffers[2];
+    // The buffer fBlock comes from.
+    Buffer* fRecording;
     SkGPipeReader fReader;
+
+    SkThread* fPlaybackThread;
+    SkCondVar fCondVar;
+    // Guarded by fCondVar: the buffer the playback thread plays back, or NULL.
+    Buffer* fHandedOff;
+    bool fQuit;
 };
 
-DeferredPipeController::DeferredPipeController() :
-    fAllocator(kMinBlockSize) {
+DeferredPipeController::DeferredPipeController() {
     fBlock = NULL;
     fBytesWritten = 0;
+    fRecording = &fBuffers[0];
+    fPlaybackThread = NULL;
+    fHandedOff = NULL;
+    fQuit = false;
 }
 
 DeferredPipeController::~DeferredPipeController() {
-    fAllocator.reset();
+    this->setBackgroundPlayback(false);
+    fBuffers[0].fAllocator.reset();
+    fBuffers[1].fAllocator.reset();
 }
 
 void DeferredPipeController::setPlaybackCanvas(SkCanvas* canvas) {
+    this->waitForBackgroundPlayback();
     fReader.setCanvas(canvas);
 }
 
 void* DeferredPipeController::requestBlock(size_t minRequest, size_t *actual) {
-    if (fBlock) {
-        // Save the previous block for later
-        PipeBlock previousBloc(fBlock, fBytesWritten);
-        fBlockList.push(previousBloc);
-    }
+    this->detachBlock();
     size_t blockSize = SkTMax<size_t>(minRequest, kMinBlockSize);
-    fBlock = fAllocator.allocThrow(blockSize);
+    fBlock = fRecording->fAllocator.allocThrow(blockSize);
     fBytesWritten = 0;
     *actual = blockSize;
     return fBlock;
@@ -115,21 +149,111 @@ void DeferredPipeController::notifyWritten(size_t bytes) {
     fBytesWritten += bytes;
 }
 
+void DeferredPipeController::detachBlock() {
+    if (fBlock) {
+        // Save the previous block for later
+        PipeBlock previousBloc(fBlock, fBytesWritten);
+        fRecording->fBlockList.push(previousBloc);
+        fBlock = NULL;
+    }
+}
+
 void DeferredPipeController::playback(bool silent) {
+    this->waitForBackgroundPlayback();
+    this->detachBlock();
+    this->playback(fRecording, silent);
+}
+
+void DeferredPipeController::playback(Buffer* buffer, bool silent) {
     uint32_t flags = silent ? SkGPipeReader::kSilent_PlaybackFlag : 0;
-    for (int currentBlock = 0; currentBlock < fBlockList.count(); currentBlock++ ) {
-        fReader.playback(fBlockList[currentBlock].fBlock, fBlockList[currentBlock].fSize,
-                         flags);
+    for (int currentBlock = 0; currentBlock < buffer->fBlockList.count(); currentBlock++ ) {
+        fReader.playback(buffer->fBlockList[currentBlock].fBlock,
+                         buffer->fBlockList[currentBlock].fSize, flags);
     }
-    fBlockList.reset();
+    buffer->fBlockList.reset();
 
-    if (fBlock) {
-        fReader.playback(fBlock, fBytesWritten, flags);
-        fBlock = NULL;
+    // Release all allocated blocks
+    buffer->fAllocator.reset();
+}
+
+void DeferredPipeController::setBackgroundPlayback(bool background) {
+    if (background == (NULL != fPlaybackThread)) {
+        return;
+    }
+    if (background) {
+        fQuit = false;
+        fPlaybackThread = SkNEW_ARGS(SkThread, (PlaybackThreadMain, this));
+        if (!fPlaybackThread->start()) {
+            SkDELETE(fPlaybackThread);
+            fPlaybackThread = NULL;
+        }
+        return;
     }
+    fCondVar.lock();
+    fQuit = true;
+    fCondVar.broadcast();
+    fCondVar.unlock();
+    // The thread plays back what it was handed before it quits.
+    fPlaybackThread->join();
+    SkDELETE(fPlaybackThread);
+    fPlaybackThread = NULL;
+}
+
+void DeferredPipeController::PlaybackThreadMain(void* data) {
+    DeferredPipeController* controller = static_cast<DeferredPipeController*>(data);
+    controller->fCondVar.lock();
+    for (;;) {
+        while (NULL == controller->fHandedOff && !controller->fQuit) {
+            controller->fCondVar.wait();
+        }
+        Buffer* buffer = controller->fHandedOff;
+        if (NULL == buffer) {
+            break;
+        }
+        // The recording thread only touches the reader and this buffer again once fHandedOff
+        // is back to NULL.
+        controller->fCondVar.unlock();
+        controller->playback(buffer, false);
+        controller->fCondVar.lock();
+        controller->fHandedOff = NULL;
+        controller->fCondVar.broadcast();
+    }
+    controller->fCondVar.unlock();
+}
 
-    // Release all allocated blocks
-    fAllocator.reset();
+void DeferredPipeController::playbackInBackground() {
+    if (NULL == fPlaybackThread) {
+        this->playback(false);
+        return;
+    }
+    this->detachBlock();
+    fCondVar.lock();
+    SkASSERT(NULL == fHandedOff);
+    fHandedOff = fRecording;
+    fCondVar.broadcast();
+    fCondVar.unlock();
+    fRecording = fRecording == &fBuffers[0] ? &fBuffers[1] : &fBuffers[0];
+}
+
+bool DeferredPipeController::isPlayingBackInBackground() {
+    if (NULL == fPlaybackThread) {
+        return false;
+    }
+    fCondVar.lock();
+    bool playing = NULL != fHandedOff;
+    fCondVar.unlock();
+    return playing;
+}
+
+void DeferredPipeController::waitForBackgroundPlayback() {
+    if (NULL == fPlaybackThread) {
+        return;
+    }
+    fCondVar.lock();
+    while (NULL != fHandedOff) {
+        fCondVar.wait();
+    }
+    fCondVar.unlock();
 }
 
 //-----------------------------------------------------------------------------
@@ -155,6 +279,8 @@ public:
     void flushPendingCommands(PlaybackMode);
     void skipPendingCommands();
     void setMaxRecordingStorage(size_t);
+    void setMaxRecordingCommands(int);
+    void setAsyncFlush(bool);
     void recordedDrawCommand();
 
     virtual SkImageInfo imageInfo() const SK_OVERRIDE;
@@ -251,6 +377,7 @@ private:
     void beginRecording();
     void init();
     void aboutToDraw();
+    void flushPendingCommandsInBackground();
     void prepareForImmediatePixelWrite();
 
     DeferredPipeController fPipeController;
@@ -261,9 +388,12 @@ private:
     SkDeferredCanvas::NotificationClient* fNotificationClient;
     bool fFreshFrame;
     bool fCanDiscardCanvasContents;
+    bool fAsyncFlush;
     size_t fMaxRecordingStorageBytes;
     size_t fPreviousStorageAllocated;
     size_t fBitmapSizeThreshold;
+    int fMaxRecordingCommands;
+    int fCommandsSinceFlush;
 };
 
 SkDeferredDevice::SkDeferredDevice(SkSurface* surface) {
@@ -271,14 +401,19 @@ SkDeferredDevice::SkDeferredDevice(SkSurface* surface) {
     fNotificationClient = NULL;
     fImmediateCanvas = NULL;
     fSurface = NULL;
+    fAsyncFlush = false;
     this->setSurface(surface);
     this->init();
 }
 
 void SkDeferredDevice::setSurface(SkSurface* surface) {
+    fPipeController.waitForBackgroundPlayback();
     SkRefCnt_SafeAssign(fImmediateCanvas, surface->getCanvas());
     SkRefCnt_SafeAssign(fSurface, surface);
     fPipeController.setPlaybackCanvas(fImmediateCanvas);
+    if (fAsyncFlush && NULL != fImmediateCanvas->getGrContext()) {
+        this->setAsyncFlush(false);
+    }
 }
 
 void SkDeferredDevice::init() {
@@ -288,12 +423,16 @@ void SkDeferredDevice::init() {
     fPreviousStorageAllocated = 0;
     fBitmapSizeThreshold = kDeferredCanvasBitmapSizeThreshold;
     fMaxRecordingStorageBytes = kDefaultMaxRecordingStorageBytes;
+    fMaxRecordingCommands = kDefaultMaxRecordingCommands;
+    fCommandsSinceFlush = 0;
+    fAsyncFlush = false;
     fNotificationClient = NULL;
     this->beginRecording();
 }
 
 SkDeferredDevice::~SkDeferredDevice() {
     this->flushPendingCommands(kSilent_PlaybackMode);
+    fPipeController.setBackgroundPlayback(false);
     SkSafeUnref(fImmediateCanvas);
     SkSafeUnref(fSurface);
 }
@@ -303,6 +442,19 @@ void SkDeferredDevice::setMaxRecordingStorage(size_t maxStorage) {
     this->recordingCanvas(); // Accessing the recording canvas applies the new limit.
 }
 
+void SkDeferredDevice::setMaxRecordingCommands(int maxCommands) {
+    fMaxRecordingCommands = maxCommands;
+}
+
+void SkDeferredDevice::setAsyncFlush(bool async) {
+    // A GrContext may only be used on the thread that owns its GL context.
+    if (NULL != fImmediateCanvas->getGrContext()) {
+        async = false;
+    }
+    fAsyncFlush = async;
+    fPipeController.setBackgroundPlayback(async);
+}
+
 void SkDeferredDevice::beginRecording() {
     SkASSERT(NULL == fRecordingCanvas);
     fRecordingCanvas = fPipeWriter.startRecording(&fPipeController, 0,
@@ -331,7 +483,7 @@ bool SkDeferredDevice::isFreshFrame() {
 }
 
 bool SkDeferredDevice::hasPendingCommands() {
-    return fPipeController.hasPendingCommands();
+    return fPipeController.hasPendingCommands() || fPipeController.isPlayingBackInBackground();
 }
 
 void SkDeferredDevice::aboutToDraw()
@@ -348,6 +500,9 @@ void SkDeferredDevice::aboutToDraw()
 }
 
 void SkDeferredDevice::flushPendingCommands(PlaybackMode playbackMode) {
+    // Whatever is left of a flush in the background must reach the surface before the caller
+    // looks at it, even if nothing was recorded since.
+    fPipeController.waitForBackgroundPlayback();
     if (!fPipeController.hasPendingCommands()) {
         return;
     }
@@ -365,6 +520,29 @@ void SkDeferredDevice::flushPendingCommands(PlaybackMode playbackMode) {
     }
 
     fPreviousStorageAllocated = storageAllocatedForRecording();
+    fCommandsSinceFlush = 0;
+}
+
+void SkDeferredDevice::flushPendingCommandsInBackground() {
+    if (!fAsyncFlush) {
+        this->flushPendingCommands(kNormal_PlaybackMode);
+        return;
+    }
+    if (!fPipeController.hasPendingCommands()) {
+        return;
+    }
+    // Only one flush at a time is played back in the background, and the surface must not be
+    // told its content will change while it is being drawn to.
+    fPipeController.waitForBackgroundPlayback();
+    this->aboutToDraw();
+    fPipeWriter.flushRecording(true);
+    fPipeController.playbackInBackground();
+    if (fNotificationClient) {
+        fNotificationClient->flushedDrawCommands();
+    }
+
+    fPreviousStorageAllocated = storageAllocatedForRecording();
+    fCommandsSinceFlush = 0;
 }
 
 void SkDeferredDevice::flush() {
@@ -394,12 +572,21 @@ size_t SkDeferredDevice::storageAllocatedForRecording() const {
 void SkDeferredDevice::recordedDrawCommand() {
     size_t storageAllocated = this->storageAllocatedForRecording();
 
+    if (++fCommandsSinceFlush >= fMaxRecordingCommands) {
+        // Unlike the storage limit, the command limit does not make recording wait for the
+        // previous flush in the background: the commands keep piling up until it is done.
+        if (!fAsyncFlush || !fPipeController.isPlayingBackInBackground()) {
+            this->flushPendingCommandsInBackground();
+            storageAllocated = this->storageAllocatedForRecording();
+        }
+    }
+
     if (storageAllocated > fMaxRecordingStorageBytes) {
         // First, attempt to reduce cache without flushing
         size_t tryFree = storageAllocated - fMaxRecordingStorageBytes;
         if (this->freeMemoryIfPossible(tryFree) < tryFree) {
             // Flush is necessary to free more space.
-            this->flushPendingCommands(kNormal_PlaybackMode);
+            this->flushPendingCommandsInBackground();
             // Free as much as possible to avoid oscillating around fMaxRecordingStorageBytes
             // which could cause a high flushing frequency.
             this->freeMemoryIfPossible(~0U);
@@ -556,6 +743,16 @@ size_t SkDeferredCanvas::freeMemoryIfPossible(size_t bytesToFree) {
     return this->getDeferredDevice()->freeMemoryIfPossible(bytesToFree);
 }
 
+void SkDeferredCanvas::setMaxRecordingCommands(int maxCommands) {
+    this->validate();
+    this->getDeferredDevice()->setMaxRecordingCommands(maxCommands);
+}
+
+void SkDeferredCanvas::setAsyncFlush(bool async) {
+    this->validate();
+    this->getDeferredDevice()->setAsyncFlush(async);
+}
+
 void SkDeferredCanvas::setBitmapSizeThreshold(size_t sizeThreshold) {
     SkDeferredDevice* deferredDevice = this->getDeferredDevice();
     SkASSERT(deferredDevice);
@@ -20,6 +20,7 @@ public:
     explicit Dumper(SkCanvas* canvas, int count, bool timeWithCommand)
         : fDigits(0)
         , fIndent(0)
+        , fNoOps(0)
         , fDraw(canvas)
         , fTimeWithCommand(timeWithCommand) {
         while (count > 0) {
@@ -29,6 +30,7 @@ public:
     }
 
     unsigned index() const { return fDraw.index(); }
+    int noOps() const { return fNoOps; }
     void next() { fDraw.next(); }
 
     template <typename T>
@@ -42,7 +44,8 @@ public:
     }
 
     void operator()(const SkRecords::NoOp&) {
-        // Move on without printing anything.
+        // Move on without printing anything, but remember how many commands were optimized away.
+        ++fNoOps;
     }
 
     template <typename T>
@@ -96,6 +99,7 @@ private:
 
     int fDigits;
     int fIndent;
+    int fNoOps;
     SkRecords::Draw fDraw;
     const bool fTimeWithCommand;
 };
@@ -105,9 +109,9 @@ private:
 void DumpRecord(const SkRecord& record,
                   SkCanvas* canvas,
                   bool timeWithCommand) {
-    for (Dumper dumper(canvas, record.count(), timeWithCommand);
-         dumper.index() < record.count();
-         dumper.next()) {
+    Dumper dumper(canvas, record.count(), timeWithCommand);
+    for (; dumper.index() < record.count(); dumper.next()) {
         record.visit<void>(dumper.index(), dumper);
     }
+    printf("%u commands, %d NoOps\n", record.count(), dumper.noOps());
 }
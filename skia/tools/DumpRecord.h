@@ -12,7 +12,8 @@ class SkCanvas;
 
 /**
  * Draw the record to the supplied canvas via SkRecords::Draw, while
- * printing each draw command and run time in microseconds to stdout.
+ * printing each draw command and run time in microseconds to stdout,
+ * followed by the number of commands and how many of them are NoOps.
  *
  * @param timeWithCommand If true, print time next to command, else in
  *        first column.
@@ -913,6 +913,8 @@ SkBBHFactory* PictureRenderer::getFactory() {
             return SkNEW(SkRTreeFactory);
         case kTileGrid_BBoxHierarchyType:
             return SkNEW_ARGS(SkTileGridFactory, (fGridInfo));
+        case kAdaptiveTileGrid_BBoxHierarchyType:
+            return SkNEW_ARGS(SkTileGridFactory, (fGridInfo, SkTileGridFactory::kAdaptive_Layout));
     }
     SkASSERT(0); // invalid bbhType
     return NULL;
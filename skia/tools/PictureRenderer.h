@@ -61,8 +61,9 @@ public:
         kQuadTree_BBoxHierarchyType,
         kRTree_BBoxHierarchyType,
         kTileGrid_BBoxHierarchyType,
+        kAdaptiveTileGrid_BBoxHierarchyType,
 
-        kLast_BBoxHierarchyType = kTileGrid_BBoxHierarchyType,
+        kLast_BBoxHierarchyType = kAdaptiveTileGrid_BBoxHierarchyType,
     };
 
     // this uses SkPaint::Flags as a base and adds additional flags
@@ -258,8 +259,10 @@ public:
             config.append("_rtree");
         } else if (kQuadTree_BBoxHierarchyType == fBBoxHierarchyType) {
             config.append("_quadtree");
-        } else if (kTileGrid_BBoxHierarchyType == fBBoxHierarchyType) {
-            config.append("_grid");
+        } else if (kTileGrid_BBoxHierarchyType == fBBoxHierarchyType ||
+                   kAdaptiveTileGrid_BBoxHierarchyType == fBBoxHierarchyType) {
+            config.append(kTileGrid_BBoxHierarchyType == fBBoxHierarchyType ? "_grid"
+                                                                             : "_adaptivegrid");
             config.append("_");
             config.appendS32(fGridInfo.fTileInterval.width());
             config.append("x");
@@ -18,9 +18,9 @@
 
 // Alphabetized list of flags used by this file or bench_ and render_pictures.
 DEFINE_string(bbh, "none", "bbhType [width height]: Set the bounding box hierarchy type to "
-              "be used. Accepted values are: none, rtree, quadtree, grid. "
+              "be used. Accepted values are: none, rtree, quadtree, grid, adaptivegrid. "
               "Not compatible with --pipe. With value "
-              "'grid', width and height must be specified. 'grid' can "
+              "'grid' or 'adaptivegrid', width and height must be specified. They can "
               "only be used with modes tile, record, and "
               "playbackCreation.");
 
@@ -347,14 +347,16 @@ sk_tools::PictureRenderer* parseRenderer(SkString& error, PictureTool tool) {
             bbhType = sk_tools::PictureRenderer::kQuadTree_BBoxHierarchyType;
         } else if (0 == strcmp(type, "rtree")) {
             bbhType = sk_tools::PictureRenderer::kRTree_BBoxHierarchyType;
-        } else if (0 == strcmp(type, "grid")) {
+        } else if (0 == strcmp(type, "grid") || 0 == strcmp(type, "adaptivegrid")) {
             if (!gridSupported) {
-                error.printf("'--bbh grid' is not compatible with --mode=%s.\n", mode);
+                error.printf("'--bbh %s' is not compatible with --mode=%s.\n", type, mode);
                 return NULL;
             }
-            bbhType = sk_tools::PictureRenderer::kTileGrid_BBoxHierarchyType;
+            bbhType = 0 == strcmp(type, "grid")
+                    ? sk_tools::PictureRenderer::kTileGrid_BBoxHierarchyType
+                    : sk_tools::PictureRenderer::kAdaptiveTileGrid_BBoxHierarchyType;
             if (FLAGS_bbh.count() != 3) {
-                error.printf("--bbh grid requires a width and a height.\n");
+                error.printf("--bbh %s requires a width and a height.\n", type);
                 return NULL;
             }
             int gridWidth = atoi(FLAGS_bbh[1]);
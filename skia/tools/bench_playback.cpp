@@ -26,7 +26,9 @@ __SK_FORCE_IMAGE_DECODER_LINKING;
 DEFINE_string2(skps, r, "skps", "Directory containing SKPs to playback.");
 DEFINE_int32(samples, 10, "Gather this many samples of each picture playback.");
 DEFINE_bool(skr, false, "Play via SkRecord instead of SkPicture.");
+DEFINE_bool(skrbbh, false, "Cull SkRecord playback with the same tile grid as the SkPicture.");
 DEFINE_int32(tile, 1000000000, "Simulated tile size.");
+DEFINE_int32(scroll, 0, "Simulated scroll: play back the tile this many pixels down the page.");
 DEFINE_string(match, "", "The usual filters on file names of SKPs to bench.");
 DEFINE_string(timescale, "ms", "Print times in ms, us, or ns");
 DEFINE_int32(verbose, 0, "0: print min sample; "
@@ -39,12 +41,16 @@ static double timescale() {
     return 1;
 }
 
-static SkPicture* rerecord_with_tilegrid(SkPicture& src) {
+static SkTileGridFactory::TileGridInfo tile_grid_info() {
     SkTileGridFactory::TileGridInfo info;
     info.fTileInterval.set(FLAGS_tile, FLAGS_tile);
     info.fMargin.setEmpty();
     info.fOffset.setZero();
-    SkTileGridFactory factory(info);
+    return info;
+}
+
+static SkPicture* rerecord_with_tilegrid(SkPicture& src) {
+    SkTileGridFactory factory(tile_grid_info());
 
     SkPictureRecorder recorder;
     src.draw(recorder.beginRecording(src.width(), src.height(), &factory));
@@ -52,7 +58,9 @@ static SkPicture* rerecord_with_tilegrid(SkPicture& src) {
 }
 
 static EXPERIMENTAL::SkPlayback* rerecord_with_skr(SkPicture& src) {
-    EXPERIMENTAL::SkRecording recording(src.width(), src.height());
+    SkTileGridFactory factory(tile_grid_info());
+    EXPERIMENTAL::SkRecording recording(src.width(), src.height(),
+                                        FLAGS_skrbbh ? &factory : NULL);
     src.draw(recording.canvas());
     return recording.releasePlayback();
 }
@@ -73,7 +81,8 @@ static void bench(SkPMColor* scratch, SkPicture& src, const char* name) {
                                                                 src.height(),
                                                                 scratch,
                                                                 src.width() * sizeof(SkPMColor)));
-    canvas->clipRect(SkRect::MakeWH(SkIntToScalar(FLAGS_tile), SkIntToScalar(FLAGS_tile)));
+    canvas->clipRect(SkRect::MakeXYWH(0, SkIntToScalar(FLAGS_scroll),
+                                      SkIntToScalar(FLAGS_tile), SkIntToScalar(FLAGS_tile)));
 
     // Draw once to warm any caches.  The first sample otherwise can be very noisy.
     draw(*record, *picture, canvas.get());
@@ -23,14 +23,18 @@ DEFINE_bool2(optimize, O, false, "Run SkRecordOptimize before dumping.");
 DEFINE_int32(tile, 1000000000, "Simulated tile size.");
 DEFINE_bool(timeWithCommand, false, "If true, print time next to command, else in first column.");
 
-static void dump(const char* name, int w, int h, const SkRecord& record) {
+static void dump(const char* name, int w, int h, const SkRecord& record, int occluded) {
     SkBitmap bitmap;
     bitmap.allocN32Pixels(w, h);
     SkCanvas canvas(bitmap);
     canvas.clipRect(SkRect::MakeWH(SkIntToScalar(FLAGS_tile),
                                    SkIntToScalar(FLAGS_tile)));
 
-    printf("%s %s\n", FLAGS_optimize ? "optimized" : "not-optimized", name);
+    if (FLAGS_optimize) {
+        printf("optimized %s, %d draws occluded\n", name, occluded);
+    } else {
+        printf("not-optimized %s\n", name);
+    }
 
     DumpRecord(record, &canvas, FLAGS_timeWithCommand);
 }
@@ -63,11 +67,14 @@ int tool_main(int argc, char** argv) {
         SkRecorder canvas(&record, w, h);
         src->draw(&canvas);
 
+        int occluded = 0;
         if (FLAGS_optimize) {
+            // SkRecordOptimize runs this pass too, but it finds nothing more to do the second time.
+            occluded = SkRecordNoopOccludedDraws(&record);
             SkRecordOptimize(&record);
         }
 
-        dump(FLAGS_skps[i], w, h, record);
+        dump(FLAGS_skps[i], w, h, record, occluded);
     }
 
     return 0;